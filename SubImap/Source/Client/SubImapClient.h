@@ -26,6 +26,8 @@
 #import "SubImapCommand.h"
 #import "SubImapResponse.h"
 #import "SubImapClientDelegate.h"
+#import "SubImapMetrics.h"
+#import "SubImapMailboxState.h"
 
 
 @interface SubImapClient : NSObject <SubImapConnectionDelegate>
@@ -45,9 +47,55 @@
 
 @property (readonly) SubImapConnection *connection;
 
+#pragma mark Capabilities
+
+/*
+ * The server's capabilities, uppercased, or nil if they are not known.
+ *
+ * These are read from the greeting, CAPABILITY responses, and CAPABILITY
+ * response codes such as the one in a LOGIN or AUTHENTICATE OK, so a
+ * separate CAPABILITY command is rarely needed. They are cached for each
+ * host and port, separately before and after authenticating, and the
+ * cached list is used until the server sends a new one.
+ *
+ * The connection's LITERAL+ settings follow the capabilities.
+ */
+@property (readonly) NSArray *capabilities;
+
+- (BOOL)hasCapability:(NSString *)capability;
+
+#pragma mark Mailbox
+
+/*
+ * The selected mailbox, or nil if none is selected.
+ *
+ * A new state is started when a SELECT command is sent, and is updated
+ * from the untagged responses to every command, so it tracks EXISTS,
+ * EXPUNGE, VANISHED and any UIDs and flags that are fetched.
+ */
+@property (readonly) SubImapMailboxState *mailboxState;
+
+#pragma mark Metrics
+
+/*
+ * Records command latencies, parse times and byte counts while set.
+ *
+ * Defaults to nil, in which case nothing is measured.
+ */
+@property SubImapMetrics *metrics;
+
 #pragma mark Commands
 
+/*
+ * Queues a command to be sent once the client is in a state it can
+ * execute in. Commands are sent one at a time, highest priority first,
+ * and in the order they were enqueued within a priority.
+ */
 - (void)enqueueCommand:(SubImapCommand *)command;
+
+/*
+ * Removes every queued command, and completes the active one.
+ */
 - (void)dequeueAllCommands;
 
 @end
\ No newline at end of file
@@ -23,8 +23,27 @@
 
 #import "SubImapClient.h"
 
+#import "SubImapCommandQueue.h"
+#import "SubImapDelegateList.h"
 #import "SubImapParser.h"
 #import "SubImapResponse.h"
+#import "SubImapSelectCommand.h"
+
+// SubImapClientDelegate methods, in the order they are passed to
+// SubImapDelegateList
+typedef enum {
+  SubImapClientEventDidEnqueueCommand,
+  SubImapClientEventDidDequeueCommand,
+  SubImapClientEventWillSendCommand,
+  SubImapClientEventDidSendCommand,
+  SubImapClientEventWillParseResponseData,
+  SubImapClientEventDidReceiveResponse,
+  SubImapClientEventDidReceiveResponseBatch,
+  SubImapClientEventDidChangeState,
+  SubImapClientEventDidEncounterParserError,
+  SubImapClientEventDidReceiveMailboxEvent,
+  SubImapClientEventCount,
+} SubImapClientEvent;
 
 @implementation SubImapClient {
   // Connection
@@ -32,15 +51,24 @@
   BOOL _connectionHasSpace;
 
   // Delegates
-  NSMutableArray *_delegates;
+  SubImapDelegateList *_delegates;
+  NSMutableArray *_responseBatch;
+  NSUInteger _responseBatchLength;
 
   // Command queue
-  NSMutableArray *_commandQueue;
+  SubImapCommandQueue *_commandQueue;
+  NSTimer *_deadlineTimer;
   SubImapCommand *_activeCommand;
   NSUInteger _commandNumber;
 
   // Parser
   SubImapParser *_parser;
+
+  // Capabilities
+  NSArray *_capabilities;
+
+  // Mailbox
+  SubImapMailboxState *_mailboxState;
 }
 
 + (instancetype)clientWithConnection:(SubImapConnection *)connection {
@@ -55,9 +83,23 @@
     _connectionHasSpace = NO;
     [_connection addDelegate:self];
 
-    _delegates = [NSMutableArray array];
-
-    _commandQueue = [NSMutableArray array];
+    SEL events[SubImapClientEventCount] = {
+      @selector(client:didEnqueueCommand:),
+      @selector(client:didDequeueCommand:),
+      @selector(client:willSendCommand:),
+      @selector(client:didSendCommand:),
+      @selector(client:parser:willParseResponseData:),
+      @selector(client:didReceiveResponse:),
+      @selector(client:didReceiveResponseBatch:),
+      @selector(client:didChangeState:),
+      @selector(client:didEncounterParserError:),
+      @selector(client:didReceiveMailboxEvent:forMailbox:),
+    };
+
+    _delegates = [[SubImapDelegateList alloc] initWithSelectors:events count:SubImapClientEventCount];
+    _responseBatch = [NSMutableArray array];
+
+    _commandQueue = [SubImapCommandQueue queue];
     _activeCommand = nil;
     _commandNumber = 0;
 
@@ -85,13 +127,13 @@
   command.tag = tag;
 
   // Add command to queue
-  [_commandQueue addObject:command];
+  [_commandQueue addCommand:command];
+  [self scheduleDeadline:command.deadline];
+  [_metrics commandWasEnqueued:command];
 
   // Delegate: didEnqueueCommand
-  for (id<SubImapClientDelegate>delegate in _delegates) {
-    if ([delegate respondsToSelector:@selector(client:didEnqueueCommand:)]) {
-      [delegate client:self didEnqueueCommand:command];
-    }
+  for (id<SubImapClientDelegate>delegate in [_delegates delegatesForEvent:SubImapClientEventDidEnqueueCommand]) {
+    [delegate client:self didEnqueueCommand:command];
   }
 
   // Process queue
@@ -100,11 +142,9 @@
 
 - (void)dequeueAllCommands {
   // Delegate: DidDequeueCommand
-  for (SubImapCommand *command in _commandQueue) {
-    for (id<SubImapClientDelegate>delegate in _delegates) {
-      if ([delegate respondsToSelector:@selector(client:didDequeueCommand:)]) {
-        [delegate client:self didDequeueCommand:command];
-      }
+  for (SubImapCommand *command in [_commandQueue allCommands]) {
+    for (id<SubImapClientDelegate>delegate in [_delegates delegatesForEvent:SubImapClientEventDidDequeueCommand]) {
+      [delegate client:self didDequeueCommand:command];
     }
   }
 
@@ -113,18 +153,31 @@
   }
 
   _activeCommand = nil;
-  [_commandQueue removeAllObjects];
+  [_commandQueue removeAllCommands];
+
+  [_deadlineTimer invalidate];
+  _deadlineTimer = nil;
   _commandNumber = 0;
 }
 
+#pragma mark Capabilities
+
+- (NSArray *)capabilities {
+  return _capabilities;
+}
+
+- (BOOL)hasCapability:(NSString *)capability {
+  return [_capabilities containsObject:[capability uppercaseString]];
+}
+
 #pragma mark Delegates
 
 - (void)addDelegate:(id<SubImapClientDelegate>)delegate {
-  [_delegates addObject:delegate];
+  [_delegates addDelegate:delegate];
 }
 
 - (void)removeDelegate:(id<SubImapClientDelegate>)delegate {
-  [_delegates removeObject:delegate];
+  [_delegates removeDelegate:delegate];
 }
 
 #pragma mark -
@@ -138,13 +191,25 @@
     return;
   }
 
+  SubImapClientState previousState = _state;
   _state = state;
 
+  if (state != SubImapClientStateSelected) {
+    _mailboxState = nil;
+  }
+
+  // Capabilities can change when authenticating, so switch to the ones
+  // cached for the new state until the server sends its own
+  NSString *cacheKey = [self capabilityCacheKeyForState:state];
+
+  if (!cacheKey || ![cacheKey isEqualToString:[self capabilityCacheKeyForState:previousState]]) {
+    _capabilities = [[self class] cachedCapabilitiesForKey:cacheKey];
+    [self configureConnectionForCapabilities];
+  }
+
   // Delegate: DidChangeState
-  for (id<SubImapClientDelegate>delegate in _delegates) {
-    if ([delegate respondsToSelector:@selector(client:didChangeState:)]) {
-      [delegate client:self didChangeState:_state];
-    }
+  for (id<SubImapClientDelegate>delegate in [_delegates delegatesForEvent:SubImapClientEventDidChangeState]) {
+    [delegate client:self didChangeState:_state];
   }
 
   // If a command wasn't able to be executed before
@@ -166,48 +231,48 @@
   // Send command
   _activeCommand = command;
   _connectionHasSpace = NO;
+  command.capabilities = _capabilities;
+  command.connection = _connection;
+
+  // Responses from here on are for the new mailbox
+  if ([command isKindOfClass:[SubImapSelectCommand class]]) {
+    _mailboxState = [SubImapMailboxState stateWithPath:[(SubImapSelectCommand *)command mailboxPath]];
+  }
 
   // Delegate: WillSendCommand
-  for (id<SubImapClientDelegate>delegate in _delegates) {
-    if ([delegate respondsToSelector:@selector(client:willSendCommand:)]) {
-      [delegate client:self willSendCommand:command];
-    }
+  for (id<SubImapClientDelegate>delegate in [_delegates delegatesForEvent:SubImapClientEventWillSendCommand]) {
+    [delegate client:self willSendCommand:command];
   }
 
-  for (SubImapConnectionData *data in [SubImapConnectionData compressDataList:[command render]]) {
+  NSArray *dataList = [SubImapConnectionData compressDataList:[command render]];
+
+  for (SubImapConnectionData *data in dataList) {
     [_connection write:data];
   }
 
+  [_metrics commandWasSent:command dataList:dataList];
+
   // Delegate: DidSendCommand
-  for (id<SubImapClientDelegate>delegate in _delegates) {
-    if ([delegate respondsToSelector:@selector(client:didSendCommand:)]) {
-      [delegate client:self didSendCommand:command];
-    }
+  for (id<SubImapClientDelegate>delegate in [_delegates delegatesForEvent:SubImapClientEventDidSendCommand]) {
+    [delegate client:self didSendCommand:command];
   }
 }
 
 - (SubImapCommand *)nextCommand {
   SubImapCommand *command;
 
-  for (SubImapCommand *possibleCommand in _commandQueue) {
-    if ([possibleCommand canExecuteInState:self.state]) {
-      command = possibleCommand;
-      break;
-    }
-  }
-
-  if (command) {
-    [_commandQueue removeObject:command];
-
-    // Command is already complete for some reason
-    if (command.isComplete) {
-      command = [self nextCommand];
+  // Cancelled and completed commands are skipped by the queue
+  while ((command = [_commandQueue takeCommandForState:self.state])) {
+    // The command missed its deadline while queued
+    if (command.deadline && [command.deadline timeIntervalSinceNow] <= 0) {
+      [command failWithErrorCode:SubImapCommandErrorTimedOut message:@"The command timed out before it was sent."];
+      continue;
     }
 
     // There was an error setting up the command
-    else if (command.error) {
+    if (command.error) {
       [command complete];
-      command = [self nextCommand];
+      continue;
     }
 
     return command;
@@ -216,31 +281,282 @@
   return nil;
 }
 
+#pragma mark Deadlines
+
+- (void)scheduleDeadline:(NSDate *)deadline {
+  if (!deadline) {
+    return;
+  }
+
+  // An earlier deadline is already scheduled
+  if (_deadlineTimer && [_deadlineTimer.fireDate compare:deadline] != NSOrderedDescending) {
+    return;
+  }
+
+  [_deadlineTimer invalidate];
+
+  _deadlineTimer = [NSTimer timerWithTimeInterval:MAX([deadline timeIntervalSinceNow], 0) target:self selector:@selector(deadlineTimerDidFire:) userInfo:nil repeats:NO];
+  [[NSRunLoop currentRunLoop] addTimer:_deadlineTimer forMode:NSDefaultRunLoopMode];
+}
+
+- (void)deadlineTimerDidFire:(NSTimer *)timer {
+  _deadlineTimer = nil;
+
+  NSDate *now = [NSDate date];
+
+  for (SubImapCommand *command in [_commandQueue takeCommandsWithDeadlineBeforeDate:now]) {
+    [command failWithErrorCode:SubImapCommandErrorTimedOut message:@"The command timed out before it was sent."];
+  }
+
+  // A sent command keeps the connection until its tagged response
+  // arrives, but the caller stops waiting now
+  if (_activeCommand && !_activeCommand.isComplete && _activeCommand.deadline) {
+    if ([_activeCommand.deadline compare:now] != NSOrderedDescending) {
+      [_activeCommand failWithErrorCode:SubImapCommandErrorTimedOut message:@"The command timed out."];
+    }
+
+    else {
+      [self scheduleDeadline:_activeCommand.deadline];
+    }
+  }
+
+  [self scheduleDeadline:[_commandQueue nextDeadline]];
+}
+
 - (void)processResponse:(SubImapResponse *)response {
-  // Throw out all continuation responses
-  if ([response isType:SubImapResponseTypeContinue]) {
-    // Clean up IDLE commands
-    if ([_activeCommand.name isEqualToString:@"IDLE"]) {
-      [_activeCommand complete];
-      _activeCommand = nil;
-      [self processCommandQueue];
+  // Mailbox changes apply whichever command they arrive with
+  if ([response isUntagged]) {
+    [_mailboxState handleResponse:response];
+  }
+
+  // The active command was cancelled or timed out after it was sent, so
+  // its responses are not delivered. The server still runs it, so its
+  // tagged response changes the client state all the same
+  if (_activeCommand.isComplete) {
+    NSArray *capabilities = [self capabilitiesInResponse:response];
+
+    if ([response isResult] && [response.tag isEqualToString:_activeCommand.tag]) {
+      [self finishActiveCommandWithResponse:response capabilities:capabilities];
     }
 
+    // The server waits on the command until a challenge is answered
+    else if ([response isType:SubImapResponseTypeContinue]) {
+      [self answerContinuation:response];
+    }
+
+    else if (![response isResult]) {
+      if (capabilities) {
+        [self updateCapabilities:capabilities];
+      }
+
+      [self processMailboxEvent:response];
+    }
+
+    return;
+  }
+
+  if (![response isResult]) {
+    [_metrics command:_activeCommand didReceiveResponse:response];
+  }
+
+  // Untagged capabilities, including any in the greeting
+  NSArray *capabilities = [self capabilitiesInResponse:response];
+
+  if (capabilities && ![response isResult]) {
+    [self updateCapabilities:capabilities];
+  }
+
+  // Throw out all continuation responses
+  if ([response isType:SubImapResponseTypeContinue]) {
+    [self answerContinuation:response];
     return;
   }
 
   // Forward the response to the active command
   if ([_activeCommand handleResponse:response]) {
     if ([response isResult]) {
-      // Update state
-      if (response.status) {
-        self.state = [_activeCommand stateFromState:self.state];
-      }
+      [_metrics commandDidComplete:_activeCommand response:response];
+      [self finishActiveCommandWithResponse:response capabilities:capabilities];
+    }
+  }
+
+  // Nothing asked for it
+  else if (![response isResult]) {
+    [self processMailboxEvent:response];
+  }
+}
 
-      // Process next command
-      _activeCommand = nil;
-      [self processCommandQueue];
+- (void)answerContinuation:(SubImapResponse *)response {
+  NSArray *dataList;
+
+  // A cancelled AUTHENTICATE is aborted, and the server answers with a
+  // tagged BAD, RFC3501 6.2.2
+  if (_activeCommand.isComplete && [_activeCommand.name isEqualToString:@"AUTHENTICATE"]) {
+    dataList = @[[SubImapConnectionData dataWithString:@"*\r\n"]];
+  }
+
+  // Answer challenges, such as for AUTHENTICATE
+  else {
+    dataList = [SubImapConnectionData compressDataList:[_activeCommand renderContinuation:response]];
+  }
+
+  for (SubImapConnectionData *data in dataList) {
+    [_connection write:data];
+  }
+
+  // Clean up IDLE commands
+  if ([_activeCommand.name isEqualToString:@"IDLE"]) {
+    if (!_activeCommand.isComplete) {
+      [_activeCommand complete];
     }
+
+    _activeCommand = nil;
+    [self processCommandQueue];
+  }
+}
+
+- (void)finishActiveCommandWithResponse:(SubImapResponse *)response capabilities:(NSArray *)capabilities {
+  // The SELECT result says if the mailbox is read-only, and a failed
+  // SELECT leaves no mailbox selected
+  if ([_activeCommand isKindOfClass:[SubImapSelectCommand class]]) {
+    if (response.status) {
+      [_mailboxState handleResponse:response];
+    } else {
+      _mailboxState = nil;
+    }
+  }
+
+  // Update state
+  if (response.status) {
+    self.state = [_activeCommand stateFromState:self.state];
+  }
+
+  // Capabilities sent with a LOGIN or AUTHENTICATE OK apply to the
+  // new state
+  if (capabilities) {
+    [self updateCapabilities:capabilities];
+  }
+
+  // Process next command
+  _activeCommand = nil;
+  [self processCommandQueue];
+}
+
+- (void)processMailboxEvent:(SubImapResponse *)response {
+  NSString *path = nil;
+
+  if ([response isType:SubImapResponseTypeStatus]) {
+    path = response.data[@"mailbox"];
+  } else if ([response isType:SubImapResponseTypeList]) {
+    path = response.data[@"path"];
+  } else if ([response isType:SubImapResponseTypeFetch]) {
+    path = _mailboxState.path;
+  }
+
+  if (!path) {
+    return;
+  }
+
+  // Delegate: DidReceiveMailboxEvent
+  for (id<SubImapClientDelegate>delegate in [_delegates delegatesForEvent:SubImapClientEventDidReceiveMailboxEvent]) {
+    [delegate client:self didReceiveMailboxEvent:response forMailbox:path];
+  }
+}
+
+#pragma mark Capabilities
+
+- (NSArray *)capabilitiesInResponse:(SubImapResponse *)response {
+  if ([response isType:SubImapResponseTypeCapability]) {
+    return response.data;
+  }
+
+  if ([response.data isKindOfClass:[NSDictionary class]] && [response.data[@"code"] isEqualToString:@"CAPABILITY"]) {
+    return response.data[@"capabilities"];
+  }
+
+  return nil;
+}
+
+- (void)updateCapabilities:(NSArray *)capabilities {
+  NSMutableArray *uppercaseCapabilities = [NSMutableArray arrayWithCapacity:capabilities.count];
+
+  for (NSString *capability in capabilities) {
+    [uppercaseCapabilities addObject:[capability uppercaseString]];
+  }
+
+  _capabilities = uppercaseCapabilities;
+  [[self class] cacheCapabilities:_capabilities forKey:[self capabilityCacheKeyForState:self.state]];
+  [self configureConnectionForCapabilities];
+}
+
+- (void)configureConnectionForCapabilities {
+  if (!_capabilities) {
+    return;
+  }
+
+  // RFC2088 - LITERAL+
+  if ([self hasCapability:@"LITERAL+"]) {
+    _connection.supportLiteralPlus = YES;
+    _connection.literalPlusMaximumLength = 0;
+  }
+
+  // RFC7888 - LITERAL-, non-synchronizing literals up to 4096 bytes
+  else if ([self hasCapability:@"LITERAL-"]) {
+    _connection.supportLiteralPlus = YES;
+    _connection.literalPlusMaximumLength = 4096;
+  }
+
+  else {
+    _connection.supportLiteralPlus = NO;
+  }
+}
+
+- (NSString *)capabilityCacheKeyForState:(SubImapClientState)state {
+  NSString *stateName;
+
+  switch (state) {
+    case SubImapClientStateUnauthenticated:
+      stateName = @"unauthenticated";
+      break;
+    case SubImapClientStateAuthenticated:
+    case SubImapClientStateSelected:
+      stateName = @"authenticated";
+      break;
+    default:
+      return nil;
+  }
+
+  return [NSString stringWithFormat:@"%@:%lu:%@", _connection.host, (unsigned long)_connection.port, stateName];
+}
+
++ (NSMutableDictionary *)capabilityCache {
+  static NSMutableDictionary *cache = nil;
+  static dispatch_once_t onceToken;
+
+  dispatch_once(&onceToken, ^{
+    cache = [NSMutableDictionary dictionary];
+  });
+
+  return cache;
+}
+
++ (NSArray *)cachedCapabilitiesForKey:(NSString *)key {
+  if (!key) return nil;
+
+  NSMutableDictionary *cache = [self capabilityCache];
+
+  @synchronized (cache) {
+    return cache[key];
+  }
+}
+
++ (void)cacheCapabilities:(NSArray *)capabilities forKey:(NSString *)key {
+  if (!key || !capabilities) return;
+
+  NSMutableDictionary *cache = [self capabilityCache];
+
+  @synchronized (cache) {
+    cache[key] = capabilities;
   }
 }
 
@@ -251,6 +567,10 @@
 }
 
 - (void)connectionDidClose:(SubImapConnection *)connection {
+  // Responses of a read cut short by the close are never delivered
+  [_responseBatch removeAllObjects];
+  [self releaseResponseBatch];
+
   self.state = SubImapClientStateDisconnected;
   _commandNumber = 0;
   _activeCommand = nil;
@@ -261,32 +581,64 @@
   [self processCommandQueue];
 }
 
+- (void)connection:(SubImapConnection *)connection didSendData:(NSData *)data {
+  [_metrics didSendData:data];
+}
+
+- (void)connection:(SubImapConnection *)connection didReceiveResponseDataBatch:(NSArray *)dataList {
+  if (!_responseBatch.count) {
+    return;
+  }
+
+  NSArray *responses = _responseBatch;
+  _responseBatch = [NSMutableArray array];
+
+  // Delegate: DidReceiveResponseBatch
+  for (id<SubImapClientDelegate>delegate in [_delegates delegatesForEvent:SubImapClientEventDidReceiveResponseBatch]) {
+    [delegate client:self didReceiveResponseBatch:responses];
+  }
+
+  [self releaseResponseBatch];
+}
+
+- (void)releaseResponseBatch {
+  [_connection releaseBytes:_responseBatchLength];
+  _responseBatchLength = 0;
+}
+
 - (void)connection:(SubImapConnection *)connection didReceiveResponseData:(NSData *)data {
   // Delegate: WillParseResponseData
-  for (id<SubImapClientDelegate>delegate in _delegates) {
-    if ([delegate respondsToSelector:@selector(client:parser:willParseResponseData:)]) {
-      [delegate client:self parser:_parser willParseResponseData:data];
-    }
+  for (id<SubImapClientDelegate>delegate in [_delegates delegatesForEvent:SubImapClientEventWillParseResponseData]) {
+    [delegate client:self parser:_parser willParseResponseData:data];
   }
 
+  uint64_t parseStart = _metrics ? SubImapMetricsNow() : 0;
+
   NSError *error;
   SubImapResponse *response = [_parser parseResponseData:data error:&error];
 
+  if (_metrics) {
+    [_metrics didParseResponse:(error ? nil : response) data:data duration:SubImapMetricsNow() - parseStart];
+  }
+
   if (error) {
     // Delegate: DidEncounterParserError
-    for (id<SubImapClientDelegate>delegate in _delegates) {
-      if ([delegate respondsToSelector:@selector(client:didEncounterParserError:)]) {
-        [delegate client:self didEncounterParserError:error];
-      }
+    for (id<SubImapClientDelegate>delegate in [_delegates delegatesForEvent:SubImapClientEventDidEncounterParserError]) {
+      [delegate client:self didEncounterParserError:error];
     }
   }
 
   else {
     // Delegate: DidReceiveResponse
-    for (id<SubImapClientDelegate>delegate in _delegates) {
-      if ([delegate respondsToSelector:@selector(client:didReceiveResponse:)]) {
-        [delegate client:self didReceiveResponse:response];
-      }
+    for (id<SubImapClientDelegate>delegate in [_delegates delegatesForEvent:SubImapClientEventDidReceiveResponse]) {
+      [delegate client:self didReceiveResponse:response];
+    }
+
+    // Collect responses for DidReceiveResponseBatch
+    if ([[_delegates delegatesForEvent:SubImapClientEventDidReceiveResponseBatch] count]) {
+      [_responseBatch addObject:response];
+      [_connection holdBytes:response.length];
+      _responseBatchLength += response.length;
     }
 
     // Process response
@@ -19,4 +19,20 @@
 - (void)client:(SubImapClient *)client didReceiveResponse:(SubImapResponse *)response;
 - (void)client:(SubImapClient *)client didChangeState:(SubImapClientState)state;
 - (void)client:(SubImapClient *)client didEncounterParserError:(NSError *)error;
+
+/*
+ * Called once per read with every response parsed from it, after
+ * client:didReceiveResponse: has been called for each of them. Observers
+ * that only need to look at responses can implement this instead, to get
+ * one callback per read rather than one per response.
+ */
+- (void)client:(SubImapClient *)client didReceiveResponseBatch:(NSArray *)responses;
+
+/*
+ * Called with an untagged STATUS, LIST or FETCH response that no command
+ * asked for, such as a NOTIFY event, RFC5465. The mailbox is the one the
+ * response is about: the STATUS mailbox, the LIST path, or the selected
+ * mailbox for a FETCH.
+ */
+- (void)client:(SubImapClient *)client didReceiveMailboxEvent:(SubImapResponse *)response forMailbox:(NSString *)path;
 @end
\ No newline at end of file
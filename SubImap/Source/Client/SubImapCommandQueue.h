@@ -0,0 +1,83 @@
+// SubImapCommandQueue.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapTypes.h"
+
+@class SubImapCommand;
+
+/*
+ * SubImapCommandQueue
+ *
+ * The queue of commands waiting to be sent by a SubImapClient.
+ *
+ * Commands are kept in a FIFO for each priority and client state they can
+ * execute in, so finding the next command for a state does not scan past
+ * commands that can't run in it, or that have a lower priority.
+ *
+ * The states a command can execute in are checked once, when it is
+ * added, so canExecuteInState: should only depend on the state. So is
+ * its deadline.
+ *
+ * Commands with deadlines are also kept in a min-heap by deadline, so
+ * finding the expired ones doesn't scan or sort the whole queue.
+ *
+ * Removal is lazy: commands that are taken, cancelled or otherwise
+ * completed are skipped and dropped when they reach the front of a FIFO.
+ */
+@interface SubImapCommandQueue : NSObject
+
+/*
+ * Number of commands that have not been taken or removed. Includes
+ * commands that completed while queued, until they are dropped.
+ */
+@property (readonly) NSUInteger count;
+
++ (instancetype)queue;
+
+- (void)addCommand:(SubImapCommand *)command;
+
+/*
+ * Removes and returns the highest priority, earliest queued command that
+ * can execute in a state and has not completed, or nil.
+ */
+- (SubImapCommand *)takeCommandForState:(SubImapClientState)state;
+
+/*
+ * The earliest deadline of a queued command, or nil.
+ */
+- (NSDate *)nextDeadline;
+
+/*
+ * Removes and returns the queued commands whose deadlines are not later
+ * than the date, earliest first.
+ */
+- (NSArray *)takeCommandsWithDeadlineBeforeDate:(NSDate *)date;
+
+/*
+ * Every queued command, in priority then queue order.
+ */
+- (NSArray *)allCommands;
+
+- (void)removeAllCommands;
+
+@end
\ No newline at end of file
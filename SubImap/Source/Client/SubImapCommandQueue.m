@@ -0,0 +1,411 @@
+// SubImapCommandQueue.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapCommandQueue.h"
+
+#import "SubImapCommand.h"
+
+#define SubImapCommandQueuePriorityCount 3
+#define SubImapCommandQueueStateCount 4
+
+static const SubImapClientState SubImapCommandQueueStates[SubImapCommandQueueStateCount] = {
+  SubImapClientStateDisconnected,
+  SubImapClientStateUnauthenticated,
+  SubImapClientStateAuthenticated,
+  SubImapClientStateSelected,
+};
+
+/*
+ * A queued command. One entry is shared by each FIFO the command is in.
+ */
+@interface SubImapCommandQueueEntry : NSObject {
+@public
+  SubImapCommand *command;
+  NSUInteger sequence;
+  BOOL taken;
+
+  // Since the reference date, 0 for none
+  NSTimeInterval deadline;
+}
+@end
+
+@implementation SubImapCommandQueueEntry
+@end
+
+/*
+ * An array with a moving head, so removing from the front is O(1).
+ */
+@interface SubImapCommandQueueFIFO : NSObject {
+@public
+  NSMutableArray *entries;
+  NSUInteger head;
+}
+@end
+
+@implementation SubImapCommandQueueFIFO
+
+- (id)init {
+  self = [super init];
+
+  if (self) {
+    entries = [NSMutableArray array];
+    head = 0;
+  }
+
+  return self;
+}
+
+- (SubImapCommandQueueEntry *)first {
+  return head < entries.count ? entries[head] : nil;
+}
+
+- (void)removeFirst {
+  head++;
+
+  // Reclaim the front of the array once it is at least half of it
+  if (head == entries.count) {
+    [entries removeAllObjects];
+    head = 0;
+  }
+
+  else if (head > 32 && head * 2 > entries.count) {
+    [entries removeObjectsInRange:NSMakeRange(0, head)];
+    head = 0;
+  }
+}
+
+@end
+
+#pragma mark -
+
+@implementation SubImapCommandQueue {
+  // [priority][state]
+  SubImapCommandQueueFIFO *_fifos[SubImapCommandQueuePriorityCount][SubImapCommandQueueStateCount];
+  NSUInteger _sequence;
+
+  // Commands that can't execute in any state, kept until removed
+  NSMutableArray *_unrunnableEntries;
+
+  // Entries with deadlines, as a binary min-heap by deadline
+  NSMutableArray *_deadlineHeap;
+
+  // Entries in the heap that were taken from a FIFO
+  NSUInteger _takenDeadlineCount;
+}
+
++ (instancetype)queue {
+  return [[self alloc] init];
+}
+
+- (id)init {
+  self = [super init];
+
+  if (self) {
+    for (NSUInteger priority = 0; priority < SubImapCommandQueuePriorityCount; priority++) {
+      for (NSUInteger state = 0; state < SubImapCommandQueueStateCount; state++) {
+        _fifos[priority][state] = [[SubImapCommandQueueFIFO alloc] init];
+      }
+    }
+
+    _unrunnableEntries = [NSMutableArray array];
+    _deadlineHeap = [NSMutableArray array];
+    _takenDeadlineCount = 0;
+    _count = 0;
+    _sequence = 0;
+  }
+
+  return self;
+}
+
+#pragma mark -
+
+static NSUInteger SubImapCommandQueuePriorityIndex(SubImapCommandPriority priority) {
+  NSInteger index = (NSInteger)priority - SubImapCommandPriorityBackground;
+  return (NSUInteger)MIN(MAX(index, 0), SubImapCommandQueuePriorityCount - 1);
+}
+
+static NSInteger SubImapCommandQueueStateIndex(SubImapClientState state) {
+  for (NSUInteger idx = 0; idx < SubImapCommandQueueStateCount; idx++) {
+    if (SubImapCommandQueueStates[idx] == state) {
+      return idx;
+    }
+  }
+
+  return NSNotFound;
+}
+
+- (void)addCommand:(SubImapCommand *)command {
+  SubImapCommandQueueEntry *entry = [[SubImapCommandQueueEntry alloc] init];
+  entry->command = command;
+  entry->sequence = _sequence++;
+  entry->taken = NO;
+  entry->deadline = [command.deadline timeIntervalSinceReferenceDate];
+
+  if (command.deadline) {
+    [_deadlineHeap addObject:entry];
+    [self siftUpDeadlineAtIndex:_deadlineHeap.count - 1];
+  }
+
+  NSUInteger priority = SubImapCommandQueuePriorityIndex(command.priority);
+  BOOL queued = NO;
+
+  for (NSUInteger state = 0; state < SubImapCommandQueueStateCount; state++) {
+    if ([command canExecuteInState:SubImapCommandQueueStates[state]]) {
+      [_fifos[priority][state]->entries addObject:entry];
+      queued = YES;
+    }
+  }
+
+  if (!queued) {
+    [_unrunnableEntries addObject:entry];
+  }
+
+  _count++;
+}
+
+- (SubImapCommand *)takeCommandForState:(SubImapClientState)state {
+  NSInteger stateIndex = SubImapCommandQueueStateIndex(state);
+  if (stateIndex == NSNotFound) return nil;
+
+  for (NSInteger priority = SubImapCommandQueuePriorityCount - 1; priority >= 0; priority--) {
+    SubImapCommandQueueFIFO *fifo = _fifos[priority][stateIndex];
+    SubImapCommandQueueEntry *entry;
+
+    while ((entry = [fifo first])) {
+      [fifo removeFirst];
+
+      // Already taken from another state's FIFO
+      if (entry->taken) {
+        continue;
+      }
+
+      entry->taken = YES;
+      _count--;
+
+      if (entry->deadline) {
+        [self deadlineEntryWasTaken];
+      }
+
+      // Completed while queued, for example cancelled
+      if (entry->command.isComplete) {
+        continue;
+      }
+
+      return entry->command;
+    }
+  }
+
+  return nil;
+}
+
+- (NSArray *)allCommands {
+  NSMutableArray *commands = [NSMutableArray arrayWithCapacity:_count];
+
+  for (NSInteger priority = SubImapCommandQueuePriorityCount - 1; priority >= 0; priority--) {
+    NSMutableSet *seen = [NSMutableSet set];
+    NSMutableArray *entries = [NSMutableArray array];
+
+    for (NSUInteger state = 0; state < SubImapCommandQueueStateCount; state++) {
+      SubImapCommandQueueFIFO *fifo = _fifos[priority][state];
+
+      for (NSUInteger idx = fifo->head; idx < fifo->entries.count; idx++) {
+        SubImapCommandQueueEntry *entry = fifo->entries[idx];
+
+        if (!entry->taken && ![seen containsObject:entry]) {
+          [seen addObject:entry];
+          [entries addObject:entry];
+        }
+      }
+    }
+
+    for (SubImapCommandQueueEntry *entry in _unrunnableEntries) {
+      // Taken when its deadline passed
+      if (entry->taken) {
+        continue;
+      }
+
+      if (SubImapCommandQueuePriorityIndex(entry->command.priority) == priority) {
+        [entries addObject:entry];
+      }
+    }
+
+    [entries sortUsingComparator:^NSComparisonResult(SubImapCommandQueueEntry *a, SubImapCommandQueueEntry *b) {
+      return a->sequence < b->sequence ? NSOrderedAscending : NSOrderedDescending;
+    }];
+
+    for (SubImapCommandQueueEntry *entry in entries) {
+      [commands addObject:entry->command];
+    }
+  }
+
+  return commands;
+}
+
+- (void)removeAllCommands {
+  for (NSUInteger priority = 0; priority < SubImapCommandQueuePriorityCount; priority++) {
+    for (NSUInteger state = 0; state < SubImapCommandQueueStateCount; state++) {
+      SubImapCommandQueueFIFO *fifo = _fifos[priority][state];
+
+      for (NSUInteger idx = fifo->head; idx < fifo->entries.count; idx++) {
+        ((SubImapCommandQueueEntry *)fifo->entries[idx])->taken = YES;
+      }
+
+      [fifo->entries removeAllObjects];
+      fifo->head = 0;
+    }
+  }
+
+  [_unrunnableEntries removeAllObjects];
+  [_deadlineHeap removeAllObjects];
+  _takenDeadlineCount = 0;
+  _count = 0;
+}
+
+#pragma mark Deadlines
+
+- (NSDate *)nextDeadline {
+  SubImapCommandQueueEntry *entry = [self firstDeadlineEntry];
+  return entry ? [NSDate dateWithTimeIntervalSinceReferenceDate:entry->deadline] : nil;
+}
+
+- (NSArray *)takeCommandsWithDeadlineBeforeDate:(NSDate *)date {
+  NSTimeInterval time = [date timeIntervalSinceReferenceDate];
+  NSMutableArray *commands = [NSMutableArray array];
+  SubImapCommandQueueEntry *entry;
+
+  while ((entry = [self firstDeadlineEntry]) && entry->deadline <= time) {
+    [self removeFirstDeadlineEntry];
+
+    // Skipped when it reaches the front of its FIFOs
+    entry->taken = YES;
+    _count--;
+
+    [commands addObject:entry->command];
+  }
+
+  return commands;
+}
+
+/*
+ * The queued entry with the earliest deadline, after dropping taken and
+ * completed ones from the top of the heap.
+ */
+- (SubImapCommandQueueEntry *)firstDeadlineEntry {
+  while (_deadlineHeap.count) {
+    SubImapCommandQueueEntry *entry = _deadlineHeap[0];
+
+    if (!entry->taken && !entry->command.isComplete) {
+      return entry;
+    }
+
+    [self removeFirstDeadlineEntry];
+
+    if (entry->taken) {
+      _takenDeadlineCount--;
+    } else {
+      entry->taken = YES;
+      _count--;
+    }
+  }
+
+  return nil;
+}
+
+- (void)removeFirstDeadlineEntry {
+  [_deadlineHeap exchangeObjectAtIndex:0 withObjectAtIndex:_deadlineHeap.count - 1];
+  [_deadlineHeap removeLastObject];
+  [self siftDownDeadlineAtIndex:0];
+}
+
+// Taken entries are normally dropped when they reach the top of the heap,
+// but commands with far off deadlines would keep them there for long
+- (void)deadlineEntryWasTaken {
+  _takenDeadlineCount++;
+
+  if (_takenDeadlineCount <= 32 || _takenDeadlineCount * 2 <= _deadlineHeap.count) {
+    return;
+  }
+
+  NSMutableArray *entries = [NSMutableArray arrayWithCapacity:_deadlineHeap.count - _takenDeadlineCount];
+
+  for (SubImapCommandQueueEntry *entry in _deadlineHeap) {
+    if (!entry->taken) {
+      [entries addObject:entry];
+    }
+  }
+
+  _deadlineHeap = entries;
+  _takenDeadlineCount = 0;
+
+  for (NSInteger idx = (NSInteger)entries.count / 2 - 1; idx >= 0; idx--) {
+    [self siftDownDeadlineAtIndex:idx];
+  }
+}
+
+static BOOL SubImapCommandQueueEntryIsEarlier(SubImapCommandQueueEntry *entry, SubImapCommandQueueEntry *otherEntry) {
+  if (entry->deadline != otherEntry->deadline) {
+    return entry->deadline < otherEntry->deadline;
+  }
+
+  return entry->sequence < otherEntry->sequence;
+}
+
+- (void)siftUpDeadlineAtIndex:(NSUInteger)idx {
+  while (idx > 0) {
+    NSUInteger parent = (idx - 1) / 2;
+
+    if (!SubImapCommandQueueEntryIsEarlier(_deadlineHeap[idx], _deadlineHeap[parent])) {
+      break;
+    }
+
+    [_deadlineHeap exchangeObjectAtIndex:idx withObjectAtIndex:parent];
+    idx = parent;
+  }
+}
+
+- (void)siftDownDeadlineAtIndex:(NSUInteger)idx {
+  NSUInteger count = _deadlineHeap.count;
+
+  for (;;) {
+    NSUInteger earliest = idx;
+    NSUInteger left = idx * 2 + 1;
+    NSUInteger right = left + 1;
+
+    if (left < count && SubImapCommandQueueEntryIsEarlier(_deadlineHeap[left], _deadlineHeap[earliest])) {
+      earliest = left;
+    }
+
+    if (right < count && SubImapCommandQueueEntryIsEarlier(_deadlineHeap[right], _deadlineHeap[earliest])) {
+      earliest = right;
+    }
+
+    if (earliest == idx) {
+      break;
+    }
+
+    [_deadlineHeap exchangeObjectAtIndex:idx withObjectAtIndex:earliest];
+    idx = earliest;
+  }
+}
+
+@end
\ No newline at end of file
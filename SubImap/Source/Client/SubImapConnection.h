@@ -21,29 +21,141 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+#import "SubImapTypes.h"
 #import "SubImapConnectionData.h"
 #import "SubImapResponse.h"
 #import "SubImapConnectionDelegate.h"
+#import "SubImapTransport.h"
 
-@interface SubImapConnection : NSObject <NSStreamDelegate>
+@class SubImapEventLoop;
+
+extern NSString * const SubImapConnectionErrorDomain;
+
+enum {
+  // The server refused STARTTLS, or greeted with PREAUTH or BYE
+  SubImapConnectionErrorStartTLSFailed = 1,
+};
+
+@interface SubImapConnection : NSObject <SubImapTransportDelegate>
 
 /*
  * Number of bytes to read from the stream at a time.
  */
 @property NSUInteger readBufferSize;
 
+#pragma mark Flow control
+
+/*
+ * Bytes of response data held by consumers past their delegate callback,
+ * such as messages queued for writing to disk. See holdBytes:.
+ */
+@property (readonly) NSUInteger heldBytes;
+
+/*
+ * Reading from the server pauses when heldBytes goes over the high-water
+ * mark, and resumes once it is back down to the low-water mark. While
+ * paused, the server is slowed down by TCP flow control. A high-water
+ * mark of 0 turns this off.
+ *
+ * Default to 8 MB and 2 MB.
+ */
+@property NSUInteger readHighWaterMark;
+@property NSUInteger readLowWaterMark;
+
+/*
+ * YES while reading is paused.
+ */
+@property (readonly) BOOL readingPaused;
+
+/*
+ * Consumers that keep response data after connection:didReceiveResponseData:
+ * or a client delegate callback returns, and hand it to slower work, hold
+ * its size until they are done with it.
+ *
+ * releaseBytes: can be called from any thread.
+ */
+- (void)holdBytes:(NSUInteger)length;
+- (void)releaseBytes:(NSUInteger)length;
+
 /*
  * RFC2088 - LITERAL+
  * http://www.ietf.org/rfc/rfc2088.txt
+ *
+ * SubImapClient sets this from the server's capabilities.
  */
 @property BOOL supportLiteralPlus;
 
+/*
+ * RFC7888 - LITERAL-
+ *
+ * Largest literal sent without waiting for a continuation response when
+ * supportLiteralPlus is set. Larger literals are synchronizing. 0 for no
+ * limit, as with LITERAL+.
+ *
+ * Defaults to 0.
+ */
+@property NSUInteger literalPlusMaximumLength;
+
+/*
+ * The server's hostname or ip address.
+ */
+@property (readonly) NSString *host;
+
+/*
+ * The server's port. Defaults to 993.
+ */
+@property (readonly) NSUInteger port;
+
+/*
+ * Whether TLS is negotiated when the connection opens. Defaults to
+ * SubImapConnectionSecurityTLS.
+ *
+ * With SubImapConnectionSecurityStartTLS, the connection sends STARTTLS
+ * after the greeting and only calls connectionDidOpen: once TLS has
+ * started. The greeting is not passed on.
+ */
+@property (readonly) SubImapConnectionSecurity security;
+
+/*
+ * TLS options, as SubImapTLS*Key values. See SubImapTLSTransport.h.
+ *
+ * Set before opening the connection.
+ */
+@property NSDictionary *tlsSettings;
+
+/*
+ * Drives the connection with a non-blocking socket on an event loop,
+ * instead of run loop streams. The connection must then be opened and
+ * used on the event loop's thread. See SubImapEventLoop.
+ *
+ * TLS on an event loop needs a SubImapTLSSession class, such as
+ * SubImapOpenSSLSession when built with SUBIMAP_OPENSSL.
+ *
+ * Set before opening the connection.
+ */
+@property SubImapEventLoop *eventLoop;
+
+/*
+ * Moves bytes to and from the server. Created when the connection is
+ * first opened, from eventLoop, unless one is set before then.
+ */
+@property id<SubImapTransport> transport;
+
 /*
  * Host can be the server's hostname or ip address.
+ *
+ * Connects to port 993 with TLS.
  */
 + (id)connectionWithHost:(NSString *)host;
 - (id)initWithHost:(NSString *)host;
 
+/*
+ * Connects to any port, with or without TLS. For example, port 143
+ * without TLS, or a local test server.
+ */
++ (id)connectionWithHost:(NSString *)host port:(NSUInteger)port security:(SubImapConnectionSecurity)security;
+- (id)initWithHost:(NSString *)host port:(NSUInteger)port security:(SubImapConnectionSecurity)security;
+
 #pragma mark Delegates
 
 - (void)addDelegate:(id<SubImapConnectionDelegate>)delegate;
@@ -53,13 +165,12 @@
 #pragma mark Connection
 
 /*
- * Open input and output streams to the supplied host, attempting
- * to auto-detect the correct port and security settings.
+ * Opens the transport to the supplied host and port.
  */
 - (BOOL)open;
 
 /*
- * Closes the connection's input and output streams.
+ * Closes the connection's transport.
  *
  * The connection can not be used until it is opened again.
  *
@@ -68,7 +179,7 @@
 - (BOOL)close;
 
 /*
- * Returns YES if the input and output streams are open or active.
+ * Returns YES if the transport is open.
  */
 - (BOOL)isOpen;
 
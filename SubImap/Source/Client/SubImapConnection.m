@@ -23,21 +23,51 @@
 
 #import "SubImapConnection.h"
 
-@implementation SubImapConnection {
-  NSString *_host;
+#import "SubImapDelegateList.h"
+#import "SubImapResponseFramer.h"
+#import "SubImapSocketTransport.h"
+#import "SubImapStreamTransport.h"
+#import "SubImapTLSTransport.h"
+
+NSString * const SubImapConnectionErrorDomain = @"SubImapConnectionErrorDomain";
+
+// Tag of the STARTTLS command sent by the connection itself
+#define SubImapConnectionStartTLSTag "tls0"
+
+typedef enum {
+  SubImapConnectionStartTLSStateNone,
+  SubImapConnectionStartTLSStateAwaitingGreeting,
+  SubImapConnectionStartTLSStateAwaitingResponse,
+} SubImapConnectionStartTLSState;
+
+// SubImapConnectionDelegate methods, in the order they are passed to
+// SubImapDelegateList
+typedef enum {
+  SubImapConnectionEventDidOpen,
+  SubImapConnectionEventDidClose,
+  SubImapConnectionEventHasSpace,
+  SubImapConnectionEventDidSendData,
+  SubImapConnectionEventDidReceiveData,
+  SubImapConnectionEventDidReceiveResponseData,
+  SubImapConnectionEventDidReceiveResponseDataBatch,
+  SubImapConnectionEventDidEncounterStreamError,
+  SubImapConnectionEventCount,
+} SubImapConnectionEvent;
 
-  NSMutableArray *_delegates;
+@implementation SubImapConnection {
+  SubImapDelegateList *_delegates;
 
-  // Streams
+  // Transport
   BOOL _didOpen;
-  NSInputStream *_readStream;
-  NSOutputStream *_writeStream;
-  BOOL _writeStreamHasSpace;
+  BOOL _transportHasSpace;
+  SubImapConnectionStartTLSState _startTLSState;
 
   // Buffers
-  NSMutableData *_readBuffer;
-  NSMutableData *_responseBuffer;
-  NSUInteger _literalBytesToRead;
+  SubImapResponseFramer *_framer;
+
+  // Flow control
+  NSThread *_thread;
+  volatile NSUInteger _heldBytes;
 
   // Data queue
   NSMutableArray *_dataQueue;
@@ -49,16 +79,40 @@
   return [[self alloc] initWithHost:host];
 }
 
++ (id)connectionWithHost:(NSString *)host port:(NSUInteger)port security:(SubImapConnectionSecurity)security {
+  return [[self alloc] initWithHost:host port:port security:security];
+}
+
 - (id)initWithHost:(NSString *)host {
+  return [self initWithHost:host port:993 security:SubImapConnectionSecurityTLS];
+}
+
+- (id)initWithHost:(NSString *)host port:(NSUInteger)port security:(SubImapConnectionSecurity)security {
   self = [super init];
 
   if (self) {
     _host = host;
-
-    _delegates = [NSMutableArray array];
+    _port = port;
+    _security = security;
+
+    SEL events[SubImapConnectionEventCount] = {
+      @selector(connectionDidOpen:),
+      @selector(connectionDidClose:),
+      @selector(connectionHasSpace:),
+      @selector(connection:didSendData:),
+      @selector(connection:didReceiveData:),
+      @selector(connection:didReceiveResponseData:),
+      @selector(connection:didReceiveResponseDataBatch:),
+      @selector(connection:didEncounterStreamError:),
+    };
+
+    _delegates = [[SubImapDelegateList alloc] initWithSelectors:events count:SubImapConnectionEventCount];
 
     self.supportLiteralPlus = NO;
+    self.literalPlusMaximumLength = 0;
     self.readBufferSize = 1024;
+    self.readHighWaterMark = 8 * 1024 * 1024;
+    self.readLowWaterMark = 2 * 1024 * 1024;
   }
 
   return self;
@@ -74,11 +128,11 @@
 #pragma mark Delegates
 
 - (void)addDelegate:(id<SubImapConnectionDelegate>)delegate {
-  [_delegates addObject:delegate];
+  [_delegates addDelegate:delegate];
 }
 
 - (void)removeDelegate:(id<SubImapConnectionDelegate>)delegate {
-  [_delegates removeObject:delegate];
+  [_delegates removeDelegate:delegate];
 }
 
 #pragma mark Connection
@@ -86,103 +140,62 @@
 - (BOOL)open {
   // Reset associated variables
   _didOpen = NO;
+  _transportHasSpace = NO;
+  _startTLSState = _security == SubImapConnectionSecurityStartTLS
+    ? SubImapConnectionStartTLSStateAwaitingGreeting
+    : SubImapConnectionStartTLSStateNone;
 
-  _readStream = nil;
-  _writeStream = nil;
-  _writeStreamHasSpace = NO;
-
-  _readBuffer = [NSMutableData data];
-  _responseBuffer = [NSMutableData data];
-  _literalBytesToRead = 0;
+  _framer = [SubImapResponseFramer framer];
 
   _dataQueue = [NSMutableArray array];
   _activeLiteralData = nil;
   _canWriteLiteralData = NO;
 
-  // Create sockets
-  CFReadStreamRef cfInputStream = NULL;
-  CFWriteStreamRef cfOutputStream = NULL;
-
-  int port = 993;
-  CFStringRef cfHost = (CFStringRef)CFBridgingRetain(_host);
-  CFStreamCreatePairWithSocketToHost(NULL, cfHost, port, &cfInputStream, &cfOutputStream);
-  CFRelease(cfHost);
-
-  // Configure sockets
-  if (cfInputStream && cfOutputStream) {
-    CFReadStreamSetProperty(cfInputStream, kCFStreamPropertyShouldCloseNativeSocket, kCFBooleanTrue);
-    CFWriteStreamSetProperty(cfOutputStream, kCFStreamPropertyShouldCloseNativeSocket, kCFBooleanTrue);
-
-    // Negotiate SSL
-    if (port == 993) {
-      CFReadStreamSetProperty(cfInputStream, kCFStreamPropertySocketSecurityLevel, kCFStreamSocketSecurityLevelNegotiatedSSL);
-      CFWriteStreamSetProperty(cfOutputStream, kCFStreamPropertySocketSecurityLevel, kCFStreamSocketSecurityLevelNegotiatedSSL);
-
-      NSDictionary *settings = @{
-        // (NSString *)kCFStreamSSLValidatesCertificateChain: @NO,
-        // (NSString *)kCFStreamSSLAllowsAnyRoot: @YES, // Deprecated
-        // (NSString *)kCFStreamSSLAllowsExpiredCertificates: @YES,
-        // (NSString *)kCFStreamSSLPeerName: nil,
-      };
-
-      CFReadStreamSetProperty(cfInputStream, kCFStreamPropertySSLSettings, (CFTypeRef)settings);
-      CFWriteStreamSetProperty(cfOutputStream, kCFStreamPropertySSLSettings, (CFTypeRef)settings);
-    }
+  // Create transport
+  if (!_transport) {
+    _transport = [self createTransport];
+  }
 
-    // Bridge sockets
-    _readStream = (NSInputStream *)CFBridgingRelease(cfInputStream);
-    _writeStream = (NSOutputStream *)CFBridgingRelease(cfOutputStream);
+  _transport.delegate = self;
+  _transport.readingPaused = NO;
+  _thread = [NSThread currentThread];
+  [self updateReadingPaused];
 
-    [_readStream setDelegate:self];
-    [_readStream scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSDefaultRunLoopMode];
-    [_readStream open];
+  if (![_transport open]) {
+    [self close];
+    return NO;
+  }
 
-    [_writeStream setDelegate:self];
-    [_writeStream scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSDefaultRunLoopMode];
-    [_writeStream open];
+  return YES;
+}
 
-    return YES;
+- (id<SubImapTransport>)createTransport {
+  if (!_eventLoop) {
+    return [[SubImapStreamTransport alloc] initWithHost:_host port:_port security:_security settings:self.tlsSettings];
   }
 
-  // Error creating sockets
-  else {
-    [self close];
-    return NO;
+  SubImapSocketTransport *socketTransport = [[SubImapSocketTransport alloc] initWithHost:_host port:_port eventLoop:_eventLoop];
+
+  if (_security == SubImapConnectionSecurityNone) {
+    return socketTransport;
   }
+
+  return [[SubImapTLSTransport alloc] initWithTransport:socketTransport host:_host port:_port settings:self.tlsSettings startImmediately:(_security == SubImapConnectionSecurityTLS)];
 }
 
 - (BOOL)close {
-  _readStream.delegate = nil;
-  _writeStream.delegate = nil;
-
-  [_readStream close];
-  [_writeStream close];
+  [_transport close];
 
   // Delegate: DidClose
-  for (id<SubImapConnectionDelegate>delegate in _delegates) {
-    if ([delegate respondsToSelector:@selector(connectionDidClose:)]) {
-      [delegate connectionDidClose:self];
-    }
+  for (id<SubImapConnectionDelegate>delegate in [_delegates delegatesForEvent:SubImapConnectionEventDidClose]) {
+    [delegate connectionDidClose:self];
   }
 
-  return
-    [_readStream streamStatus] == NSStreamStatusClosed &&
-    [_writeStream streamStatus] == NSStreamStatusClosed;
+  return ![_transport isOpen];
 }
 
 - (BOOL)isOpen {
-  // Not initialized yet
-  if (!_readStream || !_writeStream) {
-    return NO;
-  }
-
-  // Check stream status
-  NSStreamStatus inputStatus = [_readStream streamStatus];
-  NSStreamStatus outputStatus = [_writeStream streamStatus];
-
-  return
-  (inputStatus == NSStreamStatusOpen || inputStatus == NSStreamStatusReading) &&
-  (outputStatus == NSStreamStatusOpen || outputStatus == NSStreamStatusWriting);
+  return [_transport isOpen];
 }
 
 #pragma mark Data
@@ -192,163 +205,206 @@
   [self streamWrite];
 }
 
-#pragma mark -
+#pragma mark Flow control
 
-#pragma mark NSStreamDelegate
-
-- (void)stream:(NSStream *)stream handleEvent:(NSStreamEvent)event {
-//  NSDictionary *logLookup = @{
-//    @(NSStreamEventEndEncountered):     @"END",
-//    @(NSStreamEventErrorOccurred):      [NSString stringWithFormat:@"ERROR:%@", [stream streamError]],
-//    @(NSStreamEventHasBytesAvailable):  @"HASBYTES",
-//    @(NSStreamEventHasSpaceAvailable):  @"HASSPACE",
-//    @(NSStreamEventNone):               @"NONE",
-//    @(NSStreamEventOpenCompleted):      @"OPEN",
-//  };
-//
-//  NSLog(@"STREAM:%@:%@", stream == _readStream ? @"IN" : @"OUT", logLookup[@(event)]);
+- (NSUInteger)heldBytes {
+  return __sync_fetch_and_add(&_heldBytes, 0);
+}
 
-  switch (event) {
-    case NSStreamEventOpenCompleted:{
-      break;
-    }
+- (BOOL)readingPaused {
+  return _transport.readingPaused;
+}
 
-    case NSStreamEventHasBytesAvailable: {
-      [self streamRead];
-      break;
-    }
+- (void)holdBytes:(NSUInteger)length {
+  __sync_add_and_fetch(&_heldBytes, length);
+  [self performUpdateReadingPaused];
+}
 
-    case NSStreamEventHasSpaceAvailable:{
-      _writeStreamHasSpace = YES;
-      [self streamWrite];
-      break;
-    }
+- (void)releaseBytes:(NSUInteger)length {
+  __sync_sub_and_fetch(&_heldBytes, length);
+  [self performUpdateReadingPaused];
+}
 
-    case NSStreamEventEndEncountered:{
-      [self close];
-      break;
-    }
+// The transport is only used from the thread the connection was opened on
+- (void)performUpdateReadingPaused {
+  if (!_thread || [NSThread currentThread] == _thread) {
+    [self updateReadingPaused];
+  }
 
-    case NSStreamEventErrorOccurred:{
-      // Delegate: DidEncounterStreamError
-      for (id<SubImapConnectionDelegate>delegate in _delegates) {
-        if ([delegate respondsToSelector:@selector(connection:didEncounterStreamError:)]) {
-          [delegate connection:self didEncounterStreamError:stream.streamError];
-        }
-      }
+  else if (_eventLoop) {
+    __weak SubImapConnection *weakSelf = self;
 
-      break;
-    }
+    [_eventLoop performBlock:^{
+      [weakSelf updateReadingPaused];
+    }];
+  }
 
-    case NSStreamEventNone:
-    default:
-      break;
+  else {
+    [self performSelector:@selector(updateReadingPaused) onThread:_thread withObject:nil waitUntilDone:NO];
+  }
+}
+
+- (void)updateReadingPaused {
+  NSUInteger heldBytes = self.heldBytes;
+  NSUInteger highWaterMark = self.readHighWaterMark;
+
+  if (!_transport.readingPaused && highWaterMark && heldBytes > highWaterMark) {
+    _transport.readingPaused = YES;
+  }
+
+  else if (_transport.readingPaused && (!highWaterMark || heldBytes <= self.readLowWaterMark)) {
+    _transport.readingPaused = NO;
+  }
+}
+
+#pragma mark -
+
+#pragma mark SubImapTransportDelegate
+
+- (void)transportDidOpen:(id<SubImapTransport>)transport {
+  // Opened once STARTTLS has been negotiated
+  if (_didOpen || _startTLSState != SubImapConnectionStartTLSStateNone) {
+    return;
   }
 
+  [self didOpen];
+}
+
+- (void)didOpen {
+  _didOpen = YES;
+
   // Delegate: DidOpen
-  if (!_didOpen && [self isOpen]) {
-    _didOpen = YES;
+  for (id<SubImapConnectionDelegate>delegate in [_delegates delegatesForEvent:SubImapConnectionEventDidOpen]) {
+    [delegate connectionDidOpen:self];
+  }
+}
 
-    for (id<SubImapConnectionDelegate>delegate in _delegates) {
-      if ([delegate respondsToSelector:@selector(connectionDidOpen:)]) {
-        [delegate connectionDidOpen:self];
-      }
-    }
+- (void)transportHasBytesAvailable:(id<SubImapTransport>)transport {
+  [self streamRead];
+}
+
+- (void)transportHasSpaceAvailable:(id<SubImapTransport>)transport {
+  _transportHasSpace = YES;
+  [self streamWrite];
+}
+
+- (void)transportDidEnd:(id<SubImapTransport>)transport {
+  [self close];
+}
+
+- (void)transport:(id<SubImapTransport>)transport didFailWithError:(NSError *)error {
+  // Delegate: DidEncounterStreamError
+  for (id<SubImapConnectionDelegate>delegate in [_delegates delegatesForEvent:SubImapConnectionEventDidEncounterStreamError]) {
+    [delegate connection:self didEncounterStreamError:error];
+  }
+
+  // The connection can't be used any more
+  if (_didOpen && ![_transport isOpen]) {
+    [self close];
   }
 }
 
 - (void)streamWrite {
   // The write stream is not ready
-  if (!_writeStreamHasSpace) {
+  if (!_transportHasSpace) {
     return;
   }
 
-  // The write stream is ready, and we have data to write
-  else if (_activeLiteralData || _dataQueue.count) {
-    NSData *delegateData = nil;
+  // Waiting for a continuation response before writing the literal
+  if (_activeLiteralData && !_canWriteLiteralData) {
+    return;
+  }
 
-    // Write pending literal data
-    if (_activeLiteralData) {
-      if (_canWriteLiteralData) {
-        [_writeStream write:[_activeLiteralData bytes] maxLength:[_activeLiteralData length]];
-        delegateData = _activeLiteralData;
+  NSMutableArray *buffers = [NSMutableArray array];
 
-        // Clear active literal
-        _canWriteLiteralData = NO;
-        _activeLiteralData = nil;
+  // Write pending literal data
+  if (_activeLiteralData) {
+    [buffers addObject:_activeLiteralData];
 
-        // We wrote data to the stream
-        _writeStreamHasSpace = NO;
-      }
-    }
+    // Clear active literal
+    _canWriteLiteralData = NO;
+    _activeLiteralData = nil;
+  }
 
-    // Write data from queue
-    else {
-      SubImapConnectionData *data = [_dataQueue objectAtIndex:0];
-      [_dataQueue removeObjectAtIndex:0];
-
-      // Literal data
-      if ([data isLiteral]) {
-        // Create literal marker
-        NSString *literalMarkerFormat = self.supportLiteralPlus ? @"{%lu+}\r\n" : @"{%lu}\r\n";
-        NSString *literalMarker = [NSString stringWithFormat:literalMarkerFormat, [data.data length]];
-        NSData *literalMarkerData = [literalMarker dataUsingEncoding:NSASCIIStringEncoding];
-        delegateData = literalMarkerData;
-
-        // Write literal marker to stream
-        [_writeStream write:[literalMarkerData bytes] maxLength:[literalMarkerData length]];
-
-        // With LITERAL+ support, we can just write our data without
-        // waiting for a conitinuation response
-        if (self.supportLiteralPlus) {
-          [_writeStream write:[data.data bytes] maxLength:[data.data length]];
-          NSMutableData *mdata = [NSMutableData dataWithData:delegateData];
-          [mdata appendData:data.data];
-          delegateData = mdata;
-        }
-
-        // Without LITERAL+ support, we have to queue our literal data
-        // Our handleResponseData method will then check for continuation
-        // responses and set the _canWriteLiteral flag
-        else {
-          _activeLiteralData = data.data;
-        }
+  // Gather everything queued up to the next synchronizing literal into
+  // one write
+  NSUInteger count = 0;
+
+  while (count < _dataQueue.count && !_activeLiteralData) {
+    SubImapConnectionData *data = [_dataQueue objectAtIndex:count++];
+
+    // Literal data
+    if ([data isLiteral]) {
+      NSUInteger maximumLength = self.literalPlusMaximumLength;
+      BOOL nonSynchronizing = self.supportLiteralPlus && (!maximumLength || [data.data length] <= maximumLength);
+
+      [buffers addObject:[self literalMarkerForLength:[data.data length] nonSynchronizing:nonSynchronizing]];
+
+      // With LITERAL+ support, we can just write our data without
+      // waiting for a conitinuation response
+      if (nonSynchronizing) {
+        [buffers addObject:data.data];
       }
 
-      // Normal data
+      // Without LITERAL+ support, we have to queue our literal data
+      // Our handleResponseData method will then check for continuation
+      // responses and set the _canWriteLiteral flag
       else {
-        // Write to stream
-        [_writeStream write:[data.data bytes] maxLength:[data.data length]];
-        delegateData = data.data;
+        _activeLiteralData = data.data;
       }
-
-      // We wrote data to the stream
-      _writeStreamHasSpace = NO;
     }
 
-    // Delegate: DidSendData
-    for (id<SubImapConnectionDelegate>delegate in _delegates) {
-      if ([delegate respondsToSelector:@selector(connection:didSendData:)]) {
-        [delegate connection:self didSendData:delegateData];
-      }
+    // Normal data
+    else {
+      [buffers addObject:data.data];
     }
   }
 
+  [_dataQueue removeObjectsInRange:NSMakeRange(0, count)];
+
   // The write stream is ready, but we don't have any data to write
-  else {
+  if (!buffers.count) {
     // Delegate: HasSpace
-    for (id<SubImapConnectionDelegate>delegate in _delegates) {
-      if ([delegate respondsToSelector:@selector(connectionHasSpace:)]) {
-        [delegate connectionHasSpace:self];
-      }
+    for (id<SubImapConnectionDelegate>delegate in [_delegates delegatesForEvent:SubImapConnectionEventHasSpace]) {
+      [delegate connectionHasSpace:self];
+    }
+
+    return;
+  }
+
+  [_transport writeBuffers:buffers];
+
+  // We wrote data to the stream
+  _transportHasSpace = NO;
+
+  // Delegate: DidSendData
+  for (id<SubImapConnectionDelegate>delegate in [_delegates delegatesForEvent:SubImapConnectionEventDidSendData]) {
+    for (NSData *buffer in buffers) {
+      [delegate connection:self didSendData:buffer];
     }
   }
 }
 
+- (NSData *)literalMarkerForLength:(NSUInteger)length nonSynchronizing:(BOOL)nonSynchronizing {
+  char marker[25];
+  NSUInteger markerLength = 0;
+
+  marker[markerLength++] = '{';
+  markerLength += SubImapFormatUnsignedInteger(marker + markerLength, length);
+
+  if (nonSynchronizing) {
+    marker[markerLength++] = '+';
+  }
+
+  memcpy(marker + markerLength, "}\r\n", 3);
+
+  return [NSData dataWithBytes:marker length:markerLength + 3];
+}
+
 - (void)streamRead {
   // Read bytes from stream
   uint8_t buffer[self.readBufferSize];
-	NSInteger bytesRead = [_readStream read:buffer maxLength:self.readBufferSize];
+	NSInteger bytesRead = [_transport read:buffer maxLength:self.readBufferSize];
 
   // Read failed, or read 0 bytes
   if (bytesRead <= 0) {
@@ -358,160 +414,131 @@
   // Delegate: DidReceiveData
   NSData *delegateData;
 
-  for (id<SubImapConnectionDelegate>delegate in _delegates) {
-    if ([delegate respondsToSelector:@selector(connection:didReceiveData:)]) {
-      if (!delegateData) {
-        delegateData = [NSData dataWithBytes:buffer length:bytesRead];
-      }
-
-      [delegate connection:self didReceiveData:delegateData];
+  for (id<SubImapConnectionDelegate>delegate in [_delegates delegatesForEvent:SubImapConnectionEventDidReceiveData]) {
+    if (!delegateData) {
+      delegateData = [NSData dataWithBytes:buffer length:bytesRead];
     }
-  }
 
-  // Add bytes to buffer
-  [_readBuffer appendBytes:buffer length:bytesRead];
+    [delegate connection:self didReceiveData:delegateData];
+  }
 
-  // IMAP responses are terminated with CRLF
-  NSUInteger termLength = 2;
-  NSData *term = [NSData dataWithBytes:"\x0D\x0A" length:termLength];
+  // Split bytes into complete responses
+  NSArray *responses = [_framer responsesByAppendingBytes:buffer length:bytesRead];
 
-  // Calculate starting position
-  NSUInteger bufferLength = [_readBuffer length];
-  NSUInteger scannedPosition = bufferLength - bytesRead;
+  // The server waits for the TLS handshake after its STARTTLS response, so
+  // nothing else arrives with it
+  if (_startTLSState != SubImapConnectionStartTLSStateNone) {
+    for (NSUInteger idx = 0; idx < responses.count; idx++) {
+      BOOL followed = idx + 1 < responses.count || [_framer bufferedLength];
+      [self negotiateStartTLSWithResponseData:responses[idx] followedByBytes:followed];
 
-  while (1) {
-    // Nothing left in the buffer
-    if (bufferLength <= 0) {
-      break;
+      // Started TLS, or failed and closed
+      if (_startTLSState == SubImapConnectionStartTLSStateNone) {
+        break;
+      }
     }
 
-    // We are expecting literal bytes
-    if (_literalBytesToRead > 0) {
-      // Calculate how many bytes we can read
-      NSInteger availableBytes = MIN(bufferLength, _literalBytesToRead);
+    return;
+  }
 
-      // Pull literal bytes from buffer
-      [_responseBuffer appendBytes:[_readBuffer bytes] length:availableBytes];
-      [_readBuffer replaceBytesInRange:NSMakeRange(0, availableBytes) withBytes:NULL length:0];
+  // Objects made while handling each response are freed before the next
+  for (NSData *response in responses) @autoreleasepool {
+    [self handleResponseData:response];
+  }
 
-      // Reset scan positions
-      _literalBytesToRead -= availableBytes;
-      bufferLength -= availableBytes;
-      scannedPosition = 0;
+  // Delegate: DidReceiveResponseDataBatch
+  if (responses.count) {
+    for (id<SubImapConnectionDelegate>delegate in [_delegates delegatesForEvent:SubImapConnectionEventDidReceiveResponseDataBatch]) {
+      [delegate connection:self didReceiveResponseDataBatch:responses];
     }
+  }
+}
 
-    // We are not expecting literal bytes
-    if (_literalBytesToRead <= 0) {
-      // Not enough data for a full term yet
-      if (bufferLength < termLength) {
-        break;
-      }
+- (void)handleResponseData:(NSData *)data {
+  // Delegate: DidReceiveResponseData
+  for (id<SubImapConnectionDelegate>delegate in [_delegates delegatesForEvent:SubImapConnectionEventDidReceiveResponseData]) {
+    [delegate connection:self didReceiveResponseData:data];
+  }
 
-      // Since we've already scanned some of the previous
-      // buffer, we only need to rescan enough of it to
-      // ensure we didn't miss our term
-      //  .             .             .             .
-      // |B|B|B|B|B| |A|B|B|B|B| |A|A|B|B|B| |A|A|A|B|B|
-      //  ^ ^ ^       ^ ^ ^       ^ ^ ^         ^ ^ ^
-      NSUInteger scanPosition = (scannedPosition > termLength - 1)
-        ? scannedPosition - termLength + 1
-        : 0;
-
-      // Scan for the term
-      NSRange eol = [_readBuffer rangeOfData:term options:0 range:NSMakeRange(scanPosition, bufferLength - scanPosition)];
-
-      // If the term is not found, wait for more bytes
-      if (eol.location == NSNotFound) {
-        break;
+  // Write queued literal data if this is a continuation response
+  const char *bytes = [data bytes];
+  if (bytes != nil && bytes[0] == '+' && _activeLiteralData) {
+    _canWriteLiteralData = YES;
+    [self streamWrite];
+  }
+}
+
+#pragma mark STARTTLS
+
+- (void)negotiateStartTLSWithResponseData:(NSData *)data followedByBytes:(BOOL)followed {
+  const char *bytes = [data bytes];
+  NSUInteger length = [data length];
+
+  switch (_startTLSState) {
+    case SubImapConnectionStartTLSStateAwaitingGreeting: {
+      // A PREAUTH or BYE greeting can't be upgraded
+      if (length < 5 || strncmp(bytes, "* OK ", 5) != 0) {
+        [self failStartTLS];
+        return;
       }
 
-      // Pull response from buffer
-      NSUInteger responseLength = eol.location + eol.length;
-      [_responseBuffer appendBytes:[_readBuffer bytes] length:responseLength];
-      [_readBuffer replaceBytesInRange:NSMakeRange(0, responseLength) withBytes:NULL length:0];
+      _startTLSState = SubImapConnectionStartTLSStateAwaitingResponse;
+      [self write:[SubImapConnectionData dataWithString:@SubImapConnectionStartTLSTag " STARTTLS\r\n"]];
+      break;
+    }
 
-      // Reset scan positions
-      bufferLength -= responseLength;
-      scannedPosition = 0;
+    case SubImapConnectionStartTLSStateAwaitingResponse: {
+      // Untagged responses before the result
+      if (length && bytes[0] == '*') {
+        return;
+      }
 
-      // We have to check if there is a literal to follow...
-      _literalBytesToRead += [self bytesForLiteralMarkerInResponseBuffer];
+      const char *ok = SubImapConnectionStartTLSTag " OK";
 
-      // If there are no more literal bytes to follow, we have a complete response
-      if (_literalBytesToRead <= 0) {
-        // Handle response
-        [self handleResponseData:_responseBuffer];
+      if (length < strlen(ok) || strncmp(bytes, ok, strlen(ok)) != 0) {
+        [self failStartTLS];
+        return;
+      }
 
-        // Reset buffer
-        _responseBuffer = [NSMutableData data];
+      // Bytes read with the result were sent before the handshake, so they
+      // weren't protected by it and may have been injected (CVE-2011-0411)
+      if (followed) {
+        [self failStartTLS];
+        return;
       }
-    }
 
-    // continue;
-  }
-}
+      // Nothing received in plain text carries over
+      [_framer reset];
 
-/*
- * Checks the responseBuffer for a literal marker. It is
- * assumed that the buffer is terminated by a CRLF.
- *
- * Returns: the number of bytes specified in the marker,
- *          or 0 if none found
- */
-- (NSUInteger)bytesForLiteralMarkerInResponseBuffer {
-  NSUInteger bufferLength = [_responseBuffer length];
-
-  // {1}\r\n
-  if (bufferLength < 5) {
-    return 0;
-  }
-
-  // Literal markers take the form of: {123}\r\n
-  // We want to start scanning from the } character, so
-  // here we subtract the length of the CRLF term + 1
-  NSInteger bracePos = bufferLength - 2 - 1;
-  NSInteger idx = bracePos;
-
-  // Since we are scanning backwards, we can exit out right
-  // away if we don't see the term and end literal character }
-  const char *bytes = [_responseBuffer bytes];
-  const char *character = &bytes[idx];
-
-  if (*character != '}') return 0;
-
-  // Start scanning backwards
-  while (idx--) {
-    character = &bytes[idx];
-
-    // Are we at the end of the literal?
-    if (*character == '{') {
-      character = &bytes[idx + 1];
-      return [[[NSString alloc] initWithBytes:character length:bracePos - 1 encoding:NSASCIIStringEncoding] integerValue];
-    }
+      if (![_transport startTLS]) {
+        [self failStartTLS];
+        return;
+      }
 
-    // If the character is not a digit, this isn't a literal
-    if (*character < '0' || *character > '9') {
+      _startTLSState = SubImapConnectionStartTLSStateNone;
+      [self didOpen];
       break;
     }
+
+    case SubImapConnectionStartTLSStateNone:
+    default:
+      break;
   }
-  
-  return 0;
 }
 
-- (void)handleResponseData:(NSData *)data {
-  // Delegate: DidReceiveResponseData
-  for (id<SubImapConnectionDelegate>delegate in _delegates) {
-    if ([delegate respondsToSelector:@selector(connection:didReceiveResponseData:)]) {
-      [delegate connection:self didReceiveResponseData:data];
-    }
-  }
+- (void)failStartTLS {
+  _startTLSState = SubImapConnectionStartTLSStateNone;
 
-  // Write queued literal data if this is a continuation response
-  const char *bytes = [data bytes];
-  if (bytes != nil && bytes[0] == '+' && _activeLiteralData) {
-    _canWriteLiteralData = YES;
-    [self streamWrite];
+  NSError *error = [NSError errorWithDomain:SubImapConnectionErrorDomain code:SubImapConnectionErrorStartTLSFailed userInfo:@{
+    NSLocalizedDescriptionKey: @"Unable to start TLS with the server.",
+  }];
+
+  // Delegate: DidEncounterStreamError
+  for (id<SubImapConnectionDelegate>delegate in [_delegates delegatesForEvent:SubImapConnectionEventDidEncounterStreamError]) {
+    [delegate connection:self didEncounterStreamError:error];
   }
+
+  [self close];
 }
 
 @end
\ No newline at end of file
@@ -21,6 +21,12 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+/*
+ * Writes the decimal digits of value to buffer, which must have room for
+ * 20 bytes, and returns how many were written.
+ */
+NSUInteger SubImapFormatUnsignedInteger(char *buffer, unsigned long long value);
+
 @interface SubImapConnectionData : NSObject
 
 @property NSData *data;
@@ -32,12 +38,17 @@
 + (id)dataWithQuotedString:(NSString *)string;
 + (id)literalDataWithString:(NSString *)string encoding:(NSStringEncoding)encoding;
 + (id)dataWithInteger:(NSInteger)integer;
+
+/*
+ * These return shared objects, so they must not be modified.
+ */
 + (id)CRLF;
 + (id)SP;
 
 /*
  * Tries to reduce the number of stream writes by concatinating
- * adjacent non-literal objects.
+ * adjacent non-literal objects. Runs of non-literals are joined into a
+ * new buffer; the given objects are not modified.
  *
  * The dataList is expected to contain only ConnectionData
  * objects. Result is undefined otherwise.
@@ -23,6 +23,22 @@
 
 #import "SubImapConnectionData.h"
 
+NSUInteger SubImapFormatUnsignedInteger(char *buffer, unsigned long long value) {
+  char digits[20];
+  NSUInteger count = 0;
+
+  do {
+    digits[count++] = '0' + (value % 10);
+    value /= 10;
+  } while (value);
+
+  for (NSUInteger i = 0; i < count; i++) {
+    buffer[i] = digits[count - i - 1];
+  }
+
+  return count;
+}
+
 @implementation SubImapConnectionData
 
 + (id)data:(NSData *)data {
@@ -48,31 +64,64 @@
 }
 
 + (id)dataWithInteger:(NSInteger)integer {
-  return [self dataWithString:[NSString stringWithFormat:@"%ld", integer]];
+  char buffer[21];
+  NSUInteger length = 0;
+  unsigned long long value = integer;
+
+  if (integer < 0) {
+    buffer[length++] = '-';
+    value = -value;
+  }
+
+  length += SubImapFormatUnsignedInteger(buffer + length, value);
+
+  return [[self alloc] initWithData:[NSData dataWithBytes:buffer length:length] literal:NO];
 }
 
 + (id)CRLF {
-  return [[self alloc] initWithData:[NSData dataWithBytes:"\x0D\x0A" length:2] literal:NO];
+  static SubImapConnectionData *CRLF;
+  static dispatch_once_t onceToken;
+
+  dispatch_once(&onceToken, ^{
+    CRLF = [[self alloc] initWithData:[NSData dataWithBytes:"\x0D\x0A" length:2] literal:NO];
+  });
+
+  return CRLF;
 }
 
 + (id)SP {
-  return [[self alloc] initWithData:[NSData dataWithBytes:" " length:1] literal:NO];
+  static SubImapConnectionData *SP;
+  static dispatch_once_t onceToken;
+
+  dispatch_once(&onceToken, ^{
+    SP = [[self alloc] initWithData:[NSData dataWithBytes:" " length:1] literal:NO];
+  });
+
+  return SP;
 }
 
 + (NSArray *)compressDataList:(NSArray *)dataList {
-  NSMutableArray *list = [NSMutableArray array];
-  NSMutableData *buffer;
-
-  for (SubImapConnectionData *data in dataList) {
-    // Concat two non-literal data objects if they are side-by-side
-    if (!data.isLiteral && list.lastObject && ![list.lastObject isLiteral]) {
-      buffer = [[list.lastObject data] mutableCopy];
-      [list removeLastObject];
-      [buffer appendData:data.data];
-      data.data = buffer;
+  NSMutableArray *list = [NSMutableArray arrayWithCapacity:dataList.count];
+  NSUInteger count = dataList.count;
+  NSUInteger i = 0;
+
+  while (i < count) {
+    SubImapConnectionData *data = [dataList objectAtIndex:i++];
+
+    // Literals, and non-literals with nothing to join, are kept as they are
+    if (data.isLiteral || i == count || [[dataList objectAtIndex:i] isLiteral]) {
+      [list addObject:data];
+      continue;
+    }
+
+    // Join the whole run of adjacent non-literals into one buffer
+    NSMutableData *buffer = [NSMutableData dataWithData:data.data];
+
+    while (i < count && ![[dataList objectAtIndex:i] isLiteral]) {
+      [buffer appendData:[[dataList objectAtIndex:i++] data]];
     }
 
-    [list addObject:data];
+    [list addObject:[self data:buffer]];
   }
 
   return list;
@@ -17,4 +17,10 @@
 - (void)connection:(SubImapConnection *)connection didReceiveData:(NSData *)data;
 - (void)connection:(SubImapConnection *)connection didReceiveResponseData:(NSData *)data;
 - (void)connection:(SubImapConnection *)connection didEncounterStreamError:(NSError *)error;
+
+/*
+ * Called once per read with every response completed by it, after
+ * connection:didReceiveResponseData: has been called for each of them.
+ */
+- (void)connection:(SubImapConnection *)connection didReceiveResponseDataBatch:(NSArray *)dataList;
 @end
\ No newline at end of file
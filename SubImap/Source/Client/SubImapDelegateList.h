@@ -0,0 +1,55 @@
+// SubImapDelegateList.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/*
+ * SubImapDelegateList
+ *
+ * Holds the delegates of a SubImapConnection or SubImapClient, grouped by
+ * the optional methods they implement.
+ *
+ * Each method is an "event", identified by its index in the selector list
+ * the list was created with. Delegates are checked with respondsToSelector:
+ * once when they are added, so sending an event only loops over the
+ * delegates that implement it.
+ */
+@interface SubImapDelegateList : NSObject
+
+- (id)initWithSelectors:(const SEL *)selectors count:(NSUInteger)count;
+
+/*
+ * Adding a delegate twice has no effect.
+ */
+- (void)addDelegate:(id)delegate;
+- (void)removeDelegate:(id)delegate;
+
+/*
+ * The delegates that implement an event's method, in the order they were
+ * added.
+ *
+ * The returned array is not changed by later calls to addDelegate: or
+ * removeDelegate:, so delegates can add or remove themselves while it is
+ * being enumerated.
+ */
+- (NSArray *)delegatesForEvent:(NSUInteger)event;
+
+@end
\ No newline at end of file
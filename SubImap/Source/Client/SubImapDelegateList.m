@@ -0,0 +1,98 @@
+// SubImapDelegateList.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapDelegateList.h"
+
+@implementation SubImapDelegateList {
+  NSArray *_selectors;
+  NSMutableArray *_delegates;
+
+  // One immutable array of delegates per event, replaced whenever the
+  // delegates change
+  NSArray *_delegatesByEvent;
+}
+
+- (id)initWithSelectors:(const SEL *)selectors count:(NSUInteger)count {
+  self = [super init];
+
+  if (self) {
+    NSMutableArray *selectorNames = [NSMutableArray arrayWithCapacity:count];
+    NSMutableArray *delegatesByEvent = [NSMutableArray arrayWithCapacity:count];
+
+    for (NSUInteger event = 0; event < count; event++) {
+      [selectorNames addObject:NSStringFromSelector(selectors[event])];
+      [delegatesByEvent addObject:@[]];
+    }
+
+    _selectors = selectorNames;
+    _delegates = [NSMutableArray array];
+    _delegatesByEvent = delegatesByEvent;
+  }
+
+  return self;
+}
+
+#pragma mark -
+
+- (void)addDelegate:(id)delegate {
+  if (!delegate || [_delegates indexOfObjectIdenticalTo:delegate] != NSNotFound) {
+    return;
+  }
+
+  [_delegates addObject:delegate];
+  [self updateDelegatesByEvent];
+}
+
+- (void)removeDelegate:(id)delegate {
+  if ([_delegates indexOfObjectIdenticalTo:delegate] == NSNotFound) {
+    return;
+  }
+
+  [_delegates removeObjectIdenticalTo:delegate];
+  [self updateDelegatesByEvent];
+}
+
+- (NSArray *)delegatesForEvent:(NSUInteger)event {
+  return [_delegatesByEvent objectAtIndex:event];
+}
+
+- (void)updateDelegatesByEvent {
+  NSMutableArray *delegatesByEvent = [NSMutableArray arrayWithCapacity:_selectors.count];
+
+  for (NSString *selectorName in _selectors) {
+    SEL selector = NSSelectorFromString(selectorName);
+    NSMutableArray *delegates = [NSMutableArray array];
+
+    for (id delegate in _delegates) {
+      if ([delegate respondsToSelector:selector]) {
+        [delegates addObject:delegate];
+      }
+    }
+
+    [delegatesByEvent addObject:[delegates copy]];
+  }
+
+  _delegatesByEvent = delegatesByEvent;
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,109 @@
+// SubImapEventLoop.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapTypes.h"
+
+enum {
+  SubImapEventLoopEventRead  = 1 << 0,
+  SubImapEventLoopEventWrite = 1 << 1,
+
+  // An error or hangup, which is reported whether it was asked for or not
+  SubImapEventLoopEventError = 1 << 2,
+};
+
+@class SubImapEventLoop;
+
+@protocol SubImapEventLoopHandler <NSObject>
+- (void)eventLoop:(SubImapEventLoop *)eventLoop handleEvents:(NSUInteger)events forDescriptor:(int)descriptor;
+@end
+
+/*
+ * SubImapEventLoop
+ *
+ * A thread waiting on many non-blocking sockets at once with epoll, or
+ * poll where epoll is not available. A few event loops can drive
+ * thousands of SubImapConnections, instead of a pair of run loop streams
+ * for each of them:
+ *
+ *   SubImapEventLoop *eventLoop = [SubImapEventLoop eventLoop];
+ *   [eventLoop start];
+ *
+ *   SubImapConnection *connection = [SubImapConnection connectionWithHost:@"127.0.0.1" port:143 security:SubImapConnectionSecurityNone];
+ *   connection.eventLoop = eventLoop;
+ *
+ *   [eventLoop performBlock:^{
+ *     [connection open];
+ *   }];
+ *
+ * Connections on an event loop, and the clients using them, call their
+ * delegates on the event loop's thread, and must only be used from it.
+ *
+ * NSTimers scheduled on the event loop thread's run loop fire between
+ * waits, so SubImapClient command deadlines work as usual.
+ */
+@interface SubImapEventLoop : NSObject
+
+@property (readonly) SubImapEventLoopBackend backend;
+
+/*
+ * Number of descriptors being watched.
+ */
+@property (readonly) NSUInteger descriptorCount;
+
++ (instancetype)eventLoop;
+
+/*
+ * Falls back to poll if the backend is not available.
+ */
+- (id)initWithBackend:(SubImapEventLoopBackend)backend;
+
+/*
+ * Starts the event loop's thread.
+ */
+- (BOOL)start;
+
+/*
+ * Stops the event loop's thread after its current pass. Descriptors are
+ * left open.
+ */
+- (void)stop;
+
+- (BOOL)isCurrentThread;
+
+/*
+ * Runs a block on the event loop's thread. Safe to call from any thread.
+ */
+- (void)performBlock:(void (^)(void))block;
+
+#pragma mark Descriptors
+
+/*
+ * These must be called on the event loop's thread. The handler is
+ * retained until the descriptor is removed, which must be done before
+ * the descriptor is closed.
+ */
+- (BOOL)addDescriptor:(int)descriptor events:(NSUInteger)events handler:(id<SubImapEventLoopHandler>)handler;
+- (BOOL)setEvents:(NSUInteger)events forDescriptor:(int)descriptor;
+- (void)removeDescriptor:(int)descriptor;
+
+@end
\ No newline at end of file
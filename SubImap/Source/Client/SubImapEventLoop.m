@@ -0,0 +1,378 @@
+// SubImapEventLoop.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapEventLoop.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <unistd.h>
+
+#ifdef __linux__
+  #include <sys/epoll.h>
+  #define SUBIMAP_EVENT_LOOP_EPOLL 1
+#endif
+
+// Events returned by one wait
+#define SUBIMAP_EVENT_LOOP_MAX_EVENTS 256
+
+@implementation SubImapEventLoop {
+  NSThread *_thread;
+  volatile BOOL _stopped;
+
+  // Handlers and the events they are watching for, by descriptor
+  NSMutableDictionary *_handlers;
+  NSMutableDictionary *_events;
+
+  // epoll
+  int _epollDescriptor;
+
+  // poll, rebuilt from _events when they change
+  NSMutableData *_pollDescriptors;
+  BOOL _pollDescriptorsChanged;
+
+  // Blocks from performBlock:, and a pipe to wake the loop for them
+  NSMutableArray *_pendingBlocks;
+  BOOL _wakePending;
+  int _wakeDescriptors[2];
+}
+
++ (instancetype)eventLoop {
+  return [[self alloc] initWithBackend:SubImapEventLoopBackendDefault];
+}
+
+- (id)init {
+  return [self initWithBackend:SubImapEventLoopBackendDefault];
+}
+
+- (id)initWithBackend:(SubImapEventLoopBackend)backend {
+  self = [super init];
+
+  if (self) {
+    _handlers = [NSMutableDictionary dictionary];
+    _events = [NSMutableDictionary dictionary];
+    _pendingBlocks = [NSMutableArray array];
+    _epollDescriptor = -1;
+
+    if (pipe(_wakeDescriptors) != 0) {
+      return nil;
+    }
+
+    for (int i = 0; i < 2; i++) {
+      fcntl(_wakeDescriptors[i], F_SETFL, fcntl(_wakeDescriptors[i], F_GETFL) | O_NONBLOCK);
+      fcntl(_wakeDescriptors[i], F_SETFD, FD_CLOEXEC);
+    }
+
+#ifdef SUBIMAP_EVENT_LOOP_EPOLL
+    if (backend != SubImapEventLoopBackendPoll) {
+      _epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+
+      struct epoll_event event = {0};
+      event.events = EPOLLIN;
+      event.data.fd = _wakeDescriptors[0];
+
+      if (_epollDescriptor >= 0 && epoll_ctl(_epollDescriptor, EPOLL_CTL_ADD, _wakeDescriptors[0], &event) != 0) {
+        close(_epollDescriptor);
+        _epollDescriptor = -1;
+      }
+    }
+#endif
+
+    _backend = _epollDescriptor >= 0 ? SubImapEventLoopBackendEpoll : SubImapEventLoopBackendPoll;
+
+    _pollDescriptors = [NSMutableData data];
+    _pollDescriptorsChanged = YES;
+  }
+
+  return self;
+}
+
+- (void)dealloc {
+  if (_epollDescriptor >= 0) {
+    close(_epollDescriptor);
+  }
+
+  close(_wakeDescriptors[0]);
+  close(_wakeDescriptors[1]);
+}
+
+- (NSUInteger)descriptorCount {
+  return _handlers.count;
+}
+
+#pragma mark Thread
+
+- (BOOL)start {
+  if (_thread) {
+    return NO;
+  }
+
+  _stopped = NO;
+  _thread = [[NSThread alloc] initWithTarget:self selector:@selector(run) object:nil];
+  [_thread setName:@"SubImapEventLoop"];
+  [_thread start];
+
+  return YES;
+}
+
+- (void)stop {
+  _stopped = YES;
+  [self wake];
+}
+
+- (BOOL)isCurrentThread {
+  return [NSThread currentThread] == _thread;
+}
+
+- (void)performBlock:(void (^)(void))block {
+  BOOL wake;
+
+  @synchronized (_pendingBlocks) {
+    [_pendingBlocks addObject:[block copy]];
+    wake = !_wakePending;
+    _wakePending = YES;
+  }
+
+  if (wake) {
+    [self wake];
+  }
+}
+
+- (void)wake {
+  char byte = 0;
+  write(_wakeDescriptors[1], &byte, 1);
+}
+
+- (void)run {
+  NSRunLoop *runLoop = [NSRunLoop currentRunLoop];
+
+  while (!_stopped) @autoreleasepool {
+    // Fire any timers that are due, and wait no longer than the next one
+    NSDate *limitDate = [runLoop limitDateForMode:NSDefaultRunLoopMode];
+    int timeout = -1;
+
+    if (limitDate) {
+      NSTimeInterval interval = [limitDate timeIntervalSinceNow];
+      timeout = interval <= 0 ? 0 : (int)MIN(ceil(interval * 1000), INT_MAX);
+    }
+
+    [self waitWithTimeout:timeout];
+    [self performPendingBlocks];
+  }
+
+  _thread = nil;
+}
+
+- (void)performPendingBlocks {
+  NSArray *blocks;
+
+  @synchronized (_pendingBlocks) {
+    if (!_pendingBlocks.count) return;
+
+    blocks = [_pendingBlocks copy];
+    [_pendingBlocks removeAllObjects];
+  }
+
+  for (void (^block)(void) in blocks) {
+    block();
+  }
+}
+
+- (void)drainWakeDescriptor {
+  char buffer[64];
+  while (read(_wakeDescriptors[0], buffer, sizeof(buffer)) > 0);
+
+  @synchronized (_pendingBlocks) {
+    _wakePending = NO;
+  }
+}
+
+#pragma mark Descriptors
+
+- (BOOL)addDescriptor:(int)descriptor events:(NSUInteger)events handler:(id<SubImapEventLoopHandler>)handler {
+  if (descriptor < 0 || !handler || _handlers[@(descriptor)]) {
+    return NO;
+  }
+
+#ifdef SUBIMAP_EVENT_LOOP_EPOLL
+  if (_epollDescriptor >= 0) {
+    struct epoll_event event = {0};
+    event.events = [self epollEventsFromEvents:events];
+    event.data.fd = descriptor;
+
+    if (epoll_ctl(_epollDescriptor, EPOLL_CTL_ADD, descriptor, &event) != 0) {
+      return NO;
+    }
+  }
+#endif
+
+  _handlers[@(descriptor)] = handler;
+  _events[@(descriptor)] = @(events);
+  _pollDescriptorsChanged = YES;
+
+  return YES;
+}
+
+- (BOOL)setEvents:(NSUInteger)events forDescriptor:(int)descriptor {
+  if (!_handlers[@(descriptor)]) {
+    return NO;
+  }
+
+#ifdef SUBIMAP_EVENT_LOOP_EPOLL
+  if (_epollDescriptor >= 0) {
+    struct epoll_event event = {0};
+    event.events = [self epollEventsFromEvents:events];
+    event.data.fd = descriptor;
+
+    if (epoll_ctl(_epollDescriptor, EPOLL_CTL_MOD, descriptor, &event) != 0) {
+      return NO;
+    }
+  }
+#endif
+
+  _events[@(descriptor)] = @(events);
+  _pollDescriptorsChanged = YES;
+
+  return YES;
+}
+
+- (void)removeDescriptor:(int)descriptor {
+  if (!_handlers[@(descriptor)]) {
+    return;
+  }
+
+#ifdef SUBIMAP_EVENT_LOOP_EPOLL
+  if (_epollDescriptor >= 0) {
+    epoll_ctl(_epollDescriptor, EPOLL_CTL_DEL, descriptor, NULL);
+  }
+#endif
+
+  [_handlers removeObjectForKey:@(descriptor)];
+  [_events removeObjectForKey:@(descriptor)];
+  _pollDescriptorsChanged = YES;
+}
+
+#pragma mark Waiting
+
+- (void)waitWithTimeout:(int)timeout {
+#ifdef SUBIMAP_EVENT_LOOP_EPOLL
+  if (_epollDescriptor >= 0) {
+    [self epollWithTimeout:timeout];
+    return;
+  }
+#endif
+
+  [self pollWithTimeout:timeout];
+}
+
+// Handlers can add and remove descriptors while events are dispatched, so
+// each one is looked up again before it is called
+- (void)dispatchEvents:(NSUInteger)events forDescriptor:(int)descriptor {
+  id<SubImapEventLoopHandler> handler = _handlers[@(descriptor)];
+
+  if (handler) {
+    [handler eventLoop:self handleEvents:events forDescriptor:descriptor];
+  }
+}
+
+#ifdef SUBIMAP_EVENT_LOOP_EPOLL
+- (uint32_t)epollEventsFromEvents:(NSUInteger)events {
+  uint32_t epollEvents = 0;
+  if (events & SubImapEventLoopEventRead) epollEvents |= EPOLLIN;
+  if (events & SubImapEventLoopEventWrite) epollEvents |= EPOLLOUT;
+  return epollEvents;
+}
+
+- (void)epollWithTimeout:(int)timeout {
+  struct epoll_event epollEvents[SUBIMAP_EVENT_LOOP_MAX_EVENTS];
+  int count = epoll_wait(_epollDescriptor, epollEvents, SUBIMAP_EVENT_LOOP_MAX_EVENTS, timeout);
+
+  for (int i = 0; i < count; i++) {
+    int descriptor = epollEvents[i].data.fd;
+    uint32_t epollEvent = epollEvents[i].events;
+
+    if (descriptor == _wakeDescriptors[0]) {
+      [self drainWakeDescriptor];
+      continue;
+    }
+
+    NSUInteger events = 0;
+    if (epollEvent & EPOLLIN) events |= SubImapEventLoopEventRead;
+    if (epollEvent & EPOLLOUT) events |= SubImapEventLoopEventWrite;
+    if (epollEvent & (EPOLLERR | EPOLLHUP)) events |= SubImapEventLoopEventError;
+
+    [self dispatchEvents:events forDescriptor:descriptor];
+  }
+}
+#endif
+
+- (void)pollWithTimeout:(int)timeout {
+  // Rebuild the descriptor list, with the wake pipe first
+  if (_pollDescriptorsChanged) {
+    _pollDescriptorsChanged = NO;
+    [_pollDescriptors setLength:(_events.count + 1) * sizeof(struct pollfd)];
+
+    struct pollfd *pollDescriptors = [_pollDescriptors mutableBytes];
+    pollDescriptors[0].fd = _wakeDescriptors[0];
+    pollDescriptors[0].events = POLLIN;
+
+    NSUInteger i = 1;
+
+    for (NSNumber *descriptor in _events) {
+      NSUInteger events = [_events[descriptor] unsignedIntegerValue];
+
+      pollDescriptors[i].fd = [descriptor intValue];
+      pollDescriptors[i].events = 0;
+      if (events & SubImapEventLoopEventRead) pollDescriptors[i].events |= POLLIN;
+      if (events & SubImapEventLoopEventWrite) pollDescriptors[i].events |= POLLOUT;
+      i++;
+    }
+  }
+
+  struct pollfd *pollDescriptors = [_pollDescriptors mutableBytes];
+  NSUInteger pollDescriptorCount = [_pollDescriptors length] / sizeof(struct pollfd);
+
+  if (poll(pollDescriptors, (nfds_t)pollDescriptorCount, timeout) <= 0) {
+    return;
+  }
+
+  if (pollDescriptors[0].revents) {
+    [self drainWakeDescriptor];
+  }
+
+  // Handlers only mark the list as changed, so it stays valid here
+  for (NSUInteger i = 1; i < pollDescriptorCount; i++) {
+    short pollEvents = pollDescriptors[i].revents;
+    if (!pollEvents) continue;
+
+    NSUInteger events = 0;
+    if (pollEvents & POLLIN) events |= SubImapEventLoopEventRead;
+    if (pollEvents & POLLOUT) events |= SubImapEventLoopEventWrite;
+    if (pollEvents & (POLLERR | POLLHUP | POLLNVAL)) events |= SubImapEventLoopEventError;
+
+    [self dispatchEvents:events forDescriptor:pollDescriptors[i].fd];
+  }
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,55 @@
+// SubImapGmailMessageStore.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/*
+ * SubImapGmailMessageStore
+ *
+ * Keeps Gmail messages by X-GM-MSGID. Gmail shows a message in the
+ * mailbox of each of its labels, under a different UID in each, but its
+ * X-GM-MSGID is the same everywhere. SubImapTransaction
+ * gmailFetchTransactionWithMailbox:criteria:fields:store: uses a store to
+ * download each message once, and only records its UID in every other
+ * mailbox it is found in.
+ *
+ * Messages are kept in memory. Subclass and override the first three
+ * methods to keep them elsewhere, such as on disk.
+ */
+@interface SubImapGmailMessageStore : NSObject
+
++ (instancetype)store;
+
+- (BOOL)containsMessageWithID:(NSString *)messageID;
+- (NSDictionary *)messageWithID:(NSString *)messageID;
+- (void)storeMessage:(NSDictionary *)message withID:(NSString *)messageID;
+
+/*
+ * Records the UID a mailbox holds the message under.
+ */
+- (void)addUID:(NSUInteger)UID inMailbox:(NSString *)path forMessageID:(NSString *)messageID;
+
+/*
+ * Every mailbox the message has been seen in, mapped to its UID there.
+ */
+- (NSDictionary *)UIDsForMessageID:(NSString *)messageID;
+
+@end
\ No newline at end of file
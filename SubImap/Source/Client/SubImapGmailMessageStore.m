@@ -0,0 +1,73 @@
+// SubImapGmailMessageStore.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapGmailMessageStore.h"
+
+@implementation SubImapGmailMessageStore {
+  NSMutableDictionary *_messages;
+  NSMutableDictionary *_UIDs;
+}
+
++ (instancetype)store {
+  return [[self alloc] init];
+}
+
+- (id)init {
+  self = [super init];
+
+  if (self) {
+    _messages = [NSMutableDictionary dictionary];
+    _UIDs = [NSMutableDictionary dictionary];
+  }
+
+  return self;
+}
+
+- (BOOL)containsMessageWithID:(NSString *)messageID {
+  return _messages[messageID] != nil;
+}
+
+- (NSDictionary *)messageWithID:(NSString *)messageID {
+  return _messages[messageID];
+}
+
+- (void)storeMessage:(NSDictionary *)message withID:(NSString *)messageID {
+  _messages[messageID] = message;
+}
+
+- (void)addUID:(NSUInteger)UID inMailbox:(NSString *)path forMessageID:(NSString *)messageID {
+  NSMutableDictionary *UIDs = _UIDs[messageID];
+
+  if (!UIDs) {
+    UIDs = [NSMutableDictionary dictionary];
+    _UIDs[messageID] = UIDs;
+  }
+
+  UIDs[path] = @(UID);
+}
+
+- (NSDictionary *)UIDsForMessageID:(NSString *)messageID {
+  return _UIDs[messageID] ?: @{};
+}
+
+@end
\ No newline at end of file
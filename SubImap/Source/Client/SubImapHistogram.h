@@ -0,0 +1,69 @@
+// SubImapHistogram.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/*
+ * SubImapHistogram
+ *
+ * Records latencies with a fixed relative error, in the style of an HDR
+ * histogram: each power of two is split into 32 equal buckets, so a
+ * recorded value is off by less than 1/32 (about 3%) of itself. Memory
+ * is fixed regardless of how many values are recorded.
+ *
+ * Values are unsigned integers, usually nanoseconds. Values above 2^44
+ * (about 4.9 hours in nanoseconds) are recorded as 2^44.
+ */
+@interface SubImapHistogram : NSObject <NSCopying>
+
+@property (readonly) uint64_t count;
+@property (readonly) uint64_t min;
+@property (readonly) uint64_t max;
+@property (readonly) double mean;
+
++ (instancetype)histogram;
+
+- (void)recordValue:(uint64_t)value;
+
+/*
+ * Adds every value recorded by another histogram.
+ */
+- (void)addHistogram:(SubImapHistogram *)histogram;
+
+/*
+ * Returns the value below which the given percentage of recorded
+ * values fall. For example, 99.9 for the 99.9th percentile.
+ *
+ * Returns 0 if nothing has been recorded.
+ */
+- (uint64_t)valueAtPercentile:(double)percentile;
+
+- (void)reset;
+
+/*
+ * A summary suitable for logging or exporting:
+ *
+ *   "count", "min", "max", "mean",
+ *   "p50", "p90", "p99", "p999": (NSNumber *)
+ */
+- (NSDictionary *)dictionaryRepresentation;
+
+@end
\ No newline at end of file
@@ -0,0 +1,174 @@
+// SubImapHistogram.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapHistogram.h"
+
+// Every power of two is split into 2^SubImapHistogramSubBucketBits buckets
+#define SubImapHistogramSubBucketBits 5
+#define SubImapHistogramSubBucketCount (1 << SubImapHistogramSubBucketBits)
+
+// Largest value that can be recorded, as a power of two
+#define SubImapHistogramMaxValueBits 44
+#define SubImapHistogramMaxValue ((uint64_t)1 << SubImapHistogramMaxValueBits)
+
+// Values below 2 * SubImapHistogramSubBucketCount have a bucket each, and
+// every power of two above that has SubImapHistogramSubBucketCount
+#define SubImapHistogramBucketCount \
+  (2 * SubImapHistogramSubBucketCount + (SubImapHistogramMaxValueBits - SubImapHistogramSubBucketBits) * SubImapHistogramSubBucketCount)
+
+static NSUInteger SubImapHistogramIndexForValue(uint64_t value) {
+  if (value < 2 * SubImapHistogramSubBucketCount) {
+    return (NSUInteger)value;
+  }
+
+  // Number of bits beyond the sub bucket precision
+  NSUInteger bits = 64 - __builtin_clzll(value);
+  NSUInteger shift = bits - SubImapHistogramSubBucketBits - 1;
+  NSUInteger subBucket = (NSUInteger)(value >> shift) - SubImapHistogramSubBucketCount;
+
+  return 2 * SubImapHistogramSubBucketCount + (shift - 1) * SubImapHistogramSubBucketCount + subBucket;
+}
+
+static uint64_t SubImapHistogramHighestValueForIndex(NSUInteger index) {
+  if (index < 2 * SubImapHistogramSubBucketCount) {
+    return index;
+  }
+
+  NSUInteger shift = (index - 2 * SubImapHistogramSubBucketCount) / SubImapHistogramSubBucketCount + 1;
+  uint64_t top = (index - 2 * SubImapHistogramSubBucketCount) % SubImapHistogramSubBucketCount + SubImapHistogramSubBucketCount;
+
+  return ((top + 1) << shift) - 1;
+}
+
+@implementation SubImapHistogram {
+  uint64_t *_counts;
+  uint64_t _total;
+  uint64_t _min;
+}
+
++ (instancetype)histogram {
+  return [[self alloc] init];
+}
+
+- (id)init {
+  self = [super init];
+
+  if (self) {
+    _counts = calloc(SubImapHistogramBucketCount, sizeof(uint64_t));
+    [self reset];
+  }
+
+  return self;
+}
+
+- (void)dealloc {
+  free(_counts);
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+  SubImapHistogram *copy = [[[self class] allocWithZone:zone] init];
+  [copy addHistogram:self];
+  return copy;
+}
+
+#pragma mark -
+
+- (void)recordValue:(uint64_t)value {
+  value = MIN(value, SubImapHistogramMaxValue);
+
+  _counts[SubImapHistogramIndexForValue(value)]++;
+
+  _count++;
+  _total += value;
+  _min = MIN(_min, value);
+  _max = MAX(_max, value);
+}
+
+- (void)addHistogram:(SubImapHistogram *)histogram {
+  if (!histogram.count) {
+    return;
+  }
+
+  for (NSUInteger i = 0; i < SubImapHistogramBucketCount; i++) {
+    _counts[i] += histogram->_counts[i];
+  }
+
+  _count += histogram->_count;
+  _total += histogram->_total;
+  _min = MIN(_min, histogram->_min);
+  _max = MAX(_max, histogram->_max);
+}
+
+- (uint64_t)valueAtPercentile:(double)percentile {
+  if (!_count) {
+    return 0;
+  }
+
+  // Number of values at or below the requested percentile
+  uint64_t target = (uint64_t)ceil(MIN(MAX(percentile, 0), 100) / 100 * _count);
+  target = MAX(target, 1);
+
+  uint64_t seen = 0;
+
+  for (NSUInteger i = 0; i < SubImapHistogramBucketCount; i++) {
+    seen += _counts[i];
+
+    if (seen >= target) {
+      return MIN(SubImapHistogramHighestValueForIndex(i), _max);
+    }
+  }
+
+  return _max;
+}
+
+- (double)mean {
+  return _count ? (double)_total / _count : 0;
+}
+
+- (uint64_t)min {
+  return _count ? _min : 0;
+}
+
+- (void)reset {
+  memset(_counts, 0, SubImapHistogramBucketCount * sizeof(uint64_t));
+
+  _count = 0;
+  _total = 0;
+  _min = UINT64_MAX;
+  _max = 0;
+}
+
+- (NSDictionary *)dictionaryRepresentation {
+  return @{
+    @"count": @(self.count),
+    @"min":   @(self.min),
+    @"max":   @(self.max),
+    @"mean":  @(self.mean),
+    @"p50":   @([self valueAtPercentile:50]),
+    @"p90":   @([self valueAtPercentile:90]),
+    @"p99":   @([self valueAtPercentile:99]),
+    @"p999":  @([self valueAtPercentile:99.9]),
+  };
+}
+
+@end
\ No newline at end of file
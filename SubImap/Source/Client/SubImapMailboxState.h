@@ -0,0 +1,98 @@
+// SubImapMailboxState.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapResponse.h"
+
+/*
+ * SubImapMailboxState
+ *
+ * What is known about the selected mailbox: its size, UIDs and the flags
+ * of each message, kept up to date from SELECT, EXISTS, EXPUNGE, FETCH
+ * UID/FLAGS and VANISHED responses. SubImapClient maintains one for the
+ * selected mailbox.
+ *
+ * Sequence numbers map to UIDs through one array of 32 bit UIDs, with 0
+ * for messages whose UID has not been fetched yet. A burst of EXPUNGE
+ * responses for adjacent messages is applied as one move, so expunging
+ * many messages is not quadratic.
+ *
+ * Each message's flags are a bitset. Up to 63 distinct flags are tracked
+ * per mailbox; later ones are ignored.
+ */
+@interface SubImapMailboxState : NSObject
+
+@property (readonly) NSString *path;
+
+@property (readonly) BOOL readOnly;
+@property (readonly) NSUInteger UIDValidity;
+@property (readonly) NSUInteger UIDNext;
+@property (readonly) NSUInteger recent;
+
+/*
+ * The mailbox's FLAGS and PERMANENTFLAGS.
+ */
+@property (readonly) NSArray *flags;
+@property (readonly) NSArray *permanentFlags;
+
+/*
+ * The number of messages in the mailbox.
+ */
+@property (readonly) NSUInteger count;
+
++ (id)stateWithPath:(NSString *)path;
+
+/*
+ * Returns 0 if the message's UID is not known.
+ */
+- (NSUInteger)UIDForSequenceNumber:(NSUInteger)sequenceNumber;
+
+/*
+ * Returns NSNotFound if no message with a known UID has this one.
+ */
+- (NSUInteger)sequenceNumberForUID:(NSUInteger)UID;
+
+/*
+ * The messages whose UIDs have not been fetched yet. An incremental sync
+ * only needs to fetch these.
+ */
+- (NSIndexSet *)sequenceNumbersWithUnknownUIDs;
+
+/*
+ * Returns nil if the message's flags are not known.
+ */
+- (NSArray *)flagsForSequenceNumber:(NSUInteger)sequenceNumber;
+
+/*
+ * Flags are compared case-insensitively, as IMAP does. Messages whose
+ * flags are not known are never included.
+ */
+- (NSIndexSet *)sequenceNumbersWithFlag:(NSString *)flag;
+- (NSIndexSet *)sequenceNumbersWithoutFlag:(NSString *)flag;
+
+/*
+ * Updates the state from a response for the mailbox. Returns YES if the
+ * response was used.
+ */
+- (BOOL)handleResponse:(SubImapResponse *)response;
+
+@end
\ No newline at end of file
@@ -0,0 +1,434 @@
+// SubImapMailboxState.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapMailboxState.h"
+
+// Set in a message's flag bits once its flags have been fetched
+#define SubImapMailboxStateFlagsKnown (1ULL << 63)
+#define SubImapMailboxStateMaximumFlags 63
+
+@implementation SubImapMailboxState {
+  // Indexed by sequence number - 1
+  uint32_t *_UIDs;
+  uint64_t *_flagBits;
+  NSUInteger _length;
+  NSUInteger _capacity;
+
+  // Flag bit indexes, keyed by lowercase flag
+  NSMutableDictionary *_flagIndexes;
+  NSMutableArray *_flagNames;
+
+  // Adjacent expunged messages that are still in the arrays
+  NSUInteger _expungeLocation;
+  NSUInteger _expungeLength;
+}
+
++ (id)stateWithPath:(NSString *)path {
+  return [[self alloc] initWithPath:path];
+}
+
+- (id)initWithPath:(NSString *)path {
+  self = [super init];
+
+  if (self) {
+    _path = path;
+    _flagIndexes = [NSMutableDictionary dictionary];
+    _flagNames = [NSMutableArray array];
+
+    // System flags always have the same bits
+    for (NSString *flag in @[@"\\Seen", @"\\Answered", @"\\Flagged", @"\\Deleted", @"\\Draft", @"\\Recent"]) {
+      [self indexForFlag:flag create:YES];
+    }
+  }
+
+  return self;
+}
+
+- (void)dealloc {
+  free(_UIDs);
+  free(_flagBits);
+}
+
+- (NSUInteger)count {
+  [self applyExpunges];
+  return _length;
+}
+
+#pragma mark Sequence numbers
+
+- (NSUInteger)UIDForSequenceNumber:(NSUInteger)sequenceNumber {
+  [self applyExpunges];
+
+  if (!sequenceNumber || sequenceNumber > _length) {
+    return 0;
+  }
+
+  return _UIDs[sequenceNumber - 1];
+}
+
+- (NSUInteger)sequenceNumberForUID:(NSUInteger)UID {
+  [self applyExpunges];
+
+  if (!UID || UID > UINT32_MAX) {
+    return NSNotFound;
+  }
+
+  // UIDs ascend with sequence numbers, so this is a binary search that
+  // steps over messages whose UIDs are not known
+  NSUInteger low = 0;
+  NSUInteger high = _length;
+
+  while (low < high) {
+    NSUInteger middle = low + (high - low) / 2;
+    NSUInteger known = middle;
+
+    while (known < high && !_UIDs[known]) {
+      known++;
+    }
+
+    if (known == high || _UIDs[known] > UID) {
+      high = middle;
+    }
+
+    else if (_UIDs[known] < UID) {
+      low = known + 1;
+    }
+
+    else {
+      return known + 1;
+    }
+  }
+
+  return NSNotFound;
+}
+
+- (NSIndexSet *)sequenceNumbersWithUnknownUIDs {
+  [self applyExpunges];
+
+  NSMutableIndexSet *sequenceNumbers = [NSMutableIndexSet indexSet];
+
+  for (NSUInteger i = 0; i < _length; i++) {
+    if (!_UIDs[i]) {
+      [sequenceNumbers addIndex:i + 1];
+    }
+  }
+
+  return sequenceNumbers;
+}
+
+#pragma mark Flags
+
+- (NSArray *)flagsForSequenceNumber:(NSUInteger)sequenceNumber {
+  [self applyExpunges];
+
+  if (!sequenceNumber || sequenceNumber > _length) {
+    return nil;
+  }
+
+  uint64_t bits = _flagBits[sequenceNumber - 1];
+
+  if (!(bits & SubImapMailboxStateFlagsKnown)) {
+    return nil;
+  }
+
+  NSMutableArray *flags = [NSMutableArray array];
+
+  for (NSUInteger i = 0; i < _flagNames.count; i++) {
+    if (bits & (1ULL << i)) {
+      [flags addObject:_flagNames[i]];
+    }
+  }
+
+  return flags;
+}
+
+- (NSIndexSet *)sequenceNumbersWithFlag:(NSString *)flag {
+  return [self sequenceNumbersWithFlag:flag set:YES];
+}
+
+- (NSIndexSet *)sequenceNumbersWithoutFlag:(NSString *)flag {
+  return [self sequenceNumbersWithFlag:flag set:NO];
+}
+
+- (NSIndexSet *)sequenceNumbersWithFlag:(NSString *)flag set:(BOOL)set {
+  [self applyExpunges];
+
+  NSUInteger index = [self indexForFlag:flag create:NO];
+  uint64_t bit = index == NSNotFound ? 0 : 1ULL << index;
+  NSMutableIndexSet *sequenceNumbers = [NSMutableIndexSet indexSet];
+
+  for (NSUInteger i = 0; i < _length; i++) {
+    uint64_t bits = _flagBits[i];
+
+    if ((bits & SubImapMailboxStateFlagsKnown) && (BOOL)((bits & bit) != 0) == set) {
+      [sequenceNumbers addIndex:i + 1];
+    }
+  }
+
+  return sequenceNumbers;
+}
+
+- (NSUInteger)indexForFlag:(NSString *)flag create:(BOOL)create {
+  NSString *key = [flag lowercaseString];
+  NSNumber *index = _flagIndexes[key];
+
+  if (index) {
+    return [index unsignedIntegerValue];
+  }
+
+  if (!create || _flagNames.count == SubImapMailboxStateMaximumFlags) {
+    return NSNotFound;
+  }
+
+  _flagIndexes[key] = @(_flagNames.count);
+  [_flagNames addObject:flag];
+
+  return _flagNames.count - 1;
+}
+
+- (uint64_t)bitsForFlags:(NSArray *)flags {
+  uint64_t bits = SubImapMailboxStateFlagsKnown;
+
+  for (NSString *flag in flags) {
+    NSUInteger index = [self indexForFlag:flag create:YES];
+
+    if (index != NSNotFound) {
+      bits |= 1ULL << index;
+    }
+  }
+
+  return bits;
+}
+
+#pragma mark Responses
+
+- (BOOL)handleResponse:(SubImapResponse *)response {
+  switch (response.type) {
+    case SubImapResponseTypeExists:{
+      [self setLength:[response.data unsignedIntegerValue]];
+      return YES;
+    }
+    case SubImapResponseTypeRecent:{
+      _recent = [response.data unsignedIntegerValue];
+      return YES;
+    }
+    case SubImapResponseTypeFlags:{
+      _flags = response.data;
+      return YES;
+    }
+    case SubImapResponseTypeExpunge:{
+      [self expungeSequenceNumber:[response.data unsignedIntegerValue]];
+      return YES;
+    }
+    case SubImapResponseTypeVanished:{
+      // Messages expunged before the mailbox was selected were never
+      // part of this state
+      if ([response.data[@"earlier"] boolValue]) {
+        return NO;
+      }
+
+      [self vanishUIDs:response.data[@"uids"]];
+      return YES;
+    }
+    case SubImapResponseTypeFetch:{
+      return [self updateMessageWithData:response.data];
+    }
+    case SubImapResponseTypeOk:
+    case SubImapResponseTypeNo:
+    case SubImapResponseTypeBad:{
+      return [self updateWithCodeData:response.data];
+    }
+    default:
+      return NO;
+  }
+}
+
+- (BOOL)updateMessageWithData:(NSDictionary *)data {
+  [self applyExpunges];
+
+  NSUInteger sequenceNumber = [data[@"sequenceID"] unsignedIntegerValue];
+
+  if (!sequenceNumber || sequenceNumber > _length) {
+    return NO;
+  }
+
+  NSNumber *UID = data[@"uid"];
+  NSArray *flags = data[@"flags"];
+
+  if (UID && [UID unsignedIntegerValue] <= UINT32_MAX) {
+    _UIDs[sequenceNumber - 1] = (uint32_t)[UID unsignedIntegerValue];
+    _UIDNext = MAX(_UIDNext, [UID unsignedIntegerValue] + 1);
+  }
+
+  if (flags) {
+    _flagBits[sequenceNumber - 1] = [self bitsForFlags:flags];
+  }
+
+  return UID || flags;
+}
+
+- (BOOL)updateWithCodeData:(NSDictionary *)data {
+  if (![data isKindOfClass:[NSDictionary class]]) {
+    return NO;
+  }
+
+  NSString *code = data[@"code"];
+
+  if ([code isEqualToString:@"READ-ONLY"] || [code isEqualToString:@"READ-WRITE"]) {
+    _readOnly = [code isEqualToString:@"READ-ONLY"];
+    return YES;
+  }
+
+  if ([code isEqualToString:@"PERMANENTFLAGS"]) {
+    _permanentFlags = data[@"flags"];
+    return YES;
+  }
+
+  if (data[@"uidvalidity"]) {
+    NSUInteger UIDValidity = [data[@"uidvalidity"] unsignedIntegerValue];
+
+    // Every UID we know is stale
+    if (_UIDValidity && _UIDValidity != UIDValidity) {
+      [self applyExpunges];
+      memset(_UIDs, 0, _length * sizeof(*_UIDs));
+      _UIDNext = 0;
+    }
+
+    _UIDValidity = UIDValidity;
+    return YES;
+  }
+
+  if (data[@"uidnext"]) {
+    _UIDNext = [data[@"uidnext"] unsignedIntegerValue];
+    return YES;
+  }
+
+  return NO;
+}
+
+#pragma mark Storage
+
+- (void)setLength:(NSUInteger)length {
+  [self applyExpunges];
+
+  if (length > _capacity) {
+    NSUInteger capacity = MAX(MAX(length, _capacity * 2), 64);
+
+    _UIDs = realloc(_UIDs, capacity * sizeof(*_UIDs));
+    _flagBits = realloc(_flagBits, capacity * sizeof(*_flagBits));
+    _capacity = capacity;
+  }
+
+  // New messages have no known UID or flags
+  if (length > _length) {
+    memset(_UIDs + _length, 0, (length - _length) * sizeof(*_UIDs));
+    memset(_flagBits + _length, 0, (length - _length) * sizeof(*_flagBits));
+  }
+
+  _length = length;
+}
+
+// Servers send EXPUNGE responses for a range of messages either with the
+// same sequence number, or counting down. Both grow the pending range,
+// which is removed from the arrays in one move when it is next needed.
+- (void)expungeSequenceNumber:(NSUInteger)sequenceNumber {
+  if (!sequenceNumber || sequenceNumber > _length - _expungeLength) {
+    return;
+  }
+
+  NSUInteger index = sequenceNumber - 1;
+
+  if (_expungeLength && index == _expungeLocation) {
+    _expungeLength++;
+    return;
+  }
+
+  if (_expungeLength && index + 1 == _expungeLocation) {
+    _expungeLocation--;
+    _expungeLength++;
+    return;
+  }
+
+  [self applyExpunges];
+
+  _expungeLocation = index;
+  _expungeLength = 1;
+}
+
+- (void)applyExpunges {
+  if (!_expungeLength) {
+    return;
+  }
+
+  NSUInteger end = _expungeLocation + _expungeLength;
+
+  memmove(_UIDs + _expungeLocation, _UIDs + end, (_length - end) * sizeof(*_UIDs));
+  memmove(_flagBits + _expungeLocation, _flagBits + end, (_length - end) * sizeof(*_flagBits));
+
+  _length -= _expungeLength;
+  _expungeLength = 0;
+}
+
+- (void)vanishUIDs:(NSIndexSet *)UIDs {
+  [self applyExpunges];
+
+  NSUInteger kept = 0;
+  NSUInteger previousUID = 0;
+  NSUInteger i = 0;
+
+  // One pass, moving the messages that are kept down over the others
+  while (i < _length) {
+    if (_UIDs[i]) {
+      if (![UIDs containsIndex:_UIDs[i]]) {
+        _UIDs[kept] = _UIDs[i];
+        _flagBits[kept] = _flagBits[i];
+        kept++;
+      }
+
+      previousUID = _UIDs[i++];
+      continue;
+    }
+
+    // A run of messages with unknown UIDs. The vanished UIDs between the
+    // known ones around it must belong to messages in the run; which ones
+    // can't be told, so the first ones go.
+    NSUInteger end = i;
+
+    while (end < _length && !_UIDs[end]) {
+      end++;
+    }
+
+    NSUInteger nextUID = end < _length ? _UIDs[end] : (NSUInteger)UINT32_MAX + 1;
+    NSUInteger vanished = [UIDs countOfIndexesInRange:NSMakeRange(previousUID + 1, nextUID - previousUID - 1)];
+
+    for (i += MIN(vanished, end - i); i < end; i++) {
+      _UIDs[kept] = _UIDs[i];
+      _flagBits[kept] = _flagBits[i];
+      kept++;
+    }
+  }
+
+  _length = kept;
+}
+
+@end
\ No newline at end of file
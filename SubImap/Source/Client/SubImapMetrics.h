@@ -0,0 +1,93 @@
+// SubImapMetrics.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapHistogram.h"
+
+@class SubImapCommand;
+@class SubImapResponse;
+
+/*
+ * Monotonic clock in nanoseconds, used for every metric.
+ */
+uint64_t SubImapMetricsNow(void);
+
+/*
+ * SubImapMetrics
+ *
+ * Collects timings and byte counts for a SubImapClient. Assign one to
+ * the client's metrics property to start recording; while it is nil,
+ * nothing is measured.
+ *
+ * Recording happens on the client's run loop, snapshots can be taken
+ * from any thread.
+ */
+@interface SubImapMetrics : NSObject
+
++ (instancetype)metrics;
+
+/*
+ * Returns everything recorded since the last reset. Histograms are
+ * copies, and are in nanoseconds.
+ *
+ *   "commands": (NSDictionary *) by command name {
+ *     "count":          (NSNumber *) commands completed
+ *     "failures":       (NSNumber *) completed with NO or BAD
+ *     "queue_wait":     (SubImapHistogram *) enqueued until sent
+ *     "first_response": (SubImapHistogram *) sent until its first response
+ *     "completion":     (SubImapHistogram *) sent until its tagged response
+ *   }
+ *   "parse":            (NSDictionary *) by response type, as named by
+ *                       SubImapResponse stringFromType:, of
+ *                       (SubImapHistogram *) time spent parsing
+ *   "responses":        (NSNumber *) responses received
+ *   "parse_errors":     (NSNumber *) responses that failed to parse
+ *   "bytes_in":         (NSNumber *) response bytes received
+ *   "bytes_out":        (NSNumber *) command bytes sent
+ *   "literal_bytes_in": (NSNumber *) literal data received
+ *   "literal_bytes_out":(NSNumber *) literal data sent
+ *   "interval":         (NSNumber *) seconds covered by the snapshot
+ */
+- (NSDictionary *)snapshot;
+
+/*
+ * Takes a snapshot and resets, without losing anything recorded in
+ * between.
+ */
+- (NSDictionary *)snapshotAndReset;
+
+- (void)reset;
+
+#pragma mark Recording
+
+/*
+ * Called by SubImapClient.
+ */
+- (void)commandWasEnqueued:(SubImapCommand *)command;
+- (void)commandWasSent:(SubImapCommand *)command dataList:(NSArray *)dataList;
+- (void)command:(SubImapCommand *)command didReceiveResponse:(SubImapResponse *)response;
+- (void)commandDidComplete:(SubImapCommand *)command response:(SubImapResponse *)response;
+
+- (void)didParseResponse:(SubImapResponse *)response data:(NSData *)data duration:(uint64_t)duration;
+- (void)didSendData:(NSData *)data;
+
+@end
\ No newline at end of file
@@ -0,0 +1,336 @@
+// SubImapMetrics.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapMetrics.h"
+
+#import "SubImapCommand.h"
+#import "SubImapConnectionData.h"
+#import "SubImapResponse.h"
+
+#ifdef __APPLE__
+  #include <mach/mach_time.h>
+#else
+  #include <time.h>
+#endif
+
+uint64_t SubImapMetricsNow(void) {
+#ifdef __APPLE__
+  static mach_timebase_info_data_t timebase;
+  if (!timebase.denom) mach_timebase_info(&timebase);
+  return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+/*
+ * Sums the length of every literal in a response, announced by a {123}
+ * marker at the end of a line.
+ */
+static NSUInteger SubImapMetricsLiteralLength(NSData *data) {
+  const char *bytes = [data bytes];
+  NSUInteger length = [data length];
+  NSUInteger literalLength = 0;
+
+  for (NSUInteger idx = 2; idx < length; idx++) {
+    if (bytes[idx] != '\n' || bytes[idx - 1] != '\r' || bytes[idx - 2] != '}') {
+      continue;
+    }
+
+    // Read the marker's digits backwards
+    NSUInteger size = 0;
+    NSUInteger scale = 1;
+    NSInteger pos = idx - 3;
+
+    while (pos >= 0 && bytes[pos] >= '0' && bytes[pos] <= '9') {
+      size += (bytes[pos] - '0') * scale;
+      scale *= 10;
+      pos--;
+    }
+
+    if (pos < 0 || bytes[pos] != '{' || scale == 1) {
+      continue;
+    }
+
+    literalLength += size;
+    idx += size;
+  }
+
+  return literalLength;
+}
+
+#pragma mark -
+
+/*
+ * Timestamps for a command that has not completed yet.
+ */
+@interface SubImapMetricsCommandTiming : NSObject {
+@public
+  uint64_t enqueued;
+  uint64_t sent;
+  uint64_t firstResponse;
+}
+@end
+
+@implementation SubImapMetricsCommandTiming
+@end
+
+/*
+ * Histograms and counts for one command name.
+ */
+@interface SubImapMetricsCommandStats : NSObject {
+@public
+  NSUInteger count;
+  NSUInteger failures;
+  SubImapHistogram *queueWait;
+  SubImapHistogram *firstResponse;
+  SubImapHistogram *completion;
+}
+@end
+
+@implementation SubImapMetricsCommandStats
+
+- (id)init {
+  self = [super init];
+
+  if (self) {
+    queueWait = [SubImapHistogram histogram];
+    firstResponse = [SubImapHistogram histogram];
+    completion = [SubImapHistogram histogram];
+  }
+
+  return self;
+}
+
+- (NSDictionary *)dictionaryRepresentation {
+  return @{
+    @"count":          @(count),
+    @"failures":       @(failures),
+    @"queue_wait":     [queueWait copy],
+    @"first_response": [firstResponse copy],
+    @"completion":     [completion copy],
+  };
+}
+
+@end
+
+#pragma mark -
+
+@implementation SubImapMetrics {
+  // In flight commands, released along with their command
+  NSMapTable *_timings;
+
+  NSMutableDictionary *_commands;
+  NSMutableDictionary *_parse;
+
+  NSUInteger _responses;
+  NSUInteger _parseErrors;
+  NSUInteger _bytesIn;
+  NSUInteger _bytesOut;
+  NSUInteger _literalBytesIn;
+  NSUInteger _literalBytesOut;
+
+  uint64_t _resetTime;
+}
+
++ (instancetype)metrics {
+  return [[self alloc] init];
+}
+
+- (id)init {
+  self = [super init];
+
+  if (self) {
+    _timings = [NSMapTable weakToStrongObjectsMapTable];
+    _commands = [NSMutableDictionary dictionary];
+    _parse = [NSMutableDictionary dictionary];
+
+    [self reset];
+  }
+
+  return self;
+}
+
+#pragma mark Snapshots
+
+- (NSDictionary *)snapshot {
+  @synchronized (self) {
+    NSMutableDictionary *commands = [NSMutableDictionary dictionary];
+    for (NSString *name in _commands) {
+      commands[name] = [_commands[name] dictionaryRepresentation];
+    }
+
+    NSMutableDictionary *parse = [NSMutableDictionary dictionary];
+    for (NSString *type in _parse) {
+      parse[type] = [_parse[type] copy];
+    }
+
+    return @{
+      @"commands":          commands,
+      @"parse":             parse,
+      @"responses":         @(_responses),
+      @"parse_errors":      @(_parseErrors),
+      @"bytes_in":          @(_bytesIn),
+      @"bytes_out":         @(_bytesOut),
+      @"literal_bytes_in":  @(_literalBytesIn),
+      @"literal_bytes_out": @(_literalBytesOut),
+      @"interval":          @((SubImapMetricsNow() - _resetTime) / 1e9),
+    };
+  }
+}
+
+- (NSDictionary *)snapshotAndReset {
+  @synchronized (self) {
+    NSDictionary *snapshot = [self snapshot];
+    [self reset];
+    return snapshot;
+  }
+}
+
+- (void)reset {
+  @synchronized (self) {
+    // Commands in flight keep their timings, so they are still measured
+    // when they complete
+    [_commands removeAllObjects];
+    [_parse removeAllObjects];
+
+    _responses = 0;
+    _parseErrors = 0;
+    _bytesIn = 0;
+    _bytesOut = 0;
+    _literalBytesIn = 0;
+    _literalBytesOut = 0;
+
+    _resetTime = SubImapMetricsNow();
+  }
+}
+
+#pragma mark Recording
+
+- (SubImapMetricsCommandStats *)statsForCommand:(SubImapCommand *)command {
+  NSString *name = command.name ?: @"";
+  SubImapMetricsCommandStats *stats = _commands[name];
+
+  if (!stats) {
+    stats = [[SubImapMetricsCommandStats alloc] init];
+    _commands[name] = stats;
+  }
+
+  return stats;
+}
+
+- (void)commandWasEnqueued:(SubImapCommand *)command {
+  SubImapMetricsCommandTiming *timing = [[SubImapMetricsCommandTiming alloc] init];
+  timing->enqueued = SubImapMetricsNow();
+
+  @synchronized (self) {
+    [_timings setObject:timing forKey:command];
+  }
+}
+
+- (void)commandWasSent:(SubImapCommand *)command dataList:(NSArray *)dataList {
+  uint64_t now = SubImapMetricsNow();
+
+  NSUInteger literalBytes = 0;
+  for (SubImapConnectionData *data in dataList) {
+    if (data.isLiteral) {
+      literalBytes += [data.data length];
+    }
+  }
+
+  @synchronized (self) {
+    _literalBytesOut += literalBytes;
+
+    SubImapMetricsCommandTiming *timing = [_timings objectForKey:command];
+    if (!timing) return;
+
+    timing->sent = now;
+    [[self statsForCommand:command]->queueWait recordValue:now - timing->enqueued];
+  }
+}
+
+- (void)command:(SubImapCommand *)command didReceiveResponse:(SubImapResponse *)response {
+  @synchronized (self) {
+    SubImapMetricsCommandTiming *timing = [_timings objectForKey:command];
+    if (!timing || !timing->sent || timing->firstResponse) return;
+
+    timing->firstResponse = SubImapMetricsNow();
+    [[self statsForCommand:command]->firstResponse recordValue:timing->firstResponse - timing->sent];
+  }
+}
+
+- (void)commandDidComplete:(SubImapCommand *)command response:(SubImapResponse *)response {
+  uint64_t now = SubImapMetricsNow();
+
+  @synchronized (self) {
+    SubImapMetricsCommandTiming *timing = [_timings objectForKey:command];
+    if (!timing || !timing->sent) return;
+
+    SubImapMetricsCommandStats *stats = [self statsForCommand:command];
+    stats->count++;
+    if (!response.status) stats->failures++;
+
+    // The tagged response may be the only one
+    if (!timing->firstResponse) {
+      [stats->firstResponse recordValue:now - timing->sent];
+    }
+
+    [stats->completion recordValue:now - timing->sent];
+    [_timings removeObjectForKey:command];
+  }
+}
+
+- (void)didParseResponse:(SubImapResponse *)response data:(NSData *)data duration:(uint64_t)duration {
+  NSUInteger literalBytes = SubImapMetricsLiteralLength(data);
+
+  @synchronized (self) {
+    _responses++;
+    _bytesIn += [data length];
+    _literalBytesIn += literalBytes;
+
+    if (!response) {
+      _parseErrors++;
+      return;
+    }
+
+    NSString *type = [SubImapResponse stringFromType:response.type] ?: @"UNKNOWN";
+    SubImapHistogram *histogram = _parse[type];
+
+    if (!histogram) {
+      histogram = [SubImapHistogram histogram];
+      _parse[type] = histogram;
+    }
+
+    [histogram recordValue:duration];
+  }
+}
+
+- (void)didSendData:(NSData *)data {
+  @synchronized (self) {
+    _bytesOut += [data length];
+  }
+}
+
+@end
\ No newline at end of file
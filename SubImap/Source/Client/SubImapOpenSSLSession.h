@@ -0,0 +1,54 @@
+// SubImapOpenSSLSession.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapTLSSession.h"
+
+#ifdef SUBIMAP_OPENSSL
+
+// Error codes are SSL_get_error values
+extern NSString * const SubImapOpenSSLErrorDomain;
+
+/*
+ * SubImapOpenSSLSession
+ *
+ * A SubImapTLSSession on OpenSSL 1.1.1 or later, with TLS 1.2 as the
+ * minimum version.
+ *
+ * Each verified session the server hands out, including TLS 1.3 tickets
+ * sent after the handshake, is kept per host, port and peer name and
+ * offered on the next connection, so reconnects skip the full handshake.
+ * Sessions that skipped certificate validation are never kept, so they
+ * can't be resumed by a connection that requires it. Tickets are used
+ * once. Early data is never sent, since IMAP commands are not safe to
+ * replay.
+ */
+@interface SubImapOpenSSLSession : NSObject <SubImapTLSSession>
+
+/*
+ * Forgets every cached session.
+ */
++ (void)removeAllCachedSessions;
+
+@end
+
+#endif
\ No newline at end of file
@@ -0,0 +1,300 @@
+// SubImapOpenSSLSession.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapOpenSSLSession.h"
+
+#ifdef SUBIMAP_OPENSSL
+
+#import "SubImapTLSTransport.h"
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+NSString * const SubImapOpenSSLErrorDomain = @"SubImapOpenSSLErrorDomain";
+
+@interface SubImapOpenSSLSession ()
+@property (readonly) NSString *cacheKey;
+@property (readonly) BOOL verifiesPeer;
+@end
+
+#pragma mark Session cache
+
+// Serialized sessions by "host:port peer-name validates"
+static NSMutableDictionary *SubImapOpenSSLSessionCache(void) {
+  static NSMutableDictionary *cache = nil;
+  static dispatch_once_t onceToken;
+
+  dispatch_once(&onceToken, ^{
+    cache = [NSMutableDictionary dictionary];
+  });
+
+  return cache;
+}
+
+// Called for every session the server hands out
+static int SubImapOpenSSLSessionDidReceiveSession(SSL *ssl, SSL_SESSION *sslSession) {
+  SubImapOpenSSLSession *session = (__bridge SubImapOpenSSLSession *)SSL_get_app_data(ssl);
+  if (!session.cacheKey || !SSL_SESSION_is_resumable(sslSession)) return 0;
+
+  // A resumed session skips certificate validation, so only keep ones
+  // whose chain and peer name were checked
+  if (!session.verifiesPeer || SSL_get_verify_result(ssl) != X509_V_OK) return 0;
+
+  int length = i2d_SSL_SESSION(sslSession, NULL);
+  if (length <= 0) return 0;
+
+  NSMutableData *data = [NSMutableData dataWithLength:length];
+  unsigned char *bytes = [data mutableBytes];
+  i2d_SSL_SESSION(sslSession, &bytes);
+
+  NSMutableDictionary *cache = SubImapOpenSSLSessionCache();
+
+  @synchronized (cache) {
+    cache[session.cacheKey] = data;
+  }
+
+  // The session is not kept, only its serialized copy
+  return 0;
+}
+
+static SSL_CTX *SubImapOpenSSLSessionContext(void) {
+  static SSL_CTX *context = NULL;
+  static dispatch_once_t onceToken;
+
+  dispatch_once(&onceToken, ^{
+    context = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_min_proto_version(context, TLS1_2_VERSION);
+    SSL_CTX_set_default_verify_paths(context);
+
+    // Sessions are cached by host in SubImapOpenSSLSessionCache
+    SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(context, SubImapOpenSSLSessionDidReceiveSession);
+  });
+
+  return context;
+}
+
+#pragma mark -
+
+@implementation SubImapOpenSSLSession {
+  SSL *_ssl;
+  BIO *_readBIO;
+  BIO *_writeBIO;
+}
+
++ (id<SubImapTLSSession>)sessionWithHost:(NSString *)host port:(NSUInteger)port settings:(NSDictionary *)settings {
+  return [[self alloc] initWithHost:host port:port settings:settings];
+}
+
++ (void)removeAllCachedSessions {
+  NSMutableDictionary *cache = SubImapOpenSSLSessionCache();
+
+  @synchronized (cache) {
+    [cache removeAllObjects];
+  }
+}
+
+- (id)initWithHost:(NSString *)host port:(NSUInteger)port settings:(NSDictionary *)settings {
+  self = [super init];
+
+  if (self) {
+    SSL_CTX *context = SubImapOpenSSLSessionContext();
+    if (!context) return nil;
+
+    _ssl = SSL_new(context);
+    if (!_ssl) return nil;
+
+    // The SSL owns both BIOs
+    _readBIO = BIO_new(BIO_s_mem());
+    _writeBIO = BIO_new(BIO_s_mem());
+    SSL_set_bio(_ssl, _readBIO, _writeBIO);
+    SSL_set_connect_state(_ssl);
+    SSL_set_app_data(_ssl, (__bridge void *)self);
+
+    NSString *peerName = settings[SubImapTLSPeerNameKey] ?: host;
+    SSL_set_tlsext_host_name(_ssl, [peerName UTF8String]);
+
+    NSNumber *validates = settings[SubImapTLSValidatesCertificateChainKey];
+    BOOL validatesChain = !validates || [validates boolValue];
+    _verifiesPeer = validatesChain;
+
+    if (validatesChain) {
+      SSL_set_hostflags(_ssl, X509_CHECK_FLAG_NO_PARTIAL_WILDCARDS);
+      SSL_set_verify(_ssl, SSL_VERIFY_PEER, NULL);
+
+      // Without the name check, the session isn't verified well enough to keep
+      if (SSL_set1_host(_ssl, [peerName UTF8String]) != 1) {
+        _verifiesPeer = NO;
+      }
+    }
+
+    NSNumber *resumption = settings[SubImapTLSSessionResumptionKey];
+
+    if (!resumption || [resumption boolValue]) {
+      _cacheKey = [NSString stringWithFormat:@"%@:%lu %@ %d", host, (unsigned long)port, peerName, validatesChain];
+      [self resumeCachedSession];
+    }
+  }
+
+  return self;
+}
+
+- (void)dealloc {
+  if (_ssl) {
+    SSL_free(_ssl);
+  }
+}
+
+- (void)resumeCachedSession {
+  NSMutableDictionary *cache = SubImapOpenSSLSessionCache();
+  NSData *data;
+
+  // TLS 1.3 tickets are single use, so take it out of the cache
+  @synchronized (cache) {
+    data = cache[_cacheKey];
+    [cache removeObjectForKey:_cacheKey];
+  }
+
+  if (!data) {
+    return;
+  }
+
+  const unsigned char *bytes = [data bytes];
+  SSL_SESSION *sslSession = d2i_SSL_SESSION(NULL, &bytes, (long)[data length]);
+
+  if (sslSession) {
+    SSL_set_session(_ssl, sslSession);
+    SSL_SESSION_free(sslSession);
+  }
+}
+
+- (BOOL)resumed {
+  return SSL_session_reused(_ssl) == 1;
+}
+
+#pragma mark SubImapTLSSession
+
+- (void)receiveCiphertext:(const uint8_t *)bytes length:(NSUInteger)length {
+  BIO_write(_readBIO, bytes, (int)length);
+}
+
+- (NSData *)takeCiphertext {
+  size_t length = BIO_ctrl_pending(_writeBIO);
+
+  if (!length) {
+    return nil;
+  }
+
+  NSMutableData *data = [NSMutableData dataWithLength:length];
+  int bytesRead = BIO_read(_writeBIO, [data mutableBytes], (int)length);
+  [data setLength:MAX(bytesRead, 0)];
+
+  return data;
+}
+
+- (SubImapTLSHandshakeStatus)handshake:(NSError **)error {
+  int result = SSL_do_handshake(_ssl);
+
+  if (result == 1) {
+    return SubImapTLSHandshakeComplete;
+  }
+
+  int sslError = SSL_get_error(_ssl, result);
+
+  if (sslError == SSL_ERROR_WANT_READ || sslError == SSL_ERROR_WANT_WRITE) {
+    return SubImapTLSHandshakeInProgress;
+  }
+
+  if (error) *error = [self errorWithCode:sslError];
+  return SubImapTLSHandshakeFailed;
+}
+
+- (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)length error:(NSError **)error {
+  int bytesRead = SSL_read(_ssl, buffer, (int)MIN(length, INT_MAX));
+
+  if (bytesRead > 0) {
+    return bytesRead;
+  }
+
+  int sslError = SSL_get_error(_ssl, bytesRead);
+
+  switch (sslError) {
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+      return -1;
+
+    // close_notify
+    case SSL_ERROR_ZERO_RETURN:
+      return 0;
+
+    default:
+      if (error) *error = [self errorWithCode:sslError];
+      return -1;
+  }
+}
+
+- (BOOL)write:(const uint8_t *)bytes length:(NSUInteger)length error:(NSError **)error {
+  // Memory BIOs take everything, so writes are never partial
+  while (length) {
+    int chunk = (int)MIN(length, INT_MAX);
+    int bytesWritten = SSL_write(_ssl, bytes, chunk);
+
+    if (bytesWritten <= 0) {
+      if (error) *error = [self errorWithCode:SSL_get_error(_ssl, bytesWritten)];
+      return NO;
+    }
+
+    bytes += bytesWritten;
+    length -= bytesWritten;
+  }
+
+  return YES;
+}
+
+#pragma mark -
+
+- (NSError *)errorWithCode:(int)sslError {
+  NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
+  unsigned long queuedError = ERR_get_error();
+
+  if (queuedError) {
+    char description[256];
+    ERR_error_string_n(queuedError, description, sizeof(description));
+    userInfo[NSLocalizedDescriptionKey] = [NSString stringWithUTF8String:description];
+  }
+
+  long verifyResult = SSL_get_verify_result(_ssl);
+
+  if (verifyResult != X509_V_OK) {
+    userInfo[NSLocalizedFailureReasonErrorKey] = [NSString stringWithUTF8String:X509_verify_cert_error_string(verifyResult)];
+  }
+
+  ERR_clear_error();
+
+  return [NSError errorWithDomain:SubImapOpenSSLErrorDomain code:sslError userInfo:userInfo];
+}
+
+@end
+
+#endif
\ No newline at end of file
@@ -67,6 +67,15 @@ typedef enum {
    *
    * The "code" may be one of the following:
    *
+   * "APPENDUID" - RFC4315
+   * An APPEND succeeded. Includes the destination mailbox's UID validity
+   * and the UIDs given to the appended messages.
+   *
+   *     "appenduid": (NSDictionary *) {
+   *       "uidvalidity": (NSNumber *) the destination's UID validity
+   *       "destination": (NSArray *)(NSNumber *) the new UIDs, in order
+   *     }
+   *
    * "ALERT"
    * The human-readable text contains a special alert that MUST be
    * presented to the user in a fashion that calls the user's
@@ -88,6 +97,28 @@ typedef enum {
    *
    *     "capabilities": (NSArray *)(NSString *) the server's capabilites
    *
+   * "COPYUID" - RFC4315
+   * A COPY or MOVE succeeded. Includes the destination mailbox's UID
+   * validity, the UIDs of the copied messages and the UIDs they were
+   * given, in the same order. A MOVE sends it in an untagged OK.
+   *
+   *     "copyuid": (NSDictionary *) {
+   *       "uidvalidity": (NSNumber *) the destination's UID validity
+   *       "source": (NSArray *)(NSNumber *) the copied messages' UIDs
+   *       "destination": (NSArray *)(NSNumber *) their new UIDs, in the
+   *                      same order
+   *     }
+   *
+   * "NOTIFICATIONOVERFLOW" - RFC5465
+   * The server stopped sending NOTIFY events, having too many to send.
+   * Everything being watched has to be checked again.
+   *
+   * "BADEVENT" - RFC5465
+   * A NOTIFY asked for an event the server does not support. Includes
+   * the events it does support.
+   *
+   *     "events": (NSArray *)(NSString *) the supported events
+   *
    * "PARSE"
    * The human-readable text represents an error in parsing the
    * [RFC-2822] header or [MIME-IMB] headers of a message in the
@@ -175,6 +206,8 @@ typedef enum {
    *   "flags": (NSArray *) mailbox flags -- see RFC
    *   "delimiter": (NSString *) the mailbox path delimiter
    *   "path": (NSString *) the mailbox path
+   *   "extended": (NSDictionary *) RFC5258 extended items, if any
+   *   "oldname": (NSString *) the path before a rename, RFC5465
    * }
    */
   SubImapResponseTypeList,
@@ -205,10 +238,28 @@ typedef enum {
    * A listing of sequence IDs or UIDs, depending on which SEARCH
    * command was used. The list may be empty.
    *
-   * Data: (NSArray *)(NSNumber *) sequence IDs or UIDs
+   * Data: (NSIndexSet *) sequence IDs or UIDs
    */
   SubImapResponseTypeSearch,
 
+  /*
+   * ESEARCH - RFC4731 3.1.
+   *
+   * The result of a SEARCH with RETURN options. Only the requested
+   * results are included, and MIN, MAX and ALL are left out when
+   * nothing matched.
+   *
+   * Data: (NSDictionary *) {
+   *   "tag": (NSString *) the tag of the SEARCH command, if given
+   *   "uid": (NSNumber *) BOOL, YES if the results are UIDs
+   *   "min": (NSNumber *) the lowest match
+   *   "max": (NSNumber *) the highest match
+   *   "count": (NSNumber *) the number of matches
+   *   "all": (NSIndexSet *) every match
+   * }
+   */
+  SubImapResponseTypeEsearch,
+
   /*
    * FLAGS - RFC3501 7.2.6.
    *
@@ -259,6 +310,36 @@ typedef enum {
   // TODO: document this
   SubImapResponseTypeFetch,
 
+  /*
+   * VANISHED - RFC7162 3.2.10.
+   *
+   * Reports that the messages with these UIDs have been expunged. Sent
+   * instead of EXPUNGE once QRESYNC is enabled. With "earlier", the
+   * messages were expunged before the mailbox was selected, and the
+   * number of messages in the mailbox does not change.
+   *
+   * Data: (NSDictionary *) {
+   *   "earlier": (NSNumber *) BOOL, YES for VANISHED (EARLIER)
+   *   "uids": (NSIndexSet *) the expunged UIDs
+   * }
+   */
+  SubImapResponseTypeVanished,
+
+  /*
+   * THREAD - RFC5256 4.
+   *
+   * The threads found by a THREAD command, as trees of message numbers,
+   * or UIDs after UID THREAD. A node without an "id" stands for a
+   * missing message that its children replied to.
+   *
+   * Data: (NSArray *) the root node of each thread, each an
+   *   (NSDictionary *) {
+   *     "id": (NSNumber *) the message number or UID, if any
+   *     "children": (NSArray *) the replies, as nodes
+   *   }
+   */
+  SubImapResponseTypeThread,
+
   // RFC3501 7.5. Command Continuation Request
   SubImapResponseTypeContinue
 } SubImapResponseType;
@@ -270,6 +351,9 @@ typedef enum {
 @property NSString *tag;
 @property id data;
 
+// Bytes of response data it was parsed from, including literals
+@property NSUInteger length;
+
 + (id)responseWithStatus:(BOOL)status type:(SubImapResponseType)type tag:(NSString *)tag data:(id)data;
 + (id)responseWithType:(SubImapResponseType)type data:(id)data;
 
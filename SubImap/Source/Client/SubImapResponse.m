@@ -112,6 +112,7 @@
     [names insertObject:@"LSUB"          atIndex:SubImapResponseTypeLsub];
     [names insertObject:@"STATUS"        atIndex:SubImapResponseTypeStatus];
     [names insertObject:@"SEARCH"        atIndex:SubImapResponseTypeSearch];
+    [names insertObject:@"ESEARCH"       atIndex:SubImapResponseTypeEsearch];
     [names insertObject:@"FLAGS"         atIndex:SubImapResponseTypeFlags];
 
     // RFC3501 7.5. Mailbox Size
@@ -122,6 +123,12 @@
     [names insertObject:@"EXPUNGE"       atIndex:SubImapResponseTypeExpunge];
     [names insertObject:@"FETCH"         atIndex:SubImapResponseTypeFetch];
 
+    // RFC7162 3.2.10. VANISHED Response
+    [names insertObject:@"VANISHED"      atIndex:SubImapResponseTypeVanished];
+
+    // RFC5256 4. THREAD Response
+    [names insertObject:@"THREAD"        atIndex:SubImapResponseTypeThread];
+
     // RFC3501 7.5. Command Continuation Request
     [names insertObject:@"CONTINUE"      atIndex:SubImapResponseTypeContinue];
   });
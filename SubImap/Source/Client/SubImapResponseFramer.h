@@ -0,0 +1,57 @@
+// SubImapResponseFramer.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/*
+ * SubImapResponseFramer
+ *
+ * Splits the raw byte stream received from a server into complete
+ * responses. A response is a line terminated by CRLF, plus any literal
+ * data announced by a {123} marker, or a ~{123} literal8 marker, at the
+ * end of the line and the rest of the line that follows it.
+ *
+ * This holds the framing logic used by SubImapConnection, so that it can
+ * be driven without a socket.
+ */
+@interface SubImapResponseFramer : NSObject
+
++ (instancetype)framer;
+
+/*
+ * Appends bytes read from the server, and returns any responses completed
+ * by them, in order. Each response includes its terminating CRLF.
+ *
+ * Returns an empty array if no response was completed.
+ */
+- (NSArray *)responsesByAppendingBytes:(const void *)bytes length:(NSUInteger)length;
+
+/*
+ * Number of bytes received that are not yet part of a complete response.
+ */
+- (NSUInteger)bufferedLength;
+
+/*
+ * Discards any partially received response.
+ */
+- (void)reset;
+
+@end
\ No newline at end of file
@@ -0,0 +1,194 @@
+// SubImapResponseFramer.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapResponseFramer.h"
+
+@implementation SubImapResponseFramer {
+  NSMutableData *_readBuffer;
+  NSMutableData *_responseBuffer;
+  NSUInteger _literalBytesToRead;
+}
+
++ (instancetype)framer {
+  return [[self alloc] init];
+}
+
+- (id)init {
+  self = [super init];
+
+  if (self) {
+    [self reset];
+  }
+
+  return self;
+}
+
+#pragma mark -
+
+- (void)reset {
+  _readBuffer = [NSMutableData data];
+  _responseBuffer = [NSMutableData data];
+  _literalBytesToRead = 0;
+}
+
+- (NSUInteger)bufferedLength {
+  return [_readBuffer length] + [_responseBuffer length];
+}
+
+- (NSArray *)responsesByAppendingBytes:(const void *)bytes length:(NSUInteger)length {
+  NSMutableArray *responses = [NSMutableArray array];
+
+  // Add bytes to buffer
+  [_readBuffer appendBytes:bytes length:length];
+
+  // IMAP responses are terminated with CRLF
+  NSUInteger termLength = 2;
+  NSData *term = [NSData dataWithBytes:"\x0D\x0A" length:termLength];
+
+  // Calculate starting position
+  NSUInteger bufferLength = [_readBuffer length];
+  NSUInteger scannedPosition = bufferLength - length;
+
+  while (1) {
+    // Nothing left in the buffer
+    if (bufferLength <= 0) {
+      break;
+    }
+
+    // We are expecting literal bytes
+    if (_literalBytesToRead > 0) {
+      // Calculate how many bytes we can read
+      NSInteger availableBytes = MIN(bufferLength, _literalBytesToRead);
+
+      // Pull literal bytes from buffer
+      [_responseBuffer appendBytes:[_readBuffer bytes] length:availableBytes];
+      [_readBuffer replaceBytesInRange:NSMakeRange(0, availableBytes) withBytes:NULL length:0];
+
+      // Reset scan positions
+      _literalBytesToRead -= availableBytes;
+      bufferLength -= availableBytes;
+      scannedPosition = 0;
+    }
+
+    // We are not expecting literal bytes
+    if (_literalBytesToRead <= 0) {
+      // Not enough data for a full term yet
+      if (bufferLength < termLength) {
+        break;
+      }
+
+      // Since we've already scanned some of the previous
+      // buffer, we only need to rescan enough of it to
+      // ensure we didn't miss our term
+      //  .             .             .             .
+      // |B|B|B|B|B| |A|B|B|B|B| |A|A|B|B|B| |A|A|A|B|B|
+      //  ^ ^ ^       ^ ^ ^       ^ ^ ^         ^ ^ ^
+      NSUInteger scanPosition = (scannedPosition > termLength - 1)
+        ? scannedPosition - termLength + 1
+        : 0;
+
+      // Scan for the term
+      NSRange eol = [_readBuffer rangeOfData:term options:0 range:NSMakeRange(scanPosition, bufferLength - scanPosition)];
+
+      // If the term is not found, wait for more bytes
+      if (eol.location == NSNotFound) {
+        break;
+      }
+
+      // Pull response from buffer
+      NSUInteger responseLength = eol.location + eol.length;
+      [_responseBuffer appendBytes:[_readBuffer bytes] length:responseLength];
+      [_readBuffer replaceBytesInRange:NSMakeRange(0, responseLength) withBytes:NULL length:0];
+
+      // Reset scan positions
+      bufferLength -= responseLength;
+      scannedPosition = 0;
+
+      // We have to check if there is a literal to follow...
+      _literalBytesToRead += [self bytesForLiteralMarkerInResponseBuffer];
+
+      // If there are no more literal bytes to follow, we have a complete response
+      if (_literalBytesToRead <= 0) {
+        [responses addObject:_responseBuffer];
+
+        // Reset buffer
+        _responseBuffer = [NSMutableData data];
+      }
+    }
+
+    // continue;
+  }
+
+  return responses;
+}
+
+/*
+ * Checks the responseBuffer for a literal marker. It is
+ * assumed that the buffer is terminated by a CRLF.
+ *
+ * Returns: the number of bytes specified in the marker,
+ *          or 0 if none found
+ */
+- (NSUInteger)bytesForLiteralMarkerInResponseBuffer {
+  NSUInteger bufferLength = [_responseBuffer length];
+
+  // {1}\r\n
+  if (bufferLength < 5) {
+    return 0;
+  }
+
+  // Literal markers take the form of: {123}\r\n
+  // A literal8 marker, ~{123}\r\n, ends the same way, and the scan
+  // stops at the { before the ~
+  // We want to start scanning from the } character, so
+  // here we subtract the length of the CRLF term + 1
+  NSInteger bracePos = bufferLength - 2 - 1;
+  NSInteger idx = bracePos;
+
+  // Since we are scanning backwards, we can exit out right
+  // away if we don't see the term and end literal character }
+  const char *bytes = [_responseBuffer bytes];
+  const char *character = &bytes[idx];
+
+  if (*character != '}') return 0;
+
+  // Start scanning backwards
+  while (idx--) {
+    character = &bytes[idx];
+
+    // Are we at the end of the literal?
+    if (*character == '{') {
+      character = &bytes[idx + 1];
+      return [[[NSString alloc] initWithBytes:character length:bracePos - idx - 1 encoding:NSASCIIStringEncoding] integerValue];
+    }
+
+    // If the character is not a digit, this isn't a literal
+    if (*character < '0' || *character > '9') {
+      break;
+    }
+  }
+
+  return 0;
+}
+
+@end
\ No newline at end of file
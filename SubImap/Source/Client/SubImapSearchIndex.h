@@ -0,0 +1,88 @@
+// SubImapSearchIndex.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapMailboxState.h"
+#import "SubImapSearchCriteria.h"
+
+/*
+ * SubImapSearchIndex
+ *
+ * Searches one mailbox's messages locally, without the server. Messages
+ * are added as they are fetched: envelope, header sections and decoded
+ * text parts are split into words, and each word keeps a posting list of
+ * the UIDs it appears in. Lists are delta-encoded varints, usually one
+ * or two bytes per message, and since new messages have the highest UIDs
+ * adding one is an append. Older messages are merged into each list once
+ * per addMessages:.
+ *
+ * Text keys match whole words, case and diacritic insensitively: FROM
+ * "ann" finds "Ann Smith <ann@example.com>", but not "Annabel", which an
+ * IMAP server would. Only the parts of a message that were added are
+ * searched, so BODY needs the text parts fetched.
+ *
+ * Expunged messages are dropped from results at once, and from the lists
+ * when enough have piled up.
+ */
+@interface SubImapSearchIndex : NSObject
+
++ (instancetype)indexWithPath:(NSString *)path;
+
+@property (readonly) NSString *path;
+
+/*
+ * The number of messages in the index.
+ */
+@property (readonly) NSUInteger count;
+
+/*
+ * Adds a message from a UID FETCH. It needs its "uid", and may have an
+ * "envelope", "internaldate", RFC822.SIZE, header sections and text
+ * sections with the "bodystructure" to decode them. Adding a message
+ * again adds the new parts to it.
+ */
+- (void)addMessage:(NSDictionary *)message;
+- (void)addMessages:(NSArray *)messages;
+
+- (void)removeMessagesWithUIDs:(NSIndexSet *)UIDs;
+
+/*
+ * Drops messages that are no longer in the mailbox, or every message when
+ * its UIDVALIDITY changed. Flag keys and sequence numbers are evaluated
+ * with the last state given.
+ */
+- (void)updateWithMailboxState:(SubImapMailboxState *)state;
+
+/*
+ * The UIDs of the messages matching the criteria, or nil if the criteria
+ * use a key that can't be evaluated locally and have to be sent to the
+ * server. Supported are ALL, UID, sequence numbers, flags and keywords,
+ * FROM, TO, CC, BCC, SUBJECT, HEADER, BODY, TEXT, BEFORE, ON, SINCE,
+ * LARGER and SMALLER, combined in any way.
+ *
+ * BEFORE, ON and SINCE need every message's "internaldate", and LARGER
+ * and SMALLER its RFC822.SIZE, or they can't be evaluated either. Nor
+ * can text keys whose string has no words, such as HEADER with "".
+ */
+- (NSIndexSet *)UIDsMatchingCriteria:(SubImapSearchCriteria *)criteria;
+
+@end
\ No newline at end of file
@@ -0,0 +1,650 @@
+// SubImapSearchIndex.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapSearchIndex.h"
+
+#import "SubImapFetchCommand.h"
+#import "SubImapTransferDecoder.h"
+
+// Longer words are mostly encoded data, and are not indexed
+#define SubImapSearchIndexMaxWordLength 64
+
+// Expunged UIDs are taken out of the lists once there are this many, and
+// they are a quarter of the index
+#define SubImapSearchIndexCompactThreshold 256
+
+#pragma mark Posting lists
+
+/*
+ * A posting list is the highest UID in it, as a native uint32_t, followed
+ * by the ascending UIDs as varint deltas.
+ */
+static void SubImapAppendVarint(NSMutableData *list, uint32_t value) {
+  uint8_t bytes[5];
+  NSUInteger length = 0;
+
+  while (value >= 0x80) {
+    bytes[length++] = (uint8_t)(value & 0x7f) | 0x80;
+    value >>= 7;
+  }
+
+  bytes[length++] = (uint8_t)value;
+  [list appendBytes:bytes length:length];
+}
+
+static uint32_t SubImapPostingListLastUID(NSData *list) {
+  uint32_t last;
+  memcpy(&last, list.bytes, sizeof(last));
+  return last;
+}
+
+static void SubImapPostingListAppendUID(NSMutableData *list, uint32_t UID) {
+  SubImapAppendVarint(list, UID - SubImapPostingListLastUID(list));
+  memcpy(list.mutableBytes, &UID, sizeof(UID));
+}
+
+static NSMutableIndexSet *SubImapPostingListUIDs(NSData *list) {
+  NSMutableIndexSet *UIDs = [NSMutableIndexSet indexSet];
+  const uint8_t *bytes = (const uint8_t *)list.bytes + sizeof(uint32_t);
+  const uint8_t *end = (const uint8_t *)list.bytes + list.length;
+
+  // Consecutive UIDs are added as one range
+  uint32_t UID = 0;
+  NSRange run = NSMakeRange(0, 0);
+
+  while (bytes < end) {
+    uint32_t delta = 0;
+    unsigned shift = 0;
+
+    while (bytes < end) {
+      uint8_t byte = *bytes++;
+      delta |= (uint32_t)(byte & 0x7f) << shift;
+      shift += 7;
+
+      if (!(byte & 0x80)) break;
+    }
+
+    UID += delta;
+
+    if (run.length && UID == NSMaxRange(run)) {
+      run.length++;
+    } else {
+      if (run.length) [UIDs addIndexesInRange:run];
+      run = NSMakeRange(UID, 1);
+    }
+  }
+
+  if (run.length) [UIDs addIndexesInRange:run];
+
+  return UIDs;
+}
+
+static void SubImapPostingListSetUIDs(NSMutableData *list, NSIndexSet *UIDs) {
+  list.length = sizeof(uint32_t);
+  memset(list.mutableBytes, 0, sizeof(uint32_t));
+
+  [UIDs enumerateIndexesUsingBlock:^(NSUInteger UID, BOOL *stop) {
+    SubImapPostingListAppendUID(list, (uint32_t)UID);
+  }];
+}
+
+static void SubImapIntersectIndexes(NSMutableIndexSet *indexes, NSIndexSet *otherIndexes) {
+  NSMutableIndexSet *missing = [indexes mutableCopy];
+  [missing removeIndexes:otherIndexes];
+  [indexes removeIndexes:missing];
+}
+
+
+@implementation SubImapSearchIndex {
+  // Posting lists, keyed by field and word, eg: @"subject:invoice"
+  NSMutableDictionary *_postings;
+
+  // UIDs older than the end of their list, merged in once per addMessages:
+  NSMutableDictionary *_pendingPostings;
+
+  // Every field with words in the index, for TEXT
+  NSMutableSet *_fields;
+
+  // The messages in the index
+  NSMutableIndexSet *_UIDs;
+
+  // Expunged messages that are still in posting lists
+  NSMutableIndexSet *_removedUIDs;
+
+  // NSDates and NSNumbers, keyed by UID
+  NSMutableDictionary *_internalDates;
+  NSMutableDictionary *_sizes;
+
+  SubImapMailboxState *_state;
+  NSUInteger _UIDValidity;
+}
+
++ (instancetype)indexWithPath:(NSString *)path {
+  return [[self alloc] initWithPath:path];
+}
+
+- (id)initWithPath:(NSString *)path {
+  self = [super init];
+
+  if (self) {
+    _path = path;
+    [self removeAllMessages];
+  }
+
+  return self;
+}
+
+- (NSUInteger)count {
+  return _UIDs.count;
+}
+
+#pragma mark Adding messages
+
+- (void)addMessages:(NSArray *)messages {
+  for (NSDictionary *message in messages) {
+    [self indexMessage:message];
+  }
+
+  [self mergePendingPostings];
+}
+
+- (void)addMessage:(NSDictionary *)message {
+  [self addMessages:@[message]];
+}
+
+- (void)indexMessage:(NSDictionary *)message {
+  NSUInteger UID = [message[@"uid"] unsignedIntegerValue];
+
+  // UIDs are not reused, so a removed one is a late response
+  if (!UID || UID > UINT32_MAX || [_removedUIDs containsIndex:UID]) {
+    return;
+  }
+
+  [_UIDs addIndex:UID];
+
+  if (message[@"internaldate"]) {
+    _internalDates[@(UID)] = message[@"internaldate"];
+  }
+
+  if (message[@"rfc.size"]) {
+    _sizes[@(UID)] = message[@"rfc.size"];
+  }
+
+  // Each term once, however often the word appears
+  NSMutableSet *terms = [NSMutableSet set];
+  NSDictionary *envelope = message[@"envelope"];
+
+  if (envelope) {
+    [self addWordsInString:envelope[@"subject"] field:@"subject" toTerms:terms];
+
+    for (NSString *field in @[@"from", @"to", @"cc", @"bcc"]) {
+      for (NSDictionary *address in envelope[field]) {
+        [self addWordsInString:address[@"name"] field:field toTerms:terms];
+        [self addWordsInString:address[@"email"] field:field toTerms:terms];
+      }
+    }
+  }
+
+  for (NSDictionary *section in [message[@"sections"] allValues]) {
+    NSDictionary *headers = section[@"headers"];
+
+    for (NSString *field in headers) {
+      NSString *value = [SubImapTransferDecoder stringByDecodingEncodedWords:headers[field]];
+      [self addWordsInString:value field:field toTerms:terms];
+    }
+  }
+
+  if (message[@"bodystructure"]) {
+    [self addTextInPart:message[@"bodystructure"] message:message toTerms:terms];
+  }
+
+  for (NSString *term in terms) {
+    [self addUID:(uint32_t)UID toTerm:term];
+  }
+}
+
+- (void)addTextInPart:(NSDictionary *)part message:(NSDictionary *)message toTerms:(NSMutableSet *)terms {
+  for (NSDictionary *subpart in part[@"parts"]) {
+    [self addTextInPart:subpart message:message toTerms:terms];
+  }
+
+  if (part[@"message"]) {
+    [self addTextInPart:part[@"message"] message:message toTerms:terms];
+  }
+
+  if (![part[@"type"] isEqualToString:@"TEXT"]) {
+    return;
+  }
+
+  NSData *data = [SubImapFetchCommand decodedDataForPart:part inMessage:message];
+
+  if (!data) {
+    return;
+  }
+
+  NSString *text = [SubImapTransferDecoder stringWithData:data charset:part[@"params"][@"charset"]];
+
+  // Tag and attribute names are not words of the message
+  if ([part[@"subtype"] isEqualToString:@"HTML"]) {
+    text = [text stringByReplacingOccurrencesOfString:@"<[^>]*>" withString:@" " options:NSRegularExpressionSearch range:NSMakeRange(0, text.length)];
+  }
+
+  [self addWordsInString:text field:@"body" toTerms:terms];
+}
+
+- (void)addWordsInString:(NSString *)string field:(NSString *)field toTerms:(NSMutableSet *)terms {
+  NSArray *words = [self wordsInString:string];
+
+  if (words.count) {
+    [_fields addObject:field];
+  }
+
+  for (NSString *word in words) {
+    [terms addObject:[NSString stringWithFormat:@"%@:%@", field, word]];
+  }
+}
+
+- (void)addUID:(uint32_t)UID toTerm:(NSString *)term {
+  NSMutableData *list = _postings[term];
+
+  if (!list) {
+    list = [NSMutableData dataWithLength:sizeof(uint32_t)];
+    _postings[term] = list;
+  }
+
+  uint32_t last = SubImapPostingListLastUID(list);
+
+  // New messages
+  if (UID > last) {
+    SubImapPostingListAppendUID(list, UID);
+  }
+
+  // Older messages fetched later, which would rewrite the list each time
+  else if (UID < last) {
+    NSMutableIndexSet *pending = _pendingPostings[term];
+
+    if (!pending) {
+      pending = [NSMutableIndexSet indexSet];
+      _pendingPostings[term] = pending;
+    }
+
+    [pending addIndex:UID];
+  }
+}
+
+- (void)mergePendingPostings {
+  [_pendingPostings enumerateKeysAndObjectsUsingBlock:^(NSString *term, NSIndexSet *pending, BOOL *stop) {
+    NSMutableData *list = _postings[term];
+    NSMutableIndexSet *UIDs = SubImapPostingListUIDs(list);
+
+    if (![UIDs containsIndexes:pending]) {
+      [UIDs addIndexes:pending];
+      SubImapPostingListSetUIDs(list, UIDs);
+    }
+  }];
+
+  [_pendingPostings removeAllObjects];
+}
+
+/*
+ * Lowercase words without diacritics, eg: "Café, 2 cafes" is "cafe", "2"
+ * and "cafes".
+ */
+- (NSArray *)wordsInString:(NSString *)string {
+  static NSCharacterSet *separators;
+  static dispatch_once_t onceToken;
+
+  dispatch_once(&onceToken, ^{
+    separators = [[NSCharacterSet alphanumericCharacterSet] invertedSet];
+  });
+
+  if (![string isKindOfClass:[NSString class]] || !string.length) {
+    return @[];
+  }
+
+  NSString *folded = [string stringByFoldingWithOptions:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch locale:nil];
+  NSMutableArray *words = [NSMutableArray array];
+
+  for (NSString *word in [folded componentsSeparatedByCharactersInSet:separators]) {
+    if (word.length && word.length <= SubImapSearchIndexMaxWordLength) {
+      [words addObject:word];
+    }
+  }
+
+  return words;
+}
+
+#pragma mark Removing messages
+
+- (void)removeMessagesWithUIDs:(NSIndexSet *)UIDs {
+  NSMutableIndexSet *removed = [UIDs mutableCopy];
+  SubImapIntersectIndexes(removed, _UIDs);
+
+  if (!removed.count) {
+    return;
+  }
+
+  [_UIDs removeIndexes:removed];
+  [_removedUIDs addIndexes:removed];
+
+  [removed enumerateIndexesUsingBlock:^(NSUInteger UID, BOOL *stop) {
+    [_internalDates removeObjectForKey:@(UID)];
+    [_sizes removeObjectForKey:@(UID)];
+  }];
+
+  if (_removedUIDs.count >= SubImapSearchIndexCompactThreshold && _removedUIDs.count * 4 >= _UIDs.count) {
+    [self compact];
+  }
+}
+
+- (void)compact {
+  for (NSString *term in [_postings allKeys]) {
+    NSMutableData *list = _postings[term];
+    NSMutableIndexSet *UIDs = SubImapPostingListUIDs(list);
+    [UIDs removeIndexes:_removedUIDs];
+
+    if (UIDs.count) {
+      SubImapPostingListSetUIDs(list, UIDs);
+    } else {
+      [_postings removeObjectForKey:term];
+    }
+  }
+
+  [_removedUIDs removeAllIndexes];
+}
+
+- (void)removeAllMessages {
+  _postings = [NSMutableDictionary dictionary];
+  _pendingPostings = [NSMutableDictionary dictionary];
+  _fields = [NSMutableSet set];
+  _UIDs = [NSMutableIndexSet indexSet];
+  _removedUIDs = [NSMutableIndexSet indexSet];
+  _internalDates = [NSMutableDictionary dictionary];
+  _sizes = [NSMutableDictionary dictionary];
+}
+
+- (void)updateWithMailboxState:(SubImapMailboxState *)state {
+  if (![state.path isEqualToString:_path]) {
+    return;
+  }
+
+  _state = state;
+
+  if (state.UIDValidity && _UIDValidity && state.UIDValidity != _UIDValidity) {
+    [self removeAllMessages];
+  }
+
+  if (state.UIDValidity) {
+    _UIDValidity = state.UIDValidity;
+  }
+
+  // Only a state that knows every UID can tell which were expunged
+  if ([state sequenceNumbersWithUnknownUIDs].count) {
+    return;
+  }
+
+  NSMutableIndexSet *expunged = [_UIDs mutableCopy];
+
+  for (NSUInteger i = 1; i <= state.count; i++) {
+    [expunged removeIndex:[state UIDForSequenceNumber:i]];
+  }
+
+  [self removeMessagesWithUIDs:expunged];
+}
+
+#pragma mark Searching
+
+- (NSIndexSet *)UIDsMatchingCriteria:(SubImapSearchCriteria *)criteria {
+  return [self evaluateCriteria:criteria];
+}
+
+/*
+ * Guaranteed to only return messages in the index, or nil if the criteria
+ * can't be evaluated.
+ */
+- (NSMutableIndexSet *)evaluateCriteria:(SubImapSearchCriteria *)criteria {
+  NSString *key = criteria.key;
+  NSArray *arguments = criteria.arguments;
+
+  // Sequence numbers
+  if (!key && [arguments.firstObject isKindOfClass:[NSIndexSet class]]) {
+    return [self UIDsForSequenceNumbers:arguments[0]];
+  }
+
+  // allOf:
+  if (!key) {
+    NSMutableIndexSet *UIDs = [_UIDs mutableCopy];
+
+    for (SubImapSearchCriteria *item in arguments) {
+      NSIndexSet *matches = [self evaluateCriteria:item];
+      if (!matches) return nil;
+
+      SubImapIntersectIndexes(UIDs, matches);
+    }
+
+    return UIDs;
+  }
+
+  if ([key isEqualToString:@"ALL"]) {
+    return [_UIDs mutableCopy];
+  }
+
+  if ([key isEqualToString:@"UID"]) {
+    NSMutableIndexSet *UIDs = [arguments[0] mutableCopy];
+    SubImapIntersectIndexes(UIDs, _UIDs);
+    return UIDs;
+  }
+
+  if ([key isEqualToString:@"OR"]) {
+    NSMutableIndexSet *UIDs = [self evaluateCriteria:arguments[0]];
+    NSIndexSet *otherUIDs = [self evaluateCriteria:arguments[1]];
+    if (!UIDs || !otherUIDs) return nil;
+
+    [UIDs addIndexes:otherUIDs];
+    return UIDs;
+  }
+
+  if ([key isEqualToString:@"NOT"]) {
+    NSIndexSet *matches = [self evaluateCriteria:arguments[0]];
+    if (!matches) return nil;
+
+    NSMutableIndexSet *UIDs = [_UIDs mutableCopy];
+    [UIDs removeIndexes:matches];
+    return UIDs;
+  }
+
+  // Text
+  if ([@[@"FROM", @"TO", @"CC", @"BCC", @"SUBJECT", @"BODY"] containsObject:key]) {
+    return [self UIDsWithWordsInString:arguments[0] fields:@[[key lowercaseString]]];
+  }
+
+  if ([key isEqualToString:@"HEADER"]) {
+    return [self UIDsWithWordsInString:arguments[1] fields:@[[arguments[0] lowercaseString]]];
+  }
+
+  if ([key isEqualToString:@"TEXT"]) {
+    return [self UIDsWithWordsInString:arguments[0] fields:[_fields allObjects]];
+  }
+
+  // Dates and sizes
+  if ([@[@"BEFORE", @"ON", @"SINCE"] containsObject:key]) {
+    return [self UIDsWithInternalDate:key date:arguments[0]];
+  }
+
+  if ([key isEqualToString:@"LARGER"] || [key isEqualToString:@"SMALLER"]) {
+    return [self UIDsWithSize:key size:[arguments[0] unsignedIntegerValue]];
+  }
+
+  return [self UIDsWithFlagKey:key];
+}
+
+// Nil when the string has no words, such as HEADER "X-Spam-Flag" "",
+// which means the messages that have the header, or punctuation that a
+// server would match as a substring
+- (NSMutableIndexSet *)UIDsWithWordsInString:(NSString *)string fields:(NSArray *)fields {
+  NSArray *words = [self wordsInString:string];
+
+  if (!words.count) {
+    return nil;
+  }
+
+  NSMutableIndexSet *UIDs = [_UIDs mutableCopy];
+
+  for (NSString *word in words) {
+    NSMutableIndexSet *matches = [NSMutableIndexSet indexSet];
+
+    for (NSString *field in fields) {
+      NSData *list = _postings[[NSString stringWithFormat:@"%@:%@", field, word]];
+
+      if (list) {
+        [matches addIndexes:SubImapPostingListUIDs(list)];
+      }
+    }
+
+    SubImapIntersectIndexes(UIDs, matches);
+
+    if (!UIDs.count) {
+      break;
+    }
+  }
+
+  return UIDs;
+}
+
+// Compared by day, in the local time zone. Nil when a message was added
+// without its date, since it might match.
+- (NSMutableIndexSet *)UIDsWithInternalDate:(NSString *)key date:(NSDate *)date {
+  if (_internalDates.count < _UIDs.count) {
+    return nil;
+  }
+
+  NSDate *start;
+  NSTimeInterval length;
+  [[NSCalendar currentCalendar] rangeOfUnit:NSDayCalendarUnit startDate:&start interval:&length forDate:date];
+
+  NSMutableIndexSet *UIDs = [NSMutableIndexSet indexSet];
+
+  [_internalDates enumerateKeysAndObjectsUsingBlock:^(NSNumber *UID, NSDate *internalDate, BOOL *stop) {
+    NSTimeInterval offset = [internalDate timeIntervalSinceDate:start];
+    BOOL match;
+
+    if ([key isEqualToString:@"BEFORE"]) {
+      match = offset < 0;
+    } else if ([key isEqualToString:@"SINCE"]) {
+      match = offset >= 0;
+    } else {
+      match = offset >= 0 && offset < length;
+    }
+
+    if (match) {
+      [UIDs addIndex:[UID unsignedIntegerValue]];
+    }
+  }];
+
+  return UIDs;
+}
+
+// Nil when a message was added without its size
+- (NSMutableIndexSet *)UIDsWithSize:(NSString *)key size:(NSUInteger)size {
+  if (_sizes.count < _UIDs.count) {
+    return nil;
+  }
+
+  BOOL larger = [key isEqualToString:@"LARGER"];
+  NSMutableIndexSet *UIDs = [NSMutableIndexSet indexSet];
+
+  [_sizes enumerateKeysAndObjectsUsingBlock:^(NSNumber *UID, NSNumber *messageSize, BOOL *stop) {
+    NSUInteger value = [messageSize unsignedIntegerValue];
+
+    if (larger ? value > size : value < size) {
+      [UIDs addIndex:[UID unsignedIntegerValue]];
+    }
+  }];
+
+  return UIDs;
+}
+
+#pragma mark Mailbox state
+
+- (NSMutableIndexSet *)UIDsWithFlagKey:(NSString *)key {
+  static NSDictionary *flagKeys;
+  static dispatch_once_t onceToken;
+
+  dispatch_once(&onceToken, ^{
+    flagKeys = @{
+      @"ANSWERED": @"\\Answered", @"DELETED": @"\\Deleted", @"DRAFT": @"\\Draft",
+      @"FLAGGED": @"\\Flagged", @"SEEN": @"\\Seen",
+    };
+  });
+
+  NSString *flag;
+  BOOL set = YES;
+
+  if ([key hasPrefix:@"UN"] && flagKeys[[key substringFromIndex:2]]) {
+    flag = flagKeys[[key substringFromIndex:2]];
+    set = NO;
+  } else if ([key hasPrefix:@"KEYWORD "]) {
+    flag = [key substringFromIndex:8];
+  } else if ([key hasPrefix:@"UNKEYWORD "]) {
+    flag = [key substringFromIndex:10];
+    set = NO;
+  } else {
+    flag = flagKeys[key];
+  }
+
+  // Flags change too often to index, they come from the mailbox state
+  if (!flag || !_state) {
+    return nil;
+  }
+
+  NSIndexSet *sequenceNumbers = set ? [_state sequenceNumbersWithFlag:flag] : [_state sequenceNumbersWithoutFlag:flag];
+
+  return [self UIDsForSequenceNumbers:sequenceNumbers];
+}
+
+- (NSMutableIndexSet *)UIDsForSequenceNumbers:(NSIndexSet *)sequenceNumbers {
+  if (!_state) {
+    return nil;
+  }
+
+  NSMutableIndexSet *UIDs = [NSMutableIndexSet indexSet];
+
+  [sequenceNumbers enumerateIndexesUsingBlock:^(NSUInteger sequenceNumber, BOOL *stop) {
+    if (sequenceNumber > _state.count) {
+      *stop = YES;
+      return;
+    }
+
+    NSUInteger UID = [_state UIDForSequenceNumber:sequenceNumber];
+
+    if (UID) {
+      [UIDs addIndex:UID];
+    }
+  }];
+
+  SubImapIntersectIndexes(UIDs, _UIDs);
+
+  return UIDs;
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,41 @@
+// SubImapSocketTransport.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapTransport.h"
+#import "SubImapEventLoop.h"
+
+/*
+ * SubImapSocketTransport
+ *
+ * A plain text transport on a non-blocking socket, driven by a
+ * SubImapEventLoop. It must be opened, used and closed on the event
+ * loop's thread.
+ *
+ * The host name is resolved with getaddrinfo when opening, which blocks
+ * the event loop, so pass an address where that matters.
+ */
+@interface SubImapSocketTransport : NSObject <SubImapTransport, SubImapEventLoopHandler>
+
+- (id)initWithHost:(NSString *)host port:(NSUInteger)port eventLoop:(SubImapEventLoop *)eventLoop;
+
+@end
\ No newline at end of file
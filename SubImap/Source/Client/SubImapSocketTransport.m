@@ -0,0 +1,403 @@
+// SubImapSocketTransport.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapSocketTransport.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef MSG_NOSIGNAL
+  #define SUBIMAP_SEND_FLAGS MSG_NOSIGNAL
+#else
+  #define SUBIMAP_SEND_FLAGS 0
+#endif
+
+// Buffers gathered into a single sendmsg
+#define SUBIMAP_MAX_IOVECS 64
+
+@implementation SubImapSocketTransport {
+  NSString *_host;
+  NSUInteger _port;
+  SubImapEventLoop *_eventLoop;
+
+  int _descriptor;
+  NSUInteger _events;
+  BOOL _connecting;
+  BOOL _open;
+
+  // Bytes the socket did not take
+  NSMutableData *_pendingData;
+
+  // Send transportHasSpaceAvailable: once the socket is writable
+  BOOL _wantsSpace;
+
+  // Found while reading, and reported once the delegate is done
+  BOOL _atEnd;
+  int _readError;
+}
+
+@synthesize delegate = _delegate;
+@synthesize readingPaused = _readingPaused;
+
+- (id)initWithHost:(NSString *)host port:(NSUInteger)port eventLoop:(SubImapEventLoop *)eventLoop {
+  self = [super init];
+
+  if (self) {
+    _host = host;
+    _port = port;
+    _eventLoop = eventLoop;
+    _descriptor = -1;
+  }
+
+  return self;
+}
+
+#pragma mark SubImapTransport
+
+- (BOOL)open {
+  if (_descriptor >= 0) {
+    return NO;
+  }
+
+  _pendingData = [NSMutableData data];
+  _wantsSpace = NO;
+  _atEnd = NO;
+  _readError = 0;
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  struct addrinfo *addresses = NULL;
+  NSString *port = [NSString stringWithFormat:@"%lu", (unsigned long)_port];
+
+  if (getaddrinfo([_host UTF8String], [port UTF8String], &hints, &addresses) != 0) {
+    return NO;
+  }
+
+  // Start connecting to the first address that accepts it
+  int descriptor = -1;
+
+  for (struct addrinfo *address = addresses; address; address = address->ai_next) {
+    descriptor = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (descriptor < 0) continue;
+
+    fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL) | O_NONBLOCK);
+    fcntl(descriptor, F_SETFD, FD_CLOEXEC);
+
+    int yes = 1;
+    setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+#ifdef SO_NOSIGPIPE
+    setsockopt(descriptor, SOL_SOCKET, SO_NOSIGPIPE, &yes, sizeof(yes));
+#endif
+
+    if (connect(descriptor, address->ai_addr, address->ai_addrlen) == 0 || errno == EINPROGRESS) {
+      break;
+    }
+
+    close(descriptor);
+    descriptor = -1;
+  }
+
+  freeaddrinfo(addresses);
+
+  if (descriptor < 0) {
+    return NO;
+  }
+
+  // The socket is writable once connected
+  if (![_eventLoop addDescriptor:descriptor events:SubImapEventLoopEventWrite handler:self]) {
+    close(descriptor);
+    return NO;
+  }
+
+  _descriptor = descriptor;
+  _events = SubImapEventLoopEventWrite;
+  _connecting = YES;
+
+  return YES;
+}
+
+- (void)close {
+  if (_descriptor >= 0) {
+    [_eventLoop removeDescriptor:_descriptor];
+    close(_descriptor);
+    _descriptor = -1;
+  }
+
+  _connecting = NO;
+  _open = NO;
+  _pendingData = nil;
+}
+
+- (BOOL)isOpen {
+  return _open;
+}
+
+// Wrap the transport in a SubImapTLSTransport for TLS
+- (BOOL)startTLS {
+  return NO;
+}
+
+- (void)setReadingPaused:(BOOL)readingPaused {
+  _readingPaused = readingPaused;
+  [self updateEvents];
+}
+
+- (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)length {
+  if (!_open) {
+    return -1;
+  }
+
+  ssize_t bytesRead = recv(_descriptor, buffer, length, 0);
+
+  if (bytesRead == 0) {
+    _atEnd = YES;
+  }
+
+  else if (bytesRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+    _readError = errno;
+  }
+
+  return bytesRead;
+}
+
+- (NSInteger)write:(const uint8_t *)buffer maxLength:(NSUInteger)length {
+  if (!_open) {
+    return -1;
+  }
+
+  NSUInteger bytesWritten = 0;
+
+  // Keep bytes in order behind anything still pending
+  if (!_pendingData.length) {
+    ssize_t result = send(_descriptor, buffer, length, SUBIMAP_SEND_FLAGS);
+
+    if (result >= 0) {
+      bytesWritten = result;
+    }
+
+    else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      [self failAfterWriteWithError:errno];
+      return -1;
+    }
+  }
+
+  if (bytesWritten < length) {
+    [_pendingData appendBytes:buffer + bytesWritten length:length - bytesWritten];
+  }
+
+  _wantsSpace = YES;
+  [self updateEvents];
+
+  return length;
+}
+
+- (NSInteger)writeBuffers:(NSArray *)buffers {
+  if (!_open) {
+    return -1;
+  }
+
+  NSUInteger length = 0;
+  NSUInteger bytesWritten = 0;
+
+  for (NSData *buffer in buffers) {
+    length += [buffer length];
+  }
+
+  // Keep bytes in order behind anything still pending
+  if (!_pendingData.length) {
+    struct iovec vectors[SUBIMAP_MAX_IOVECS];
+    int count = 0;
+
+    // Anything past the last vector is left for the pending data
+    for (NSData *buffer in buffers) {
+      if (count == SUBIMAP_MAX_IOVECS) break;
+      if (![buffer length]) continue;
+
+      vectors[count].iov_base = (void *)[buffer bytes];
+      vectors[count].iov_len = [buffer length];
+      count++;
+    }
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = vectors;
+    message.msg_iovlen = count;
+
+    ssize_t result = sendmsg(_descriptor, &message, SUBIMAP_SEND_FLAGS);
+
+    if (result >= 0) {
+      bytesWritten = result;
+    }
+
+    else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      [self failAfterWriteWithError:errno];
+      return -1;
+    }
+  }
+
+  // Buffer whatever the socket did not take
+  NSUInteger offset = 0;
+
+  for (NSData *buffer in buffers) {
+    NSUInteger end = offset + [buffer length];
+
+    if (end > bytesWritten) {
+      NSUInteger skip = bytesWritten > offset ? bytesWritten - offset : 0;
+      [_pendingData appendBytes:(const uint8_t *)[buffer bytes] + skip length:[buffer length] - skip];
+    }
+
+    offset = end;
+  }
+
+  _wantsSpace = YES;
+  [self updateEvents];
+
+  return length;
+}
+
+// Reports the error after the caller is done writing
+- (void)failAfterWriteWithError:(int)error {
+  __weak SubImapSocketTransport *weakSelf = self;
+
+  [_eventLoop performBlock:^{
+    [weakSelf failWithError:error];
+  }];
+}
+
+#pragma mark SubImapEventLoopHandler
+
+- (void)eventLoop:(SubImapEventLoop *)eventLoop handleEvents:(NSUInteger)events forDescriptor:(int)descriptor {
+  if (_connecting) {
+    [self finishConnecting];
+    return;
+  }
+
+  // Errors and hangups are reported even while paused, so read what is
+  // left rather than being woken for them over and over
+  if (((events & SubImapEventLoopEventRead) && !_readingPaused) || (events & SubImapEventLoopEventError)) {
+    [self.delegate transportHasBytesAvailable:self];
+
+    if (_readError) {
+      [self failWithError:_readError];
+      return;
+    }
+
+    if (_atEnd) {
+      [self close];
+      [self.delegate transportDidEnd:self];
+      return;
+    }
+  }
+
+  // Closed by the delegate
+  if (!_open) {
+    return;
+  }
+
+  if (events & SubImapEventLoopEventWrite) {
+    [self writePendingData];
+
+    if (!_pendingData.length && _wantsSpace) {
+      _wantsSpace = NO;
+      [self updateEvents];
+      [self.delegate transportHasSpaceAvailable:self];
+    }
+  }
+}
+
+#pragma mark -
+
+- (void)finishConnecting {
+  int error = 0;
+  socklen_t errorLength = sizeof(error);
+
+  if (getsockopt(_descriptor, SOL_SOCKET, SO_ERROR, &error, &errorLength) != 0) {
+    error = errno;
+  }
+
+  if (error) {
+    [self failWithError:error];
+    return;
+  }
+
+  // Like a new NSOutputStream, announce space before anything is written
+  _connecting = NO;
+  _open = YES;
+  _wantsSpace = YES;
+  [self updateEvents];
+
+  [self.delegate transportDidOpen:self];
+}
+
+- (void)writePendingData {
+  if (!_pendingData.length) {
+    return;
+  }
+
+  ssize_t bytesWritten = send(_descriptor, [_pendingData bytes], _pendingData.length, SUBIMAP_SEND_FLAGS);
+
+  if (bytesWritten > 0) {
+    [_pendingData replaceBytesInRange:NSMakeRange(0, bytesWritten) withBytes:NULL length:0];
+  }
+
+  else if (bytesWritten < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+    [self failWithError:errno];
+  }
+}
+
+- (void)updateEvents {
+  if (_descriptor < 0) {
+    return;
+  }
+
+  NSUInteger events = _readingPaused ? 0 : SubImapEventLoopEventRead;
+
+  if (_pendingData.length || _wantsSpace) {
+    events |= SubImapEventLoopEventWrite;
+  }
+
+  if (events != _events) {
+    _events = events;
+    [_eventLoop setEvents:events forDescriptor:_descriptor];
+  }
+}
+
+- (void)failWithError:(int)error {
+  if (_descriptor < 0) {
+    return;
+  }
+
+  [self close];
+  [self.delegate transport:self didFailWithError:[NSError errorWithDomain:NSPOSIXErrorDomain code:error userInfo:nil]];
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,43 @@
+// SubImapStreamTransport.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapTypes.h"
+#import "SubImapTransport.h"
+#import "SubImapTLSTransport.h"
+
+/*
+ * SubImapStreamTransport
+ *
+ * A transport built on a pair of CFStream (NSStream with GNUstep)
+ * streams, scheduled on the run loop of the thread that opens it.
+ */
+@interface SubImapStreamTransport : NSObject <SubImapTransport, NSStreamDelegate>
+
+/*
+ * Settings are SubImapTLS*Key values, and are passed on as
+ * kCFStreamPropertySSLSettings. The system resumes TLS sessions with the
+ * same peer name on its own.
+ */
+- (id)initWithHost:(NSString *)host port:(NSUInteger)port security:(SubImapConnectionSecurity)security settings:(NSDictionary *)settings;
+
+@end
\ No newline at end of file
@@ -0,0 +1,296 @@
+// SubImapStreamTransport.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapStreamTransport.h"
+
+@implementation SubImapStreamTransport {
+  NSString *_host;
+  NSUInteger _port;
+  SubImapConnectionSecurity _security;
+  NSDictionary *_settings;
+
+  NSInputStream *_readStream;
+  NSOutputStream *_writeStream;
+  BOOL _didOpen;
+
+  // Bytes the write stream did not take
+  NSMutableData *_pendingData;
+
+  // Bytes arrived while reading was paused
+  BOOL _bytesAvailable;
+}
+
+@synthesize delegate = _delegate;
+@synthesize readingPaused = _readingPaused;
+
+- (id)initWithHost:(NSString *)host port:(NSUInteger)port security:(SubImapConnectionSecurity)security settings:(NSDictionary *)settings {
+  self = [super init];
+
+  if (self) {
+    _host = host;
+    _port = port;
+    _security = security;
+    _settings = settings;
+  }
+
+  return self;
+}
+
+- (void)dealloc {
+  [self close];
+}
+
+#pragma mark SubImapTransport
+
+- (BOOL)open {
+  _didOpen = NO;
+  _pendingData = [NSMutableData data];
+
+  if (![self createStreams]) {
+    return NO;
+  }
+
+  [_readStream setDelegate:self];
+  [_readStream scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSDefaultRunLoopMode];
+  [_readStream open];
+
+  [_writeStream setDelegate:self];
+  [_writeStream scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSDefaultRunLoopMode];
+  [_writeStream open];
+
+  return YES;
+}
+
+- (void)close {
+  _readStream.delegate = nil;
+  _writeStream.delegate = nil;
+
+  [_readStream close];
+  [_writeStream close];
+}
+
+- (BOOL)isOpen {
+  // Not initialized yet
+  if (!_readStream || !_writeStream) {
+    return NO;
+  }
+
+  // Check stream status
+  NSStreamStatus inputStatus = [_readStream streamStatus];
+  NSStreamStatus outputStatus = [_writeStream streamStatus];
+
+  return
+  (inputStatus == NSStreamStatusOpen || inputStatus == NSStreamStatusReading) &&
+  (outputStatus == NSStreamStatusOpen || outputStatus == NSStreamStatusWriting);
+}
+
+- (BOOL)startTLS {
+  if (![self isOpen]) {
+    return NO;
+  }
+
+  [self negotiateTLS];
+  return YES;
+}
+
+- (void)setReadingPaused:(BOOL)readingPaused {
+  _readingPaused = readingPaused;
+
+  // The stream doesn't announce bytes that were announced while paused
+  if (!readingPaused && (_bytesAvailable || [_readStream hasBytesAvailable])) {
+    _bytesAvailable = NO;
+    [self.delegate transportHasBytesAvailable:self];
+  }
+}
+
+- (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)length {
+  return [_readStream read:buffer maxLength:length];
+}
+
+- (NSInteger)write:(const uint8_t *)buffer maxLength:(NSUInteger)length {
+  // Keep bytes in order behind anything still pending
+  if (_pendingData.length) {
+    [_pendingData appendBytes:buffer length:length];
+    return length;
+  }
+
+  NSInteger bytesWritten = [_writeStream write:buffer maxLength:length];
+
+  if (bytesWritten < 0) {
+    return -1;
+  }
+
+  if ((NSUInteger)bytesWritten < length) {
+    [_pendingData appendBytes:buffer + bytesWritten length:length - bytesWritten];
+  }
+
+  return length;
+}
+
+// NSOutputStream has no gather write, but once a write comes up short
+// the rest of the buffers are only copied into the pending data
+- (NSInteger)writeBuffers:(NSArray *)buffers {
+  NSInteger length = 0;
+
+  for (NSData *buffer in buffers) {
+    if ([self write:[buffer bytes] maxLength:[buffer length]] < 0) {
+      return -1;
+    }
+
+    length += [buffer length];
+  }
+
+  return length;
+}
+
+#pragma mark -
+
+- (BOOL)createStreams {
+#ifdef GNUSTEP
+  NSInputStream *inputStream = nil;
+  NSOutputStream *outputStream = nil;
+
+  [NSStream getStreamsToHost:[NSHost hostWithName:_host] port:_port inputStream:&inputStream outputStream:&outputStream];
+
+  if (!inputStream || !outputStream) {
+    return NO;
+  }
+
+  _readStream = inputStream;
+  _writeStream = outputStream;
+
+  // Negotiate SSL
+  if (_security == SubImapConnectionSecurityTLS) {
+    [self negotiateTLS];
+  }
+
+  return YES;
+#else
+  CFReadStreamRef cfInputStream = NULL;
+  CFWriteStreamRef cfOutputStream = NULL;
+
+  CFStringRef cfHost = (CFStringRef)CFBridgingRetain(_host);
+  CFStreamCreatePairWithSocketToHost(NULL, cfHost, (UInt32)_port, &cfInputStream, &cfOutputStream);
+  CFRelease(cfHost);
+
+  if (!cfInputStream || !cfOutputStream) {
+    if (cfInputStream) CFRelease(cfInputStream);
+    if (cfOutputStream) CFRelease(cfOutputStream);
+    return NO;
+  }
+
+  // Configure sockets
+  CFReadStreamSetProperty(cfInputStream, kCFStreamPropertyShouldCloseNativeSocket, kCFBooleanTrue);
+  CFWriteStreamSetProperty(cfOutputStream, kCFStreamPropertyShouldCloseNativeSocket, kCFBooleanTrue);
+
+  // Bridge sockets
+  _readStream = (NSInputStream *)CFBridgingRelease(cfInputStream);
+  _writeStream = (NSOutputStream *)CFBridgingRelease(cfOutputStream);
+
+  // Negotiate SSL
+  if (_security == SubImapConnectionSecurityTLS) {
+    [self negotiateTLS];
+  }
+
+  return YES;
+#endif
+}
+
+// Setting the security level on open streams upgrades them for STARTTLS
+- (void)negotiateTLS {
+  [_readStream setProperty:NSStreamSocketSecurityLevelNegotiatedSSL forKey:NSStreamSocketSecurityLevelKey];
+  [_writeStream setProperty:NSStreamSocketSecurityLevelNegotiatedSSL forKey:NSStreamSocketSecurityLevelKey];
+
+#ifndef GNUSTEP
+  NSMutableDictionary *settings = [NSMutableDictionary dictionary];
+
+  if (_settings[SubImapTLSValidatesCertificateChainKey]) {
+    settings[(__bridge NSString *)kCFStreamSSLValidatesCertificateChain] = _settings[SubImapTLSValidatesCertificateChainKey];
+  }
+
+  settings[(__bridge NSString *)kCFStreamSSLPeerName] = _settings[SubImapTLSPeerNameKey] ?: _host;
+
+  CFReadStreamSetProperty((__bridge CFReadStreamRef)_readStream, kCFStreamPropertySSLSettings, (__bridge CFTypeRef)settings);
+  CFWriteStreamSetProperty((__bridge CFWriteStreamRef)_writeStream, kCFStreamPropertySSLSettings, (__bridge CFTypeRef)settings);
+#endif
+}
+
+#pragma mark NSStreamDelegate
+
+- (void)stream:(NSStream *)stream handleEvent:(NSStreamEvent)event {
+  id<SubImapTransportDelegate> delegate = self.delegate;
+
+  switch (event) {
+    case NSStreamEventHasBytesAvailable: {
+      if (_readingPaused) {
+        _bytesAvailable = YES;
+      }
+
+      else {
+        [delegate transportHasBytesAvailable:self];
+      }
+
+      break;
+    }
+
+    case NSStreamEventHasSpaceAvailable: {
+      // Finish writing what the stream did not take before asking for
+      // more
+      if (_pendingData.length) {
+        NSInteger bytesWritten = [_writeStream write:[_pendingData bytes] maxLength:_pendingData.length];
+
+        if (bytesWritten > 0) {
+          [_pendingData replaceBytesInRange:NSMakeRange(0, bytesWritten) withBytes:NULL length:0];
+        }
+      }
+
+      else {
+        [delegate transportHasSpaceAvailable:self];
+      }
+
+      break;
+    }
+
+    case NSStreamEventEndEncountered: {
+      [delegate transportDidEnd:self];
+      break;
+    }
+
+    case NSStreamEventErrorOccurred: {
+      [delegate transport:self didFailWithError:stream.streamError];
+      break;
+    }
+
+    case NSStreamEventOpenCompleted:
+    case NSStreamEventNone:
+    default:
+      break;
+  }
+
+  if (!_didOpen && [self isOpen]) {
+    _didOpen = YES;
+    [delegate transportDidOpen:self];
+  }
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,73 @@
+// SubImapTLSSession.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+typedef enum {
+  SubImapTLSHandshakeFailed = -1,
+  SubImapTLSHandshakeInProgress,
+  SubImapTLSHandshakeComplete,
+} SubImapTLSHandshakeStatus;
+
+/*
+ * SubImapTLSSession
+ *
+ * A TLS client engine working on memory buffers, so it can sit on top of
+ * any transport. Ciphertext from the server goes in with
+ * receiveCiphertext:length:, and ciphertext for the server comes out of
+ * takeCiphertext after every other call.
+ *
+ * SubImapOpenSSLSession is used when the library is built with
+ * SUBIMAP_OPENSSL. Other libraries, such as GnuTLS, can be plugged in with
+ * +[SubImapTLSTransport setSessionClass:].
+ */
+@protocol SubImapTLSSession <NSObject>
+
+/*
+ * Settings are SubImapTLS*Key values. Sessions should resume earlier
+ * sessions with the same host and port unless the settings turn it off.
+ */
++ (id<SubImapTLSSession>)sessionWithHost:(NSString *)host port:(NSUInteger)port settings:(NSDictionary *)settings;
+
+/*
+ * YES if the handshake resumed an earlier session.
+ */
+@property (readonly) BOOL resumed;
+
+- (void)receiveCiphertext:(const uint8_t *)bytes length:(NSUInteger)length;
+
+/*
+ * Ciphertext waiting to be sent, or nil.
+ */
+- (NSData *)takeCiphertext;
+
+- (SubImapTLSHandshakeStatus)handshake:(NSError **)error;
+
+/*
+ * Returns the number of plaintext bytes read, 0 once the server has
+ * closed the session, or -1 if there are none yet or on an error, which
+ * sets error.
+ */
+- (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)length error:(NSError **)error;
+
+- (BOOL)write:(const uint8_t *)bytes length:(NSUInteger)length error:(NSError **)error;
+
+@end
\ No newline at end of file
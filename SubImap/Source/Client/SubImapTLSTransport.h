@@ -0,0 +1,69 @@
+// SubImapTLSTransport.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapTransport.h"
+#import "SubImapTLSSession.h"
+
+/*
+ * Keys for SubImapConnection tlsSettings.
+ */
+
+// NSNumber BOOL, defaults to YES
+extern NSString * const SubImapTLSValidatesCertificateChainKey;
+
+// NSString, the name the certificate must match, defaults to the host
+extern NSString * const SubImapTLSPeerNameKey;
+
+// NSNumber BOOL, resume earlier verified sessions with the same host, port
+// and peer name, defaults to YES
+extern NSString * const SubImapTLSSessionResumptionKey;
+
+/*
+ * SubImapTLSTransport
+ *
+ * Encrypts another transport, such as a SubImapSocketTransport, with a
+ * SubImapTLSSession.
+ *
+ * The handshake starts as soon as the underlying transport opens, or
+ * from startTLS when created for STARTTLS. Data written during the
+ * handshake is sent once it completes.
+ */
+@interface SubImapTLSTransport : NSObject <SubImapTransport, SubImapTransportDelegate>
+
+/*
+ * The class sessions are created with. Defaults to SubImapOpenSSLSession
+ * when it is built in, otherwise nil, and opening a TLS transport fails.
+ */
++ (Class)sessionClass;
++ (void)setSessionClass:(Class)sessionClass;
+
+@property (readonly) id<SubImapTransport> transport;
+
+/*
+ * The current TLS session, once the handshake has started.
+ */
+@property (readonly) id<SubImapTLSSession> session;
+
+- (id)initWithTransport:(id<SubImapTransport>)transport host:(NSString *)host port:(NSUInteger)port settings:(NSDictionary *)settings startImmediately:(BOOL)startImmediately;
+
+@end
\ No newline at end of file
@@ -0,0 +1,354 @@
+// SubImapTLSTransport.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapTLSTransport.h"
+
+#include <errno.h>
+
+NSString * const SubImapTLSValidatesCertificateChainKey = @"SubImapTLSValidatesCertificateChain";
+NSString * const SubImapTLSPeerNameKey = @"SubImapTLSPeerName";
+NSString * const SubImapTLSSessionResumptionKey = @"SubImapTLSSessionResumption";
+
+static Class SubImapTLSTransportSessionClass = Nil;
+
+@implementation SubImapTLSTransport {
+  NSString *_host;
+  NSUInteger _port;
+  NSDictionary *_settings;
+  BOOL _startImmediately;
+
+  BOOL _didOpen;
+  BOOL _tls;
+  BOOL _handshaking;
+
+  // Plaintext written during the handshake
+  NSMutableData *_pendingData;
+
+  // The underlying transport had space during the handshake
+  BOOL _wantsSpace;
+
+  // Found while the delegate reads, and handled once it is done
+  BOOL _didReadPlaintext;
+  BOOL _atEnd;
+  NSError *_readError;
+}
+
+@synthesize delegate = _delegate;
+
++ (Class)sessionClass {
+  @synchronized (self) {
+    return SubImapTLSTransportSessionClass ?: NSClassFromString(@"SubImapOpenSSLSession");
+  }
+}
+
++ (void)setSessionClass:(Class)sessionClass {
+  @synchronized (self) {
+    SubImapTLSTransportSessionClass = sessionClass;
+  }
+}
+
+- (id)initWithTransport:(id<SubImapTransport>)transport host:(NSString *)host port:(NSUInteger)port settings:(NSDictionary *)settings startImmediately:(BOOL)startImmediately {
+  self = [super init];
+
+  if (self) {
+    _transport = transport;
+    _host = host;
+    _port = port;
+    _settings = settings;
+    _startImmediately = startImmediately;
+  }
+
+  return self;
+}
+
+#pragma mark SubImapTransport
+
+- (BOOL)open {
+  _session = nil;
+  _didOpen = NO;
+  _tls = NO;
+  _handshaking = NO;
+  _pendingData = [NSMutableData data];
+  _wantsSpace = NO;
+
+  _transport.delegate = self;
+  return [_transport open];
+}
+
+- (void)close {
+  [_transport close];
+  _session = nil;
+  _didOpen = NO;
+}
+
+- (BOOL)isOpen {
+  return _didOpen && [_transport isOpen];
+}
+
+- (BOOL)startTLS {
+  if (_tls || ![_transport isOpen]) {
+    return NO;
+  }
+
+  _session = [[[self class] sessionClass] sessionWithHost:_host port:_port settings:_settings];
+
+  if (!_session) {
+    return NO;
+  }
+
+  _tls = YES;
+  _handshaking = YES;
+  [self continueHandshake];
+
+  return YES;
+}
+
+- (BOOL)readingPaused {
+  return _transport.readingPaused;
+}
+
+- (void)setReadingPaused:(BOOL)readingPaused {
+  _transport.readingPaused = readingPaused;
+
+  // The session can hold plaintext that was decrypted before pausing
+  if (!readingPaused && _tls && !_handshaking && _session) {
+    [self readPlaintext];
+  }
+}
+
+- (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)length {
+  if (!_tls) {
+    return [_transport read:buffer maxLength:length];
+  }
+
+  if (_handshaking || !_session) {
+    return -1;
+  }
+
+  NSError *error = nil;
+  NSInteger bytesRead = [_session read:buffer maxLength:length error:&error];
+
+  // Reading can produce records to send, such as key updates
+  [self writeCiphertext];
+
+  if (bytesRead > 0) {
+    _didReadPlaintext = YES;
+  }
+
+  else if (bytesRead == 0) {
+    _atEnd = YES;
+  }
+
+  else if (error) {
+    _readError = error;
+  }
+
+  return bytesRead;
+}
+
+- (NSInteger)write:(const uint8_t *)buffer maxLength:(NSUInteger)length {
+  if (!_tls) {
+    return [_transport write:buffer maxLength:length];
+  }
+
+  if (!_session) {
+    return -1;
+  }
+
+  if (_handshaking) {
+    [_pendingData appendBytes:buffer length:length];
+    return length;
+  }
+
+  NSError *error = nil;
+
+  if (![_session write:buffer length:length error:&error]) {
+    [self failWithError:error];
+    return -1;
+  }
+
+  [self writeCiphertext];
+  return length;
+}
+
+- (NSInteger)writeBuffers:(NSArray *)buffers {
+  if (!_tls) {
+    return [_transport writeBuffers:buffers];
+  }
+
+  if (!_session) {
+    return -1;
+  }
+
+  NSInteger length = 0;
+  NSError *error = nil;
+
+  for (NSData *buffer in buffers) {
+    if (_handshaking) {
+      [_pendingData appendData:buffer];
+    }
+
+    else if (![_session write:[buffer bytes] length:[buffer length] error:&error]) {
+      [self failWithError:error];
+      return -1;
+    }
+
+    length += [buffer length];
+  }
+
+  // The records for every buffer go out in one write
+  [self writeCiphertext];
+  return length;
+}
+
+#pragma mark SubImapTransportDelegate
+
+- (void)transportDidOpen:(id<SubImapTransport>)transport {
+  if (!_startImmediately) {
+    _didOpen = YES;
+    [self.delegate transportDidOpen:self];
+    return;
+  }
+
+  if (![self startTLS]) {
+    [self failWithError:[NSError errorWithDomain:NSPOSIXErrorDomain code:EPROTONOSUPPORT userInfo:nil]];
+  }
+}
+
+- (void)transportHasBytesAvailable:(id<SubImapTransport>)transport {
+  if (!_tls) {
+    [self.delegate transportHasBytesAvailable:self];
+    return;
+  }
+
+  uint8_t buffer[16384];
+  NSInteger bytesRead = [_transport read:buffer maxLength:sizeof(buffer)];
+
+  if (bytesRead <= 0) {
+    return;
+  }
+
+  [_session receiveCiphertext:buffer length:bytesRead];
+
+  if (_handshaking) {
+    [self continueHandshake];
+  }
+
+  else {
+    [self readPlaintext];
+  }
+}
+
+- (void)transportHasSpaceAvailable:(id<SubImapTransport>)transport {
+  if (_handshaking) {
+    _wantsSpace = YES;
+    return;
+  }
+
+  [self.delegate transportHasSpaceAvailable:self];
+}
+
+- (void)transportDidEnd:(id<SubImapTransport>)transport {
+  _didOpen = NO;
+  [self.delegate transportDidEnd:self];
+}
+
+- (void)transport:(id<SubImapTransport>)transport didFailWithError:(NSError *)error {
+  [self.delegate transport:self didFailWithError:error];
+}
+
+#pragma mark -
+
+- (void)continueHandshake {
+  NSError *error = nil;
+  SubImapTLSHandshakeStatus status = [_session handshake:&error];
+
+  [self writeCiphertext];
+
+  if (status == SubImapTLSHandshakeFailed) {
+    [self failWithError:error];
+    return;
+  }
+
+  if (status == SubImapTLSHandshakeInProgress) {
+    return;
+  }
+
+  _handshaking = NO;
+
+  // Send what was written during the handshake
+  if (_pendingData.length) {
+    NSData *pendingData = _pendingData;
+    _pendingData = [NSMutableData data];
+    [self write:[pendingData bytes] maxLength:[pendingData length]];
+  }
+
+  if (!_didOpen) {
+    _didOpen = YES;
+    [self.delegate transportDidOpen:self];
+  }
+
+  if (_wantsSpace && _session) {
+    _wantsSpace = NO;
+    [self.delegate transportHasSpaceAvailable:self];
+  }
+
+  // Data can arrive with the last handshake message
+  [self readPlaintext];
+}
+
+// One read of ciphertext can hold more plaintext than the delegate reads
+// at a time, so keep offering it until a read comes up empty
+- (void)readPlaintext {
+  _atEnd = NO;
+  _readError = nil;
+
+  do {
+    _didReadPlaintext = NO;
+    [self.delegate transportHasBytesAvailable:self];
+  } while (_didReadPlaintext && _session && !_transport.readingPaused);
+
+  if (_readError) {
+    [self failWithError:_readError];
+  }
+
+  else if (_atEnd && _session) {
+    [self close];
+    [self.delegate transportDidEnd:self];
+  }
+}
+
+- (void)writeCiphertext {
+  NSData *ciphertext = [_session takeCiphertext];
+
+  if (ciphertext.length) {
+    [_transport write:[ciphertext bytes] maxLength:[ciphertext length]];
+  }
+}
+
+- (void)failWithError:(NSError *)error {
+  [self close];
+  [self.delegate transport:self didFailWithError:error];
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,95 @@
+// SubImapThreadIndex.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/*
+ * SubImapThreadIndex
+ *
+ * Groups one mailbox's messages into conversations as they are fetched,
+ * with the reference linking of the JWZ algorithm,
+ * https://www.jwz.org/doc/threading.html, without its subject pass.
+ *
+ * Each message-id is interned once into a node number. Nodes are kept in
+ * one array of parent, first child and next sibling numbers, so adding a
+ * message costs a dictionary lookup per reference and a walk up its
+ * thread to rule out loops, however many messages the index holds.
+ * Message-ids that are referenced but not in the mailbox keep empty
+ * nodes, which hold their replies together.
+ *
+ * Gmail messages with an "x-gm-thrid" join that thread even when their
+ * references are missing. Threads from a THREAD command can be added
+ * too, and take precedence over local linking.
+ */
+@interface SubImapThreadIndex : NSObject
+
++ (instancetype)index;
+
+/*
+ * The number of messages in the index.
+ */
+@property (readonly) NSUInteger count;
+
+/*
+ * Adds a message from a UID FETCH. It needs its "uid" and "envelope".
+ * References are read from a fetched References header, eg:
+ * fieldForHeaderFields:@[@"REFERENCES"], or else from the envelope's
+ * in-reply-to. A message already in the index is left as it is.
+ */
+- (void)addMessage:(NSDictionary *)message;
+- (void)addMessages:(NSArray *)messages;
+
+/*
+ * Adds the result of a UID THREAD command, SubImapThreadCommand.
+ */
+- (void)addThreads:(NSArray *)threads;
+
+/*
+ * Removes expunged messages. Their nodes stay, empty, so their replies
+ * remain in one thread.
+ */
+- (void)removeMessageWithUID:(NSUInteger)UID;
+- (void)removeMessagesWithUIDs:(NSIndexSet *)UIDs;
+
+/*
+ * An identifier for the message's thread, or 0 if the message is not
+ * in the index. Two messages are in the same thread when these match.
+ * It changes when the thread gains a new root.
+ */
+- (NSUInteger)threadIDForUID:(NSUInteger)UID;
+
+/*
+ * Every message in the message's thread, including itself.
+ */
+- (NSIndexSet *)UIDsInThreadOfUID:(NSUInteger)UID;
+
+/*
+ * The message the message replied to, skipping messages that are not in
+ * the mailbox, or 0 for the first message of a thread.
+ */
+- (NSUInteger)parentUIDOfUID:(NSUInteger)UID;
+
+/*
+ * The UIDs of each thread, as NSIndexSets.
+ */
+- (NSArray *)threads;
+
+@end
\ No newline at end of file
@@ -0,0 +1,373 @@
+// SubImapThreadIndex.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapThreadIndex.h"
+
+// Node numbers start at 1, so 0 can mean none
+typedef struct {
+  uint32_t parent;
+  uint32_t firstChild;
+  uint32_t nextSibling;
+  uint32_t UID;         // 0 for a message that is not in the mailbox
+} SubImapThreadNode;
+
+@implementation SubImapThreadIndex {
+  // Indexed by node number - 1
+  SubImapThreadNode *_nodes;
+  NSUInteger _length;
+  NSUInteger _capacity;
+
+  // Node numbers, keyed by message-id or Gmail thread
+  NSMutableDictionary *_nodesByKey;
+
+  // Node numbers, keyed by UID
+  NSMutableDictionary *_nodesByUID;
+}
+
++ (instancetype)index {
+  return [[self alloc] init];
+}
+
+- (id)init {
+  self = [super init];
+
+  if (self) {
+    _nodesByKey = [NSMutableDictionary dictionary];
+    _nodesByUID = [NSMutableDictionary dictionary];
+  }
+
+  return self;
+}
+
+- (void)dealloc {
+  free(_nodes);
+}
+
+- (NSUInteger)count {
+  return _nodesByUID.count;
+}
+
+#pragma mark Adding messages
+
+- (void)addMessages:(NSArray *)messages {
+  for (NSDictionary *message in messages) {
+    [self addMessage:message];
+  }
+}
+
+- (void)addMessage:(NSDictionary *)message {
+  NSUInteger UID = [message[@"uid"] unsignedIntegerValue];
+
+  if (!UID || UID > UINT32_MAX || _nodesByUID[@(UID)]) {
+    return;
+  }
+
+  NSString *messageID = [[self messageIDsInString:message[@"envelope"][@"id"]] firstObject];
+  uint32_t node = messageID ? [self nodeForKey:messageID] : 0;
+
+  // A second message with the same message-id is threaded on its own
+  if (!node || _nodes[node - 1].UID) {
+    node = [self newNode];
+  }
+
+  _nodes[node - 1].UID = (uint32_t)UID;
+  _nodesByUID[@(UID)] = @(node);
+
+  // Each reference replied to the one before it, unless already known
+  uint32_t previous = 0;
+
+  for (NSString *reference in [self referencesInMessage:message]) {
+    uint32_t referenced = [self nodeForKey:reference];
+
+    if (previous && !_nodes[referenced - 1].parent && ![self node:referenced isAncestorOfNode:previous]) {
+      [self setParent:previous ofNode:referenced];
+    }
+
+    previous = referenced;
+  }
+
+  // The message itself replied to the last one, whatever was guessed
+  if (previous && ![self node:node isAncestorOfNode:previous]) {
+    [self setParent:previous ofNode:node];
+  }
+
+  // Gmail already knows the thread
+  NSString *threadID = message[@"x-gm-thrid"];
+
+  if (threadID) {
+    uint32_t thread = [self nodeForKey:[@"x-gm-thrid:" stringByAppendingString:[threadID description]]];
+    uint32_t root = [self rootOfNode:node];
+
+    // The root can be another Gmail thread that this one already joined,
+    // when replies cross thread IDs
+    if (root != thread && ![self node:root isAncestorOfNode:thread]) {
+      [self setParent:thread ofNode:root];
+    }
+  }
+}
+
+- (void)addThreads:(NSArray *)threads {
+  for (NSDictionary *thread in threads) {
+    [self addThreadNode:thread parent:0];
+  }
+}
+
+- (void)addThreadNode:(NSDictionary *)threadNode parent:(uint32_t)parent {
+  NSUInteger UID = [threadNode[@"id"] unsignedIntegerValue];
+  uint32_t node = 0;
+
+  if (UID && UID <= UINT32_MAX) {
+    node = [_nodesByUID[@(UID)] unsignedIntValue];
+
+    if (!node) {
+      node = [self newNode];
+      _nodes[node - 1].UID = (uint32_t)UID;
+      _nodesByUID[@(UID)] = @(node);
+    }
+  }
+
+  // A missing message that its children replied to
+  else {
+    node = [self newNode];
+  }
+
+  if (parent && ![self node:node isAncestorOfNode:parent]) {
+    [self setParent:parent ofNode:node];
+  }
+
+  for (NSDictionary *child in threadNode[@"children"]) {
+    [self addThreadNode:child parent:node];
+  }
+}
+
+#pragma mark Removing messages
+
+- (void)removeMessageWithUID:(NSUInteger)UID {
+  uint32_t node = [_nodesByUID[@(UID)] unsignedIntValue];
+
+  if (node) {
+    _nodes[node - 1].UID = 0;
+    [_nodesByUID removeObjectForKey:@(UID)];
+  }
+}
+
+- (void)removeMessagesWithUIDs:(NSIndexSet *)UIDs {
+  [UIDs enumerateIndexesUsingBlock:^(NSUInteger UID, BOOL *stop) {
+    [self removeMessageWithUID:UID];
+  }];
+}
+
+#pragma mark Threads
+
+- (NSUInteger)threadIDForUID:(NSUInteger)UID {
+  uint32_t node = [_nodesByUID[@(UID)] unsignedIntValue];
+  return node ? [self rootOfNode:node] : 0;
+}
+
+- (NSIndexSet *)UIDsInThreadOfUID:(NSUInteger)UID {
+  NSMutableIndexSet *UIDs = [NSMutableIndexSet indexSet];
+  NSUInteger thread = [self threadIDForUID:UID];
+
+  if (thread) {
+    [self addUIDsUnderNode:(uint32_t)thread toSet:UIDs];
+  }
+
+  return UIDs;
+}
+
+- (NSUInteger)parentUIDOfUID:(NSUInteger)UID {
+  uint32_t node = [_nodesByUID[@(UID)] unsignedIntValue];
+
+  if (!node) {
+    return 0;
+  }
+
+  for (uint32_t parent = _nodes[node - 1].parent; parent; parent = _nodes[parent - 1].parent) {
+    if (_nodes[parent - 1].UID) {
+      return _nodes[parent - 1].UID;
+    }
+  }
+
+  return 0;
+}
+
+- (NSArray *)threads {
+  NSMutableArray *threads = [NSMutableArray array];
+
+  for (NSUInteger i = 0; i < _length; i++) {
+    if (_nodes[i].parent) {
+      continue;
+    }
+
+    NSMutableIndexSet *UIDs = [NSMutableIndexSet indexSet];
+    [self addUIDsUnderNode:(uint32_t)i + 1 toSet:UIDs];
+
+    if (UIDs.count) {
+      [threads addObject:UIDs];
+    }
+  }
+
+  return threads;
+}
+
+#pragma mark Nodes
+
+- (uint32_t)newNode {
+  if (_length == _capacity) {
+    _capacity = MAX(_capacity * 2, 64);
+    _nodes = reallocf(_nodes, _capacity * sizeof(SubImapThreadNode));
+  }
+
+  _nodes[_length] = (SubImapThreadNode){0, 0, 0, 0};
+  _length++;
+
+  return (uint32_t)_length;
+}
+
+- (uint32_t)nodeForKey:(NSString *)key {
+  NSNumber *node = _nodesByKey[key];
+
+  if (node) {
+    return [node unsignedIntValue];
+  }
+
+  uint32_t newNode = [self newNode];
+  _nodesByKey[key] = @(newNode);
+
+  return newNode;
+}
+
+- (uint32_t)rootOfNode:(uint32_t)node {
+  while (_nodes[node - 1].parent) {
+    node = _nodes[node - 1].parent;
+  }
+
+  return node;
+}
+
+/*
+ * YES if node is other, or one of its parents. Linking other under node
+ * would then make a loop.
+ */
+- (BOOL)node:(uint32_t)node isAncestorOfNode:(uint32_t)other {
+  for (; other; other = _nodes[other - 1].parent) {
+    if (other == node) {
+      return YES;
+    }
+  }
+
+  return NO;
+}
+
+- (void)setParent:(uint32_t)parent ofNode:(uint32_t)node {
+  SubImapThreadNode *child = &_nodes[node - 1];
+
+  if (child->parent == parent) {
+    return;
+  }
+
+  // Unlink from the old parent's children
+  if (child->parent) {
+    uint32_t *link = &_nodes[child->parent - 1].firstChild;
+
+    while (*link != node) {
+      link = &_nodes[*link - 1].nextSibling;
+    }
+
+    *link = child->nextSibling;
+  }
+
+  child->parent = parent;
+  child->nextSibling = _nodes[parent - 1].firstChild;
+  _nodes[parent - 1].firstChild = node;
+}
+
+- (void)addUIDsUnderNode:(uint32_t)root toSet:(NSMutableIndexSet *)UIDs {
+  uint32_t node = root;
+
+  // Depth first, without recursion
+  while (node) {
+    if (_nodes[node - 1].UID) {
+      [UIDs addIndex:_nodes[node - 1].UID];
+    }
+
+    if (_nodes[node - 1].firstChild) {
+      node = _nodes[node - 1].firstChild;
+      continue;
+    }
+
+    while (node != root && !_nodes[node - 1].nextSibling) {
+      node = _nodes[node - 1].parent;
+    }
+
+    node = (node == root) ? 0 : _nodes[node - 1].nextSibling;
+  }
+}
+
+#pragma mark Message-ids
+
+/*
+ * The message-ids in a References or In-Reply-To value, eg:
+ * "<a@example.com> <b@example.com>".
+ */
+- (NSArray *)messageIDsInString:(NSString *)string {
+  NSMutableArray *messageIDs = [NSMutableArray array];
+
+  if (![string isKindOfClass:[NSString class]]) {
+    return messageIDs;
+  }
+
+  NSUInteger length = string.length;
+  NSRange search = NSMakeRange(0, length);
+
+  while (search.length) {
+    NSRange open = [string rangeOfString:@"<" options:NSLiteralSearch range:search];
+    if (open.location == NSNotFound) break;
+
+    NSRange rest = NSMakeRange(open.location + 1, length - open.location - 1);
+    NSRange close = [string rangeOfString:@">" options:NSLiteralSearch range:rest];
+    if (close.location == NSNotFound) break;
+
+    [messageIDs addObject:[string substringWithRange:NSMakeRange(open.location, close.location + 1 - open.location)]];
+    search = NSMakeRange(close.location + 1, length - close.location - 1);
+  }
+
+  return messageIDs;
+}
+
+- (NSArray *)referencesInMessage:(NSDictionary *)message {
+  for (NSDictionary *section in [message[@"sections"] allValues]) {
+    NSString *references = section[@"headers"][@"references"];
+
+    if (references) {
+      return [self messageIDsInString:references];
+    }
+  }
+
+  // In-Reply-To can hold other text, so only its first message-id
+  NSString *inReplyTo = [[self messageIDsInString:message[@"envelope"][@"in-reply-to"]] firstObject];
+
+  return inReplyTo ? @[inReplyTo] : @[];
+}
+
+@end
\ No newline at end of file
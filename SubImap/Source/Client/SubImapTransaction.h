@@ -25,11 +25,76 @@
 #import "SubImapCommand.h"
 
 @class SubImapClient;
+@class SubImapGmailMessageStore;
+@class SubImapSearchCriteria;
 
 @interface SubImapTransaction : NSObject
 
+/*
+ * The mailbox this transaction selects and works in, or nil if it does not
+ * depend on the selected mailbox (for example STATUS or LIST).
+ *
+ * Setting a mailbox also makes the transaction non-exclusive.
+ */
+@property (nonatomic, copy) NSString *mailbox;
+
+/*
+ * An exclusive transaction runs on its own: it waits for every running
+ * transaction to finish, and nothing else starts until it is done. Use
+ * this for transactions that change the client's state, such as logging
+ * in or out.
+ *
+ * A non-exclusive transaction may run alongside others, with their
+ * commands interleaved on the connection. Transactions with different
+ * mailboxes never run at the same time.
+ *
+ * Defaults to YES.
+ */
+@property (nonatomic) BOOL exclusive;
+
 + (instancetype)transaction;
 
+/*
+ * A non-exclusive transaction that works in the given mailbox.
+ */
++ (instancetype)transactionWithMailbox:(NSString *)mailbox;
+
+/*
+ * A non-exclusive transaction that lists every mailbox with the given
+ * status items, such as MESSAGES and UNSEEN, and results in the
+ * SubImapListCommand mailboxTree.
+ *
+ * Uses LIST-STATUS when the server supports it, or else pipelines one
+ * STATUS per mailbox, so either way it takes at most two round trips.
+ */
++ (instancetype)mailboxTreeTransactionWithStatusItems:(NSArray *)items;
+
+/*
+ * A transaction that selects the source mailbox and moves the messages
+ * to the destination, resulting in the SubImapMoveCommand result.
+ *
+ * Without MOVE, it copies them, sets \Deleted and, with UIDPLUS,
+ * expunges just those messages. Without UIDPLUS they are left marked
+ * \Deleted, since EXPUNGE would remove every such message.
+ */
++ (instancetype)moveTransactionWithUIDs:(NSIndexSet *)UIDs fromMailbox:(NSString *)source toMailbox:(NSString *)destination;
+
+/*
+ * A transaction that downloads a Gmail mailbox's messages, skipping any
+ * already in the store under another label. It selects the mailbox,
+ * finds the messages matching the criteria, or every message if it is
+ * nil, and fetches their X-GM-MSGID. Only messages the store does not
+ * hold are then fetched with the given fields, and stored as they
+ * arrive.
+ *
+ * Use SubImapSearchCriteria gmailRaw: to narrow down the messages with a
+ * Gmail query. The result is a dictionary:
+ *
+ *   "fetched": (NSIndexSet *) UIDs of the messages downloaded
+ *   "skipped": (NSIndexSet *) UIDs of the messages already stored
+ */
++ (instancetype)gmailFetchTransactionWithMailbox:(NSString *)path criteria:(SubImapSearchCriteria *)criteria fields:(NSArray *)fields store:(SubImapGmailMessageStore *)store;
+
 - (void)addBlock:(SubImapTransactionBlock)block;
 
 - (void)addCommand:(SubImapCommand *)command;
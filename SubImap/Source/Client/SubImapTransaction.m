@@ -24,6 +24,15 @@
 #import "SubImapTransaction.h"
 
 #import "SubImapClient.h"
+#import "SubImapExpungeCommand.h"
+#import "SubImapFetchCommand.h"
+#import "SubImapGmailMessageStore.h"
+#import "SubImapListCommand.h"
+#import "SubImapMoveCommand.h"
+#import "SubImapSearchCommand.h"
+#import "SubImapSelectCommand.h"
+#import "SubImapStatusCommand.h"
+#import "SubImapStoreCommand.h"
 
 @implementation SubImapTransaction {
   NSMutableArray *_blocks;
@@ -34,17 +43,181 @@
   return [[self alloc] init];
 }
 
++ (instancetype)transactionWithMailbox:(NSString *)mailbox {
+  SubImapTransaction *transaction = [self transaction];
+  transaction.mailbox = mailbox;
+  return transaction;
+}
+
++ (instancetype)mailboxTreeTransactionWithStatusItems:(NSArray *)items {
+  SubImapTransaction *transaction = [self transaction];
+  transaction.exclusive = NO;
+
+  SubImapListCommand *list = [SubImapListCommand commandWithAll];
+  list.statusItems = items;
+
+  [transaction addCommand:list];
+
+  // Without LIST-STATUS, pipeline a STATUS for every mailbox instead
+  [transaction addBlock:^id(id result) {
+    NSArray *paths = [list mailboxPathsWithoutStatus];
+
+    if (!items.count || !paths.count) {
+      return result;
+    }
+
+    return [SubImapStatusCommand commandWithMailboxes:paths items:items];
+  }];
+
+  [transaction addBlock:^id(id result) {
+    if ([result isKindOfClass:[NSDictionary class]]) {
+      [list addStatuses:result];
+    }
+
+    return [list mailboxTree];
+  }];
+
+  return transaction;
+}
+
++ (instancetype)moveTransactionWithUIDs:(NSIndexSet *)UIDs fromMailbox:(NSString *)source toMailbox:(NSString *)destination {
+  SubImapTransaction *transaction = [self transactionWithMailbox:source];
+  SubImapMoveCommand *move = [SubImapMoveCommand commandWithUIDs:UIDs mailbox:destination];
+
+  [transaction addCommand:[SubImapSelectCommand commandWithMailboxPath:source]];
+  [transaction addCommand:move];
+
+  // Without MOVE, the copied messages still have to be removed
+  [transaction addBlock:^id(id result) {
+    if (!move.copiedOnly) {
+      return result;
+    }
+
+    return [SubImapStoreCommand commandWithUIDs:UIDs flags:@[@"\\Deleted"] operation:SubImapStoreOperationAdd];
+  }];
+
+  // A plain EXPUNGE would also remove other messages marked \Deleted
+  [transaction addBlock:^id(id result) {
+    if (!move.copiedOnly || ![move.capabilities containsObject:@"UIDPLUS"]) {
+      return result;
+    }
+
+    return [SubImapExpungeCommand commandWithUIDs:UIDs];
+  }];
+
+  [transaction addBlock:^id(id result) {
+    return move.result;
+  }];
+
+  return transaction;
+}
+
++ (instancetype)gmailFetchTransactionWithMailbox:(NSString *)path criteria:(SubImapSearchCriteria *)criteria fields:(NSArray *)fields store:(SubImapGmailMessageStore *)store {
+  SubImapTransaction *transaction = [self transactionWithMailbox:path];
+  NSMutableIndexSet *fetched = [NSMutableIndexSet indexSet];
+  NSMutableIndexSet *skipped = [NSMutableIndexSet indexSet];
+  NSArray *IDFields = @[@"UID", @"X-GM-MSGID"];
+
+  [transaction addCommand:[SubImapSelectCommand commandWithMailboxPath:path]];
+
+  [transaction addBlock:^id(id result) {
+    return criteria ? [SubImapSearchCommand UIDCommandWithCriteria:criteria] : nil;
+  }];
+
+  // Only message IDs, which are small next to the messages
+  [transaction addBlock:^id(id result) {
+    NSIndexSet *UIDs = result[@"all"];
+
+    if (criteria && !UIDs.count) {
+      return @[];
+    }
+
+    SubImapFetchCommand *fetch = criteria ? [SubImapFetchCommand commandWithUIDSet:UIDs] : [SubImapFetchCommand commandWithAll];
+    fetch.fields = IDFields;
+
+    return fetch;
+  }];
+
+  // Then only the messages not stored under another label
+  [transaction addBlock:^id(NSArray *messages) {
+    NSMutableIndexSet *missing = [NSMutableIndexSet indexSet];
+
+    for (NSDictionary *message in messages) {
+      NSString *messageID = message[@"x-gm-msgid"];
+      NSUInteger UID = [message[@"uid"] unsignedIntegerValue];
+
+      if (!messageID || !UID) {
+        continue;
+      }
+
+      [store addUID:UID inMailbox:path forMessageID:messageID];
+
+      if ([store containsMessageWithID:messageID]) {
+        [skipped addIndex:UID];
+      } else {
+        [missing addIndex:UID];
+      }
+    }
+
+    if (!missing.count) {
+      return nil;
+    }
+
+    NSMutableArray *messageFields = [IDFields mutableCopy];
+
+    for (NSString *field in fields) {
+      if (![messageFields containsObject:[field uppercaseString]]) {
+        [messageFields addObject:field];
+      }
+    }
+
+    SubImapFetchCommand *fetch = [SubImapFetchCommand commandWithUIDSet:missing];
+    fetch.fields = messageFields;
+    fetch.batchSize = 100;
+    fetch.retainsMessages = NO;
+
+    [fetch addMessagesBlock:^(NSArray *batch) {
+      for (NSDictionary *message in batch) {
+        NSString *messageID = message[@"x-gm-msgid"];
+
+        if (messageID) {
+          [store storeMessage:message withID:messageID];
+          [fetched addIndex:[message[@"uid"] unsignedIntegerValue]];
+        }
+      }
+    }];
+
+    return fetch;
+  }];
+
+  [transaction addBlock:^id(id result) {
+    return @{@"fetched": fetched, @"skipped": skipped};
+  }];
+
+  return transaction;
+}
+
 - (id)init {
   self = [super init];
 
   if (self) {
     _blocks = [NSMutableArray array];
     _errorBlocks = [NSMutableArray array];
+
+    self.exclusive = YES;
   }
 
   return self;
 }
 
+- (void)setMailbox:(NSString *)mailbox {
+  _mailbox = [mailbox copy];
+
+  if (mailbox) {
+    self.exclusive = NO;
+  }
+}
+
 #pragma mark -
 
 - (void)addCommand:(SubImapCommand *)command {
@@ -24,6 +24,17 @@
 #import "SubImapClient.h"
 #import "SubImapTransaction.h"
 
+/*
+ * SubImapTransactionalClient
+ *
+ * Runs SubImapTransactions in the order they are enqueued.
+ *
+ * Exclusive transactions run one at a time, as barriers. Non-exclusive
+ * transactions run together and their commands are interleaved, so a
+ * quick STATUS poll or flag update does not wait for a large download
+ * to finish. Transactions for different mailboxes are still run one
+ * after the other, since only one mailbox can be selected at a time.
+ */
 @interface SubImapTransactionalClient : SubImapClient
 
 - (void)enqueueTransaction:(SubImapTransaction *)transaction;
@@ -25,14 +25,20 @@
 
 @implementation SubImapTransactionalClient {
   NSMutableArray *_transactionQueue;
-  SubImapTransaction *_activeTransaction;
+  NSMutableArray *_activeTransactions;
+
+  // A transaction can finish while it is started, which asks for the
+  // queue to be processed again from inside processTransactionQueue
+  BOOL _processingQueue;
+  BOOL _queueChanged;
 }
 
 - (id)init {
-  self = [super self];
+  self = [super init];
 
   if (self) {
     _transactionQueue = [NSMutableArray array];
+    _activeTransactions = [NSMutableArray array];
   }
 
   return self;
@@ -45,15 +51,15 @@
     return;
   }
 
+  __weak SubImapTransaction *weakTransaction = transaction;
+
   [transaction addBlock:^id(id result) {
-    _activeTransaction = nil;
-    [self processTransactionQueue];
+    [self finishTransaction:weakTransaction];
     return nil;
   }];
 
   [transaction addErrorBlock:^(NSError *error) {
-    _activeTransaction = nil;
-    [self processTransactionQueue];
+    [self finishTransaction:weakTransaction];
   }];
 
   [_transactionQueue addObject:transaction];
@@ -62,24 +68,100 @@
 
 - (void)dequeueAllCommands {
   [_transactionQueue removeAllObjects];
-  _activeTransaction = nil;
+  [_activeTransactions removeAllObjects];
   [super dequeueAllCommands];
 }
 
 #pragma mark -
 
+- (void)finishTransaction:(SubImapTransaction *)transaction {
+  if (!transaction) {
+    return;
+  }
+
+  [_activeTransactions removeObjectIdenticalTo:transaction];
+  [self processTransactionQueue];
+}
+
 - (void)processTransactionQueue {
-  if (_activeTransaction || !_transactionQueue.count) {
+  if (_processingQueue) {
+    _queueChanged = YES;
     return;
   }
 
-  // Get next transaction
-  SubImapTransaction *transaction = _transactionQueue[0];
-  [_transactionQueue removeObjectAtIndex:0];
+  _processingQueue = YES;
+
+  do {
+    _queueChanged = NO;
+    [self startQueuedTransactions];
+  } while (_queueChanged);
+
+  _processingQueue = NO;
+}
+
+- (void)startQueuedTransactions {
+  NSUInteger idx = 0;
+  BOOL mailboxIsWaiting = NO;
+
+  while (idx < _transactionQueue.count) {
+    SubImapTransaction *transaction = _transactionQueue[idx];
+
+    // Once a mailbox transaction has to wait, later mailbox transactions
+    // wait as well, so it is not starved
+    BOOL canStart = !(mailboxIsWaiting && transaction.mailbox != nil) && [self canStartTransaction:transaction];
+
+    if (!canStart) {
+      // Nothing may start ahead of a waiting exclusive transaction
+      if (transaction.exclusive) {
+        return;
+      }
+
+      mailboxIsWaiting = mailboxIsWaiting || transaction.mailbox != nil;
+      idx++;
+      continue;
+    }
+
+    [_transactionQueue removeObjectAtIndex:idx];
+
+    // Execute transaction
+    [_activeTransactions addObject:transaction];
+    [transaction runWithClient:self];
+
+    // Nothing else runs alongside an exclusive transaction, and if one
+    // finished already the scan so far is stale
+    if (transaction.exclusive || _queueChanged) {
+      return;
+    }
+  }
+}
+
+- (BOOL)canStartTransaction:(SubImapTransaction *)transaction {
+  if (transaction.exclusive) {
+    return !_activeTransactions.count;
+  }
+
+  for (SubImapTransaction *activeTransaction in _activeTransactions) {
+    if (activeTransaction.exclusive) {
+      return NO;
+    }
+
+    // Only one mailbox can be selected at a time
+    if (transaction.mailbox && activeTransaction.mailbox &&
+        ![self mailbox:transaction.mailbox isEqualToMailbox:activeTransaction.mailbox]) {
+      return NO;
+    }
+  }
+
+  return YES;
+}
+
+- (BOOL)mailbox:(NSString *)mailbox isEqualToMailbox:(NSString *)otherMailbox {
+  // RFC3501 5.1. INBOX is case-insensitive
+  if ([mailbox caseInsensitiveCompare:@"INBOX"] == NSOrderedSame) {
+    return [otherMailbox caseInsensitiveCompare:@"INBOX"] == NSOrderedSame;
+  }
 
-  // Execute transaction
-  _activeTransaction = transaction;
-  [transaction runWithClient:self];
+  return [mailbox isEqualToString:otherMailbox];
 }
 
 @end
\ No newline at end of file
@@ -0,0 +1,89 @@
+// SubImapTransport.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+@protocol SubImapTransport;
+
+@protocol SubImapTransportDelegate <NSObject>
+- (void)transportDidOpen:(id<SubImapTransport>)transport;
+- (void)transportHasBytesAvailable:(id<SubImapTransport>)transport;
+- (void)transportHasSpaceAvailable:(id<SubImapTransport>)transport;
+- (void)transportDidEnd:(id<SubImapTransport>)transport;
+- (void)transport:(id<SubImapTransport>)transport didFailWithError:(NSError *)error;
+@end
+
+/*
+ * SubImapTransport
+ *
+ * Moves bytes between a SubImapConnection and the server. Events follow
+ * NSStream's: after a write, transportHasSpaceAvailable: is sent once the
+ * transport can take more data, and transportHasBytesAvailable: is sent
+ * while there is data to read.
+ *
+ * Every delegate method is called on the thread the transport is driven
+ * from: the run loop it was opened on for SubImapStreamTransport, or the
+ * SubImapEventLoop thread for SubImapSocketTransport.
+ */
+@protocol SubImapTransport <NSObject>
+
+@property (weak) id<SubImapTransportDelegate> delegate;
+
+- (BOOL)open;
+- (void)close;
+- (BOOL)isOpen;
+
+/*
+ * Starts negotiating TLS on an open plain text transport, for STARTTLS.
+ * Data written from now on is encrypted once the handshake completes.
+ *
+ * Returns NO if the transport can not do TLS.
+ */
+- (BOOL)startTLS;
+
+/*
+ * While YES, the transport stops reading from the server, so the
+ * kernel's receive window fills up and the server slows down, and
+ * transportHasBytesAvailable: is not sent. Bytes already available are
+ * offered again when reading resumes.
+ */
+@property BOOL readingPaused;
+
+/*
+ * Returns the number of bytes read, 0 at the end of the stream, or -1 if
+ * nothing could be read.
+ */
+- (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)length;
+
+/*
+ * Takes all of the bytes, buffering what can not be written right away,
+ * and returns the length, or -1 if the transport is closed.
+ */
+- (NSInteger)write:(const uint8_t *)buffer maxLength:(NSUInteger)length;
+
+/*
+ * Writes an array of NSData buffers in order, as one gather write where
+ * the transport can, and buffers what can not be written right away.
+ * Returns their total length, or -1 if the transport is closed.
+ */
+- (NSInteger)writeBuffers:(NSArray *)buffers;
+
+@end
\ No newline at end of file
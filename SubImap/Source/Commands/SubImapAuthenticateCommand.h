@@ -0,0 +1,46 @@
+// SubImapAuthenticateCommand.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapCommand.h"
+
+
+enum {
+  SubImapAuthenticateCommandFailedError = 9,
+};
+
+
+/*
+ * SASL authentication. The initial response is sent with the command when
+ * the server advertises SASL-IR, saving a round trip, and after the first
+ * continuation otherwise.
+ */
+@interface SubImapAuthenticateCommand : SubImapCommand
+
++ (id)commandWithPlainLogin:(NSString *)login password:(NSString *)password;
++ (id)commandWithXOAuth2User:(NSString *)user accessToken:(NSString *)accessToken;
+
+- (id)initWithMechanism:(NSString *)mechanism initialResponse:(NSData *)initialResponse;
+
+@property (readonly) NSString *mechanism;
+
+@end
\ No newline at end of file
@@ -0,0 +1,144 @@
+// SubImapAuthenticateCommand.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapAuthenticateCommand.h"
+
+#import "SubImapCommandBuilder.h"
+
+@implementation SubImapAuthenticateCommand {
+  NSData *_initialResponse;
+  BOOL _sentInitialResponse;
+}
+
++ (id)commandWithPlainLogin:(NSString *)login password:(NSString *)password {
+  if (!login || !password || !login.length || !password.length) {
+    return [[self alloc] initWithMechanism:@"PLAIN" initialResponse:nil];
+  }
+
+  // RFC4616 - authzid NUL authcid NUL passwd
+  NSString *response = [NSString stringWithFormat:@"%C%@%C%@", (unichar)0, login, (unichar)0, password];
+
+  return [[self alloc] initWithMechanism:@"PLAIN" initialResponse:[response dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
++ (id)commandWithXOAuth2User:(NSString *)user accessToken:(NSString *)accessToken {
+  if (!user || !accessToken || !user.length || !accessToken.length) {
+    return [[self alloc] initWithMechanism:@"XOAUTH2" initialResponse:nil];
+  }
+
+  NSString *response = [NSString stringWithFormat:@"user=%@\1auth=Bearer %@\1\1", user, accessToken];
+
+  return [[self alloc] initWithMechanism:@"XOAUTH2" initialResponse:[response dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (id)initWithMechanism:(NSString *)mechanism initialResponse:(NSData *)initialResponse {
+  self = [super init];
+
+  if (self) {
+    if (!mechanism || !mechanism.length || !initialResponse) {
+      [self setErrorCode:SubImapAuthenticateCommandFailedError message:@"Nil mechanism or credentials given to authenticate command."];
+    }
+
+    _mechanism = [mechanism uppercaseString];
+    _initialResponse = initialResponse;
+  }
+
+  return self;
+}
+
+- (NSString *)name {
+  return @"AUTHENTICATE";
+}
+
+- (BOOL)canExecuteInState:(SubImapClientState)state {
+  return state == SubImapClientStateUnauthenticated;
+}
+
+- (NSArray *)render {
+  SubImapCommandBuilder *builder = [self builder];
+
+  [builder appendSP];
+  [builder appendString:_mechanism];
+
+  // RFC4959 - SASL-IR
+  if ([self.capabilities containsObject:@"SASL-IR"]) {
+    _sentInitialResponse = YES;
+
+    [builder appendSP];
+    [builder appendString:[self encodedInitialResponse]];
+  }
+
+  [builder appendCRLF];
+
+  return [builder dataList];
+}
+
+- (NSArray *)renderContinuation:(SubImapResponse *)response {
+  SubImapCommandBuilder *builder = [SubImapCommandBuilder builder];
+
+  // Any further challenge is an error description, as with XOAUTH2, and
+  // the server expects an empty response before the tagged NO
+  if (!_sentInitialResponse) {
+    _sentInitialResponse = YES;
+    [builder appendString:[self encodedInitialResponse]];
+  }
+
+  [builder appendCRLF];
+
+  return [builder dataList];
+}
+
+- (BOOL)handleUntaggedResponse:(SubImapResponse *)response {
+  return [response isType:SubImapResponseTypeCapability];
+}
+
+- (BOOL)handleTaggedResponse:(SubImapResponse *)response {
+  if (![response isType:SubImapResponseTypeOk]) {
+    [self setErrorCode:SubImapAuthenticateCommandFailedError message:@"Unable to authenticate account."];
+  }
+
+  self.result = response.data[@"message"];
+
+  return YES;
+}
+
+- (SubImapClientState)stateFromState:(SubImapClientState)state {
+  if (state == SubImapClientStateUnauthenticated) {
+    return SubImapClientStateAuthenticated;
+  }
+
+  return state;
+}
+
+#pragma mark -
+
+// An empty initial response is sent as "="
+- (NSString *)encodedInitialResponse {
+  if (!_initialResponse.length) {
+    return @"=";
+  }
+
+  return [_initialResponse base64EncodedStringWithOptions:0];
+}
+
+@end
\ No newline at end of file
@@ -7,7 +7,7 @@
 //
 
 #import "SubImapCloseCommand.h"
-#import "SubImapConnectionData.h"
+#import "SubImapCommandBuilder.h"
 
 @implementation SubImapCloseCommand
 
@@ -35,12 +35,10 @@
 }
 
 - (NSArray *)render {
-  return @[
-    [SubImapConnectionData dataWithString:self.tag],
-    [SubImapConnectionData SP],
-    [SubImapConnectionData dataWithString:self.name],
-    [SubImapConnectionData CRLF],
-  ];
+  SubImapCommandBuilder *builder = [self builder];
+  [builder appendCRLF];
+
+  return [builder dataList];
 }
 
 - (BOOL)handleTaggedResponse:(SubImapResponse *)response {
@@ -24,9 +24,19 @@
 #import "SubImapTypes.h"
 #import "SubImapResponse.h"
 
+@class SubImapCommandBuilder;
+@class SubImapConnection;
+
 
 extern NSString * const SubImapCommandErrorDomain;
 
+// Error codes used by every command. Each command's own errors use codes
+// below 100.
+enum {
+  SubImapCommandErrorCancelled = 100,
+  SubImapCommandErrorTimedOut  = 101,
+};
+
 
 /*
  * SubImapCommand
@@ -57,6 +67,53 @@ extern NSString * const SubImapCommandErrorDomain;
  */
 @property id result;
 
+/*
+ * The server's capabilities, as known by the client when the command is
+ * sent. Commands can check this in render to use extensions.
+ *
+ * Assigned by SubImapClient. Capabilities are uppercase.
+ */
+@property NSArray *capabilities;
+
+/*
+ * The connection the command is sent on. Commands that keep responses
+ * after handling them hold their length on it, see holdBytes:.
+ *
+ * Assigned by SubImapClient.
+ */
+@property (weak) SubImapConnection *connection;
+
+/*
+ * Commands with a higher priority are sent first. Commands with the same
+ * priority are sent in the order they were enqueued.
+ *
+ * Defaults to SubImapCommandPriorityDefault.
+ */
+@property SubImapCommandPriority priority;
+
+/*
+ * If the command has not completed by this date, it fails with a
+ * SubImapCommandErrorTimedOut error. If it was already sent, the client
+ * ignores the rest of its responses.
+ *
+ * Defaults to nil, no deadline.
+ */
+@property NSDate *deadline;
+
+@property (readonly) BOOL isCancelled;
+
+/*
+ * Cancels the command, which completes right away with a
+ * SubImapCommandErrorCancelled error.
+ *
+ * A command that has not been sent yet never will be. A command that
+ * has been sent still runs on the server, but the client ignores the
+ * rest of its responses.
+ *
+ * Has no effect on a completed command.
+ */
+- (void)cancel;
+
 /*
  * When a command handles it's tagged response, this result block is called.
  *
@@ -97,10 +154,22 @@ extern NSString * const SubImapCommandErrorDomain;
  * Override this with your collection of ConnectionData objects that
  * will be sent to the connection.
  *
- * You must include your command's tag, and a terminating CRLF.
+ * You must include your command's tag, and a terminating CRLF. Use
+ * builder to render them without creating an object for every token.
  */
 - (NSArray *)render;
 
+/*
+ * Override this to answer continuation requests from the server, such as
+ * AUTHENTICATE challenges. Return the ConnectionData objects to send, or
+ * nil to send nothing.
+ *
+ * Continuation requests for literals are handled by the connection.
+ *
+ * Defaults to nil.
+ */
+- (NSArray *)renderContinuation:(SubImapResponse *)response;
+
 /*
  * Override this to extract any untagged responses that might be related
  * to your command.
@@ -129,6 +198,11 @@ extern NSString * const SubImapCommandErrorDomain;
 
 #pragma mark - Helpers
 
+/*
+ * Returns a new SubImapCommandBuilder holding the command's tag and name.
+ */
+- (SubImapCommandBuilder *)builder;
+
 /*
  * This should not be overridden.
  *
@@ -23,6 +23,8 @@
 
 #import "SubImapCommand.h"
 
+#import "SubImapCommandBuilder.h"
+
 
 NSString * const SubImapCommandErrorDomain = @"SubImapCommandErrorDomain";
 
@@ -49,6 +51,15 @@ NSString * const SubImapCommandErrorDomain = @"SubImapCommandErrorDomain";
   }
 }
 
+- (void)cancel {
+  if (self.isComplete) {
+    return;
+  }
+
+  _isCancelled = YES;
+  [self failWithErrorCode:SubImapCommandErrorCancelled message:@"The command was cancelled."];
+}
+
 - (void)failWithErrorCode:(NSInteger)code message:(NSString *)message {
   [self setErrorCode:code message:message];
   [self complete];
@@ -68,6 +79,10 @@ NSString * const SubImapCommandErrorDomain = @"SubImapCommandErrorDomain";
   return nil;
 }
 
+- (NSArray *)renderContinuation:(SubImapResponse *)response {
+  return nil;
+}
+
 - (BOOL)handleResponse:(SubImapResponse *)response {
   // Tagged response
   if ([response isResult]) {
@@ -94,6 +109,16 @@ NSString * const SubImapCommandErrorDomain = @"SubImapCommandErrorDomain";
   return state;
 }
 
+- (SubImapCommandBuilder *)builder {
+  SubImapCommandBuilder *builder = [SubImapCommandBuilder builder];
+
+  [builder appendString:self.tag];
+  [builder appendSP];
+  [builder appendString:self.name];
+
+  return builder;
+}
+
 - (void)setErrorCode:(NSInteger)code message:(NSString *)message {
   self.error = [NSError errorWithDomain:SubImapCommandErrorDomain code:code userInfo:@{
     NSLocalizedDescriptionKey: message ?: @"",
@@ -0,0 +1,87 @@
+// SubImapCommandBuilder.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/*
+ * SubImapCommandBuilder
+ *
+ * Renders a command straight into one output buffer. Literals split the
+ * command into several ConnectionData objects; everything between them is
+ * appended to a single buffer, which is handed to the connection as it is,
+ * so a command without literals is one write.
+ *
+ * Start one with -[SubImapCommand builder], which already holds the
+ * command's tag and name.
+ */
+@interface SubImapCommandBuilder : NSObject
+
++ (id)builder;
+
+/*
+ * The capacity is the size of the first buffer. A builder that is reused
+ * after dataList sizes its next buffer to fit the largest so far.
+ */
++ (id)builderWithCapacity:(NSUInteger)capacity;
+
+- (void)appendBytes:(const void *)bytes length:(NSUInteger)length;
+- (void)appendData:(NSData *)data;
+
+/*
+ * Appends an atom, or any other ASCII string, as it is.
+ */
+- (void)appendString:(NSString *)string;
+
+/*
+ * Appends the string as a quoted string, escaping quotes and backslashes.
+ */
+- (void)appendQuotedString:(NSString *)string;
+
+/*
+ * Appends the string as an atom when it can be one, a quoted string when
+ * it is ASCII, or a literal otherwise.
+ */
+- (void)appendAString:(NSString *)string;
+
+- (void)appendInteger:(NSInteger)integer;
+- (void)appendUnsignedInteger:(NSUInteger)integer;
+
+/*
+ * Appends the indexes as a sequence set, such as "1:4,7".
+ */
+- (void)appendSequenceSet:(NSIndexSet *)set;
+
+/*
+ * The connection writes the literal marker, and waits for a continuation
+ * response unless LITERAL+ can be used.
+ */
+- (void)appendLiteral:(NSData *)data;
+
+- (void)appendSP;
+- (void)appendCRLF;
+
+/*
+ * Returns the ConnectionData objects built so far, and empties the
+ * builder so it can be used again.
+ */
+- (NSArray *)dataList;
+
+@end
\ No newline at end of file
@@ -0,0 +1,189 @@
+// SubImapCommandBuilder.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapCommandBuilder.h"
+
+#import "SubImapConnectionData.h"
+
+// Enough for the tag, name and arguments of most commands
+#define SubImapCommandBuilderDefaultCapacity 128
+
+@implementation SubImapCommandBuilder {
+  NSMutableArray *_dataList;
+  NSMutableData *_buffer;
+  NSUInteger _capacity;
+}
+
++ (id)builder {
+  return [[self alloc] initWithCapacity:SubImapCommandBuilderDefaultCapacity];
+}
+
++ (id)builderWithCapacity:(NSUInteger)capacity {
+  return [[self alloc] initWithCapacity:capacity];
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity {
+  self = [super init];
+
+  if (self) {
+    _dataList = [NSMutableArray array];
+    _capacity = capacity;
+  }
+
+  return self;
+}
+
+#pragma mark -
+
+- (void)appendBytes:(const void *)bytes length:(NSUInteger)length {
+  if (!_buffer) {
+    _buffer = [NSMutableData dataWithCapacity:MAX(_capacity, length)];
+  }
+
+  [_buffer appendBytes:bytes length:length];
+}
+
+- (void)appendData:(NSData *)data {
+  [self appendBytes:[data bytes] length:[data length]];
+}
+
+- (void)appendString:(NSString *)string {
+  const char *cString = [string cStringUsingEncoding:NSASCIIStringEncoding];
+
+  if (cString) {
+    [self appendBytes:cString length:strlen(cString)];
+  }
+}
+
+- (void)appendQuotedString:(NSString *)string {
+  const char *cString = [string UTF8String] ?: "";
+  const char *run = cString;
+
+  [self appendBytes:"\"" length:1];
+
+  for (const char *c = cString; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      [self appendBytes:run length:c - run];
+      [self appendBytes:"\\" length:1];
+      run = c;
+    }
+  }
+
+  [self appendBytes:run length:strlen(run)];
+  [self appendBytes:"\"" length:1];
+}
+
+- (void)appendAString:(NSString *)string {
+  const char *cString = [string UTF8String] ?: "";
+  BOOL isAtom = *cString != 0;
+
+  for (const char *c = cString; *c; c++) {
+    // Anything else needs a literal
+    if ((unsigned char)*c > 0x7F || *c == '\r' || *c == '\n') {
+      [self appendLiteral:[NSData dataWithBytes:cString length:strlen(cString)]];
+      return;
+    }
+
+    // atom-specials, and "]", which is not allowed in an astring either
+    if (*c <= ' ' || *c == 0x7F || strchr("(){%*\"\\]", *c)) {
+      isAtom = NO;
+    }
+  }
+
+  if (isAtom) {
+    [self appendBytes:cString length:strlen(cString)];
+  } else {
+    [self appendQuotedString:string];
+  }
+}
+
+- (void)appendInteger:(NSInteger)integer {
+  if (integer < 0) {
+    [self appendBytes:"-" length:1];
+  }
+
+  unsigned long long value = integer;
+  [self appendUnsignedInteger:(NSUInteger)(integer < 0 ? -value : value)];
+}
+
+- (void)appendUnsignedInteger:(NSUInteger)integer {
+  char buffer[20];
+  [self appendBytes:buffer length:SubImapFormatUnsignedInteger(buffer, integer)];
+}
+
+- (void)appendSequenceSet:(NSIndexSet *)set {
+  __block BOOL first = YES;
+
+  [set enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+    if (!first) {
+      [self appendBytes:"," length:1];
+    }
+
+    first = NO;
+    [self appendUnsignedInteger:range.location];
+
+    if (range.length > 1) {
+      [self appendBytes:":" length:1];
+      [self appendUnsignedInteger:NSMaxRange(range) - 1];
+    }
+  }];
+}
+
+- (void)appendLiteral:(NSData *)data {
+  [self flush];
+  [_dataList addObject:[SubImapConnectionData literalData:data]];
+}
+
+- (void)appendSP {
+  [self appendBytes:" " length:1];
+}
+
+- (void)appendCRLF {
+  [self appendBytes:"\r\n" length:2];
+}
+
+- (NSArray *)dataList {
+  [self flush];
+
+  NSArray *dataList = _dataList;
+  _dataList = [NSMutableArray array];
+
+  return dataList;
+}
+
+#pragma mark -
+
+// The buffer is handed off rather than copied, so the next bytes go into
+// a new one
+- (void)flush {
+  if (!_buffer.length) {
+    return;
+  }
+
+  _capacity = MAX(_capacity, _buffer.length);
+
+  [_dataList addObject:[SubImapConnectionData data:_buffer]];
+  _buffer = nil;
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,66 @@
+// SubImapCopyCommand.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapCommand.h"
+
+
+enum {
+  SubImapCopyCommandFailedError = 13,
+};
+
+
+/*
+ * COPY and UID COPY, RFC3501 6.4.7.
+ *
+ * Copies every message in a set to another mailbox on the server, so
+ * nothing is downloaded or appended again. The set is sent compressed.
+ *
+ * When the server supports UIDPLUS, RFC4315, it reports the UIDs the
+ * copies were given, and the result is a dictionary:
+ *
+ *   "uidvalidity": (NSNumber *) the destination's UID validity
+ *   "source": (NSIndexSet *) the copied messages' UIDs
+ *   "destination": (NSIndexSet *) their UIDs in the destination
+ *   "uids": (NSDictionary *) each source UID to its destination UID
+ *
+ * Without UIDPLUS, the result is an empty dictionary. "uids" pairs the
+ * UIDs in the order the server listed them, which need not be ascending.
+ */
+@interface SubImapCopyCommand : SubImapCommand
+
++ (id)commandWithSequenceNumbers:(NSIndexSet *)sequenceNumbers mailbox:(NSString *)path;
++ (id)commandWithUIDs:(NSIndexSet *)UIDs mailbox:(NSString *)path;
+
+@property (readonly) NSIndexSet *IDs;
+@property (readonly) BOOL useUIDs;
+@property (readonly) NSString *mailboxPath;
+
+- (id)initWithIDs:(NSIndexSet *)IDs UID:(BOOL)useUIDs mailbox:(NSString *)path;
+
+/*
+ * The result for a COPYUID response code's data, whose source and
+ * destination are NSArrays of UIDs in the server's order.
+ */
++ (NSDictionary *)resultWithCopyUIDs:(NSDictionary *)copyUIDs;
+
+@end
\ No newline at end of file
@@ -0,0 +1,149 @@
+// SubImapCopyCommand.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapCopyCommand.h"
+
+#import "SubImapCommandBuilder.h"
+
+@implementation SubImapCopyCommand {
+  NSDictionary *_copyUIDs;
+}
+
++ (id)commandWithSequenceNumbers:(NSIndexSet *)sequenceNumbers mailbox:(NSString *)path {
+  return [[self alloc] initWithIDs:sequenceNumbers UID:NO mailbox:path];
+}
+
++ (id)commandWithUIDs:(NSIndexSet *)UIDs mailbox:(NSString *)path {
+  return [[self alloc] initWithIDs:UIDs UID:YES mailbox:path];
+}
+
++ (NSDictionary *)resultWithCopyUIDs:(NSDictionary *)copyUIDs {
+  NSArray *sourceUIDs = copyUIDs[@"source"];
+  NSArray *destinationUIDs = copyUIDs[@"destination"];
+
+  if (!sourceUIDs || !destinationUIDs) {
+    return @{};
+  }
+
+  NSMutableIndexSet *source = [NSMutableIndexSet indexSet];
+  NSMutableIndexSet *destination = [NSMutableIndexSet indexSet];
+  NSMutableDictionary *UIDs = [NSMutableDictionary dictionaryWithCapacity:sourceUIDs.count];
+
+  for (NSNumber *UID in sourceUIDs) {
+    [source addIndex:[UID unsignedIntegerValue]];
+  }
+
+  for (NSNumber *UID in destinationUIDs) {
+    [destination addIndex:[UID unsignedIntegerValue]];
+  }
+
+  // Paired in the order listed, RFC4315
+  if (sourceUIDs.count == destinationUIDs.count) {
+    for (NSUInteger idx = 0; idx < sourceUIDs.count; idx++) {
+      UIDs[sourceUIDs[idx]] = destinationUIDs[idx];
+    }
+  }
+
+  return @{
+    @"uidvalidity": copyUIDs[@"uidvalidity"],
+    @"source": source,
+    @"destination": destination,
+    @"uids": UIDs,
+  };
+}
+
+- (id)initWithIDs:(NSIndexSet *)IDs UID:(BOOL)useUIDs mailbox:(NSString *)path {
+  self = [super init];
+
+  if (self) {
+    if (!IDs.count || !path) {
+      [self setErrorCode:SubImapCopyCommandFailedError message:@"No messages or mailbox passed to copy command."];
+    }
+
+    _IDs = IDs;
+    _useUIDs = useUIDs;
+    _mailboxPath = path;
+  }
+
+  return self;
+}
+
+- (NSString *)name {
+  return @"COPY";
+}
+
+- (BOOL)canExecuteInState:(SubImapClientState)state {
+  return state == SubImapClientStateSelected;
+}
+
+- (NSArray *)render {
+  SubImapCommandBuilder *builder = [SubImapCommandBuilder builder];
+
+  [builder appendString:self.tag];
+  [builder appendSP];
+
+  if (_useUIDs) {
+    [builder appendString:@"UID"];
+    [builder appendSP];
+  }
+
+  [builder appendString:self.name];
+  [builder appendSP];
+  [builder appendSequenceSet:_IDs];
+  [builder appendSP];
+  [builder appendAString:_mailboxPath];
+  [builder appendCRLF];
+
+  return [builder dataList];
+}
+
+- (BOOL)handleUntaggedResponse:(SubImapResponse *)response {
+  // MOVE sends COPYUID before its expunges, in an untagged OK
+  if ([response isType:SubImapResponseTypeOk] && response.data[@"copyuid"]) {
+    _copyUIDs = response.data[@"copyuid"];
+    return YES;
+  }
+
+  return NO;
+}
+
+- (BOOL)handleTaggedResponse:(SubImapResponse *)response {
+  if (![response isType:SubImapResponseTypeOk]) {
+    [self setErrorCode:[self failedErrorCode] message:response.data[@"message"]];
+    return YES;
+  }
+
+  if (response.data[@"copyuid"]) {
+    _copyUIDs = response.data[@"copyuid"];
+  }
+
+  self.result = [[self class] resultWithCopyUIDs:_copyUIDs];
+
+  return YES;
+}
+
+- (NSInteger)failedErrorCode {
+  return SubImapCopyCommandFailedError;
+}
+
+@end
\ No newline at end of file
@@ -27,4 +27,13 @@
 
 + (id)command;
 
+/*
+ * UID EXPUNGE, RFC4315. Only expunges the messages in the set that have
+ * \Deleted set, leaving any others marked for deletion alone. Needs the
+ * UIDPLUS capability.
+ */
++ (id)commandWithUIDs:(NSIndexSet *)UIDs;
+
+@property (readonly) NSIndexSet *UIDs;
+
 @end
\ No newline at end of file
@@ -23,7 +23,7 @@
 
 #import "SubImapExpungeCommand.h"
 
-#import "SubImapConnectionData.h"
+#import "SubImapCommandBuilder.h"
 
 @implementation SubImapExpungeCommand {
   NSMutableArray *_responses;
@@ -33,6 +33,18 @@
   return [[self alloc] init];
 }
 
++ (id)commandWithUIDs:(NSIndexSet *)UIDs {
+  SubImapExpungeCommand *command = [[self alloc] init];
+
+  if (!UIDs.count) {
+    [command setErrorCode:2 message:@"No UIDs passed to expunge command."];
+  }
+
+  command->_UIDs = UIDs;
+
+  return command;
+}
+
 - (id)init {
   self = [super init];
 
@@ -52,16 +64,27 @@
 }
 
 - (NSArray *)render {
-  return @[
-    [SubImapConnectionData dataWithString:self.tag],
-    [SubImapConnectionData SP],
-    [SubImapConnectionData dataWithString:self.name],
-    [SubImapConnectionData CRLF],
-  ];
+  if (_UIDs) {
+    SubImapCommandBuilder *builder = [SubImapCommandBuilder builder];
+
+    [builder appendString:self.tag];
+    [builder appendString:@" UID "];
+    [builder appendString:self.name];
+    [builder appendSP];
+    [builder appendSequenceSet:_UIDs];
+    [builder appendCRLF];
+
+    return [builder dataList];
+  }
+
+  SubImapCommandBuilder *builder = [self builder];
+  [builder appendCRLF];
+
+  return [builder dataList];
 }
 
 - (BOOL)handleUntaggedResponse:(SubImapResponse *)response {
-  if ([response isType:SubImapResponseTypeExpunge]) {
+  if ([response isType:SubImapResponseTypeExpunge] || [response isType:SubImapResponseTypeVanished]) {
     [_responses addObject:response];
     return YES;
   }
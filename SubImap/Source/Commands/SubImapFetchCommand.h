@@ -29,6 +29,114 @@
 + (id)commandWithUIDs:(NSArray *)IDs;
 + (id)commandWithAll;
 
+/*
+ * A UID fetch of every message in the set, sent as ranges, eg: 1:500,502.
+ */
++ (id)commandWithUIDSet:(NSIndexSet *)UIDs;
+
 @property NSArray *fields;
 
+#pragma mark Progressive delivery
+
+/*
+ * Number of messages passed to each messages block. Messages are
+ * delivered as soon as a batch fills up, while the fetch is still
+ * streaming. Any remaining messages are delivered right before the
+ * command completes.
+ *
+ * Defaults to 1.
+ */
+@property NSUInteger batchSize;
+
+/*
+ * When NO, messages passed to a messages block are not kept, and the
+ * command's result will be an empty array. Use this for large fetches
+ * where holding every message in memory is not needed.
+ *
+ * Defaults to YES.
+ */
+@property BOOL retainsMessages;
+
+/*
+ * Adds a block that is called with batches of fetched messages as they
+ * are received.
+ */
+- (void)addMessagesBlock:(SubImapFetchMessagesBlock)block;
+
+#pragma mark Sections
+
+/*
+ * A UID fetch of one body section, such as a single attachment, without
+ * setting \Seen. Pass a range with a zero length for the whole section.
+ */
++ (id)commandWithUID:(NSUInteger)UID section:(NSString *)section range:(NSRange)range;
+
+/*
+ * A UID fetch of the first length bytes of the message's preview part,
+ * found in its parsed BODYSTRUCTURE. Nil if it has no text part.
+ */
++ (id)previewCommandWithUID:(NSUInteger)UID bodyStructure:(NSDictionary *)structure length:(NSUInteger)length;
+
+/*
+ * A field that fetches one body section without setting \Seen, RFC3501
+ * 6.4.5, eg: BODY.PEEK[2.1]<0.65536>. Pass a range with a zero length
+ * for the whole section.
+ *
+ * Fetched sections are in the message's "sections" dictionary, keyed by
+ * section spec. A partial section also has its "origin".
+ */
++ (NSString *)fieldForSection:(NSString *)section range:(NSRange)range;
+
+/*
+ * RFC3516 - BINARY. Fields that fetch a part already decoded from its
+ * base64 or quoted-printable transfer encoding, without setting \Seen,
+ * or the part's decoded size, eg: BINARY.PEEK[2]<0.65536>.
+ *
+ * Decoded parts are in the message's "binary" dictionary, keyed by part
+ * number, with their "data" as NSData. Sizes are in "binary.size".
+ *
+ * When the server does not support BINARY, BINARY.PEEK is sent as
+ * BODY.PEEK, and the still encoded part arrives in "sections" instead.
+ * BINARY.SIZE is left out.
+ */
++ (NSString *)fieldForBinarySection:(NSString *)part range:(NSRange)range;
++ (NSString *)fieldForBinarySizeOfSection:(NSString *)part;
+
+/*
+ * Fields that fetch only the named header fields, or every field except
+ * them, without setting \Seen, eg: BODY.PEEK[HEADER.FIELDS (FROM DATE)].
+ *
+ * Much cheaper than ENVELOPE when only a few fields are needed, and it
+ * can include fields ENVELOPE leaves out, such as References. The fields
+ * arrive parsed in the section's "headers", keyed by lowercase name.
+ */
++ (NSString *)fieldForHeaderFields:(NSArray *)fields;
++ (NSString *)fieldForHeaderFieldsNot:(NSArray *)fields;
+
+/*
+ * The parts of a parsed BODYSTRUCTURE, in order, each a copy with a
+ * "section" key holding its part number, eg: "2.1".
+ *
+ * Multipart containers are left out. A MESSAGE/RFC822 part is followed
+ * by the parts of the message it holds.
+ */
++ (NSArray *)partsInBodyStructure:(NSDictionary *)structure;
+
+/*
+ * The part to show as a preview: the first TEXT/PLAIN part that is not
+ * an attachment, or else the first such TEXT/HTML part. Nil if none.
+ */
++ (NSDictionary *)previewPartInBodyStructure:(NSDictionary *)structure;
+
+/*
+ * The content of a part, from partsInBodyStructure:, decoded from its
+ * transfer encoding: the part's "binary" data when it was fetched with
+ * BINARY, or else its section from "sections" run through a
+ * SubImapTransferDecoder. Nil if the message does not hold the part.
+ *
+ * A part fetched in several ranges should instead feed each range's data
+ * to one SubImapTransferDecoder, as it arrives.
+ */
++ (NSData *)decodedDataForPart:(NSDictionary *)part inMessage:(NSDictionary *)message;
+
 @end
\ No newline at end of file
@@ -23,13 +23,21 @@
 
 #import "SubImapFetchCommand.h"
 
-#import "SubImapConnectionData.h"
+#import "SubImapCommandBuilder.h"
+#import "SubImapConnection.h"
+#import "SubImapTransferDecoder.h"
 
 @implementation SubImapFetchCommand {
   BOOL _useUIDs;
   NSArray *_IDs;
 
   NSMutableArray *_fetchResponses;
+  NSUInteger _fetchResponsesLength;
+
+  // Progressive delivery
+  NSMutableArray *_messagesBlocks;
+  NSMutableArray *_pendingMessages;
+  NSUInteger _pendingMessagesLength;
 }
 
 + (id)commandWithSequenceIDs:(NSArray *)IDs {
@@ -44,6 +52,42 @@
   return [[self alloc] initWithIDs:nil UID:NO];
 }
 
++ (id)commandWithUIDSet:(NSIndexSet *)UIDs {
+  NSMutableArray *IDs = [NSMutableArray array];
+
+  [UIDs enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+    if (range.length == 1) {
+      [IDs addObject:@(range.location)];
+    } else {
+      [IDs addObject:[NSString stringWithFormat:@"%lu:%lu", (unsigned long)range.location, (unsigned long)NSMaxRange(range) - 1]];
+    }
+  }];
+
+  return [[self alloc] initWithIDs:IDs UID:YES];
+}
+
++ (id)commandWithUID:(NSUInteger)UID section:(NSString *)section range:(NSRange)range {
+  SubImapFetchCommand *command = [self commandWithUIDs:@[@(UID)]];
+
+  if (!section) {
+    [command setErrorCode:3 message:@"Nil section passed to fetch command."];
+    return command;
+  }
+
+  command.fields = @[@"UID", [self fieldForSection:section range:range]];
+  return command;
+}
+
++ (id)previewCommandWithUID:(NSUInteger)UID bodyStructure:(NSDictionary *)structure length:(NSUInteger)length {
+  NSDictionary *part = [self previewPartInBodyStructure:structure];
+
+  if (!part) {
+    return nil;
+  }
+
+  return [self commandWithUID:UID section:part[@"section"] range:NSMakeRange(0, length)];
+}
+
 - (id)initWithIDs:(NSArray *)IDs UID:(BOOL)useUIDs {
   self = [self init];
 
@@ -56,11 +100,21 @@
     _useUIDs = useUIDs;
 
     _fetchResponses = [NSMutableArray array];
+
+    _messagesBlocks = [NSMutableArray array];
+    _pendingMessages = [NSMutableArray array];
+
+    self.batchSize = 1;
+    self.retainsMessages = YES;
   }
 
   return self;
 }
 
+- (void)addMessagesBlock:(SubImapFetchMessagesBlock)block {
+  [_messagesBlocks addObject:block];
+}
+
 - (NSString *)name {
   return @"FETCH";
 }
@@ -75,44 +129,91 @@
 }
 
 - (NSArray *)render {
-  NSMutableArray *dataList = [NSMutableArray array];
+  SubImapCommandBuilder *builder = [SubImapCommandBuilder builder];
 
-  [dataList addObject:[SubImapConnectionData dataWithString:self.tag]];
-  [dataList addObject:[SubImapConnectionData SP]];
+  [builder appendString:self.tag];
+  [builder appendSP];
 
   if (_useUIDs) {
-    [dataList addObject:[SubImapConnectionData dataWithString:@"UID"]];
-    [dataList addObject:[SubImapConnectionData SP]];
+    [builder appendString:@"UID"];
+    [builder appendSP];
   }
 
-  [dataList addObject:[SubImapConnectionData dataWithString:self.name]];
-  [dataList addObject:[SubImapConnectionData SP]];
+  [builder appendString:self.name];
+  [builder appendSP];
 
   if (_IDs) {
-    NSString *IDList = [_IDs componentsJoinedByString:@","];
-    [dataList addObject:[SubImapConnectionData dataWithString:IDList]];
-    [dataList addObject:[SubImapConnectionData SP]];
+    [_IDs enumerateObjectsUsingBlock:^(id ID, NSUInteger index, BOOL *stop) {
+      if (index) {
+        [builder appendBytes:"," length:1];
+      }
+
+      if ([ID isKindOfClass:[NSNumber class]]) {
+        [builder appendUnsignedInteger:[ID unsignedIntegerValue]];
+      } else {
+        [builder appendString:[ID description]];
+      }
+    }];
   } else {
-    [dataList addObject:[SubImapConnectionData dataWithString:@"1:*"]];
-    [dataList addObject:[SubImapConnectionData SP]];
+    [builder appendString:@"1:*"];
   }
 
+  [builder appendSP];
+
   if (self.fields == nil) {
     self.fields = @[@"ENVELOPE"];
   }
 
-  [dataList addObject:[SubImapConnectionData dataWithString:@"("]];
-  [dataList addObject:[SubImapConnectionData dataWithString:[self.fields componentsJoinedByString:@" "]]];
-  [dataList addObject:[SubImapConnectionData dataWithString:@")"]];
+  [builder appendBytes:"(" length:1];
+
+  BOOL binary = [self.capabilities containsObject:@"BINARY"];
+  BOOL first = YES;
+
+  for (NSString *field in self.fields) {
+    // Without BINARY, fetch the encoded part instead
+    if (!binary && [field hasPrefix:@"BINARY"]) {
+      if ([field hasPrefix:@"BINARY.SIZE"]) continue;
+
+      field = [@"BODY" stringByAppendingString:[field substringFromIndex:6]];
+    }
+
+    if (!first) {
+      [builder appendSP];
+    }
+
+    [builder appendString:field];
+    first = NO;
+  }
+
+  // The list can't be empty
+  if (first) {
+    [builder appendString:@"UID"];
+  }
 
-  [dataList addObject:[SubImapConnectionData CRLF]];
+  [builder appendBytes:")" length:1];
+  [builder appendCRLF];
 
-  return dataList;
+  return [builder dataList];
 }
 
 - (BOOL)handleUntaggedResponse:(SubImapResponse *)response {
   if ([response isType:SubImapResponseTypeFetch]) {
-    [_fetchResponses addObject:response.data];
+    if (self.retainsMessages) {
+      [_fetchResponses addObject:response.data];
+      [self.connection holdBytes:response.length];
+      _fetchResponsesLength += response.length;
+    }
+
+    if (_messagesBlocks.count) {
+      [_pendingMessages addObject:response.data];
+      [self.connection holdBytes:response.length];
+      _pendingMessagesLength += response.length;
+
+      if (_pendingMessages.count >= MAX(self.batchSize, 1)) {
+        [self deliverPendingMessages];
+      }
+    }
+
     return YES;
   }
 
@@ -128,9 +229,147 @@
     }
   }
 
+  // Deliver any partial batch before completing
+  [self deliverPendingMessages];
+
   self.result = _fetchResponses;
 
   return YES;
 }
 
+#pragma mark - Sections
+
++ (NSString *)fieldForSection:(NSString *)section range:(NSRange)range {
+  if (!range.length) {
+    return [NSString stringWithFormat:@"BODY.PEEK[%@]", section];
+  }
+
+  return [NSString stringWithFormat:@"BODY.PEEK[%@]<%lu.%lu>", section, (unsigned long)range.location, (unsigned long)range.length];
+}
+
++ (NSString *)fieldForBinarySection:(NSString *)part range:(NSRange)range {
+  if (!range.length) {
+    return [NSString stringWithFormat:@"BINARY.PEEK[%@]", part];
+  }
+
+  return [NSString stringWithFormat:@"BINARY.PEEK[%@]<%lu.%lu>", part, (unsigned long)range.location, (unsigned long)range.length];
+}
+
++ (NSString *)fieldForBinarySizeOfSection:(NSString *)part {
+  return [NSString stringWithFormat:@"BINARY.SIZE[%@]", part];
+}
+
++ (NSString *)fieldForHeaderFields:(NSArray *)fields {
+  return [self fieldForSection:[NSString stringWithFormat:@"HEADER.FIELDS (%@)", [fields componentsJoinedByString:@" "]] range:NSMakeRange(0, 0)];
+}
+
++ (NSString *)fieldForHeaderFieldsNot:(NSArray *)fields {
+  return [self fieldForSection:[NSString stringWithFormat:@"HEADER.FIELDS.NOT (%@)", [fields componentsJoinedByString:@" "]] range:NSMakeRange(0, 0)];
+}
+
++ (NSArray *)partsInBodyStructure:(NSDictionary *)structure {
+  NSMutableArray *parts = [NSMutableArray array];
+  [self addPartsInBodyStructure:structure prefix:@"" toArray:parts];
+  return parts;
+}
+
++ (void)addPartsInBodyStructure:(NSDictionary *)structure prefix:(NSString *)prefix toArray:(NSMutableArray *)parts {
+  // A single part body is part 1
+  if (!structure[@"parts"]) {
+    [self addPart:structure section:[prefix stringByAppendingString:@"1"] toArray:parts];
+    return;
+  }
+
+  [structure[@"parts"] enumerateObjectsUsingBlock:^(NSDictionary *part, NSUInteger index, BOOL *stop) {
+    [self addPart:part section:[NSString stringWithFormat:@"%@%lu", prefix, (unsigned long)index + 1] toArray:parts];
+  }];
+}
+
++ (void)addPart:(NSDictionary *)part section:(NSString *)section toArray:(NSMutableArray *)parts {
+  NSString *prefix = [section stringByAppendingString:@"."];
+
+  if (part[@"parts"]) {
+    [self addPartsInBodyStructure:part prefix:prefix toArray:parts];
+    return;
+  }
+
+  NSMutableDictionary *copy = [part mutableCopy];
+  copy[@"section"] = section;
+  [parts addObject:copy];
+
+  // Parts of an attached message are numbered under its part
+  if (part[@"message"]) {
+    [self addPartsInBodyStructure:part[@"message"] prefix:prefix toArray:parts];
+  }
+}
+
++ (NSDictionary *)previewPartInBodyStructure:(NSDictionary *)structure {
+  NSDictionary *html = nil;
+
+  for (NSDictionary *part in [self partsInBodyStructure:structure]) {
+    if (![part[@"type"] isEqualToString:@"TEXT"] || [part[@"disposition"][@"type"] isEqualToString:@"ATTACHMENT"]) {
+      continue;
+    }
+
+    if ([part[@"subtype"] isEqualToString:@"PLAIN"]) {
+      return part;
+    }
+
+    if (!html && [part[@"subtype"] isEqualToString:@"HTML"]) {
+      html = part;
+    }
+  }
+
+  return html;
+}
+
++ (NSData *)decodedDataForPart:(NSDictionary *)part inMessage:(NSDictionary *)message {
+  NSString *section = part[@"section"];
+  NSDictionary *binary = message[@"binary"][section];
+
+  if (binary[@"data"]) {
+    return binary[@"data"];
+  }
+
+  id data = message[@"sections"][section][@"data"];
+
+  if ([data isKindOfClass:[NSString class]]) {
+    data = [data dataUsingEncoding:NSUTF8StringEncoding];
+  }
+
+  if (![data isKindOfClass:[NSData class]]) {
+    return nil;
+  }
+
+  return [SubImapTransferDecoder decodeData:data encoding:part[@"encoding"]];
+}
+
+#pragma mark -
+
+- (void)deliverPendingMessages {
+  if (!_pendingMessages.count) {
+    return;
+  }
+
+  NSArray *messages = _pendingMessages;
+  _pendingMessages = [NSMutableArray array];
+
+  for (SubImapFetchMessagesBlock block in _messagesBlocks) {
+    block(messages);
+  }
+
+  [self.connection releaseBytes:_pendingMessagesLength];
+  _pendingMessagesLength = 0;
+}
+
+// The result belongs to the completion blocks, and undelivered messages
+// are dropped
+- (void)complete {
+  [super complete];
+
+  [self.connection releaseBytes:_fetchResponsesLength + _pendingMessagesLength];
+  _fetchResponsesLength = 0;
+  _pendingMessagesLength = 0;
+}
+
 @end
\ No newline at end of file
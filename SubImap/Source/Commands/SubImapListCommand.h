@@ -23,6 +23,17 @@
 
 #import "SubImapCommand.h"
 
+/*
+ * LIST, RFC3501 6.3.8.
+ *
+ * The result is an array of mailbox dictionaries:
+ *
+ *   "path": (NSString *) the full mailbox name
+ *   "delimiter": (NSString *) the hierarchy delimiter, or nil
+ *   "flags": (NSArray *) mailbox attributes, such as \Noselect
+ *   "extended": (NSDictionary *) RFC5258 extended items, if any
+ *   "status": (NSDictionary *) the mailbox's status, with statusItems
+ */
 @interface SubImapListCommand : SubImapCommand
 
 + (id)commandWithAll;
@@ -33,4 +44,46 @@
 
 + (id)commandWithReference:(NSString *)reference mailbox:(NSString *)mailbox;
 
+/*
+ * RFC5819 - LIST-STATUS. Status items, such as MESSAGES or UNSEEN, to
+ * return for each listed mailbox, in its "status" dictionary.
+ *
+ * Only sent when the server supports LIST-STATUS. Otherwise, use
+ * mailboxPathsWithoutStatus with a SubImapStatusCommand and add the
+ * result with addStatuses:.
+ */
+@property NSArray *statusItems;
+
+/*
+ * RFC5258 - LIST-EXTENDED selection options, such as SUBSCRIBED or
+ * SPECIAL-USE, and return options, such as CHILDREN.
+ *
+ * Only sent when the server supports LIST-EXTENDED.
+ */
+@property NSArray *selectionOptions;
+@property NSArray *returnOptions;
+
+/*
+ * Paths of the listed mailboxes that can be selected but have no status
+ * yet. Mailboxes flagged \Noselect or \NonExistent are left out.
+ */
+- (NSArray *)mailboxPathsWithoutStatus;
+
+/*
+ * Adds the statuses from a SubImapStatusCommand result to the listed
+ * mailboxes.
+ */
+- (void)addStatuses:(NSDictionary *)statuses;
+
+/*
+ * The listed mailboxes as a tree, built from their delimiters. Each node
+ * is a copy of its mailbox dictionary with two more keys:
+ *
+ *   "name": (NSString *) the last component of the path
+ *   "children": (NSArray *) the child nodes
+ *
+ * Mailboxes whose parent was not listed are at the root.
+ */
+- (NSArray *)mailboxTree;
+
 @end
\ No newline at end of file
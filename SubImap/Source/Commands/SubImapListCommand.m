@@ -22,13 +22,14 @@
 // THE SOFTWARE.
 
 #import "SubImapListCommand.h"
-#import "SubImapConnectionData.h"
+#import "SubImapCommandBuilder.h"
 
 @implementation SubImapListCommand {
   NSString *_reference;
   NSString *_mailbox;
 
   NSMutableArray *_responses;
+  NSMutableDictionary *_mailboxesByPath;
 }
 
 + (id)commandWithAll {
@@ -59,6 +60,7 @@
     _mailbox = mailbox;
 
     _responses = [NSMutableArray array];
+    _mailboxesByPath = [NSMutableDictionary dictionary];
   }
 
   return self;
@@ -71,6 +73,7 @@
 - (BOOL)canExecuteInState:(SubImapClientState)state {
   switch (state) {
     case SubImapClientStateAuthenticated:
+    case SubImapClientStateSelected:
       return YES;
     default:
       return NO;
@@ -78,24 +81,66 @@
 }
 
 - (NSArray *)render {
-  return @[
-    [SubImapConnectionData dataWithString:self.tag],
-    [SubImapConnectionData SP],
-    [SubImapConnectionData dataWithString:self.name],
-    [SubImapConnectionData SP],
-    [SubImapConnectionData dataWithQuotedString:_reference],
-    [SubImapConnectionData SP],
-    [SubImapConnectionData dataWithQuotedString:_mailbox],
-    [SubImapConnectionData CRLF],
-  ];
+  SubImapCommandBuilder *builder = [self builder];
+  BOOL extended = [self.capabilities containsObject:@"LIST-EXTENDED"];
+  BOOL status = [self.capabilities containsObject:@"LIST-STATUS"] && _statusItems.count;
+
+  // RFC5258 - Selection options
+  if (extended && _selectionOptions.count) {
+    [builder appendString:@" ("];
+    [builder appendString:[_selectionOptions componentsJoinedByString:@" "]];
+    [builder appendBytes:")" length:1];
+  }
+
+  [builder appendSP];
+  [builder appendQuotedString:_reference];
+  [builder appendSP];
+  [builder appendQuotedString:_mailbox];
+
+  // RFC5258 - Return options, and RFC5819 - STATUS
+  NSMutableArray *options = [NSMutableArray array];
+
+  if (extended && _returnOptions.count) {
+    [options addObjectsFromArray:_returnOptions];
+  }
+
+  if (status) {
+    [options addObject:[NSString stringWithFormat:@"STATUS (%@)", [_statusItems componentsJoinedByString:@" "]]];
+  }
+
+  if (options.count) {
+    [builder appendString:@" RETURN ("];
+    [builder appendString:[options componentsJoinedByString:@" "]];
+    [builder appendBytes:")" length:1];
+  }
+
+  [builder appendCRLF];
+
+  return [builder dataList];
 }
 
 - (BOOL)handleUntaggedResponse:(SubImapResponse *)response {
   if ([response isType:SubImapResponseTypeList]) {
-    [_responses addObject:response.data];
+    NSMutableDictionary *mailbox = [response.data mutableCopy];
+    [_responses addObject:mailbox];
+
+    if (mailbox[@"path"]) {
+      _mailboxesByPath[mailbox[@"path"]] = mailbox;
+    }
+
     return YES;
   }
 
+  // RFC5819 - Each STATUS follows its LIST response
+  if ([response isType:SubImapResponseTypeStatus]) {
+    NSMutableDictionary *mailbox = _mailboxesByPath[response.data[@"mailbox"]];
+
+    if (mailbox) {
+      mailbox[@"status"] = response.data;
+      return YES;
+    }
+  }
+
   return NO;
 }
 
@@ -109,4 +154,74 @@
   return YES;
 }
 
+#pragma mark - Status
+
+- (NSArray *)mailboxPathsWithoutStatus {
+  NSMutableArray *paths = [NSMutableArray array];
+
+  for (NSDictionary *mailbox in _responses) {
+    if (mailbox[@"status"]) continue;
+
+    BOOL selectable = YES;
+
+    for (NSString *flag in mailbox[@"flags"]) {
+      if ([flag caseInsensitiveCompare:@"\\Noselect"] == NSOrderedSame || [flag caseInsensitiveCompare:@"\\NonExistent"] == NSOrderedSame) {
+        selectable = NO;
+        break;
+      }
+    }
+
+    if (selectable) {
+      [paths addObject:mailbox[@"path"]];
+    }
+  }
+
+  return paths;
+}
+
+- (void)addStatuses:(NSDictionary *)statuses {
+  for (NSString *path in statuses) {
+    _mailboxesByPath[path][@"status"] = statuses[path];
+  }
+}
+
+#pragma mark - Tree
+
+- (NSArray *)mailboxTree {
+  NSMutableArray *roots = [NSMutableArray array];
+  NSMutableDictionary *nodes = [NSMutableDictionary dictionaryWithCapacity:_responses.count];
+
+  for (NSDictionary *mailbox in _responses) {
+    NSMutableDictionary *node = [mailbox mutableCopy];
+    node[@"name"] = mailbox[@"path"];
+    node[@"children"] = [NSMutableArray array];
+    nodes[mailbox[@"path"]] = node;
+  }
+
+  // Parents are found by path, so they may be listed after their children
+  for (NSDictionary *mailbox in _responses) {
+    NSMutableDictionary *node = nodes[mailbox[@"path"]];
+    NSString *path = mailbox[@"path"];
+    NSString *delimiter = mailbox[@"delimiter"];
+    NSMutableDictionary *parent = nil;
+
+    if ([delimiter length]) {
+      NSRange range = [path rangeOfString:delimiter options:NSBackwardsSearch];
+
+      if (range.location != NSNotFound && range.location > 0) {
+        node[@"name"] = [path substringFromIndex:NSMaxRange(range)];
+        parent = nodes[[path substringToIndex:range.location]];
+      }
+    }
+
+    if (parent && parent != node) {
+      [parent[@"children"] addObject:node];
+    } else {
+      [roots addObject:node];
+    }
+  }
+
+  return roots;
+}
+
 @end
\ No newline at end of file
@@ -23,7 +23,7 @@
 
 #import "SubImapLoginCommand.h"
 
-#import "SubImapConnectionData.h"
+#import "SubImapCommandBuilder.h"
 
 @implementation SubImapLoginCommand {
   NSString *_login;
@@ -58,25 +58,24 @@
 }
 
 - (NSArray *)render {
+  SubImapCommandBuilder *builder = [self builder];
+
   // Only use literals when absolutely necessary
-  SubImapConnectionData *loginData = [self stringNeedsLiteral:_login]
-    ? [SubImapConnectionData literalDataWithString:_login encoding:NSUTF8StringEncoding]
-    : [SubImapConnectionData dataWithString:_login];
-
-  SubImapConnectionData *passwordData = [self stringNeedsLiteral:_password]
-    ? [SubImapConnectionData literalDataWithString:_password encoding:NSUTF8StringEncoding]
-    : [SubImapConnectionData dataWithString:_password];
-
-  return @[
-    [SubImapConnectionData dataWithString:self.tag],
-    [SubImapConnectionData SP],
-    [SubImapConnectionData dataWithString:self.name],
-    [SubImapConnectionData SP],
-    loginData,
-    [SubImapConnectionData SP],
-    passwordData,
-    [SubImapConnectionData CRLF],
-  ];
+  [builder appendSP];
+  [self appendString:_login toBuilder:builder];
+  [builder appendSP];
+  [self appendString:_password toBuilder:builder];
+  [builder appendCRLF];
+
+  return [builder dataList];
+}
+
+- (void)appendString:(NSString *)string toBuilder:(SubImapCommandBuilder *)builder {
+  if ([self stringNeedsLiteral:string]) {
+    [builder appendLiteral:[string dataUsingEncoding:NSUTF8StringEncoding]];
+  } else {
+    [builder appendString:string];
+  }
 }
 
 - (BOOL)handleUntaggedResponse:(SubImapResponse *)response {
@@ -23,7 +23,7 @@
 
 #import "SubImapLogoutCommand.h"
 
-#import "SubImapConnectionData.h"
+#import "SubImapCommandBuilder.h"
 
 @implementation SubImapLogoutCommand
 
@@ -47,12 +47,10 @@
 }
 
 - (NSArray *)render {
-  return @[
-    [SubImapConnectionData dataWithString:self.tag],
-    [SubImapConnectionData SP],
-    [SubImapConnectionData dataWithString:self.name],
-    [SubImapConnectionData CRLF],
-  ];
+  SubImapCommandBuilder *builder = [self builder];
+  [builder appendCRLF];
+
+  return [builder dataList];
 }
 
 - (BOOL)handleUntaggedResponse:(SubImapResponse *)response {
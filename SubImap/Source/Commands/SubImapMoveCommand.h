@@ -0,0 +1,51 @@
+// SubImapMoveCommand.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapCopyCommand.h"
+
+
+enum {
+  SubImapMoveCommandFailedError = 14,
+};
+
+
+/*
+ * MOVE and UID MOVE, RFC6851.
+ *
+ * Moves every message in a set to another mailbox in one command. The
+ * server expunges the moved messages from the selected mailbox, and with
+ * UIDPLUS the result has their new UIDs, as with SubImapCopyCommand.
+ *
+ * When the server does not support MOVE, a COPY is sent instead and
+ * copiedOnly is set. The messages are still in the selected mailbox, and
+ * need \Deleted set and expunging. SubImapTransaction
+ * moveTransactionWithUIDs:fromMailbox:toMailbox: does this.
+ */
+@interface SubImapMoveCommand : SubImapCopyCommand
+
+/*
+ * YES when the server did not support MOVE, and a COPY was sent.
+ */
+@property (readonly) BOOL copiedOnly;
+
+@end
\ No newline at end of file
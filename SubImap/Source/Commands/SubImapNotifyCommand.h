@@ -0,0 +1,112 @@
+// SubImapNotifyCommand.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapCommand.h"
+
+
+enum {
+  SubImapNotifyCommandFailedError = 15,
+};
+
+// RFC5465 events
+enum {
+  SubImapNotifyEventMessageNew         = 1 << 0,
+  SubImapNotifyEventMessageExpunge     = 1 << 1,
+  SubImapNotifyEventFlagChange         = 1 << 2,
+  SubImapNotifyEventMailboxName        = 1 << 3,
+  SubImapNotifyEventSubscriptionChange = 1 << 4,
+};
+
+
+/*
+ * NOTIFY, RFC5465.
+ *
+ * Asks the server to report changes to a set of mailboxes, so one
+ * connection can watch many mailboxes without polling them with STATUS.
+ * Changes to other mailboxes arrive as untagged STATUS responses, and
+ * created, deleted or renamed mailboxes as untagged LIST responses.
+ * SubImapClient passes these to its delegates'
+ * client:didReceiveMailboxEvent:forMailbox:, at any time after the
+ * command completes.
+ *
+ * The selected mailbox is watched separately, with selectedEvents. Its
+ * changes arrive as FETCH, EXPUNGE and EXISTS responses, as they do
+ * with IDLE.
+ *
+ * With sendsStatus, the server first sends the status of every watched
+ * mailbox, and the result is a dictionary of mailbox path to status
+ * dictionary, as for SubImapStatusCommand. Otherwise the result is an
+ * empty dictionary.
+ *
+ * A server that does not support an event refuses the command with a
+ * BADEVENT code, whose "events" are the ones it does support.
+ */
+@interface SubImapNotifyCommand : SubImapCommand
+
+/*
+ * Watches the given mailboxes, eg: @[@"INBOX", @"Work"].
+ */
++ (id)commandWithMailboxes:(NSArray *)paths events:(NSUInteger)events;
+
+/*
+ * Watches the mailboxes matching a filter: @"INBOXES", @"PERSONAL" or
+ * @"SUBSCRIBED".
+ */
++ (id)commandWithFilter:(NSString *)filter events:(NSUInteger)events;
+
+/*
+ * NOTIFY NONE, which stops every event.
+ */
++ (id)noneCommand;
+
+@property (readonly) NSArray *mailboxPaths;
+@property (readonly) NSString *filter;
+
+/*
+ * Events for the watched mailboxes. FlagChange can only be asked for
+ * along with MessageNew and MessageExpunge, so it adds them.
+ */
+@property (readonly) NSUInteger events;
+
+/*
+ * Events for the selected mailbox, or 0 for none.
+ *
+ * Defaults to MessageNew, MessageExpunge and FlagChange.
+ */
+@property NSUInteger selectedEvents;
+
+/*
+ * Fetch attributes sent with each new message in the selected mailbox,
+ * eg: @[@"UID", @"FLAGS"]. Nil to only be sent EXISTS.
+ */
+@property NSArray *selectedFetchAttributes;
+
+/*
+ * Sends the STATUS option, asking for the status of every watched
+ * mailbox before any events.
+ *
+ * Defaults to YES.
+ */
+@property BOOL sendsStatus;
+
+@end
\ No newline at end of file
@@ -0,0 +1,195 @@
+// SubImapNotifyCommand.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapNotifyCommand.h"
+
+#import "SubImapCommandBuilder.h"
+
+@implementation SubImapNotifyCommand {
+  BOOL _none;
+  NSMutableDictionary *_statuses;
+}
+
++ (id)commandWithMailboxes:(NSArray *)paths events:(NSUInteger)events {
+  SubImapNotifyCommand *command = [[self alloc] initWithEvents:events];
+
+  if (!paths.count) {
+    [command setErrorCode:SubImapNotifyCommandFailedError message:@"No mailboxes passed to notify command."];
+  }
+
+  command->_mailboxPaths = paths;
+
+  return command;
+}
+
++ (id)commandWithFilter:(NSString *)filter events:(NSUInteger)events {
+  SubImapNotifyCommand *command = [[self alloc] initWithEvents:events];
+
+  if (![@[@"INBOXES", @"PERSONAL", @"SUBSCRIBED"] containsObject:[filter uppercaseString]]) {
+    [command setErrorCode:SubImapNotifyCommandFailedError message:@"Unknown mailbox filter passed to notify command."];
+  }
+
+  command->_filter = [filter uppercaseString];
+
+  return command;
+}
+
++ (id)noneCommand {
+  SubImapNotifyCommand *command = [[self alloc] initWithEvents:0];
+  command->_none = YES;
+  return command;
+}
+
+- (id)initWithEvents:(NSUInteger)events {
+  self = [super init];
+
+  if (self) {
+    if (events & SubImapNotifyEventFlagChange) {
+      events |= SubImapNotifyEventMessageNew | SubImapNotifyEventMessageExpunge;
+    }
+
+    _events = events;
+    _statuses = [NSMutableDictionary dictionary];
+
+    self.selectedEvents = SubImapNotifyEventMessageNew | SubImapNotifyEventMessageExpunge | SubImapNotifyEventFlagChange;
+    self.sendsStatus = YES;
+  }
+
+  return self;
+}
+
+- (NSString *)name {
+  return @"NOTIFY";
+}
+
+- (BOOL)canExecuteInState:(SubImapClientState)state {
+  switch (state) {
+    case SubImapClientStateAuthenticated:
+    case SubImapClientStateSelected:
+      return YES;
+    default:
+      return NO;
+  }
+}
+
+- (NSArray *)render {
+  SubImapCommandBuilder *builder = [self builder];
+
+  if (_none) {
+    [builder appendString:@" NONE"];
+    [builder appendCRLF];
+
+    return [builder dataList];
+  }
+
+  [builder appendString:@" SET"];
+
+  if (self.sendsStatus) {
+    [builder appendString:@" STATUS"];
+  }
+
+  // (SELECTED (MessageNew (UID FLAGS) MessageExpunge FlagChange))
+  [builder appendString:@" (SELECTED "];
+  [self appendEvents:self.selectedEvents fetchAttributes:self.selectedFetchAttributes toBuilder:builder];
+  [builder appendBytes:")" length:1];
+
+  // (MAILBOXES (INBOX Work) (MessageNew MessageExpunge))
+  [builder appendString:@" ("];
+
+  if (_filter) {
+    [builder appendString:_filter];
+  }
+
+  else {
+    [builder appendString:@"MAILBOXES ("];
+
+    for (NSUInteger i = 0; i < _mailboxPaths.count; i++) {
+      if (i) [builder appendSP];
+      [builder appendAString:_mailboxPaths[i]];
+    }
+
+    [builder appendBytes:")" length:1];
+  }
+
+  [builder appendSP];
+  [self appendEvents:_events fetchAttributes:nil toBuilder:builder];
+  [builder appendBytes:")" length:1];
+  [builder appendCRLF];
+
+  return [builder dataList];
+}
+
+- (void)appendEvents:(NSUInteger)events fetchAttributes:(NSArray *)attributes toBuilder:(SubImapCommandBuilder *)builder {
+  NSArray *names = @[@"MessageNew", @"MessageExpunge", @"FlagChange", @"MailboxName", @"SubscriptionChange"];
+  BOOL first = YES;
+
+  if (!events) {
+    [builder appendString:@"NONE"];
+    return;
+  }
+
+  [builder appendBytes:"(" length:1];
+
+  for (NSUInteger i = 0; i < names.count; i++) {
+    if (!(events & (1 << i))) continue;
+    if (!first) [builder appendSP];
+
+    [builder appendString:names[i]];
+    first = NO;
+
+    // Only the selected mailbox can send fetch attributes
+    if (i == 0 && attributes.count) {
+      [builder appendString:@" ("];
+      [builder appendString:[attributes componentsJoinedByString:@" "]];
+      [builder appendBytes:")" length:1];
+    }
+  }
+
+  [builder appendBytes:")" length:1];
+}
+
+- (BOOL)handleUntaggedResponse:(SubImapResponse *)response {
+  if ([response isType:SubImapResponseTypeStatus]) {
+    NSString *path = response.data[@"mailbox"];
+
+    if (path) {
+      _statuses[path] = response.data;
+    }
+
+    return YES;
+  }
+
+  return NO;
+}
+
+- (BOOL)handleTaggedResponse:(SubImapResponse *)response {
+  if (![response isType:SubImapResponseTypeOk]) {
+    [self setErrorCode:SubImapNotifyCommandFailedError message:response.data[@"message"]];
+  }
+
+  self.result = _statuses;
+
+  return YES;
+}
+
+@end
\ No newline at end of file
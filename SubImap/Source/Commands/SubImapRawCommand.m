@@ -23,7 +23,7 @@
 
 #import "SubImapRawCommand.h"
 
-#import "SubImapConnectionData.h"
+#import "SubImapCommandBuilder.h"
 
 @implementation SubImapRawCommand {
   NSString *_command;
@@ -53,12 +53,14 @@
 }
 
 - (NSArray *)render {
-  return @[
-    [SubImapConnectionData dataWithString:self.tag],
-    [SubImapConnectionData SP],
-    [SubImapConnectionData dataWithString:_command],
-    [SubImapConnectionData CRLF],
-  ];
+  SubImapCommandBuilder *builder = [SubImapCommandBuilder builder];
+
+  [builder appendString:self.tag];
+  [builder appendSP];
+  [builder appendString:_command];
+  [builder appendCRLF];
+
+  return [builder dataList];
 }
 
 - (BOOL)handleUntaggedResponse:(SubImapResponse *)response {
@@ -0,0 +1,70 @@
+// SubImapSearchCommand.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapCommand.h"
+#import "SubImapSearchCriteria.h"
+
+
+enum {
+  SubImapSearchCommandFailedError = 10,
+};
+
+// RFC4731 - ESEARCH RETURN options
+enum {
+  SubImapSearchReturnMin   = 1 << 0,
+  SubImapSearchReturnMax   = 1 << 1,
+  SubImapSearchReturnCount = 1 << 2,
+  SubImapSearchReturnAll   = 1 << 3,
+};
+
+
+/*
+ * SEARCH and UID SEARCH, RFC3501 6.4.4.
+ *
+ * The result is a dictionary:
+ *
+ *   "all": (NSIndexSet *) the matching sequence numbers or UIDs
+ *   "count": (NSNumber *) the number of matches
+ *   "min": (NSNumber *) the lowest match, if any
+ *   "max": (NSNumber *) the highest match, if any
+ *
+ * When the server supports ESEARCH, only the results asked for in
+ * returnOptions are sent, and "all" arrives as a compact sequence set.
+ * Without it, every match is sent and all four are included.
+ */
+@interface SubImapSearchCommand : SubImapCommand
+
++ (id)commandWithCriteria:(SubImapSearchCriteria *)criteria;
++ (id)UIDCommandWithCriteria:(SubImapSearchCriteria *)criteria;
+
+@property (readonly) SubImapSearchCriteria *criteria;
+@property (readonly) BOOL useUIDs;
+
+/*
+ * The SubImapSearchReturn options to ask for.
+ *
+ * Defaults to SubImapSearchReturnAll.
+ */
+@property NSUInteger returnOptions;
+
+@end
\ No newline at end of file
@@ -0,0 +1,172 @@
+// SubImapSearchCommand.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapSearchCommand.h"
+
+#import "SubImapCommandBuilder.h"
+
+@implementation SubImapSearchCommand {
+  BOOL _extended;
+  NSMutableIndexSet *_all;
+  NSDictionary *_esearchData;
+}
+
++ (id)commandWithCriteria:(SubImapSearchCriteria *)criteria {
+  return [[self alloc] initWithCriteria:criteria UID:NO];
+}
+
++ (id)UIDCommandWithCriteria:(SubImapSearchCriteria *)criteria {
+  return [[self alloc] initWithCriteria:criteria UID:YES];
+}
+
+- (id)initWithCriteria:(SubImapSearchCriteria *)criteria UID:(BOOL)useUIDs {
+  self = [super init];
+
+  if (self) {
+    if (!criteria) {
+      [self setErrorCode:SubImapSearchCommandFailedError message:@"Nil criteria given to search command."];
+    }
+
+    _criteria = criteria;
+    _useUIDs = useUIDs;
+    _returnOptions = SubImapSearchReturnAll;
+    _all = [NSMutableIndexSet indexSet];
+  }
+
+  return self;
+}
+
+- (NSString *)name {
+  return @"SEARCH";
+}
+
+- (BOOL)canExecuteInState:(SubImapClientState)state {
+  return state == SubImapClientStateSelected;
+}
+
+- (NSArray *)render {
+  SubImapCommandBuilder *builder = [SubImapCommandBuilder builder];
+
+  [builder appendString:self.tag];
+  [builder appendSP];
+
+  if (_useUIDs) {
+    [builder appendString:@"UID"];
+    [builder appendSP];
+  }
+
+  [builder appendString:self.name];
+
+  // RFC4731 - ESEARCH
+  _extended = [self.capabilities containsObject:@"ESEARCH"] && _returnOptions;
+
+  if (_extended) {
+    NSArray *names = @[@"MIN", @"MAX", @"COUNT", @"ALL"];
+    BOOL first = YES;
+
+    [builder appendString:@" RETURN ("];
+
+    for (NSUInteger i = 0; i < names.count; i++) {
+      if (!(_returnOptions & (1 << i))) continue;
+      if (!first) [builder appendSP];
+
+      [builder appendString:names[i]];
+      first = NO;
+    }
+
+    [builder appendBytes:")" length:1];
+  }
+
+  if (_criteria.requiresUTF8) {
+    [builder appendString:@" CHARSET UTF-8"];
+  }
+
+  [builder appendSP];
+  [_criteria appendToBuilder:builder];
+  [builder appendCRLF];
+
+  return [builder dataList];
+}
+
+- (BOOL)handleUntaggedResponse:(SubImapResponse *)response {
+  if ([response isType:SubImapResponseTypeSearch]) {
+    [_all addIndexes:response.data];
+    return YES;
+  }
+
+  // Only the one for this command, when the server says which it is for
+  if ([response isType:SubImapResponseTypeEsearch]) {
+    NSString *tag = response.data[@"tag"];
+
+    if (tag && ![tag isEqualToString:self.tag]) {
+      return NO;
+    }
+
+    _esearchData = response.data;
+    return YES;
+  }
+
+  return NO;
+}
+
+- (BOOL)handleTaggedResponse:(SubImapResponse *)response {
+  if (![response isType:SubImapResponseTypeOk]) {
+    [self setErrorCode:SubImapSearchCommandFailedError message:response.data[@"message"]];
+    return YES;
+  }
+
+  NSMutableDictionary *result = [NSMutableDictionary dictionary];
+
+  if (_extended) {
+    for (NSString *key in @[@"all", @"count", @"min", @"max"]) {
+      if (_esearchData[key]) {
+        result[key] = _esearchData[key];
+      }
+    }
+
+    // Results are left out when nothing matched
+    if ((_returnOptions & SubImapSearchReturnAll) && !result[@"all"]) {
+      result[@"all"] = [NSIndexSet indexSet];
+    }
+
+    if ((_returnOptions & SubImapSearchReturnCount) && !result[@"count"]) {
+      result[@"count"] = @0;
+    }
+  }
+
+  else {
+    result[@"all"] = _all;
+    result[@"count"] = @(_all.count);
+
+    if (_all.count) {
+      result[@"min"] = @(_all.firstIndex);
+      result[@"max"] = @(_all.lastIndex);
+    }
+  }
+
+  self.result = result;
+
+  return YES;
+}
+
+@end
\ No newline at end of file
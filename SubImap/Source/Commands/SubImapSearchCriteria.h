@@ -0,0 +1,132 @@
+// SubImapSearchCriteria.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+@class SubImapCommandBuilder;
+
+/*
+ * SubImapSearchCriteria
+ *
+ * A search key for SubImapSearchCommand, RFC3501 6.4.4. Keys are combined
+ * with allOf:, either:or: and not:.
+ *
+ *   [SubImapSearchCriteria allOf:@[
+ *     [SubImapSearchCriteria unseen],
+ *     [SubImapSearchCriteria since:date],
+ *     [SubImapSearchCriteria not:[SubImapSearchCriteria from:@"list@example.com"]],
+ *   ]]
+ */
+@interface SubImapSearchCriteria : NSObject
+
+/*
+ * YES if a string in the criteria is not ASCII, so the search has to be
+ * sent with CHARSET UTF-8.
+ */
+@property (readonly) BOOL requiresUTF8;
+
+#pragma mark Flags
+
++ (instancetype)all;
++ (instancetype)answered;
++ (instancetype)deleted;
++ (instancetype)draft;
++ (instancetype)flagged;
++ (instancetype)seen;
++ (instancetype)unanswered;
++ (instancetype)undeleted;
++ (instancetype)undraft;
++ (instancetype)unflagged;
++ (instancetype)unseen;
++ (instancetype)keyword:(NSString *)keyword;
++ (instancetype)unkeyword:(NSString *)keyword;
+
+#pragma mark Headers and text
+
++ (instancetype)from:(NSString *)string;
++ (instancetype)to:(NSString *)string;
++ (instancetype)cc:(NSString *)string;
++ (instancetype)bcc:(NSString *)string;
++ (instancetype)subject:(NSString *)string;
++ (instancetype)header:(NSString *)field contains:(NSString *)string;
++ (instancetype)body:(NSString *)string;
++ (instancetype)text:(NSString *)string;
+
+#pragma mark Dates and sizes
+
+/*
+ * Dates are compared by day, in the local time zone. The first three use
+ * the internal date, the others the Date header.
+ */
++ (instancetype)before:(NSDate *)date;
++ (instancetype)on:(NSDate *)date;
++ (instancetype)since:(NSDate *)date;
++ (instancetype)sentBefore:(NSDate *)date;
++ (instancetype)sentOn:(NSDate *)date;
++ (instancetype)sentSince:(NSDate *)date;
+
++ (instancetype)largerThan:(NSUInteger)size;
++ (instancetype)smallerThan:(NSUInteger)size;
+
+#pragma mark Messages
+
++ (instancetype)sequenceNumbers:(NSIndexSet *)sequenceNumbers;
++ (instancetype)UIDs:(NSIndexSet *)UIDs;
+
+/*
+ * RFC7162 - CONDSTORE. Messages changed after the mod-sequence.
+ */
++ (instancetype)modifiedSince:(unsigned long long)modSeq;
+
+#pragma mark Gmail
+
+/*
+ * Gimap extension, https://developers.google.com/gmail/imap_extensions
+ *
+ * gmailRaw: searches with Gmail's own query syntax, eg:
+ * @"has:attachment newer_than:1y". The others match a message ID,
+ * thread ID or label, as fetched with X-GM-MSGID, X-GM-THRID and
+ * X-GM-LABELS.
+ */
++ (instancetype)gmailRaw:(NSString *)query;
++ (instancetype)gmailMessageID:(NSString *)messageID;
++ (instancetype)gmailThreadID:(NSString *)threadID;
++ (instancetype)gmailLabel:(NSString *)label;
+
+#pragma mark Combining
+
++ (instancetype)allOf:(NSArray *)criteria;
++ (instancetype)either:(SubImapSearchCriteria *)criteria or:(SubImapSearchCriteria *)otherCriteria;
++ (instancetype)not:(SubImapSearchCriteria *)criteria;
+
+#pragma mark Inspecting
+
+/*
+ * The search key as it is sent, eg: @"FROM" or @"KEYWORD $Important", and
+ * its NSString, NSNumber, NSDate, NSIndexSet or SubImapSearchCriteria
+ * arguments. allOf: lists and sequence numbers have no key.
+ */
+@property (readonly) NSString *key;
+@property (readonly) NSArray *arguments;
+
+- (void)appendToBuilder:(SubImapCommandBuilder *)builder;
+
+@end
\ No newline at end of file
@@ -0,0 +1,239 @@
+// SubImapSearchCriteria.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapSearchCriteria.h"
+
+#import "SubImapCommandBuilder.h"
+
+@implementation SubImapSearchCriteria {
+  // Rendered as it is, may be nil
+  NSString *_key;
+
+  // NSString astrings, NSNumber numbers, NSDate dates, NSIndexSet
+  // sequence sets and nested SubImapSearchCriteria
+  NSArray *_arguments;
+
+  // allOf: lists are parenthesized
+  BOOL _parenthesized;
+}
+
++ (instancetype)criteriaWithKey:(NSString *)key arguments:(NSArray *)arguments {
+  return [[self alloc] initWithKey:key arguments:arguments parenthesized:NO];
+}
+
+- (id)initWithKey:(NSString *)key arguments:(NSArray *)arguments parenthesized:(BOOL)parenthesized {
+  self = [super init];
+
+  if (self) {
+    _key = key;
+    _arguments = arguments ?: @[];
+    _parenthesized = parenthesized;
+  }
+
+  return self;
+}
+
+- (BOOL)requiresUTF8 {
+  for (id argument in _arguments) {
+    if ([argument isKindOfClass:[NSString class]] && ![argument canBeConvertedToEncoding:NSASCIIStringEncoding]) {
+      return YES;
+    }
+
+    if ([argument isKindOfClass:[SubImapSearchCriteria class]] && [argument requiresUTF8]) {
+      return YES;
+    }
+  }
+
+  return NO;
+}
+
+#pragma mark Flags
+
++ (instancetype)all        { return [self criteriaWithKey:@"ALL" arguments:nil]; }
++ (instancetype)answered   { return [self criteriaWithKey:@"ANSWERED" arguments:nil]; }
++ (instancetype)deleted    { return [self criteriaWithKey:@"DELETED" arguments:nil]; }
++ (instancetype)draft      { return [self criteriaWithKey:@"DRAFT" arguments:nil]; }
++ (instancetype)flagged    { return [self criteriaWithKey:@"FLAGGED" arguments:nil]; }
++ (instancetype)seen       { return [self criteriaWithKey:@"SEEN" arguments:nil]; }
++ (instancetype)unanswered { return [self criteriaWithKey:@"UNANSWERED" arguments:nil]; }
++ (instancetype)undeleted  { return [self criteriaWithKey:@"UNDELETED" arguments:nil]; }
++ (instancetype)undraft    { return [self criteriaWithKey:@"UNDRAFT" arguments:nil]; }
++ (instancetype)unflagged  { return [self criteriaWithKey:@"UNFLAGGED" arguments:nil]; }
++ (instancetype)unseen     { return [self criteriaWithKey:@"UNSEEN" arguments:nil]; }
+
+// Keywords are atoms, so they are part of the key
++ (instancetype)keyword:(NSString *)keyword {
+  return [self criteriaWithKey:[@"KEYWORD " stringByAppendingString:keyword] arguments:nil];
+}
+
++ (instancetype)unkeyword:(NSString *)keyword {
+  return [self criteriaWithKey:[@"UNKEYWORD " stringByAppendingString:keyword] arguments:nil];
+}
+
+#pragma mark Headers and text
+
++ (instancetype)from:(NSString *)string    { return [self criteriaWithKey:@"FROM" arguments:@[string]]; }
++ (instancetype)to:(NSString *)string      { return [self criteriaWithKey:@"TO" arguments:@[string]]; }
++ (instancetype)cc:(NSString *)string      { return [self criteriaWithKey:@"CC" arguments:@[string]]; }
++ (instancetype)bcc:(NSString *)string     { return [self criteriaWithKey:@"BCC" arguments:@[string]]; }
++ (instancetype)subject:(NSString *)string { return [self criteriaWithKey:@"SUBJECT" arguments:@[string]]; }
++ (instancetype)body:(NSString *)string    { return [self criteriaWithKey:@"BODY" arguments:@[string]]; }
++ (instancetype)text:(NSString *)string    { return [self criteriaWithKey:@"TEXT" arguments:@[string]]; }
+
++ (instancetype)header:(NSString *)field contains:(NSString *)string {
+  return [self criteriaWithKey:@"HEADER" arguments:@[field, string]];
+}
+
+#pragma mark Dates and sizes
+
++ (instancetype)before:(NSDate *)date     { return [self criteriaWithKey:@"BEFORE" arguments:@[date]]; }
++ (instancetype)on:(NSDate *)date         { return [self criteriaWithKey:@"ON" arguments:@[date]]; }
++ (instancetype)since:(NSDate *)date      { return [self criteriaWithKey:@"SINCE" arguments:@[date]]; }
++ (instancetype)sentBefore:(NSDate *)date { return [self criteriaWithKey:@"SENTBEFORE" arguments:@[date]]; }
++ (instancetype)sentOn:(NSDate *)date     { return [self criteriaWithKey:@"SENTON" arguments:@[date]]; }
++ (instancetype)sentSince:(NSDate *)date  { return [self criteriaWithKey:@"SENTSINCE" arguments:@[date]]; }
+
++ (instancetype)largerThan:(NSUInteger)size {
+  return [self criteriaWithKey:@"LARGER" arguments:@[@(size)]];
+}
+
++ (instancetype)smallerThan:(NSUInteger)size {
+  return [self criteriaWithKey:@"SMALLER" arguments:@[@(size)]];
+}
+
+#pragma mark Messages
+
++ (instancetype)sequenceNumbers:(NSIndexSet *)sequenceNumbers {
+  return [self criteriaWithKey:nil arguments:@[sequenceNumbers]];
+}
+
++ (instancetype)UIDs:(NSIndexSet *)UIDs {
+  return [self criteriaWithKey:@"UID" arguments:@[UIDs]];
+}
+
++ (instancetype)modifiedSince:(unsigned long long)modSeq {
+  return [self criteriaWithKey:@"MODSEQ" arguments:@[@(modSeq)]];
+}
+
+#pragma mark Gmail
+
+// IDs are 64-bit numbers, kept as the strings the parser returns
++ (instancetype)gmailRaw:(NSString *)query { return [self criteriaWithKey:@"X-GM-RAW" arguments:@[query]]; }
++ (instancetype)gmailLabel:(NSString *)label { return [self criteriaWithKey:@"X-GM-LABELS" arguments:@[label]]; }
+
++ (instancetype)gmailMessageID:(NSString *)messageID {
+  return [self criteriaWithKey:[@"X-GM-MSGID " stringByAppendingString:messageID] arguments:nil];
+}
+
++ (instancetype)gmailThreadID:(NSString *)threadID {
+  return [self criteriaWithKey:[@"X-GM-THRID " stringByAppendingString:threadID] arguments:nil];
+}
+
+#pragma mark Combining
+
++ (instancetype)allOf:(NSArray *)criteria {
+  if (criteria.count == 0) {
+    return [self all];
+  }
+
+  if (criteria.count == 1) {
+    return criteria[0];
+  }
+
+  return [[self alloc] initWithKey:nil arguments:criteria parenthesized:YES];
+}
+
++ (instancetype)either:(SubImapSearchCriteria *)criteria or:(SubImapSearchCriteria *)otherCriteria {
+  return [self criteriaWithKey:@"OR" arguments:@[criteria, otherCriteria]];
+}
+
++ (instancetype)not:(SubImapSearchCriteria *)criteria {
+  return [self criteriaWithKey:@"NOT" arguments:@[criteria]];
+}
+
+#pragma mark Rendering
+
+- (void)appendToBuilder:(SubImapCommandBuilder *)builder {
+  BOOL needsSpace = NO;
+
+  if (_parenthesized) {
+    [builder appendBytes:"(" length:1];
+  }
+
+  if (_key) {
+    [builder appendString:_key];
+    needsSpace = YES;
+  }
+
+  for (id argument in _arguments) {
+    if (needsSpace) {
+      [builder appendSP];
+    }
+
+    needsSpace = YES;
+
+    if ([argument isKindOfClass:[SubImapSearchCriteria class]]) {
+      [argument appendToBuilder:builder];
+    }
+
+    else if ([argument isKindOfClass:[NSString class]]) {
+      [builder appendAString:argument];
+    }
+
+    else if ([argument isKindOfClass:[NSIndexSet class]]) {
+      [builder appendSequenceSet:argument];
+    }
+
+    else if ([argument isKindOfClass:[NSDate class]]) {
+      [self appendDate:argument toBuilder:builder];
+    }
+
+    else if ([argument isKindOfClass:[NSNumber class]]) {
+      [builder appendString:[argument stringValue]];
+    }
+  }
+
+  if (_parenthesized) {
+    [builder appendBytes:")" length:1];
+  }
+}
+
+// date = 1*2DIGIT "-" date-month "-" 4DIGIT, with English month names
+// whatever the locale
+- (void)appendDate:(NSDate *)date toBuilder:(SubImapCommandBuilder *)builder {
+  static NSString * const months[] = {
+    @"Jan", @"Feb", @"Mar", @"Apr", @"May", @"Jun",
+    @"Jul", @"Aug", @"Sep", @"Oct", @"Nov", @"Dec",
+  };
+
+  NSCalendar *calendar = [[NSCalendar alloc] initWithCalendarIdentifier:NSGregorianCalendar];
+  NSDateComponents *components = [calendar components:NSYearCalendarUnit | NSMonthCalendarUnit | NSDayCalendarUnit fromDate:date];
+
+  [builder appendUnsignedInteger:components.day];
+  [builder appendBytes:"-" length:1];
+  [builder appendString:months[components.month - 1]];
+  [builder appendBytes:"-" length:1];
+  [builder appendUnsignedInteger:components.year];
+}
+
+@end
\ No newline at end of file
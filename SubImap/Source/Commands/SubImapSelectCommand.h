@@ -25,6 +25,8 @@
 
 @interface SubImapSelectCommand : SubImapCommand
 
+@property (readonly) NSString *mailboxPath;
+
 + (id)commandWithMailboxPath:(NSString *)mailbox;
 + (id)commandWithInbox;
 
@@ -23,11 +23,9 @@
 
 #import "SubImapSelectCommand.h"
 
-#import "SubImapConnectionData.h"
+#import "SubImapCommandBuilder.h"
 
 @implementation SubImapSelectCommand {
-  NSString *_mailboxPath;
-
   NSMutableDictionary *_data;
 }
 
@@ -69,14 +67,13 @@
 }
 
 - (NSArray *)render {
-  return @[
-    [SubImapConnectionData dataWithString:self.tag],
-    [SubImapConnectionData SP],
-    [SubImapConnectionData dataWithString:[self name]],
-    [SubImapConnectionData SP],
-    [SubImapConnectionData dataWithQuotedString:_mailboxPath],
-    [SubImapConnectionData CRLF],
-  ];
+  SubImapCommandBuilder *builder = [self builder];
+
+  [builder appendSP];
+  [builder appendQuotedString:_mailboxPath];
+  [builder appendCRLF];
+
+  return [builder dataList];
 }
 
 - (BOOL)handleUntaggedResponse:(SubImapResponse *)response {
@@ -0,0 +1,62 @@
+// SubImapStatusCommand.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapCommand.h"
+
+
+enum {
+  SubImapStatusCommandFailedError = 11,
+};
+
+
+/*
+ * STATUS, RFC3501 6.3.10.
+ *
+ * Asks for the status of one or more mailboxes. With several mailboxes,
+ * the STATUS commands are pipelined: all are written at once, and the
+ * command completes when the last tagged response arrives, so listing N
+ * folders costs one round trip rather than N.
+ *
+ * The result is a dictionary of mailbox path to status dictionary, eg:
+ *
+ *   @{ @"INBOX": @{ @"mailbox": @"INBOX", @"messages": @12, @"unseen": @2 } }
+ *
+ * A mailbox the server refused, such as one deleted since it was listed,
+ * is left out. The command only fails if every mailbox was refused.
+ *
+ * Prefer SubImapListCommand's statusItems, which uses LIST-STATUS when
+ * the server supports it.
+ */
+@interface SubImapStatusCommand : SubImapCommand
+
++ (id)commandWithMailbox:(NSString *)path items:(NSArray *)items;
++ (id)commandWithMailboxes:(NSArray *)paths items:(NSArray *)items;
+
+@property (readonly) NSArray *mailboxPaths;
+
+/*
+ * The status items asked for, eg: @[@"MESSAGES", @"UNSEEN"].
+ */
+@property (readonly) NSArray *items;
+
+@end
\ No newline at end of file
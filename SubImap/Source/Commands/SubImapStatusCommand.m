@@ -0,0 +1,139 @@
+// SubImapStatusCommand.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapStatusCommand.h"
+
+#import "SubImapCommandBuilder.h"
+
+@implementation SubImapStatusCommand {
+  NSMutableDictionary *_statuses;
+  NSUInteger _pending;
+  NSUInteger _failed;
+  NSString *_failure;
+}
+
++ (id)commandWithMailbox:(NSString *)path items:(NSArray *)items {
+  return [[self alloc] initWithMailboxes:(path ? @[path] : nil) items:items];
+}
+
++ (id)commandWithMailboxes:(NSArray *)paths items:(NSArray *)items {
+  return [[self alloc] initWithMailboxes:paths items:items];
+}
+
+- (id)initWithMailboxes:(NSArray *)paths items:(NSArray *)items {
+  self = [super init];
+
+  if (self) {
+    if (!paths.count || !items.count) {
+      [self setErrorCode:SubImapStatusCommandFailedError message:@"Status command given no mailboxes or items."];
+    }
+
+    _mailboxPaths = paths;
+    _items = items;
+    _statuses = [NSMutableDictionary dictionary];
+  }
+
+  return self;
+}
+
+- (NSString *)name {
+  return @"STATUS";
+}
+
+- (BOOL)canExecuteInState:(SubImapClientState)state {
+  switch (state) {
+    case SubImapClientStateAuthenticated:
+    case SubImapClientStateSelected:
+      return YES;
+    default:
+      return NO;
+  }
+}
+
+- (NSArray *)render {
+  SubImapCommandBuilder *builder = [SubImapCommandBuilder builderWithCapacity:_mailboxPaths.count * 48];
+  NSUInteger count = _mailboxPaths.count;
+
+  // Each STATUS gets its own tag, "tag.1", "tag.2"... The last one uses
+  // the command's tag, so the client sees the command finish with it.
+  for (NSUInteger i = 0; i < count; i++) {
+    [builder appendString:self.tag];
+
+    if (i + 1 < count) {
+      [builder appendBytes:"." length:1];
+      [builder appendUnsignedInteger:i + 1];
+    }
+
+    [builder appendSP];
+    [builder appendString:self.name];
+    [builder appendSP];
+    [builder appendAString:_mailboxPaths[i]];
+    [builder appendString:@" ("];
+    [builder appendString:[_items componentsJoinedByString:@" "]];
+    [builder appendBytes:")" length:1];
+    [builder appendCRLF];
+  }
+
+  _pending = count;
+
+  return [builder dataList];
+}
+
+- (BOOL)handleUntaggedResponse:(SubImapResponse *)response {
+  if ([response isType:SubImapResponseTypeStatus]) {
+    NSString *path = response.data[@"mailbox"];
+
+    if (path) {
+      _statuses[path] = response.data;
+    }
+
+    return YES;
+  }
+
+  return NO;
+}
+
+- (BOOL)handleTaggedResponse:(SubImapResponse *)response {
+  if (![response isType:SubImapResponseTypeOk]) {
+    _failed++;
+    _failure = response.data[@"message"];
+  }
+
+  // Wait for the rest of the pipelined commands
+  if (_pending > 1) {
+    _pending--;
+    return NO;
+  }
+
+  _pending = 0;
+
+  if (_failed == _mailboxPaths.count) {
+    [self setErrorCode:SubImapStatusCommandFailedError message:_failure];
+  }
+
+  self.result = _statuses;
+
+  return YES;
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,67 @@
+// SubImapStoreCommand.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapCommand.h"
+
+
+enum {
+  SubImapStoreCommandFailedError = 12,
+};
+
+typedef enum {
+  SubImapStoreOperationAdd,     // +FLAGS
+  SubImapStoreOperationRemove,  // -FLAGS
+  SubImapStoreOperationReplace, // FLAGS
+} SubImapStoreOperation;
+
+
+/*
+ * STORE and UID STORE, RFC3501 6.4.6.
+ *
+ * Changes the flags of every message in a set at once. The set is sent
+ * compressed, eg: 1:500,502, so filing thousands of messages is still a
+ * single short command.
+ *
+ * When silent, the server does not send back the new flags, and the
+ * result is an empty array. Otherwise it is the data of each untagged
+ * FETCH response, holding "flags". Either way, SubImapMailboxState sees
+ * the changes the server reports.
+ */
+@interface SubImapStoreCommand : SubImapCommand
+
++ (id)commandWithSequenceNumbers:(NSIndexSet *)sequenceNumbers flags:(NSArray *)flags operation:(SubImapStoreOperation)operation;
++ (id)commandWithUIDs:(NSIndexSet *)UIDs flags:(NSArray *)flags operation:(SubImapStoreOperation)operation;
+
+@property (readonly) NSIndexSet *IDs;
+@property (readonly) BOOL useUIDs;
+@property (readonly) NSArray *flags;
+@property (readonly) SubImapStoreOperation operation;
+
+/*
+ * Sends FLAGS.SILENT, so the server does not echo the new flags back.
+ *
+ * Defaults to YES.
+ */
+@property BOOL silent;
+
+@end
\ No newline at end of file
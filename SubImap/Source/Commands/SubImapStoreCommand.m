@@ -0,0 +1,117 @@
+// SubImapStoreCommand.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapStoreCommand.h"
+
+#import "SubImapCommandBuilder.h"
+
+@implementation SubImapStoreCommand {
+  NSMutableArray *_responses;
+}
+
++ (id)commandWithSequenceNumbers:(NSIndexSet *)sequenceNumbers flags:(NSArray *)flags operation:(SubImapStoreOperation)operation {
+  return [[self alloc] initWithIDs:sequenceNumbers UID:NO flags:flags operation:operation];
+}
+
++ (id)commandWithUIDs:(NSIndexSet *)UIDs flags:(NSArray *)flags operation:(SubImapStoreOperation)operation {
+  return [[self alloc] initWithIDs:UIDs UID:YES flags:flags operation:operation];
+}
+
+- (id)initWithIDs:(NSIndexSet *)IDs UID:(BOOL)useUIDs flags:(NSArray *)flags operation:(SubImapStoreOperation)operation {
+  self = [super init];
+
+  if (self) {
+    if (!IDs.count || !flags) {
+      [self setErrorCode:SubImapStoreCommandFailedError message:@"Store command given no messages or flags."];
+    }
+
+    _IDs = IDs;
+    _useUIDs = useUIDs;
+    _flags = flags;
+    _operation = operation;
+    _responses = [NSMutableArray array];
+
+    self.silent = YES;
+  }
+
+  return self;
+}
+
+- (NSString *)name {
+  return @"STORE";
+}
+
+- (BOOL)canExecuteInState:(SubImapClientState)state {
+  return state == SubImapClientStateSelected;
+}
+
+- (NSArray *)render {
+  SubImapCommandBuilder *builder = [SubImapCommandBuilder builder];
+
+  [builder appendString:self.tag];
+  [builder appendSP];
+
+  if (_useUIDs) {
+    [builder appendString:@"UID"];
+    [builder appendSP];
+  }
+
+  [builder appendString:self.name];
+  [builder appendSP];
+  [builder appendSequenceSet:_IDs];
+  [builder appendSP];
+
+  switch (_operation) {
+    case SubImapStoreOperationAdd:    [builder appendBytes:"+" length:1]; break;
+    case SubImapStoreOperationRemove: [builder appendBytes:"-" length:1]; break;
+    default: break;
+  }
+
+  [builder appendString:(self.silent ? @"FLAGS.SILENT (" : @"FLAGS (")];
+  [builder appendString:[_flags componentsJoinedByString:@" "]];
+  [builder appendBytes:")" length:1];
+  [builder appendCRLF];
+
+  return [builder dataList];
+}
+
+- (BOOL)handleUntaggedResponse:(SubImapResponse *)response {
+  if ([response isType:SubImapResponseTypeFetch]) {
+    [_responses addObject:response.data];
+    return YES;
+  }
+
+  return NO;
+}
+
+- (BOOL)handleTaggedResponse:(SubImapResponse *)response {
+  if (![response isType:SubImapResponseTypeOk]) {
+    [self setErrorCode:SubImapStoreCommandFailedError message:response.data[@"message"]];
+  }
+
+  self.result = _responses;
+
+  return YES;
+}
+
+@end
\ No newline at end of file
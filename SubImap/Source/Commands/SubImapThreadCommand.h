@@ -0,0 +1,57 @@
+// SubImapThreadCommand.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapCommand.h"
+#import "SubImapSearchCriteria.h"
+
+
+enum {
+  SubImapThreadCommandFailedError = 16,
+};
+
+
+/*
+ * THREAD and UID THREAD, RFC5256.
+ *
+ * Lets the server group the messages matching the criteria into
+ * conversations. The result is the THREAD response's array of root
+ * nodes, each an NSDictionary with an "id" and "children". Pass it to
+ * SubImapThreadIndex addThreads: to merge it with locally built threads.
+ *
+ * The algorithm is REFERENCES by default, which needs the
+ * THREAD=REFERENCES capability. ORDEREDSUBJECT only groups by subject.
+ */
+@interface SubImapThreadCommand : SubImapCommand
+
++ (id)commandWithCriteria:(SubImapSearchCriteria *)criteria;
++ (id)UIDCommandWithCriteria:(SubImapSearchCriteria *)criteria;
+
+@property (readonly) SubImapSearchCriteria *criteria;
+@property (readonly) BOOL useUIDs;
+
+/*
+ * Defaults to @"REFERENCES".
+ */
+@property NSString *algorithm;
+
+@end
\ No newline at end of file
@@ -0,0 +1,108 @@
+// SubImapThreadCommand.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapThreadCommand.h"
+
+#import "SubImapCommandBuilder.h"
+
+@implementation SubImapThreadCommand {
+  NSMutableArray *_threads;
+}
+
++ (id)commandWithCriteria:(SubImapSearchCriteria *)criteria {
+  return [[self alloc] initWithCriteria:criteria UID:NO];
+}
+
++ (id)UIDCommandWithCriteria:(SubImapSearchCriteria *)criteria {
+  return [[self alloc] initWithCriteria:criteria UID:YES];
+}
+
+- (id)initWithCriteria:(SubImapSearchCriteria *)criteria UID:(BOOL)useUIDs {
+  self = [super init];
+
+  if (self) {
+    if (!criteria) {
+      [self setErrorCode:SubImapThreadCommandFailedError message:@"Nil criteria given to thread command."];
+    }
+
+    _criteria = criteria;
+    _useUIDs = useUIDs;
+    _threads = [NSMutableArray array];
+
+    self.algorithm = @"REFERENCES";
+  }
+
+  return self;
+}
+
+- (NSString *)name {
+  return @"THREAD";
+}
+
+- (BOOL)canExecuteInState:(SubImapClientState)state {
+  return state == SubImapClientStateSelected;
+}
+
+- (NSArray *)render {
+  SubImapCommandBuilder *builder = [SubImapCommandBuilder builder];
+
+  [builder appendString:self.tag];
+  [builder appendSP];
+
+  if (_useUIDs) {
+    [builder appendString:@"UID"];
+    [builder appendSP];
+  }
+
+  [builder appendString:self.name];
+  [builder appendSP];
+  [builder appendString:self.algorithm];
+
+  // The charset is not optional here
+  [builder appendString:(_criteria.requiresUTF8 ? @" UTF-8 " : @" US-ASCII ")];
+  [_criteria appendToBuilder:builder];
+  [builder appendCRLF];
+
+  return [builder dataList];
+}
+
+- (BOOL)handleUntaggedResponse:(SubImapResponse *)response {
+  if ([response isType:SubImapResponseTypeThread]) {
+    [_threads addObjectsFromArray:response.data];
+    return YES;
+  }
+
+  return NO;
+}
+
+- (BOOL)handleTaggedResponse:(SubImapResponse *)response {
+  if (![response isType:SubImapResponseTypeOk]) {
+    [self setErrorCode:SubImapThreadCommandFailedError message:response.data[@"message"]];
+  }
+
+  self.result = _threads;
+
+  return YES;
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,78 @@
+// SubImapHeaderParser.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+typedef void (^SubImapHeaderFieldBlock)(NSString *name, NSString *value, BOOL *stop);
+
+/*
+ * SubImapHeaderParser
+ *
+ * Parses RFC5322 header fields, such as a fetched HEADER.FIELDS section.
+ * Data can be given in chunks as it arrives. Folded lines are unfolded,
+ * and parsing stops at the blank line that ends the header.
+ *
+ * Field names are lowercased, so lookups are case-insensitive, eg:
+ *
+ *   headers[@"message-id"]
+ *
+ * Values are UTF-8, or ISO-8859-1 if they are not valid UTF-8. Encoded
+ * words (RFC2047) are left as they are.
+ */
+@interface SubImapHeaderParser : NSObject
+
++ (id)parser;
+
+/*
+ * Parses a complete header at once.
+ */
++ (NSDictionary *)headersFromData:(NSData *)data;
++ (NSDictionary *)headersFromString:(NSString *)string;
+
+/*
+ * Every field, in order, including repeated fields such as Received.
+ *
+ * Set by fieldBlock, called as soon as each field is complete. If set
+ * before any data, the headers dictionary is not built.
+ */
+@property (copy) SubImapHeaderFieldBlock fieldBlock;
+
+/*
+ * The fields parsed so far. A repeated field keeps its first value.
+ */
+@property (readonly) NSDictionary *headers;
+
+/*
+ * YES once the blank line ending the header was found. Later data is
+ * ignored.
+ */
+@property (readonly) BOOL isComplete;
+
+- (void)appendBytes:(const void *)bytes length:(NSUInteger)length;
+- (void)appendData:(NSData *)data;
+
+/*
+ * Completes the last field, for headers without a blank line at the
+ * end.
+ */
+- (void)finish;
+
+@end
\ No newline at end of file
@@ -0,0 +1,173 @@
+// SubImapHeaderParser.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapHeaderParser.h"
+
+@implementation SubImapHeaderParser {
+  NSMutableDictionary *_headers;
+  NSMutableData *_field;
+  BOOL _atLineStart;
+  BOOL _stopped;
+}
+
++ (id)parser {
+  return [[self alloc] init];
+}
+
++ (NSDictionary *)headersFromData:(NSData *)data {
+  SubImapHeaderParser *parser = [self parser];
+  [parser appendData:data];
+  [parser finish];
+  return parser.headers;
+}
+
++ (NSDictionary *)headersFromString:(NSString *)string {
+  return [self headersFromData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (id)init {
+  self = [super init];
+
+  if (self) {
+    _headers = [NSMutableDictionary dictionary];
+    _field = [NSMutableData dataWithCapacity:128];
+    _atLineStart = YES;
+  }
+
+  return self;
+}
+
+- (NSDictionary *)headers {
+  return _headers;
+}
+
+- (void)appendData:(NSData *)data {
+  [self appendBytes:[data bytes] length:[data length]];
+}
+
+- (void)appendBytes:(const void *)bytes length:(NSUInteger)length {
+  const unsigned char *c = bytes;
+  const unsigned char *end = c + length;
+
+  while (c < end && !_isComplete) {
+    // A line starting with whitespace continues the field. Anything else
+    // starts a new one, and a blank line ends the header.
+    if (_atLineStart) {
+      if (*c == '\r') {
+        c++;
+        continue;
+      }
+
+      _atLineStart = NO;
+
+      if (*c != ' ' && *c != '\t') {
+        [self completeField];
+
+        if (*c == '\n') {
+          _isComplete = YES;
+          break;
+        }
+      }
+    }
+
+    // Copy up to the end of the line in one go
+    const unsigned char *line = c;
+
+    while (c < end && *c != '\n') {
+      c++;
+    }
+
+    [_field appendBytes:line length:c - line];
+
+    if (c < end) {
+      _atLineStart = YES;
+      c++;
+
+      // Unfolding removes the CRLF, and keeps the whitespace after it. The
+      // CR may have arrived with the previous data.
+      NSUInteger length = [_field length];
+
+      if (length && ((const char *)[_field bytes])[length - 1] == '\r') {
+        [_field setLength:length - 1];
+      }
+    }
+  }
+}
+
+- (void)finish {
+  if (!_isComplete) {
+    [self completeField];
+    _isComplete = YES;
+  }
+}
+
+#pragma mark -
+
+- (void)completeField {
+  const char *bytes = [_field bytes];
+  NSUInteger length = [_field length];
+
+  if (!length || _stopped) {
+    [_field setLength:0];
+    return;
+  }
+
+  const char *colon = memchr(bytes, ':', length);
+
+  // Not a field, such as a stray mbox "From " line
+  if (!colon) {
+    [_field setLength:0];
+    return;
+  }
+
+  // Trim whitespace around the name and value
+  const char *nameEnd = colon;
+  while (nameEnd > bytes && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t')) nameEnd--;
+
+  const char *value = colon + 1;
+  const char *valueEnd = bytes + length;
+  while (value < valueEnd && (*value == ' ' || *value == '\t')) value++;
+  while (valueEnd > value && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t' || valueEnd[-1] == '\r')) valueEnd--;
+
+  NSString *name = [[[NSString alloc] initWithBytes:bytes length:nameEnd - bytes encoding:NSASCIIStringEncoding] lowercaseString];
+  NSString *string = [[NSString alloc] initWithBytes:value length:valueEnd - value encoding:NSUTF8StringEncoding];
+
+  if (!string) {
+    string = [[NSString alloc] initWithBytes:value length:valueEnd - value encoding:NSISOLatin1StringEncoding];
+  }
+
+  [_field setLength:0];
+
+  if (!name.length || !string) {
+    return;
+  }
+
+  if (_fieldBlock) {
+    _fieldBlock(name, string, &_stopped);
+    if (_stopped) _isComplete = YES;
+  } else if (!_headers[name]) {
+    _headers[name] = string;
+  }
+}
+
+@end
\ No newline at end of file
@@ -23,6 +23,9 @@
 
 #import "SubImapParser.h"
 
+#import "SubImapHeaderParser.h"
+#import "SubImapTransferDecoder.h"
+
 NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
 
 @implementation SubImapParser
@@ -63,13 +66,18 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
   if (*error) return nil;
 
   // Sub-parsers
+  SubImapResponse *response;
+
   if ([token.value isEqualToString:@"*"]) {
-    return [self untaggedResponse:error];
+    response = [self untaggedResponse:error];
   } else if ([token.value isEqualToString:@"+"]) {
-    return [self continuationResponse:error];
+    response = [self continuationResponse:error];
   } else {
-    return [self taggedResponseWithTag:token.value error:error];
+    response = [self taggedResponseWithTag:token.value error:error];
   }
+
+  response.length = data.length;
+  return response;
 }
 
 #pragma mark - Sub-parsers
@@ -152,11 +160,26 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
     return [self searchResponse:error];
   }
 
+  // Esearch
+  if ([token.value isEqualToString:@"ESEARCH"]) {
+    return [self esearchResponse:error];
+  }
+
   // Flags
   if ([token.value isEqualToString:@"FLAGS"]) {
     return [self flagsResponse:error];
   }
 
+  // Vanished
+  if ([token.value isEqualToString:@"VANISHED"]) {
+    return [self vanishedResponse:error];
+  }
+
+  // Thread
+  if ([token.value isEqualToString:@"THREAD"]) {
+    return [self threadResponse:error];
+  }
+
   // Unknown command
   [self error:error code:SubImapParserErrorUnknownCommand format:@"Unknown response command '%@'.", token.value];
 
@@ -242,6 +265,19 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
   if (*error) return nil;
   mailbox[@"path"] = path;
 
+  // RFC5258 - LIST-EXTENDED items, eg: ("CHILDINFO" ("SUBSCRIBED"))
+  if ([self.tokenizer pullTokenIsType:SubImapTokenTypeSpace]) {
+    id extended = [self parseExtendedItemListData:error];
+    if (*error) return nil;
+    mailbox[@"extended"] = extended;
+
+    // RFC5465 - A NOTIFY MailboxName event for a renamed mailbox
+    id oldName = extended[@"OLDNAME"];
+    if ([oldName isKindOfClass:[NSArray class]] && [oldName count]) {
+      mailbox[@"oldname"] = oldName[0];
+    }
+  }
+
   return [SubImapResponse responseWithType:[SubImapResponse typeFromString:command] data:mailbox];
 }
 
@@ -283,7 +319,7 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
 
 - (SubImapResponse *)searchResponse:(NSError **)error {
   SubImapToken *token;
-  NSMutableArray *data = [NSMutableArray array];
+  NSMutableIndexSet *data = [NSMutableIndexSet indexSet];
 
   // Command name
   token = [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
@@ -295,16 +331,124 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
       break;
     }
 
-    // Number
-    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeNumber error:error];
-    if (*error) return nil;
+    // RFC7162 - CONDSTORE adds "(MODSEQ n)", which is not kept
+    if ([self.tokenizer pullTokenIsType:SubImapTokenTypeParenOpen]) {
+      unsigned long long modSeq;
+
+      token = [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
+      if (*error) return nil;
+
+      token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+      if (*error) return nil;
+
+      if (![self.tokenizer pullNumber:&modSeq]) {
+        [self error:error code:0 message:@"Invalid SEARCH MODSEQ."];
+        return nil;
+      }
+
+      token = [self.tokenizer pullTokenOfType:SubImapTokenTypeParenClose error:error];
+      if (*error) return nil;
+
+      break;
+    }
 
-    [data addObject:@([token.value integerValue])];
+    // Number, read without a token as there can be very many
+    unsigned long long number;
+
+    if (![self.tokenizer pullNumber:&number]) {
+      [self error:error code:0 message:@"Invalid SEARCH response number."];
+      return nil;
+    }
+
+    [data addIndex:number];
   }
 
   return [SubImapResponse responseWithType:SubImapResponseTypeSearch data:data];
 }
 
+/*
+ * RFC4731 3.1. The ESEARCH Response
+ *
+ * esearch-response   = "ESEARCH" [search-correlator] [SP "UID"]
+ *                      *(SP search-return-data)
+ * search-correlator  = SP "(" "TAG" SP tag-string ")"
+ * search-return-data = "MIN" SP nz-number / "MAX" SP nz-number /
+ *                      "ALL" SP sequence-set / "COUNT" SP number /
+ *                      search-ret-data-ext
+ */
+- (SubImapResponse *)esearchResponse:(NSError **)error {
+  SubImapToken *token;
+  NSMutableDictionary *data = [NSMutableDictionary dictionary];
+  data[@"uid"] = @NO;
+
+  // Command name
+  token = [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
+  if (*error) return nil;
+
+  while ([self.tokenizer pullTokenIsType:SubImapTokenTypeSpace]) {
+    // Correlator
+    if ([self.tokenizer pullTokenIsType:SubImapTokenTypeParenOpen]) {
+      token = [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
+      if (*error) return nil;
+
+      token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+      if (*error) return nil;
+
+      id tag = [self parseString:error];
+      if (*error) return nil;
+      data[@"tag"] = tag;
+
+      token = [self.tokenizer pullTokenOfType:SubImapTokenTypeParenClose error:error];
+      if (*error) return nil;
+
+      continue;
+    }
+
+    // Return data name
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
+    if (*error) return nil;
+
+    NSString *name = [self.tokenizer.stringTable uppercaseString:token.value];
+
+    if ([name isEqualToString:@"UID"]) {
+      data[@"uid"] = @YES;
+      continue;
+    }
+
+    // SP
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+    if (*error) return nil;
+
+    // Numbers
+    if ([@[@"MIN", @"MAX", @"COUNT"] containsObject:name]) {
+      unsigned long long number;
+
+      if (![self.tokenizer pullNumber:&number]) {
+        [self error:error code:0 format:@"Invalid ESEARCH %@ value.", name];
+        return nil;
+      }
+
+      data[[self.tokenizer.stringTable lowercaseString:name]] = @(number);
+    }
+
+    // Sequence set
+    else if ([name isEqualToString:@"ALL"]) {
+      id all = [self parseSequenceSetData:error];
+      if (*error) return nil;
+      data[@"all"] = all;
+    }
+
+    // Extensions with a simple value, such as MODSEQ
+    else {
+      token = [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
+      if (*error) return nil;
+      data[[self.tokenizer.stringTable lowercaseString:name]] = token.value;
+    }
+  }
+
+  return [SubImapResponse responseWithType:SubImapResponseTypeEsearch data:data];
+}
+
 - (SubImapResponse *)flagsResponse:(NSError **)error {
   SubImapToken *token;
 
@@ -327,6 +471,141 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
   return [SubImapResponse responseWithType:SubImapResponseTypeFlags data:flags];
 }
 
+/*
+ * RFC7162 3.2.10. VANISHED Response
+ *
+ * expunged-resp = "VANISHED" [SP "(EARLIER)"] SP known-uids
+ */
+- (SubImapResponse *)vanishedResponse:(NSError **)error {
+  SubImapToken *token;
+  NSMutableDictionary *data = [NSMutableDictionary dictionary];
+
+  // Command name
+  token = [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
+  if (*error) return nil;
+
+  // SP
+  token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+  if (*error) return nil;
+
+  // (EARLIER)
+  data[@"earlier"] = @NO;
+
+  if ([self.tokenizer pullTokenIsType:SubImapTokenTypeParenOpen]) {
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
+    if (*error) return nil;
+
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeParenClose error:error];
+    if (*error) return nil;
+
+    // SP
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+    if (*error) return nil;
+
+    data[@"earlier"] = @YES;
+  }
+
+  // UIDs
+  id UIDs = [self parseSequenceSetData:error];
+  if (*error) return nil;
+  data[@"uids"] = UIDs;
+
+  return [SubImapResponse responseWithType:SubImapResponseTypeVanished data:data];
+}
+
+/*
+ * RFC5256 4. THREAD Response
+ *
+ * thread-data = "THREAD" [SP 1*thread-list]
+ */
+- (SubImapResponse *)threadResponse:(NSError **)error {
+  SubImapToken *token;
+  NSMutableArray *data = [NSMutableArray array];
+
+  // Command name
+  token = [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
+  if (*error) return nil;
+
+  // SP
+  if ([self.tokenizer pullTokenIsType:SubImapTokenTypeSpace]) {
+    while ([self.tokenizer peekTokenIsType:SubImapTokenTypeParenOpen]) {
+      id thread = [self parseThreadListData:error];
+      if (*error) return nil;
+      [data addObject:thread];
+    }
+  }
+
+  return [SubImapResponse responseWithType:SubImapResponseTypeThread data:data];
+}
+
+/*
+ * Parses one thread into a tree of nodes.
+ *
+ * thread-list    = "(" (thread-members / thread-nested) ")"
+ * thread-members = nz-number *(SP nz-number) [SP thread-nested]
+ * thread-nested  = 2*thread-list
+ *
+ * eg: (3 6 (4 23)(44 7 96))
+ *
+ * Guaranteed to cause an error if nil is returned.
+ */
+- (id)parseThreadListData:(NSError **)error {
+  SubImapToken *token;
+
+  // (
+  token = [self.tokenizer pullTokenOfType:SubImapTokenTypeParenOpen error:error];
+  if (*error) return nil;
+
+  NSMutableDictionary *root = [NSMutableDictionary dictionary];
+  NSMutableDictionary *node = root;
+
+  // Members, each a reply to the one before it
+  unsigned long long number;
+  BOOL first = YES;
+
+  while (![self.tokenizer peekTokenIsType:SubImapTokenTypeParenOpen] && [self.tokenizer pullNumber:&number]) {
+    if (!number) {
+      [self error:error code:0 message:@"Invalid THREAD message number."];
+      return nil;
+    }
+
+    if (!first) {
+      NSMutableDictionary *child = [NSMutableDictionary dictionary];
+      node[@"children"] = @[child];
+      node = child;
+    }
+
+    node[@"id"] = @(number);
+    first = NO;
+
+    if (![self.tokenizer pullTokenIsType:SubImapTokenTypeSpace]) {
+      break;
+    }
+  }
+
+  // Nested threads, which branch from the last member
+  NSMutableArray *children = [NSMutableArray array];
+
+  while ([self.tokenizer peekTokenIsType:SubImapTokenTypeParenOpen]) {
+    id child = [self parseThreadListData:error];
+    if (*error) return nil;
+    [children addObject:child];
+  }
+
+  if (first && !children.count) {
+    [self error:error code:0 message:@"Empty THREAD list."];
+    return nil;
+  }
+
+  node[@"children"] = children;
+
+  // )
+  token = [self.tokenizer pullTokenOfType:SubImapTokenTypeParenClose error:error];
+  if (*error) return nil;
+
+  return root;
+}
+
 - (SubImapResponse *)numberResponse:(NSError **)error {
   SubImapToken *token;
 
@@ -424,7 +703,12 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
  *   "UIDNEXT" SP nz-number / "UIDVALIDITY" SP nz-number / "UNSEEN" SP nz-number /
  *   "BADCHARSET" [SP "(" astring *(SP astring) ")" ] /
  *   "PERMANENTFLAGS" SP "(" [flag-perm *(SP flag-perm)] ")" /
+ *   "NOTIFICATIONOVERFLOW" / "BADEVENT" SP "(" event *(SP event) ")" /
+ *   "APPENDUID" SP nz-number SP append-uid /
+ *   "COPYUID" SP nz-number SP uid-set SP uid-set /
  *   atom [SP 1*<any TEXT-CHAR except "]">]
+ *
+ * append-uid = uniqueid / uid-set   (RFC4315, with MULTIAPPEND)
  */
 - (id)parseTextCodeData:(NSError **)error {
   SubImapToken *token;
@@ -442,7 +726,7 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
   NSString *code = token.value;
 
   // Simple code
-  if ([@[@"ALERT", @"PARSE", @"READ-ONLY", @"READ-WRITE", @"TRYCREATE"] containsObject:code]) {
+  if ([@[@"ALERT", @"PARSE", @"READ-ONLY", @"READ-WRITE", @"TRYCREATE", @"NOTIFICATIONOVERFLOW"] containsObject:code]) {
     [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
     data[@"code"] = code;
   }
@@ -468,7 +752,7 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
     // Number
     id number = [self parseNonZeroNumber:error];
     if (*error) return nil;
-    data[[code lowercaseString]] = number;
+    data[[self.tokenizer.stringTable lowercaseString:code]] = number;
   }
 
   // Permanentflags
@@ -506,6 +790,62 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
     }
   }
 
+  // RFC5465 - Badevent
+  else if ([code isEqualToString:@"BADEVENT"]) {
+    [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
+    data[@"code"] = code;
+
+    // SP
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+    if (*error) return nil;
+
+    // Supported events
+    id events = [self parseStringListData:error];
+    if (*error) return nil;
+    if (events) {
+      data[@"events"] = events;
+    }
+  }
+
+  // RFC4315 - UIDPLUS
+  else if ([code isEqualToString:@"APPENDUID"] || [code isEqualToString:@"COPYUID"]) {
+    [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
+    data[@"code"] = code;
+
+    NSMutableDictionary *UIDs = [NSMutableDictionary dictionary];
+
+    // SP
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+    if (*error) return nil;
+
+    // Destination UID validity
+    id validity = [self parseNonZeroNumber:error];
+    if (*error) return nil;
+    UIDs[@"uidvalidity"] = validity;
+
+    // SP
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+    if (*error) return nil;
+
+    // Source UIDs
+    if ([code isEqualToString:@"COPYUID"]) {
+      id source = [self parseUIDListData:error];
+      if (*error) return nil;
+      UIDs[@"source"] = source;
+
+      // SP
+      token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+      if (*error) return nil;
+    }
+
+    // Destination UIDs
+    id destination = [self parseUIDListData:error];
+    if (*error) return nil;
+    UIDs[@"destination"] = destination;
+
+    data[[self.tokenizer.stringTable lowercaseString:code]] = UIDs;
+  }
+
   // Atom with optional parameter
   else {
     [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
@@ -517,7 +857,7 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
       token = [self.tokenizer pullTokenOfType:SubImapTokenTypeTextParam error:error];
       if (*error) return nil;
       if (token) {
-        data[[code lowercaseString]] = token.value;
+        data[[self.tokenizer.stringTable lowercaseString:code]] = token.value;
       }
     }
   }
@@ -574,27 +914,31 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
   token = [self.tokenizer pullTokenOfType:SubImapTokenTypeParenOpen error:error];
   if (*error) return nil;
 
+  // Empty list
+  if ([self.tokenizer pullTokenIsType:SubImapTokenTypeParenClose]) {
+    return data;
+  }
+
   while (1) {
-    // Attribute
+    // Attribute. Servers may send ones we did not know about, such as
+    // HIGHESTMODSEQ or SIZE, so any attribute is kept.
     token = [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
     if (*error) return nil;
 
     NSString *attribute = token.value;
 
-    if (![@[@"MESSAGES", @"RECENT", @"UIDNEXT", @"UIDVALIDITY", @"UNSEEN"] containsObject:attribute]) {
-      [self error:error code:0 format:@"Unknown status attribute '%@'.", attribute];
-      return nil;
-    }
-
     // SP
     token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
     if (*error) return nil;
 
-    // Number
-    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeNumber error:error];
-    if (*error) return nil;
+    // Number, which may be 64-bit for HIGHESTMODSEQ
+    unsigned long long value;
+    if (![self.tokenizer pullNumber:&value]) {
+      [self error:error code:0 format:@"Missing value for status attribute '%@'.", attribute];
+      return nil;
+    }
 
-    data[[attribute lowercaseString]] = @([token.value integerValue]);
+    data[[self.tokenizer.stringTable lowercaseString:attribute]] = @(value);
 
     // )
     if ([self.tokenizer peekTokenIsType:SubImapTokenTypeParenClose]) {
@@ -613,6 +957,81 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
   return data;
 }
 
+/*
+ * Parses LIST-EXTENDED items into a dictionary, keyed by the uppercased
+ * item tag. Values are parsed generically by parseExtendedValueData:.
+ *
+ * Guaranteed to cause an error if nil is returned.
+ *
+ * eg: ("CHILDINFO" ("SUBSCRIBED") "OLDNAME" ("Old"))
+ */
+- (id)parseExtendedItemListData:(NSError **)error {
+  SubImapToken *token;
+  NSMutableDictionary *data = [NSMutableDictionary dictionary];
+
+  // (
+  token = [self.tokenizer pullTokenOfType:SubImapTokenTypeParenOpen error:error];
+  if (*error) return nil;
+
+  if ([self.tokenizer pullTokenIsType:SubImapTokenTypeParenClose]) {
+    return data;
+  }
+
+  do {
+    // Tag
+    id tag = [self parseAString:error];
+    if (*error) return nil;
+
+    // SP
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+    if (*error) return nil;
+
+    // Value
+    id value = [self parseExtendedValueData:error];
+    if (*error) return nil;
+
+    data[[tag uppercaseString]] = value;
+  } while ([self.tokenizer pullTokenIsType:SubImapTokenTypeSpace]);
+
+  // )
+  token = [self.tokenizer pullTokenOfType:SubImapTokenTypeParenClose error:error];
+  if (*error) return nil;
+
+  return data;
+}
+
+/*
+ * Parses an extension value: a string, a number or a parenthesized list
+ * of values, returned as an array.
+ *
+ * Guaranteed to cause an error if nil is returned.
+ */
+- (id)parseExtendedValueData:(NSError **)error {
+  SubImapToken *token;
+
+  if (![self.tokenizer pullTokenIsType:SubImapTokenTypeParenOpen]) {
+    return [self parseAString:error];
+  }
+
+  NSMutableArray *values = [NSMutableArray array];
+
+  if ([self.tokenizer pullTokenIsType:SubImapTokenTypeParenClose]) {
+    return values;
+  }
+
+  do {
+    id value = [self parseExtendedValueData:error];
+    if (*error) return nil;
+    [values addObject:value];
+  } while ([self.tokenizer pullTokenIsType:SubImapTokenTypeSpace]);
+
+  // )
+  token = [self.tokenizer pullTokenOfType:SubImapTokenTypeParenClose error:error];
+  if (*error) return nil;
+
+  return values;
+}
+
 /*
  * Parses a list of flags. May return an empy array.
  *
@@ -718,6 +1137,8 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
  *   "RFC822.SIZE" SP number /
  *   "BODY" ["STRUCTURE"] SP body /
  *   "BODY" section ["<" number ">"] SP nstring /
+ *   "BINARY" section-binary ["<" number ">"] SP (nstring / literal8) /
+ *   "BINARY.SIZE" section-binary SP number /
  *   "UID" SP uniqueid
  */
 - (id)parseMessageAttributeData:(NSError **)error {
@@ -742,6 +1163,9 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
 //    @"BODY",
 //    @"BODY.PEEK",
 //    @"BODYSTRUCTURE",
+//    @"BINARY",
+//    @"BINARY.PEEK",
+//    @"BINARY.SIZE",
     @"X-GM-MSGID",
     @"X-GM-THRID",
     @"X-GM-LABELS",
@@ -752,7 +1176,7 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
     token = [self.tokenizer pullTokenOfType:SubImapTokenTypeMessageAttribute error:error];
     if (*error) return nil;
 
-    NSString *attribute = [token.value uppercaseString];
+    NSString *attribute = [self.tokenizer.stringTable uppercaseString:token.value];
 
     // SP
     if ([attributes containsObject:attribute]) {
@@ -799,7 +1223,7 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
     else if ([@[@"RFC822", @"RFC822.HEADER", @"RFC822.TEXT"] containsObject:attribute]) {
       id rfc = [self parseNString:error];
       if (*error) return nil;
-      data[[attribute lowercaseString]] = rfc;
+      data[[self.tokenizer.stringTable lowercaseString:attribute]] = rfc;
     }
 
     // BODY
@@ -807,6 +1231,39 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
       id body = [self parseMessageBodyData:error];
       if (*error) return nil;
       data[@"body"] = body;
+
+      // A response may hold several sections, keyed by their spec
+      if (body[@"section"]) {
+        if (!data[@"sections"]) data[@"sections"] = [NSMutableDictionary dictionary];
+        data[@"sections"][body[@"section"]] = body;
+      } else {
+        data[@"bodystructure"] = body;
+      }
+    }
+
+    // BINARY -- RFC3516, decoded content of a part
+    else if ([@[@"BINARY", @"BINARY.PEEK"] containsObject:attribute]) {
+      id binary = [self parseMessageBinarySectionData:error];
+      if (*error) return nil;
+
+      if (!data[@"binary"]) data[@"binary"] = [NSMutableDictionary dictionary];
+      data[@"binary"][binary[@"part"]] = binary;
+    }
+
+    // BINARY.SIZE -- RFC3516, decoded size of a part
+    else if ([attribute isEqualToString:@"BINARY.SIZE"]) {
+      id part = [self parseMessageBinarySectionPartData:error];
+      if (*error) return nil;
+
+      // SP
+      token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+      if (*error) return nil;
+
+      token = [self.tokenizer pullTokenOfType:SubImapTokenTypeNumber error:error];
+      if (*error) return nil;
+
+      if (!data[@"binary.size"]) data[@"binary.size"] = [NSMutableDictionary dictionary];
+      data[@"binary.size"][part] = @([token.value longLongValue]);
     }
 
     // X-GM-MSGID -- Gimap extension
@@ -871,6 +1328,72 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
   return number;
 }
 
+/*
+ * Parses a set of numbers, which can not include "*".
+ *
+ * sequence-set = (seq-number / seq-range) ["," sequence-set]
+ * seq-range    = seq-number ":" seq-number
+ *
+ * Guaranteed to cause an error if nil is returned.
+ */
+- (id)parseSequenceSetData:(NSError **)error {
+  NSMutableIndexSet *set = [NSMutableIndexSet indexSet];
+
+  do {
+    unsigned long long first = 0;
+    unsigned long long last = 0;
+
+    if (![self.tokenizer pullNumber:&first] || !first) {
+      [self error:error code:0 message:@"Invalid sequence set."];
+      return nil;
+    }
+
+    last = first;
+
+    if ([self.tokenizer pullCharacterIs:':'] && (![self.tokenizer pullNumber:&last] || !last)) {
+      [self error:error code:0 message:@"Invalid sequence set range."];
+      return nil;
+    }
+
+    [set addIndexesInRange:NSMakeRange(MIN(first, last), (first > last ? first - last : last - first) + 1)];
+  } while ([self.tokenizer pullCharacterIs:',']);
+
+  return set;
+}
+
+/*
+ * A uid-set as an NSArray of UIDs in the order written, with each range
+ * expanded in its own direction, eg: 5,3:2 is 5, 3, 2. COPYUID pairs its
+ * source and destination UIDs in that order, RFC4315.
+ */
+- (id)parseUIDListData:(NSError **)error {
+  NSMutableArray *UIDs = [NSMutableArray array];
+
+  do {
+    unsigned long long first = 0;
+    unsigned long long last = 0;
+
+    if (![self.tokenizer pullNumber:&first] || !first) {
+      [self error:error code:0 message:@"Invalid UID set."];
+      return nil;
+    }
+
+    last = first;
+
+    if ([self.tokenizer pullCharacterIs:':'] && (![self.tokenizer pullNumber:&last] || !last)) {
+      [self error:error code:0 message:@"Invalid UID set range."];
+      return nil;
+    }
+
+    for (unsigned long long UID = first; ; UID = first < last ? UID + 1 : UID - 1) {
+      [UIDs addObject:@(UID)];
+      if (UID == last) break;
+    }
+  } while ([self.tokenizer pullCharacterIs:',']);
+
+  return UIDs;
+}
+
 /*
  * Parse a string or NIL.
  *
@@ -985,7 +1508,7 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
   // env-subject
   id subject = [self parseNString:error];
   if (*error) return nil;
-  data[@"subject"] = subject;
+  data[@"subject"] = [SubImapTransferDecoder stringByDecodingEncodedWords:subject];
 
   // SP
   token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
@@ -1097,9 +1620,9 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
       break;
     }
 
-    // SP
-    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
-    if (*error) return nil;
+    // SP -- Optional. RFC3501 puts nothing between addresses, but some
+    // servers separate them with a space
+    [self.tokenizer pullTokenIsType:SubImapTokenTypeSpace];
   }
 
   // )
@@ -1144,7 +1667,7 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
   // Address name
   id name = [self parseNString:error];
   if (*error) return nil;
-  address[@"name"] = name;
+  address[@"name"] = [SubImapTransferDecoder stringByDecodingEncodedWords:name];
 
   // SP
   token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
@@ -1238,15 +1761,25 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
   if (*error) return nil;
 
   // Section spec
-  NSString *spec = [self parseMessageBodySectionSpecData:error];
+  NSDictionary *spec = [self parseMessageBodySectionSpecData:error];
   if (*error) return nil;
-  data[@"section"] = spec;
+  [data addEntriesFromDictionary:spec];
 
   // ]
   token = [self.tokenizer pullTokenOfType:SubImapTokenTypeBracketClose error:error];
   if (*error) return nil;
 
-  // TODO: Section bytes
+  // Partial origin, eg: <0>
+  if ([self.tokenizer pullCharacterIs:'<']) {
+    unsigned long long origin;
+
+    if (![self.tokenizer pullNumber:&origin] || ![self.tokenizer pullCharacterIs:'>']) {
+      [self error:error code:0 message:@"Invalid partial origin in body section."];
+      return nil;
+    }
+
+    data[@"origin"] = @(origin);
+  }
 
   // SP
   token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
@@ -1257,21 +1790,164 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
   if (*error) return nil;
   data[@"data"] = nstring;
 
+  // Header sections are also parsed into fields, eg: headers[@"subject"]
+  if ([data[@"text"] hasPrefix:@"HEADER"]) {
+    data[@"headers"] = [SubImapHeaderParser headersFromString:nstring];
+  }
+
   return data;
 }
 
-// TODO: proper section specs
+/*
+ * Parses a section-spec into a dictionary:
+ *
+ *   "section": (NSString *) the normalized spec, eg: "2.1.HEADER.FIELDS (FROM TO)"
+ *   "part": (NSString *) the part number, eg: "2.1", or "" for the message
+ *   "text": (NSString *) HEADER, HEADER.FIELDS, HEADER.FIELDS.NOT, TEXT or MIME, or ""
+ *   "fields": (NSArray *) the header-list, for HEADER.FIELDS
+ *
+ * Guaranteed to cause an error if nil is returned.
+ */
 - (id)parseMessageBodySectionSpecData:(NSError **)error {
+  SubImapToken *token;
+  NSMutableDictionary *data = [NSMutableDictionary dictionary];
+  NSMutableArray *part = [NSMutableArray array];
+  NSString *text = @"";
+
   // ]
   if ([self.tokenizer peekTokenIsType:SubImapTokenTypeBracketClose]) {
-    return @"";
+    data[@"section"] = @"";
+    data[@"part"] = @"";
+    data[@"text"] = @"";
+    return data;
   }
 
-  // Atom
-  SubImapToken *token;
+  // section-part, and section-text, as one atom, eg: 2.1.HEADER
   token = [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
   if (*error) return nil;
-  return token.value;
+
+  NSArray *components = [token.value componentsSeparatedByString:@"."];
+  NSUInteger index = 0;
+
+  for (; index < components.count; index++) {
+    NSInteger number = [components[index] integerValue];
+
+    if (number <= 0 || ![[@(number) stringValue] isEqualToString:components[index]]) {
+      break;
+    }
+
+    [part addObject:components[index]];
+  }
+
+  if (index < components.count) {
+    text = [[[components subarrayWithRange:NSMakeRange(index, components.count - index)] componentsJoinedByString:@"."] uppercaseString];
+  }
+
+  if (![@[@"", @"HEADER", @"HEADER.FIELDS", @"HEADER.FIELDS.NOT", @"TEXT", @"MIME"] containsObject:text] || ([text isEqualToString:@"MIME"] && !part.count)) {
+    [self error:error code:0 format:@"Invalid body section '%@'.", token.value];
+    return nil;
+  }
+
+  data[@"part"] = [part componentsJoinedByString:@"."];
+  data[@"text"] = text;
+
+  NSMutableString *section = [NSMutableString stringWithString:data[@"part"]];
+
+  if (part.count && text.length) {
+    [section appendString:@"."];
+  }
+
+  [section appendString:text];
+
+  // SP header-list
+  if ([text hasPrefix:@"HEADER.FIELDS"]) {
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+    if (*error) return nil;
+
+    NSArray *fields = [self parseStringListData:error];
+    if (*error) return nil;
+
+    data[@"fields"] = fields;
+    [section appendFormat:@" (%@)", [[fields componentsJoinedByString:@" "] uppercaseString]];
+  }
+
+  data[@"section"] = section;
+
+  return data;
+}
+
+/*
+ * Parses BINARY[] message attributes into a dictionary of "part", the
+ * partial "origin" if any, and "data", which is always NSData.
+ *
+ * i.e. "BINARY" section-binary ["<" number ">"] SP (nstring / literal8)
+ *
+ * section-binary  = "[" [section-part] "]"
+ */
+- (id)parseMessageBinarySectionData:(NSError **)error {
+  SubImapToken *token;
+  NSMutableDictionary *data = [NSMutableDictionary dictionary];
+
+  id part = [self parseMessageBinarySectionPartData:error];
+  if (*error) return nil;
+  data[@"part"] = part;
+
+  // Partial origin, eg: <0>
+  if ([self.tokenizer pullCharacterIs:'<']) {
+    unsigned long long origin;
+
+    if (![self.tokenizer pullNumber:&origin] || ![self.tokenizer pullCharacterIs:'>']) {
+      [self error:error code:0 message:@"Invalid partial origin in binary section."];
+      return nil;
+    }
+
+    data[@"origin"] = @(origin);
+  }
+
+  // SP
+  token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+  if (*error) return nil;
+
+  // Data, which is a literal8 unless it is NIL or plain text. A plain
+  // literal can still hold 8-bit bytes, so it isn't decoded either
+  self.tokenizer.literalsAsData = YES;
+  id value = [self parseNString:error];
+  self.tokenizer.literalsAsData = NO;
+  if (*error) return nil;
+
+  if ([value isKindOfClass:[NSString class]]) {
+    value = [value dataUsingEncoding:NSUTF8StringEncoding];
+  }
+
+  data[@"data"] = value;
+
+  return data;
+}
+
+/*
+ * section-binary  = "[" [section-part] "]"
+ *
+ * Returns the part number, eg: "1.2", or "" for the whole message.
+ */
+- (id)parseMessageBinarySectionPartData:(NSError **)error {
+  SubImapToken *token;
+  NSString *part = @"";
+
+  // [
+  token = [self.tokenizer pullTokenOfType:SubImapTokenTypeBracketOpen error:error];
+  if (*error) return nil;
+
+  if (![self.tokenizer peekTokenIsType:SubImapTokenTypeBracketClose]) {
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeAtom error:error];
+    if (*error) return nil;
+    part = token.value;
+  }
+
+  // ]
+  token = [self.tokenizer pullTokenOfType:SubImapTokenTypeBracketClose error:error];
+  if (*error) return nil;
+
+  return part;
 }
 
 /*
@@ -1367,10 +2043,25 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
     while (1) {
       // SP
       if ([self.tokenizer pullTokenIsType:SubImapTokenTypeSpace]) {
+        // Some servers separate parts with a space
+        if ([self.tokenizer peekTokenIsType:SubImapTokenTypeParenOpen]) {
+          continue;
+        }
+
         // Media sub-type
         id subtype = [self parseString:error];
         if (*error) return nil;
-        data[@"subtype"] = [subtype uppercaseString];
+        data[@"subtype"] = [self.tokenizer.stringTable uppercaseString:subtype];
+
+        // body-ext-mpart, starting with body-fld-param
+        if ([self.tokenizer pullTokenIsType:SubImapTokenTypeSpace]) {
+          id params = [self parseMessageBodyFieldsParamData:error];
+          if (*error) return nil;
+          data[@"params"] = params;
+
+          [self parseMessageBodyExtensionData:data error:error];
+          if (*error) return nil;
+        }
 
         break;
       }
@@ -1403,7 +2094,7 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
   // Media type
   id type = [self parseString:error];
   if (*error) return nil;
-  data[@"type"] = [type uppercaseString];
+  data[@"type"] = [self.tokenizer.stringTable uppercaseString:type];
 
   // SP
   token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
@@ -1412,7 +2103,7 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
   // Media sub-type
   id subtype = [self parseString:error];
   if (*error) return nil;
-  data[@"subtype"] = [subtype uppercaseString];
+  data[@"subtype"] = [self.tokenizer.stringTable uppercaseString:subtype];
 
   // SP
   token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
@@ -1427,7 +2118,32 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
 
   // Detect: MSG-MESSAGE
   if ([data[@"type"] isEqualToString:@"MESSAGE"] && [data[@"subtype"] isEqualToString:@"RFC822"]) {
-    // TODO: Message sub-parts
+    // SP
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+    if (*error) return nil;
+
+    // Envelope
+    id envelope = [self parseMessageEnvelopeData:error];
+    if (*error) return nil;
+    data[@"envelope"] = envelope;
+
+    // SP
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+    if (*error) return nil;
+
+    // Body of the attached message
+    id body = [self parseMessageBodyStructureData:error];
+    if (*error) return nil;
+    data[@"message"] = body;
+
+    // SP
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+    if (*error) return nil;
+
+    // * body-fld-lines  = number
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeNumber error:error];
+    if (*error) return nil;
+    data[@"lines"] = @([token.value integerValue]);
   }
 
   // Detect: MSG-TEXT
@@ -1442,14 +2158,116 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
     data[@"lines"] = @([token.value integerValue]);
   }
 
-  // Detect: MSG-BASIC
-  else {
-    // TODO: basic sub-parts
+  // MSG-BASIC has nothing after its body fields
+
+  // body-ext-1part, starting with body-fld-md5
+  if ([self.tokenizer pullTokenIsType:SubImapTokenTypeSpace]) {
+    id md5 = [self parseNString:error];
+    if (*error) return nil;
+    data[@"md5"] = md5;
+
+    [self parseMessageBodyExtensionData:data error:error];
+    if (*error) return nil;
   }
 
   return data;
 }
 
+/*
+ * Parses the extension fields shared by single and multipart bodies,
+ * after their first field, into the part's dictionary.
+ *
+ *   [SP body-fld-dsp [SP body-fld-lang [SP body-fld-loc *(SP body-extension)]]]
+ *
+ * body-fld-dsp is added as "disposition", with "type" and "params".
+ * body-fld-lang is added as "language", an array. body-fld-loc is added
+ * as "location". Any further body-extension values are skipped.
+ */
+- (void)parseMessageBodyExtensionData:(NSMutableDictionary *)data error:(NSError **)error {
+  SubImapToken *token;
+
+  // SP body-fld-dsp
+  if (![self.tokenizer pullTokenIsType:SubImapTokenTypeSpace]) return;
+
+  if (![self.tokenizer pullTokenIsType:SubImapTokenTypeNil]) {
+    // (
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeParenOpen error:error];
+    if (*error) return;
+
+    id type = [self parseString:error];
+    if (*error) return;
+
+    // SP
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
+    if (*error) return;
+
+    id params = [self parseMessageBodyFieldsParamData:error];
+    if (*error) return;
+
+    // )
+    token = [self.tokenizer pullTokenOfType:SubImapTokenTypeParenClose error:error];
+    if (*error) return;
+
+    data[@"disposition"] = @{@"type": [self.tokenizer.stringTable uppercaseString:type], @"params": params};
+  }
+
+  // SP body-fld-lang
+  if (![self.tokenizer pullTokenIsType:SubImapTokenTypeSpace]) return;
+
+  if ([self.tokenizer peekTokenIsType:SubImapTokenTypeParenOpen]) {
+    id languages = [self parseStringListData:error];
+    if (*error) return;
+    data[@"language"] = languages;
+  } else {
+    id language = [self parseNString:error];
+    if (*error) return;
+    if ([language length]) data[@"language"] = @[language];
+  }
+
+  // SP body-fld-loc
+  if (![self.tokenizer pullTokenIsType:SubImapTokenTypeSpace]) return;
+
+  id location = [self parseNString:error];
+  if (*error) return;
+  if ([location length]) data[@"location"] = location;
+
+  // *(SP body-extension)
+  while ([self.tokenizer pullTokenIsType:SubImapTokenTypeSpace]) {
+    [self parseMessageBodyExtensionValueData:error];
+    if (*error) return;
+  }
+}
+
+/*
+ * body-extension  = nstring / number / "(" body-extension *(SP body-extension) ")"
+ */
+- (id)parseMessageBodyExtensionValueData:(NSError **)error {
+  SubImapToken *token;
+
+  // Number
+  token = [self.tokenizer pullTokenOfType:SubImapTokenTypeNumber error:nil];
+  if (token) return @([token.value longLongValue]);
+
+  // nstring
+  if (![self.tokenizer pullTokenIsType:SubImapTokenTypeParenOpen]) {
+    return [self parseNString:error];
+  }
+
+  NSMutableArray *values = [NSMutableArray array];
+
+  do {
+    id value = [self parseMessageBodyExtensionValueData:error];
+    if (*error) return nil;
+    [values addObject:value];
+  } while ([self.tokenizer pullTokenIsType:SubImapTokenTypeSpace]);
+
+  // )
+  token = [self.tokenizer pullTokenOfType:SubImapTokenTypeParenClose error:error];
+  if (*error) return nil;
+
+  return values;
+}
+
 /*
  * body-fields     =
  *   body-fld-param SP body-fld-id SP body-fld-desc SP body-fld-enc SP body-fld-octets
@@ -1499,7 +2317,7 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
   // fld-enc
   id encoding = [self parseString:error];
   if (*error) return nil;
-  data[@"encoding"] = [encoding uppercaseString];
+  data[@"encoding"] = [self.tokenizer.stringTable uppercaseString:encoding];
 
   // SP
   token = [self.tokenizer pullTokenOfType:SubImapTokenTypeSpace error:error];
@@ -1542,7 +2360,7 @@ NSString *const SubImapParserErrorDomain = @"Parser.SubMail.sublink.ca";
     id s2 = [self parseString:error];
     if (*error) return nil;
 
-    data[[s1 lowercaseString]] = s2;
+    data[[self.tokenizer.stringTable lowercaseString:s1]] = s2;
 
     // )
     if ([self.tokenizer peekTokenIsType:SubImapTokenTypeParenClose]) {
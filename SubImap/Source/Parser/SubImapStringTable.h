@@ -0,0 +1,61 @@
+// SubImapStringTable.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/*
+ * SubImapStringTable
+ *
+ * Returns one shared NSString for each short ASCII byte sequence, so the
+ * flags, atoms, mailbox names and MIME types repeated in every response
+ * don't each allocate a new string, and strings kept from responses, eg:
+ * in a mailbox state, are stored once.
+ *
+ * The table has a fixed number of slots, picked by a hash of the bytes.
+ * A new string replaces the one in its slot, so memory stays bounded
+ * however many distinct strings go through it.
+ *
+ * A table is not thread safe. Tokenizers use the one for their thread,
+ * shared by every connection on an event loop.
+ */
+@interface SubImapStringTable : NSObject
+
++ (instancetype)tableForCurrentThread;
+
+/*
+ * The capacity is rounded up to a power of two.
+ */
++ (instancetype)tableWithCapacity:(NSUInteger)capacity;
+
+/*
+ * Returns nil if the bytes are not ASCII. Strings longer than 32 bytes
+ * are not shared.
+ */
+- (NSString *)stringWithBytes:(const char *)bytes length:(NSUInteger)length;
+
+/*
+ * Shared ASCII case conversions, for keys such as @"uid" and values such
+ * as @"TEXT".
+ */
+- (NSString *)uppercaseString:(NSString *)string;
+- (NSString *)lowercaseString:(NSString *)string;
+
+@end
\ No newline at end of file
@@ -0,0 +1,170 @@
+// SubImapStringTable.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapStringTable.h"
+
+#import <pthread.h>
+
+#define SubImapStringTableMaxLength 32
+#define SubImapStringTableDefaultCapacity 1024
+
+typedef struct {
+  uint32_t hash;
+  uint32_t length;
+  char bytes[SubImapStringTableMaxLength];
+  void *string;         // Retained NSString, NULL for an empty slot
+} SubImapStringTableSlot;
+
+static pthread_key_t SubImapStringTableKey;
+
+static void SubImapStringTableRelease(void *table) {
+  CFBridgingRelease(table);
+}
+
+// FNV-1a
+static uint32_t SubImapStringTableHash(const char *bytes, NSUInteger length) {
+  uint32_t hash = 2166136261u;
+
+  for (NSUInteger i = 0; i < length; i++) {
+    hash ^= (uint8_t)bytes[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+@implementation SubImapStringTable {
+  SubImapStringTableSlot *_slots;
+  NSUInteger _mask;
+}
+
++ (instancetype)tableForCurrentThread {
+  static dispatch_once_t onceToken;
+
+  dispatch_once(&onceToken, ^{
+    pthread_key_create(&SubImapStringTableKey, SubImapStringTableRelease);
+  });
+
+  void *table = pthread_getspecific(SubImapStringTableKey);
+
+  if (!table) {
+    table = (void *)CFBridgingRetain([self tableWithCapacity:SubImapStringTableDefaultCapacity]);
+    pthread_setspecific(SubImapStringTableKey, table);
+  }
+
+  return (__bridge SubImapStringTable *)table;
+}
+
++ (instancetype)tableWithCapacity:(NSUInteger)capacity {
+  return [[self alloc] initWithCapacity:capacity];
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity {
+  self = [super init];
+
+  if (self) {
+    NSUInteger size = 1;
+
+    while (size < capacity) {
+      size <<= 1;
+    }
+
+    _slots = calloc(size, sizeof(SubImapStringTableSlot));
+    _mask = size - 1;
+  }
+
+  return self;
+}
+
+- (void)dealloc {
+  for (NSUInteger i = 0; i <= _mask; i++) {
+    if (_slots[i].string) {
+      CFRelease(_slots[i].string);
+    }
+  }
+
+  free(_slots);
+}
+
+- (NSString *)stringWithBytes:(const char *)bytes length:(NSUInteger)length {
+  if (length > SubImapStringTableMaxLength) {
+    return [[NSString alloc] initWithBytes:bytes length:length encoding:NSASCIIStringEncoding];
+  }
+
+  uint32_t hash = SubImapStringTableHash(bytes, length);
+  SubImapStringTableSlot *slot = &_slots[hash & _mask];
+
+  if (slot->string && slot->hash == hash && slot->length == length && memcmp(slot->bytes, bytes, length) == 0) {
+    return (__bridge NSString *)slot->string;
+  }
+
+  NSString *string = [[NSString alloc] initWithBytes:bytes length:length encoding:NSASCIIStringEncoding];
+
+  if (!string) {
+    return nil;
+  }
+
+  if (slot->string) {
+    CFRelease(slot->string);
+  }
+
+  slot->hash = hash;
+  slot->length = (uint32_t)length;
+  memcpy(slot->bytes, bytes, length);
+  slot->string = (void *)CFBridgingRetain(string);
+
+  return string;
+}
+
+- (NSString *)uppercaseString:(NSString *)string {
+  return [self string:string upper:YES];
+}
+
+- (NSString *)lowercaseString:(NSString *)string {
+  return [self string:string upper:NO];
+}
+
+- (NSString *)string:(NSString *)string upper:(BOOL)upper {
+  char bytes[SubImapStringTableMaxLength];
+  NSUInteger length = string.length;
+  NSUInteger used;
+
+  BOOL ascii = length <= SubImapStringTableMaxLength &&
+    [string getBytes:bytes maxLength:sizeof(bytes) usedLength:&used encoding:NSASCIIStringEncoding options:0 range:NSMakeRange(0, length) remainingRange:NULL];
+
+  if (!ascii) {
+    return upper ? [string uppercaseString] : [string lowercaseString];
+  }
+
+  for (NSUInteger i = 0; i < used; i++) {
+    if (upper && bytes[i] >= 'a' && bytes[i] <= 'z') {
+      bytes[i] -= 'a' - 'A';
+    } else if (!upper && bytes[i] >= 'A' && bytes[i] <= 'Z') {
+      bytes[i] += 'a' - 'A';
+    }
+  }
+
+  return [self stringWithBytes:bytes length:used];
+}
+
+@end
\ No newline at end of file
@@ -22,6 +22,7 @@
 // THE SOFTWARE.
 
 #import "SubImapToken.h"
+#import "SubImapStringTable.h"
 
 typedef enum {
   SubImapTokenizerErrorUnexpectedToken,
@@ -36,9 +37,31 @@ typedef enum {
 
 - (void)setData:(NSData *)data;
 
+/*
+ * Atoms, flags, message attributes and short strings come from this
+ * table, shared with the parser. It is the current thread's, set with
+ * the data.
+ */
+@property (readonly) SubImapStringTable *stringTable;
+
+/*
+ * While YES, a literal's value is its bytes as NSData, like a literal8's,
+ * instead of a string. For BINARY sections, which RFC3516 lets a server
+ * send as a plain literal when the part has no NUL.
+ */
+@property BOOL literalsAsData;
+
 - (SubImapToken *)peekTokenOfType:(SubImapTokenType)type error:(NSError **)error;
 - (SubImapToken *)pullTokenOfType:(SubImapTokenType)type error:(NSError **)error;
 - (BOOL)peekTokenIsType:(SubImapTokenType)type;
 - (BOOL)pullTokenIsType:(SubImapTokenType)type;
 
+/*
+ * Reads a number, or a single character, without creating a token, for
+ * long lists such as search results. Both return NO, and don't move, if
+ * what is next doesn't match.
+ */
+- (BOOL)pullNumber:(unsigned long long *)number;
+- (BOOL)pullCharacterIs:(char)character;
+
 @end
\ No newline at end of file
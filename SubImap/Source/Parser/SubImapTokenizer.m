@@ -51,6 +51,7 @@
 - (void)setData:(NSData *)data {
   _data = data;
   _position = 0;
+  _stringTable = [SubImapStringTable tableForCurrentThread];
 }
 
 - (SubImapToken *)peekTokenOfType:(SubImapTokenType)type error:(NSError **)error {
@@ -85,6 +86,35 @@
   return [self pullTokenOfType:type error:nil] != nil;
 }
 
+- (BOOL)pullNumber:(unsigned long long *)number {
+  const char *data = (const char *)[_data bytes];
+  NSUInteger length = [_data length];
+  NSUInteger position = _position;
+  unsigned long long value = 0;
+
+  while (position < length && [self isDigit:data[position]]) {
+    value = value * 10 + (data[position] - '0');
+    position++;
+  }
+
+  if (position == _position) {
+    return NO;
+  }
+
+  _position = position;
+  *number = value;
+  return YES;
+}
+
+- (BOOL)pullCharacterIs:(char)character {
+  if ([self isAtEnd] || [self peekCharacter] != character) {
+    return NO;
+  }
+
+  _position++;
+  return YES;
+}
+
 #pragma mark -
 #pragma mark Main Tokenizer
 
@@ -262,8 +292,17 @@
   }
 
   if (pos != _position) {
-    NSData *data = [_data subdataWithRange:NSMakeRange(pos, _position - pos)];
-    NSString *value = [[NSString alloc] initWithData:data encoding:NSASCIIStringEncoding];
+    const char *bytes = (const char *)_data.bytes + pos;
+    NSString *value;
+
+    // Tags, numbers and response text rarely repeat, so sharing them would
+    // only evict strings that do
+    if (type == SubImapTokenTypeNumber || type == SubImapTokenTypeTag || type == SubImapTokenTypeText) {
+      value = [[NSString alloc] initWithBytes:bytes length:_position - pos encoding:NSASCIIStringEncoding];
+    } else {
+      value = [_stringTable stringWithBytes:bytes length:_position - pos];
+    }
+
     return [SubImapToken token:type value:value position:pos];
   } else {
     _position = pos;
@@ -355,7 +394,7 @@
 
 - (SubImapToken *)flagToken {
   NSInteger pos = _position;
-  NSData *value;
+  BOOL found = NO;
 
   // Check bounds
   if (![self hasSpace:2]) {
@@ -372,7 +411,7 @@
 
     if (star == '*') {
       _position++;
-      value = [_data subdataWithRange:NSMakeRange(pos, _position - pos)];
+      found = YES;
     }
 
     // \atom
@@ -380,20 +419,20 @@
       [self scan:^BOOL(char character) {
         return [self isAtomCharacter:character];
       }];
-      value = [_data subdataWithRange:NSMakeRange(pos, _position - pos)];
+      found = YES;
     }
   }
 
   // Flag Keyword
   else {
-    value = [self scan:^BOOL(char character) {
+    found = [self scan:^BOOL(char character) {
       return [self isAtomCharacter:character];
-    }];
+    }] != nil;
   }
 
-  if (value) {
-    NSString *s = [[NSString alloc] initWithData:value encoding:NSASCIIStringEncoding];
-    return [SubImapToken token:SubImapTokenTypeFlag value:s position:pos];
+  if (found) {
+    NSString *value = [_stringTable stringWithBytes:(const char *)_data.bytes + pos length:_position - pos];
+    return [SubImapToken token:SubImapTokenTypeFlag value:value position:pos];
   } else {
     _position = pos;
     return nil;
@@ -471,13 +510,24 @@
     return nil;
   }
 
-  NSString *value = [[NSString alloc] initWithData:data encoding:NSASCIIStringEncoding];
+  NSString *value = [_stringTable stringWithBytes:data.bytes length:data.length];
   return [SubImapToken token:SubImapTokenTypeQuotedString value:value position:pos];
 }
 
+/*
+ * literal         = "{" number "}" CRLF *CHAR8
+ * literal8        = "~{" number "}" CRLF *OCTET
+ *
+ * A literal8 (RFC3516) may hold any bytes, so its value is left as
+ * NSData rather than decoded into a string, as is any literal's while
+ * literalsAsData is set.
+ */
 - (SubImapToken *)literalToken {
   NSInteger pos = _position;
 
+  // ~
+  BOOL binary = [self pullCharacterIs:'~'];
+
   // {
   if ([self pullCharacter] != '{') {
     _position = pos;
@@ -514,7 +564,7 @@
   }
 
   // Ensure we have enough bytes to read
-  if ([_data length] + _position < bytes) {
+  if ([_data length] - _position < (NSUInteger)bytes) {
     _position = pos;
     return nil;
   }
@@ -523,6 +573,10 @@
   NSData *literal = [_data subdataWithRange:NSMakeRange(_position, bytes)];
   _position += bytes;
 
+  if (binary || self.literalsAsData) {
+    return [SubImapToken token:SubImapTokenTypeLiteral value:literal position:pos];
+  }
+
   // Read bytes into string
   NSString *value = [[NSString alloc] initWithData:literal encoding:NSUTF8StringEncoding];
 
@@ -0,0 +1,80 @@
+// SubImapTransferDecoder.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/*
+ * SubImapTransferDecoder
+ *
+ * Decodes a MIME content transfer encoding, RFC2045: BASE64 or
+ * QUOTED-PRINTABLE. Any other encoding, such as 7BIT, 8BIT or BINARY, is
+ * passed through unchanged.
+ *
+ * Data can be given in chunks of any size, such as the ranges of a part
+ * fetched with SubImapFetchCommand fieldForSection:range:. A base64
+ * group or escape split between two chunks is carried over to the next.
+ * Line breaks in base64 are skipped, and decoding stops at its padding.
+ *
+ * Base64 is decoded 16 characters at a time with SSSE3 on x86 CPUs that
+ * have it, checked at run time, and unescaped quoted-printable text is
+ * copied 16 bytes at a time with SSE2 where the build targets it.
+ */
+@interface SubImapTransferDecoder : NSObject
+
+/*
+ * The encoding is a body-fld-enc from BODYSTRUCTURE, eg: @"BASE64".
+ */
++ (instancetype)decoderWithEncoding:(NSString *)encoding;
+
+/*
+ * Decodes complete data at once.
+ */
++ (NSData *)decodeData:(NSData *)data encoding:(NSString *)encoding;
+
+/*
+ * RFC2047 - Decodes encoded words, such as =?UTF-8?Q?caf=C3=A9?=, in an
+ * envelope subject or address name. Whitespace between two encoded words
+ * is removed. Malformed words are left as they are.
+ */
++ (NSString *)stringByDecodingEncodedWords:(NSString *)string;
+
+/*
+ * Text from a decoded part in its body-fld-param charset, eg: @"utf-8".
+ * Bytes that are not valid in the charset are read as ISO-8859-1.
+ */
++ (NSString *)stringWithData:(NSData *)data charset:(NSString *)charset;
+
+@property (readonly) NSString *encoding;
+
+/*
+ * Decodes the next chunk, appending the result to output.
+ */
+- (void)decodeBytes:(const void *)bytes length:(NSUInteger)length intoData:(NSMutableData *)output;
+- (NSData *)decodeData:(NSData *)data;
+
+/*
+ * Decodes anything left over after the last chunk, such as base64
+ * without padding.
+ */
+- (void)finishIntoData:(NSMutableData *)output;
+- (NSData *)finish;
+
+@end
\ No newline at end of file
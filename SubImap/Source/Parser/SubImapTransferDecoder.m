@@ -0,0 +1,622 @@
+// SubImapTransferDecoder.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapTransferDecoder.h"
+
+// The SSSE3 base64 path is compiled for every x86 build, and used when
+// the CPU has it, so it doesn't need -mssse3
+#if defined(__x86_64__) || defined(__i386__)
+#define SUBIMAP_BASE64_SSSE3 1
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#pragma mark Base64
+
+// Base64 values, or 0xFF for bytes outside the alphabet
+static const uint8_t SubImapBase64Values[256] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+  0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+  0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+  0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+typedef struct {
+  uint32_t bits;
+  int count;
+  int done;
+} SubImapBase64State;
+
+#if defined(SUBIMAP_BASE64_SSSE3)
+static int SubImapBase64HasSSSE3(void) {
+#if defined(__SSSE3__)
+  return 1;
+#else
+  return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+/*
+ * Decodes runs of 16 base64 characters into 12 bytes each, writing 16,
+ * until fewer than 16 are left or a run has a character outside the
+ * alphabet. Returns the number of runs decoded.
+ */
+__attribute__((target("ssse3")))
+static NSUInteger SubImapBase64DecodeBlocks16(const uint8_t *in, NSUInteger length, uint8_t *out) {
+  const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i mask2F = _mm_set1_epi8(0x2F);
+
+  const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  NSUInteger blocks = 0;
+
+  for (; length >= 16; length -= 16, in += 16, out += 12, blocks++) {
+    __m128i chars = _mm_loadu_si128((const __m128i *)in);
+    __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(chars, 4), mask2F);
+    __m128i loNibbles = _mm_and_si128(chars, mask2F);
+    __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+    __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()))) {
+      break;
+    }
+
+    // Characters to 6-bit values
+    __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(chars, mask2F), hiNibbles));
+    __m128i values = _mm_add_epi8(chars, roll);
+
+    // Pack 4 x 6 bits into 3 bytes
+    __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    merged = _mm_shuffle_epi8(merged, pack);
+
+    _mm_storeu_si128((__m128i *)out, merged);
+  }
+
+  return blocks;
+}
+#endif
+
+/*
+ * Decodes base64, skipping line breaks and anything else outside the
+ * alphabet, and stopping at padding. Whole groups of 4 are decoded
+ * straight from the input; a group split across calls is carried in
+ * state. Output needs room for length / 4 * 3 + 3 + 16 bytes.
+ */
+static NSUInteger SubImapBase64Decode(SubImapBase64State *state, const uint8_t *in, NSUInteger length, uint8_t *out) {
+  const uint8_t *end = in + length;
+  uint8_t *start = out;
+
+  while (in < end && !state->done) {
+    if (state->count == 0) {
+#if defined(SUBIMAP_BASE64_SSSE3)
+      if (end - in >= 16 && SubImapBase64HasSSSE3()) {
+        NSUInteger blocks = SubImapBase64DecodeBlocks16(in, end - in, out);
+        in += blocks * 16;
+        out += blocks * 12;
+      }
+#endif
+
+      // Groups of 4 within a line
+      while (end - in >= 4) {
+        uint8_t a = SubImapBase64Values[in[0]], b = SubImapBase64Values[in[1]];
+        uint8_t c = SubImapBase64Values[in[2]], d = SubImapBase64Values[in[3]];
+
+        if ((a | b | c | d) & 0x80) break;
+
+        uint32_t group = (uint32_t)a << 18 | (uint32_t)b << 12 | (uint32_t)c << 6 | d;
+        out[0] = group >> 16;
+        out[1] = group >> 8;
+        out[2] = group;
+        out += 3;
+        in += 4;
+      }
+
+      if (in == end) break;
+    }
+
+    // One character at a time, across line breaks and calls
+    uint8_t character = *in++;
+    uint8_t value = SubImapBase64Values[character];
+
+    if (value & 0x80) {
+      if (character == '=') state->done = 1;
+      continue;
+    }
+
+    state->bits = state->bits << 6 | value;
+
+    if (++state->count == 4) {
+      out[0] = state->bits >> 16;
+      out[1] = state->bits >> 8;
+      out[2] = state->bits;
+      out += 3;
+      state->bits = 0;
+      state->count = 0;
+    }
+  }
+
+  // Padding leaves 2 or 3 characters, for 1 or 2 bytes
+  if (state->done && state->count) {
+    if (state->count >= 2) *out++ = state->bits >> (state->count == 2 ? 4 : 10);
+    if (state->count == 3) *out++ = state->bits >> 2;
+    state->count = 0;
+  }
+
+  return out - start;
+}
+
+/* Flushes a final group left without padding. */
+static NSUInteger SubImapBase64Finish(SubImapBase64State *state, uint8_t *out) {
+  state->done = 1;
+  return SubImapBase64Decode(state, NULL, 0, out);
+}
+
+#pragma mark Quoted-printable
+
+enum {
+  SubImapQPStateText,
+  SubImapQPStateEquals,   // after "="
+  SubImapQPStateHex,      // after "=" and one hex digit
+  SubImapQPStateSoftBreak // after "=" and whitespace or CR, until LF
+};
+
+typedef struct {
+  int state;
+  uint8_t hex;            // the first hex digit
+  uint8_t pending[64];    // whitespace that is dropped if it ends a line
+  NSUInteger pendingLength;
+} SubImapQPState;
+
+static int SubImapHexValue(uint8_t c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+static uint8_t *SubImapQPFlushPending(SubImapQPState *state, uint8_t *out) {
+  memcpy(out, state->pending, state->pendingLength);
+  out += state->pendingLength;
+  state->pendingLength = 0;
+  return out;
+}
+
+/*
+ * Decodes quoted-printable. Soft line breaks are removed, as is
+ * whitespace at the end of a line. Invalid escapes are kept as they are.
+ * Output needs room for length + 64 + 2 bytes.
+ */
+static NSUInteger SubImapQPDecode(SubImapQPState *state, const uint8_t *in, NSUInteger length, uint8_t *out) {
+  const uint8_t *end = in + length;
+  uint8_t *start = out;
+
+  while (in < end) {
+    if (state->state == SubImapQPStateText && !state->pendingLength) {
+#if defined(__SSE2__)
+      // Copy 16 bytes at a time while none of them needs decoding
+      const __m128i equals = _mm_set1_epi8('='), space = _mm_set1_epi8(' ');
+      const __m128i tab = _mm_set1_epi8('\t'), cr = _mm_set1_epi8('\r');
+
+      while (end - in >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)in);
+        __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, equals), _mm_cmpeq_epi8(chunk, space)),
+                                       _mm_or_si128(_mm_cmpeq_epi8(chunk, tab), _mm_cmpeq_epi8(chunk, cr)));
+        int mask = _mm_movemask_epi8(special);
+
+        if (mask) {
+          NSUInteger run = __builtin_ctz(mask);
+          memcpy(out, in, run);
+          out += run;
+          in += run;
+          break;
+        }
+
+        _mm_storeu_si128((__m128i *)out, chunk);
+        out += 16;
+        in += 16;
+      }
+#endif
+
+      while (in < end && *in != '=' && *in != ' ' && *in != '\t' && *in != '\r') {
+        *out++ = *in++;
+      }
+
+      if (in == end) break;
+    }
+
+    uint8_t c = *in++;
+
+    switch (state->state) {
+      case SubImapQPStateText:
+        if (c == ' ' || c == '\t') {
+          if (state->pendingLength == sizeof(state->pending)) out = SubImapQPFlushPending(state, out);
+          state->pending[state->pendingLength++] = c;
+        } else if (c == '\r' || c == '\n') {
+          // Whitespace before a line break is padding
+          state->pendingLength = 0;
+          *out++ = c;
+        } else {
+          out = SubImapQPFlushPending(state, out);
+
+          if (c == '=') {
+            state->state = SubImapQPStateEquals;
+          } else {
+            *out++ = c;
+          }
+        }
+        break;
+
+      case SubImapQPStateEquals:
+        if (SubImapHexValue(c) >= 0) {
+          state->hex = c;
+          state->state = SubImapQPStateHex;
+        } else if (c == '\n') {
+          state->state = SubImapQPStateText;
+        } else if (c == '\r' || c == ' ' || c == '\t') {
+          state->state = SubImapQPStateSoftBreak;
+        } else {
+          *out++ = '=';
+          *out++ = c;
+          state->state = SubImapQPStateText;
+        }
+        break;
+
+      case SubImapQPStateHex:
+        if (SubImapHexValue(c) >= 0) {
+          *out++ = SubImapHexValue(state->hex) << 4 | SubImapHexValue(c);
+          state->state = SubImapQPStateText;
+        } else {
+          *out++ = '=';
+          *out++ = state->hex;
+          state->state = SubImapQPStateText;
+          in--;
+        }
+        break;
+
+      case SubImapQPStateSoftBreak:
+        if (c == '\n') {
+          state->state = SubImapQPStateText;
+        } else if (c != '\r' && c != ' ' && c != '\t') {
+          // Not a soft break after all
+          state->state = SubImapQPStateText;
+          in--;
+        }
+        break;
+    }
+  }
+
+  return out - start;
+}
+
+/* Flushes an unfinished escape. Trailing whitespace is dropped. */
+static NSUInteger SubImapQPFinish(SubImapQPState *state, uint8_t *out) {
+  uint8_t *start = out;
+
+  if (state->state == SubImapQPStateEquals) {
+    *out++ = '=';
+  } else if (state->state == SubImapQPStateHex) {
+    *out++ = '=';
+    *out++ = state->hex;
+  }
+
+  state->state = SubImapQPStateText;
+  state->pendingLength = 0;
+  return out - start;
+}
+
+#pragma mark Charsets
+
+static NSStringEncoding SubImapStringEncodingForCharset(NSString *charset) {
+  static NSDictionary *encodings;
+  static dispatch_once_t onceToken;
+
+  dispatch_once(&onceToken, ^{
+    encodings = @{
+      @"utf-8":        @(NSUTF8StringEncoding),
+      @"us-ascii":     @(NSASCIIStringEncoding),
+      @"iso-8859-1":   @(NSISOLatin1StringEncoding),
+      @"iso-8859-2":   @(NSISOLatin2StringEncoding),
+      @"windows-1250": @(NSWindowsCP1250StringEncoding),
+      @"windows-1251": @(NSWindowsCP1251StringEncoding),
+      @"windows-1252": @(NSWindowsCP1252StringEncoding),
+      @"windows-1253": @(NSWindowsCP1253StringEncoding),
+      @"windows-1254": @(NSWindowsCP1254StringEncoding),
+      @"iso-2022-jp":  @(NSISO2022JPStringEncoding),
+      @"shift_jis":    @(NSShiftJISStringEncoding),
+      @"euc-jp":       @(NSJapaneseEUCStringEncoding),
+      @"utf-16":       @(NSUTF16StringEncoding),
+    };
+  });
+
+  NSNumber *encoding = encodings[charset];
+
+  if (encoding) {
+    return [encoding unsignedIntegerValue];
+  }
+
+#if defined(__APPLE__)
+  // Any other charset CoreFoundation knows, such as koi8-r or gb2312
+  CFStringEncoding cfEncoding = CFStringConvertIANACharSetNameToEncoding((__bridge CFStringRef)charset);
+
+  if (cfEncoding != kCFStringEncodingInvalidId) {
+    return CFStringConvertEncodingToNSStringEncoding(cfEncoding);
+  }
+#endif
+
+  return NSUTF8StringEncoding;
+}
+
+
+#pragma mark -
+
+typedef enum {
+  SubImapTransferEncodingIdentity,
+  SubImapTransferEncodingBase64,
+  SubImapTransferEncodingQuotedPrintable,
+} SubImapTransferEncoding;
+
+@implementation SubImapTransferDecoder {
+  SubImapTransferEncoding _type;
+  SubImapBase64State _base64;
+  SubImapQPState _quotedPrintable;
+}
+
++ (instancetype)decoderWithEncoding:(NSString *)encoding {
+  return [[self alloc] initWithEncoding:encoding];
+}
+
++ (NSData *)decodeData:(NSData *)data encoding:(NSString *)encoding {
+  SubImapTransferDecoder *decoder = [self decoderWithEncoding:encoding];
+  NSMutableData *output = [NSMutableData dataWithCapacity:[data length]];
+
+  [decoder decodeBytes:[data bytes] length:[data length] intoData:output];
+  [decoder finishIntoData:output];
+
+  return output;
+}
+
+- (id)initWithEncoding:(NSString *)encoding {
+  self = [super init];
+
+  if (self) {
+    _encoding = [encoding uppercaseString];
+
+    if ([_encoding isEqualToString:@"BASE64"]) {
+      _type = SubImapTransferEncodingBase64;
+    } else if ([_encoding isEqualToString:@"QUOTED-PRINTABLE"]) {
+      _type = SubImapTransferEncodingQuotedPrintable;
+    } else {
+      _type = SubImapTransferEncodingIdentity;
+    }
+  }
+
+  return self;
+}
+
+- (void)decodeBytes:(const void *)bytes length:(NSUInteger)length intoData:(NSMutableData *)output {
+  NSUInteger offset = [output length];
+  NSUInteger decoded = 0;
+
+  switch (_type) {
+    case SubImapTransferEncodingBase64:
+      // The SSSE3 path writes 16 bytes for every 12 it decodes
+      [output setLength:offset + length / 4 * 3 + 3 + 16];
+      decoded = SubImapBase64Decode(&_base64, bytes, length, (uint8_t *)[output mutableBytes] + offset);
+      break;
+
+    case SubImapTransferEncodingQuotedPrintable:
+      [output setLength:offset + length + sizeof(_quotedPrintable.pending) + 2];
+      decoded = SubImapQPDecode(&_quotedPrintable, bytes, length, (uint8_t *)[output mutableBytes] + offset);
+      break;
+
+    default:
+      [output appendBytes:bytes length:length];
+      return;
+  }
+
+  [output setLength:offset + decoded];
+}
+
+- (NSData *)decodeData:(NSData *)data {
+  NSMutableData *output = [NSMutableData dataWithCapacity:[data length]];
+  [self decodeBytes:[data bytes] length:[data length] intoData:output];
+  return output;
+}
+
+- (void)finishIntoData:(NSMutableData *)output {
+  NSUInteger offset = [output length];
+  NSUInteger decoded = 0;
+
+  [output setLength:offset + 4];
+
+  switch (_type) {
+    case SubImapTransferEncodingBase64:
+      decoded = SubImapBase64Finish(&_base64, (uint8_t *)[output mutableBytes] + offset);
+      break;
+
+    case SubImapTransferEncodingQuotedPrintable:
+      decoded = SubImapQPFinish(&_quotedPrintable, (uint8_t *)[output mutableBytes] + offset);
+      break;
+
+    default:
+      break;
+  }
+
+  [output setLength:offset + decoded];
+}
+
+- (NSData *)finish {
+  NSMutableData *output = [NSMutableData data];
+  [self finishIntoData:output];
+  return output;
+}
+
+#pragma mark - Charsets
+
++ (NSString *)stringWithData:(NSData *)data charset:(NSString *)charset {
+  NSStringEncoding encoding = charset ? SubImapStringEncodingForCharset([charset lowercaseString]) : NSUTF8StringEncoding;
+  NSString *string = [[NSString alloc] initWithData:data encoding:encoding];
+
+  if (!string) {
+    string = [[NSString alloc] initWithData:data encoding:NSISOLatin1StringEncoding];
+  }
+
+  return string;
+}
+
+#pragma mark - Encoded words
+
++ (NSString *)stringByDecodingEncodedWords:(NSString *)string {
+  if (![string isKindOfClass:[NSString class]] || [string rangeOfString:@"=?"].location == NSNotFound) {
+    return string;
+  }
+
+  NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+  const char *bytes = [data bytes];
+  NSUInteger length = [data length];
+
+  NSMutableString *result = [NSMutableString stringWithCapacity:length];
+  NSUInteger position = 0;
+  NSUInteger textStart = 0;
+  BOOL afterWord = NO;
+
+  while (position + 1 < length) {
+    if (bytes[position] != '=' || bytes[position + 1] != '?') {
+      position++;
+      continue;
+    }
+
+    NSUInteger wordLength = 0;
+    NSString *word = [self decodeEncodedWordAtBytes:bytes + position length:length - position wordLength:&wordLength];
+
+    if (!word) {
+      position++;
+      continue;
+    }
+
+    // Text before the word, unless it is only whitespace between words
+    BOOL whitespace = YES;
+
+    for (NSUInteger i = textStart; i < position && whitespace; i++) {
+      whitespace = (bytes[i] == ' ' || bytes[i] == '\t' || bytes[i] == '\r' || bytes[i] == '\n');
+    }
+
+    if (!(afterWord && whitespace)) {
+      [result appendString:[[NSString alloc] initWithBytes:bytes + textStart length:position - textStart encoding:NSUTF8StringEncoding]];
+    }
+
+    [result appendString:word];
+
+    position += wordLength;
+    textStart = position;
+    afterWord = YES;
+  }
+
+  [result appendString:[[NSString alloc] initWithBytes:bytes + textStart length:length - textStart encoding:NSUTF8StringEncoding]];
+
+  return result;
+}
+
+/*
+ * encoded-word = "=?" charset "?" encoding "?" encoded-text "?="
+ *
+ * Returns nil if the bytes don't start with a valid encoded word.
+ */
++ (NSString *)decodeEncodedWordAtBytes:(const char *)bytes length:(NSUInteger)length wordLength:(NSUInteger *)wordLength {
+  const char *end = bytes + length;
+  const char *charset = bytes + 2;
+  const char *question = memchr(charset, '?', end - charset);
+
+  if (!question || end - question < 4 || question[2] != '?') {
+    return nil;
+  }
+
+  char encoding = question[1];
+  const char *text = question + 3;
+  const char *textEnd = text;
+
+  while (textEnd + 1 < end && !(textEnd[0] == '?' && textEnd[1] == '=')) {
+    if (*textEnd == ' ') return nil;
+    textEnd++;
+  }
+
+  if (textEnd + 1 >= end) {
+    return nil;
+  }
+
+  NSMutableData *decoded = [NSMutableData dataWithCapacity:textEnd - text];
+
+  // B is base64, Q is quoted-printable with _ for space
+  if (encoding == 'B' || encoding == 'b') {
+    SubImapBase64State state = {0};
+    [decoded setLength:(textEnd - text) / 4 * 3 + 3 + 16];
+    NSUInteger count = SubImapBase64Decode(&state, (const uint8_t *)text, textEnd - text, [decoded mutableBytes]);
+    count += SubImapBase64Finish(&state, (uint8_t *)[decoded mutableBytes] + count);
+    [decoded setLength:count];
+  } else if (encoding == 'Q' || encoding == 'q') {
+    for (const char *c = text; c < textEnd; c++) {
+      uint8_t byte = *c;
+
+      if (byte == '_') {
+        byte = ' ';
+      } else if (byte == '=' && textEnd - c > 2 && SubImapHexValue(c[1]) >= 0 && SubImapHexValue(c[2]) >= 0) {
+        byte = SubImapHexValue(c[1]) << 4 | SubImapHexValue(c[2]);
+        c += 2;
+      }
+
+      [decoded appendBytes:&byte length:1];
+    }
+  } else {
+    return nil;
+  }
+
+  // RFC2231 allows a language after the charset, eg: UTF-8*EN
+  NSString *name = [[NSString alloc] initWithBytes:charset length:question - charset encoding:NSASCIIStringEncoding];
+  name = [[name componentsSeparatedByString:@"*"][0] lowercaseString];
+
+  NSString *word = [[NSString alloc] initWithData:decoded encoding:SubImapStringEncodingForCharset(name)];
+
+  if (!word) {
+    word = [[NSString alloc] initWithData:decoded encoding:NSISOLatin1StringEncoding];
+  }
+
+  *wordLength = textEnd + 2 - bytes;
+  return word;
+}
+
+@end
\ No newline at end of file
@@ -25,24 +25,48 @@
 
 #import "SubImapResponse.h"
 #import "SubImapConnectionData.h"
+#import "SubImapResponseFramer.h"
 #import "SubImapConnectionDelegate.h"
+#import "SubImapTransport.h"
+#import "SubImapEventLoop.h"
+#import "SubImapTLSSession.h"
+#import "SubImapTLSTransport.h"
 #import "SubImapConnection.h"
+#import "SubImapHistogram.h"
+#import "SubImapMetrics.h"
+#import "SubImapMailboxState.h"
+#import "SubImapGmailMessageStore.h"
+#import "SubImapThreadIndex.h"
+#import "SubImapSearchIndex.h"
 #import "SubImapClientDelegate.h"
 #import "SubImapClient.h"
 #import "SubImapTransaction.h"
 #import "SubImapTransactionalClient.h"
 
 #import "SubImapCommand.h"
+#import "SubImapCommandBuilder.h"
+#import "SubImapAuthenticateCommand.h"
 #import "SubImapCapabilityCommand.h"
 #import "SubImapCloseCommand.h"
+#import "SubImapCopyCommand.h"
 #import "SubImapExpungeCommand.h"
 #import "SubImapFetchCommand.h"
 #import "SubImapListCommand.h"
 #import "SubImapLoginCommand.h"
 #import "SubImapLogoutCommand.h"
+#import "SubImapMoveCommand.h"
+#import "SubImapNotifyCommand.h"
 #import "SubImapRawCommand.h"
+#import "SubImapSearchCriteria.h"
+#import "SubImapSearchCommand.h"
 #import "SubImapSelectCommand.h"
+#import "SubImapStatusCommand.h"
+#import "SubImapStoreCommand.h"
+#import "SubImapThreadCommand.h"
 
 #import "SubImapToken.h"
+#import "SubImapStringTable.h"
 #import "SubImapTokenizer.h"
-#import "SubImapParser.h"
\ No newline at end of file
+#import "SubImapParser.h"
+#import "SubImapHeaderParser.h"
+#import "SubImapTransferDecoder.h"
@@ -30,7 +30,39 @@ typedef enum {
   SubImapClientStateSelected        = 1 << 3,
 } SubImapClientState;
 
+typedef enum {
+  // Plain text, for local servers
+  SubImapConnectionSecurityNone,
+
+  // TLS negotiated as soon as the socket opens (IMAPS)
+  SubImapConnectionSecurityTLS,
+
+  // Plain text until STARTTLS is negotiated after the greeting (port 143)
+  SubImapConnectionSecurityStartTLS,
+} SubImapConnectionSecurity;
+
+typedef enum {
+  // epoll where it is available, otherwise poll
+  SubImapEventLoopBackendDefault,
+
+  // Linux only
+  SubImapEventLoopBackendEpoll,
+
+  SubImapEventLoopBackendPoll,
+} SubImapEventLoopBackend;
+
+typedef enum {
+  // Prefetching and background sync
+  SubImapCommandPriorityBackground = -1,
+
+  SubImapCommandPriorityDefault = 0,
+
+  // Someone is waiting on the result
+  SubImapCommandPriorityInteractive = 1,
+} SubImapCommandPriority;
+
 typedef void (^SubImapCompletionBlock)(SubImapCommand *command);
+typedef void (^SubImapFetchMessagesBlock)(NSArray *messages);
 
 typedef id (^SubImapTransactionBlock)(id result);
 typedef void (^SubImapTransactionErrorBlock)(NSError *error);
\ No newline at end of file
@@ -0,0 +1,136 @@
+// SubImapBenchmark.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/*
+ * Monotonic time in seconds, for measuring intervals.
+ */
+double SubImapBenchmarkNow(void);
+
+/*
+ * The process's peak resident set size, in kilobytes.
+ */
+long SubImapBenchmarkPeakRSS(void);
+
+/*
+ * The process's current resident set size, in kilobytes.
+ */
+long SubImapBenchmarkRSS(void);
+
+/*
+ * Raises the open file limit as far as it goes, for benchmarks holding
+ * thousands of sockets.
+ */
+void SubImapBenchmarkRaiseDescriptorLimit(void);
+
+typedef enum {
+  SubImapBenchmarkStageUnknown = -1,
+
+  /*
+   * Splits a corpus into responses with SubImapResponseFramer, feeding it
+   * chunkSize bytes at a time, the same way SubImapConnection streamRead
+   * does.
+   */
+  SubImapBenchmarkStageFraming,
+
+  /*
+   * Breaks each framed response into tokens with SubImapTokenizer,
+   * without any guidance from the parser.
+   */
+  SubImapBenchmarkStageTokenizer,
+
+  /*
+   * Parses each framed response into a SubImapResponse.
+   */
+  SubImapBenchmarkStageParser,
+
+  /*
+   * Decodes the corpus, base64 encoded in 76 character lines, with
+   * SubImapTransferDecoder, chunkSize bytes at a time. Each chunk counts
+   * as a response, and bytes are the encoded bytes.
+   */
+  SubImapBenchmarkStageBase64,
+
+  /*
+   * Decodes the corpus, quoted-printable encoded, the same way.
+   */
+  SubImapBenchmarkStageQuotedPrintable,
+} SubImapBenchmarkStage;
+
+/*
+ * SubImapBenchmark
+ *
+ * Measures one stage of response handling over a single corpus file: a
+ * recorded server transcript with CRLF line endings.
+ */
+@interface SubImapBenchmark : NSObject
+
+/*
+ * The corpus name, which is its file name without the extension.
+ */
+@property (readonly) NSString *name;
+
+/*
+ * Minimum time spent running a stage. The corpus is processed as many
+ * times as needed to fill it.
+ *
+ * Defaults to 1 second.
+ */
+@property NSTimeInterval minimumDuration;
+
+/*
+ * Number of bytes fed to the framer, or to a decoder, at a time.
+ *
+ * Defaults to 1024, the SubImapConnection read buffer size.
+ */
+@property NSUInteger chunkSize;
+
++ (instancetype)benchmarkWithCorpusAtPath:(NSString *)path;
+- (id)initWithCorpusAtPath:(NSString *)path;
+
+/*
+ * Returns the names of every corpus file (*.imap) in a directory.
+ */
++ (NSArray *)corpusNamesAtPath:(NSString *)path;
+
++ (NSString *)stringFromStage:(SubImapBenchmarkStage)stage;
++ (SubImapBenchmarkStage)stageFromString:(NSString *)string;
+
+/*
+ * Runs a stage and returns its results:
+ *
+ *   "stage":               (NSString *) stage name
+ *   "corpus":              (NSString *) corpus name
+ *   "responses":           (NSNumber *) responses processed
+ *   "bytes":               (NSNumber *) bytes processed
+ *   "seconds":             (NSNumber *) time spent
+ *   "responses_per_sec":   (NSNumber *)
+ *   "mb_per_sec":          (NSNumber *)
+ *   "allocs_per_response": (NSNumber *) heap allocations, or -1 if they
+ *                                       can not be counted on this platform
+ *   "peak_rss_kb":         (NSNumber *) process peak resident set size
+ *   "errors":              (NSNumber *) responses that failed to tokenize
+ *                                       or parse, per pass over the corpus
+ */
+- (NSDictionary *)runStage:(SubImapBenchmarkStage)stage;
+
+@end
\ No newline at end of file
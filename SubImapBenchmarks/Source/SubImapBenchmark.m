@@ -0,0 +1,483 @@
+// SubImapBenchmark.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapBenchmark.h"
+
+#ifdef GNUSTEP
+  #import "SubImapResponseFramer.h"
+  #import "SubImapTokenizer.h"
+  #import "SubImapParser.h"
+  #import "SubImapTransferDecoder.h"
+#else
+  #import <SubImap/SubImap.h>
+#endif
+
+#include <limits.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+  #include <mach/mach.h>
+  #include <mach/mach_time.h>
+  #include <malloc/malloc.h>
+  #include <sys/mman.h>
+#else
+  #include <time.h>
+#endif
+
+#pragma mark Allocation counting
+
+static volatile int64_t SubImapBenchmarkAllocations = 0;
+
+#if defined(__GLIBC__)
+
+// glibc lets the executable interpose the allocator
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) {
+  __sync_fetch_and_add(&SubImapBenchmarkAllocations, 1);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  __sync_fetch_and_add(&SubImapBenchmarkAllocations, 1);
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  __sync_fetch_and_add(&SubImapBenchmarkAllocations, 1);
+  return __libc_realloc(ptr, size);
+}
+
+static BOOL SubImapBenchmarkInstallAllocationCounter(void) {
+  return YES;
+}
+
+#elif defined(__APPLE__)
+
+// On Darwin, wrap the default malloc zone's functions instead
+static void *(*SubImapBenchmarkZoneMalloc)(malloc_zone_t *zone, size_t size);
+static void *(*SubImapBenchmarkZoneCalloc)(malloc_zone_t *zone, size_t count, size_t size);
+static void *(*SubImapBenchmarkZoneRealloc)(malloc_zone_t *zone, void *ptr, size_t size);
+
+static void *SubImapBenchmarkCountingMalloc(malloc_zone_t *zone, size_t size) {
+  __sync_fetch_and_add(&SubImapBenchmarkAllocations, 1);
+  return SubImapBenchmarkZoneMalloc(zone, size);
+}
+
+static void *SubImapBenchmarkCountingCalloc(malloc_zone_t *zone, size_t count, size_t size) {
+  __sync_fetch_and_add(&SubImapBenchmarkAllocations, 1);
+  return SubImapBenchmarkZoneCalloc(zone, count, size);
+}
+
+static void *SubImapBenchmarkCountingRealloc(malloc_zone_t *zone, void *ptr, size_t size) {
+  __sync_fetch_and_add(&SubImapBenchmarkAllocations, 1);
+  return SubImapBenchmarkZoneRealloc(zone, ptr, size);
+}
+
+static BOOL SubImapBenchmarkInstallAllocationCounter(void) {
+  static BOOL installed = NO;
+  if (installed) return YES;
+
+  malloc_zone_t *zone = malloc_default_zone();
+  vm_address_t page = trunc_page((vm_address_t)zone);
+
+  // The zone struct is read-only on newer systems
+  if (mprotect((void *)page, vm_page_size, PROT_READ | PROT_WRITE) != 0) {
+    return NO;
+  }
+
+  SubImapBenchmarkZoneMalloc = zone->malloc;
+  SubImapBenchmarkZoneCalloc = zone->calloc;
+  SubImapBenchmarkZoneRealloc = zone->realloc;
+
+  zone->malloc = SubImapBenchmarkCountingMalloc;
+  zone->calloc = SubImapBenchmarkCountingCalloc;
+  zone->realloc = SubImapBenchmarkCountingRealloc;
+
+  mprotect((void *)page, vm_page_size, PROT_READ);
+
+  installed = YES;
+  return YES;
+}
+
+#else
+
+static BOOL SubImapBenchmarkInstallAllocationCounter(void) {
+  return NO;
+}
+
+#endif
+
+#pragma mark Clock
+
+double SubImapBenchmarkNow(void) {
+#ifdef __APPLE__
+  static mach_timebase_info_data_t timebase;
+  if (!timebase.denom) mach_timebase_info(&timebase);
+  return (double)mach_absolute_time() * timebase.numer / timebase.denom / 1e9;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+#endif
+}
+
+long SubImapBenchmarkPeakRSS(void) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  // Reported in bytes on Darwin
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+long SubImapBenchmarkRSS(void) {
+#ifdef __APPLE__
+  struct mach_task_basic_info info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+    return SubImapBenchmarkPeakRSS();
+  }
+
+  return (long)(info.resident_size / 1024);
+#else
+  long pages = 0, residentPages = 0;
+  FILE *statm = fopen("/proc/self/statm", "r");
+
+  if (!statm || fscanf(statm, "%ld %ld", &pages, &residentPages) != 2) {
+    if (statm) fclose(statm);
+    return SubImapBenchmarkPeakRSS();
+  }
+
+  fclose(statm);
+  return residentPages * (sysconf(_SC_PAGESIZE) / 1024);
+#endif
+}
+
+void SubImapBenchmarkRaiseDescriptorLimit(void) {
+  struct rlimit limit;
+
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+#ifdef __APPLE__
+    // Darwin rejects limits above OPEN_MAX
+    limit.rlim_cur = MIN(limit.rlim_max, OPEN_MAX);
+#endif
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+}
+
+#pragma mark -
+
+// Token types tried, in order, when tokenizing without the parser
+static const SubImapTokenType SubImapBenchmarkTokenTypes[] = {
+  SubImapTokenTypeSpace,
+  SubImapTokenTypeParenOpen,
+  SubImapTokenTypeParenClose,
+  SubImapTokenTypeBracketOpen,
+  SubImapTokenTypeBracketClose,
+  SubImapTokenTypeCRLF,
+  SubImapTokenTypeLiteral,
+  SubImapTokenTypeQuotedString,
+  SubImapTokenTypeNumber,
+  SubImapTokenTypeAtom,
+  SubImapTokenTypeFlag,
+  SubImapTokenTypeText,
+};
+
+@implementation SubImapBenchmark {
+  NSData *_corpus;
+  NSArray *_responses;
+
+  // Encoded copies of the corpus for the decoding stages
+  NSData *_base64Corpus;
+  NSData *_quotedPrintableCorpus;
+}
+
++ (instancetype)benchmarkWithCorpusAtPath:(NSString *)path {
+  return [[self alloc] initWithCorpusAtPath:path];
+}
+
+- (id)initWithCorpusAtPath:(NSString *)path {
+  self = [super init];
+
+  if (self) {
+    _name = [[path lastPathComponent] stringByDeletingPathExtension];
+    _corpus = [NSData dataWithContentsOfFile:path];
+
+    if (!_corpus) {
+      return nil;
+    }
+
+    self.minimumDuration = 1.0;
+    self.chunkSize = 1024;
+
+    // Frame the corpus once up front for the tokenizer and parser stages
+    _responses = [[SubImapResponseFramer framer] responsesByAppendingBytes:[_corpus bytes] length:[_corpus length]];
+  }
+
+  return self;
+}
+
++ (NSArray *)corpusNamesAtPath:(NSString *)path {
+  NSMutableArray *names = [NSMutableArray array];
+
+  for (NSString *file in [[NSFileManager defaultManager] contentsOfDirectoryAtPath:path error:nil]) {
+    if ([[file pathExtension] isEqualToString:@"imap"]) {
+      [names addObject:[file stringByDeletingPathExtension]];
+    }
+  }
+
+  return [names sortedArrayUsingSelector:@selector(compare:)];
+}
+
++ (NSString *)stringFromStage:(SubImapBenchmarkStage)stage {
+  switch (stage) {
+    case SubImapBenchmarkStageFraming:   return @"framing";
+    case SubImapBenchmarkStageTokenizer: return @"tokenizer";
+    case SubImapBenchmarkStageParser:    return @"parser";
+    case SubImapBenchmarkStageBase64:    return @"base64";
+    case SubImapBenchmarkStageQuotedPrintable: return @"qp";
+    default:                             return nil;
+  }
+}
+
++ (SubImapBenchmarkStage)stageFromString:(NSString *)string {
+  for (SubImapBenchmarkStage stage = SubImapBenchmarkStageFraming; stage <= SubImapBenchmarkStageQuotedPrintable; stage++) {
+    if ([string isEqualToString:[self stringFromStage:stage]]) {
+      return stage;
+    }
+  }
+
+  return SubImapBenchmarkStageUnknown;
+}
+
+#pragma mark -
+
+- (NSDictionary *)runStage:(SubImapBenchmarkStage)stage {
+  BOOL countsAllocations = SubImapBenchmarkInstallAllocationCounter();
+
+  // Warm up, and count errors for a single pass
+  NSUInteger errors = 0;
+  @autoreleasepool {
+    [self runPassForStage:stage errors:&errors];
+  }
+
+  NSUInteger passes = 0;
+  NSUInteger responses = 0;
+  int64_t allocations = SubImapBenchmarkAllocations;
+  double start = SubImapBenchmarkNow();
+  double elapsed = 0;
+
+  do {
+    @autoreleasepool {
+      responses += [self runPassForStage:stage errors:NULL];
+    }
+
+    passes++;
+    elapsed = SubImapBenchmarkNow() - start;
+  } while (elapsed < self.minimumDuration);
+
+  allocations = SubImapBenchmarkAllocations - allocations;
+
+  double bytes = (double)[[self inputForStage:stage] length] * passes;
+
+  return @{
+    @"stage":               [[self class] stringFromStage:stage],
+    @"corpus":              self.name,
+    @"responses":           @(responses),
+    @"bytes":               @(bytes),
+    @"seconds":             @(elapsed),
+    @"responses_per_sec":   @(responses / elapsed),
+    @"mb_per_sec":          @(bytes / elapsed / (1024 * 1024)),
+    @"allocs_per_response": countsAllocations ? @((double)allocations / MAX(responses, 1)) : @(-1),
+    @"peak_rss_kb":         @(SubImapBenchmarkPeakRSS()),
+    @"errors":              @(errors),
+  };
+}
+
+/*
+ * Runs a stage over the whole corpus once, returning the number of
+ * responses processed.
+ */
+- (NSUInteger)runPassForStage:(SubImapBenchmarkStage)stage errors:(NSUInteger *)errors {
+  switch (stage) {
+    case SubImapBenchmarkStageFraming:   return [self frameCorpus];
+    case SubImapBenchmarkStageTokenizer: return [self tokenizeResponsesWithErrors:errors];
+    case SubImapBenchmarkStageParser:    return [self parseResponsesWithErrors:errors];
+    case SubImapBenchmarkStageBase64:    return [self decodeData:[self inputForStage:stage] encoding:@"BASE64"];
+    case SubImapBenchmarkStageQuotedPrintable: return [self decodeData:[self inputForStage:stage] encoding:@"QUOTED-PRINTABLE"];
+    default:                             return 0;
+  }
+}
+
+/*
+ * The bytes a stage reads, which are encoded once, up front, for the
+ * decoding stages.
+ */
+- (NSData *)inputForStage:(SubImapBenchmarkStage)stage {
+  switch (stage) {
+    case SubImapBenchmarkStageBase64:
+      if (!_base64Corpus) {
+        _base64Corpus = [_corpus base64EncodedDataWithOptions:NSDataBase64Encoding76CharacterLineLength | NSDataBase64EncodingEndLineWithCarriageReturn | NSDataBase64EncodingEndLineWithLineFeed];
+      }
+
+      return _base64Corpus;
+
+    case SubImapBenchmarkStageQuotedPrintable:
+      if (!_quotedPrintableCorpus) {
+        _quotedPrintableCorpus = [self quotedPrintableData:_corpus];
+      }
+
+      return _quotedPrintableCorpus;
+
+    default:
+      return _corpus;
+  }
+}
+
+- (NSUInteger)frameCorpus {
+  SubImapResponseFramer *framer = [SubImapResponseFramer framer];
+  const uint8_t *bytes = [_corpus bytes];
+  NSUInteger length = [_corpus length];
+  NSUInteger chunkSize = MAX(self.chunkSize, 1);
+  NSUInteger responses = 0;
+
+  for (NSUInteger offset = 0; offset < length; offset += chunkSize) {
+    responses += [[framer responsesByAppendingBytes:bytes + offset length:MIN(chunkSize, length - offset)] count];
+  }
+
+  return responses;
+}
+
+- (NSUInteger)tokenizeResponsesWithErrors:(NSUInteger *)errors {
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizer];
+  NSUInteger typeCount = sizeof(SubImapBenchmarkTokenTypes) / sizeof(SubImapBenchmarkTokenTypes[0]);
+
+  for (NSData *response in _responses) {
+    [tokenizer setData:response];
+    BOOL failed = ![tokenizer pullTokenIsType:SubImapTokenTypeTag];
+
+    while (!failed && ![tokenizer peekTokenIsType:SubImapTokenTypeEOF]) {
+      failed = YES;
+
+      for (NSUInteger i = 0; i < typeCount; i++) {
+        if ([tokenizer pullTokenIsType:SubImapBenchmarkTokenTypes[i]]) {
+          failed = NO;
+          break;
+        }
+      }
+    }
+
+    if (failed && errors) {
+      (*errors)++;
+    }
+  }
+
+  return _responses.count;
+}
+
+- (NSUInteger)parseResponsesWithErrors:(NSUInteger *)errors {
+  SubImapParser *parser = [SubImapParser parser];
+
+  for (NSData *response in _responses) {
+    NSError *error = nil;
+    [parser parseResponseData:response error:&error];
+
+    if (error && errors) {
+      (*errors)++;
+    }
+  }
+
+  return _responses.count;
+}
+
+- (NSUInteger)decodeData:(NSData *)data encoding:(NSString *)encoding {
+  SubImapTransferDecoder *decoder = [SubImapTransferDecoder decoderWithEncoding:encoding];
+  NSMutableData *output = [NSMutableData dataWithCapacity:[data length]];
+  const uint8_t *bytes = [data bytes];
+  NSUInteger length = [data length];
+  NSUInteger chunkSize = MAX(self.chunkSize, 1);
+  NSUInteger chunks = 0;
+
+  for (NSUInteger offset = 0; offset < length; offset += chunkSize) {
+    [decoder decodeBytes:bytes + offset length:MIN(chunkSize, length - offset) intoData:output];
+    [output setLength:0];
+    chunks++;
+  }
+
+  [decoder finishIntoData:output];
+
+  return chunks;
+}
+
+/*
+ * Quoted-printable, keeping the corpus's CRLF line breaks, with soft
+ * breaks after 75 characters.
+ */
+- (NSData *)quotedPrintableData:(NSData *)data {
+  const uint8_t *bytes = [data bytes];
+  NSUInteger length = [data length];
+  NSMutableData *output = [NSMutableData dataWithCapacity:length * 11 / 10];
+  NSUInteger column = 0;
+
+  for (NSUInteger i = 0; i < length; i++) {
+    uint8_t c = bytes[i];
+    char escaped[4];
+    NSUInteger count = 1;
+
+    if (c == '\r' && i + 1 < length && bytes[i + 1] == '\n') {
+      [output appendBytes:"\r\n" length:2];
+      column = 0;
+      i++;
+      continue;
+    }
+
+    BOOL lineEnd = (i + 1 == length || bytes[i + 1] == '\r');
+
+    if ((c >= 33 && c <= 126 && c != '=') || ((c == ' ' || c == '\t') && !lineEnd)) {
+      escaped[0] = c;
+    } else {
+      snprintf(escaped, sizeof(escaped), "=%02X", c);
+      count = 3;
+    }
+
+    if (column + count > 75) {
+      [output appendBytes:"=\r\n" length:3];
+      column = 0;
+    }
+
+    [output appendBytes:escaped length:count];
+    column += count;
+  }
+
+  return output;
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,85 @@
+// SubImapConnectionsBenchmark.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifdef GNUSTEP
+  #import "SubImapConnection.h"
+  #import "SubImapEventLoop.h"
+#else
+  #import <SubImap/SubImap.h>
+#endif
+
+/*
+ * SubImapConnectionsBenchmark
+ *
+ * Opens connectionCount SubImapConnections spread over threadCount
+ * SubImapEventLoops, waits for every greeting, measures the memory the
+ * idle connections hold, then sends a NOOP on each of them.
+ *
+ * The server should run in another process, such as a SubImapLoadServer
+ * started with -loadserver, so its memory is not counted.
+ */
+@interface SubImapConnectionsBenchmark : NSObject
+
+/*
+ * Defaults to 1000.
+ */
+@property NSUInteger connectionCount;
+
+/*
+ * Defaults to 1.
+ */
+@property NSUInteger threadCount;
+
+/*
+ * Defaults to SubImapEventLoopBackendDefault.
+ */
+@property SubImapEventLoopBackend backend;
+
+/*
+ * Gives up on each phase that takes longer than this.
+ *
+ * Defaults to 60 seconds.
+ */
+@property NSTimeInterval timeout;
+
+/*
+ * Connects to a server on 127.0.0.1 and returns the results:
+ *
+ *   "backend":                  (NSString *) "epoll" or "poll"
+ *   "threads":                  (NSNumber *)
+ *   "connections":              (NSNumber *) connections attempted
+ *   "connected":                (NSNumber *) connections greeted
+ *   "connect_seconds":          (NSNumber *) time until every greeting
+ *   "connections_per_sec":      (NSNumber *)
+ *   "connections_per_thread":   (NSNumber *)
+ *   "bytes_per_idle_connection":(NSNumber *) resident memory growth per
+ *                                            greeted connection
+ *   "noop_seconds":             (NSNumber *) time for a NOOP on every
+ *                                            connection
+ *   "noops_per_sec":            (NSNumber *)
+ *   "peak_rss_kb":              (NSNumber *)
+ *   "timed_out":                (NSNumber *) YES if a phase timed out
+ */
+- (NSDictionary *)runAgainstPort:(NSUInteger)port;
+
+@end
\ No newline at end of file
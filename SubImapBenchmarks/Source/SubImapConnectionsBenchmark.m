@@ -0,0 +1,280 @@
+// SubImapConnectionsBenchmark.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapConnectionsBenchmark.h"
+
+#import "SubImapBenchmark.h"
+
+// Connections opening at once on each event loop. Each one opens the
+// next once it is greeted, so the server's backlog is not overrun.
+#define SUBIMAP_CONNECTIONS_BENCHMARK_CHAINS 64
+
+@class SubImapConnectionsBenchmarkSession;
+
+@interface SubImapConnectionsBenchmark ()
+- (void)sessionDidSettle:(SubImapConnectionsBenchmarkSession *)session;
+@end
+
+#pragma mark -
+
+@interface SubImapConnectionsBenchmarkSession : NSObject <SubImapConnectionDelegate>
+@property SubImapConnection *connection;
+@property SubImapConnectionsBenchmarkSession *next;
+@property (weak) SubImapConnectionsBenchmark *benchmark;
+@property BOOL greeted;
+@property BOOL failed;
+
+// Opening, or waiting for a NOOP response
+@property BOOL pending;
+- (void)open;
+- (void)sendNoop;
+- (void)close;
+@end
+
+@implementation SubImapConnectionsBenchmarkSession
+
+- (void)open {
+  self.pending = YES;
+  [self.connection addDelegate:self];
+
+  if (![self.connection open]) {
+    [self fail];
+  }
+}
+
+- (void)sendNoop {
+  self.pending = YES;
+  [self.connection write:[SubImapConnectionData dataWithString:@"a NOOP\r\n"]];
+}
+
+- (void)close {
+  [self.connection removeDelegate:self];
+  [self.connection close];
+}
+
+- (void)settle {
+  if (!self.pending) return;
+
+  self.pending = NO;
+  [self.benchmark sessionDidSettle:self];
+}
+
+- (void)fail {
+  if (self.failed) return;
+
+  self.failed = YES;
+  [self settle];
+
+  if (!self.greeted) {
+    [self.next open];
+  }
+}
+
+- (void)connection:(SubImapConnection *)connection didReceiveResponseData:(NSData *)data {
+  if (!self.greeted) {
+    self.greeted = YES;
+    [self settle];
+    [self.next open];
+  }
+
+  // The tagged NOOP response
+  else if (((const char *)[data bytes])[0] == 'a') {
+    [self settle];
+  }
+}
+
+- (void)connection:(SubImapConnection *)connection didEncounterStreamError:(NSError *)error {
+  [self fail];
+}
+
+- (void)connectionDidClose:(SubImapConnection *)connection {
+  [self fail];
+}
+
+@end
+
+#pragma mark -
+
+@implementation SubImapConnectionsBenchmark {
+  dispatch_semaphore_t _semaphore;
+  volatile long _settled;
+  long _expected;
+}
+
+- (id)init {
+  self = [super init];
+
+  if (self) {
+    self.connectionCount = 1000;
+    self.threadCount = 1;
+    self.backend = SubImapEventLoopBackendDefault;
+    self.timeout = 60;
+  }
+
+  return self;
+}
+
+// Called on event loop threads as each session is greeted, answered or
+// fails
+- (void)sessionDidSettle:(SubImapConnectionsBenchmarkSession *)session {
+  if (__sync_add_and_fetch(&_settled, 1) == _expected) {
+    dispatch_semaphore_signal(_semaphore);
+  }
+}
+
+- (BOOL)waitForSessions:(long)expected {
+  if (__sync_fetch_and_add(&_settled, 0) >= expected) {
+    return YES;
+  }
+
+  return dispatch_semaphore_wait(_semaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.timeout * NSEC_PER_SEC))) == 0;
+}
+
+- (void)performOnEventLoops:(NSArray *)eventLoops sessions:(NSArray *)sessionsByLoop block:(void (^)(NSArray *sessions))block {
+  dispatch_semaphore_t done = dispatch_semaphore_create(0);
+
+  for (NSUInteger i = 0; i < eventLoops.count; i++) {
+    [eventLoops[i] performBlock:^{
+      block(sessionsByLoop[i]);
+      dispatch_semaphore_signal(done);
+    }];
+  }
+
+  for (NSUInteger i = 0; i < eventLoops.count; i++) {
+    dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+  }
+}
+
+- (NSDictionary *)runAgainstPort:(NSUInteger)port {
+  NSUInteger threadCount = MAX(self.threadCount, 1);
+  NSUInteger connectionCount = self.connectionCount;
+
+  SubImapBenchmarkRaiseDescriptorLimit();
+
+  NSMutableArray *eventLoops = [NSMutableArray array];
+  NSMutableArray *sessionsByLoop = [NSMutableArray array];
+
+  for (NSUInteger i = 0; i < threadCount; i++) {
+    SubImapEventLoop *eventLoop = [[SubImapEventLoop alloc] initWithBackend:self.backend];
+    [eventLoop start];
+
+    [eventLoops addObject:eventLoop];
+    [sessionsByLoop addObject:[NSMutableArray array]];
+  }
+
+  // Spread the connections over the event loops
+  for (NSUInteger i = 0; i < connectionCount; i++) {
+    SubImapConnectionsBenchmarkSession *session = [[SubImapConnectionsBenchmarkSession alloc] init];
+    session.connection = [SubImapConnection connectionWithHost:@"127.0.0.1" port:port security:SubImapConnectionSecurityNone];
+    session.connection.eventLoop = eventLoops[i % threadCount];
+    session.benchmark = self;
+
+    NSMutableArray *sessions = sessionsByLoop[i % threadCount];
+
+    if (sessions.count >= SUBIMAP_CONNECTIONS_BENCHMARK_CHAINS) {
+      [sessions[sessions.count - SUBIMAP_CONNECTIONS_BENCHMARK_CHAINS] setNext:session];
+    }
+
+    [sessions addObject:session];
+  }
+
+  long rssBefore = SubImapBenchmarkRSS();
+
+  // Connect
+  _semaphore = dispatch_semaphore_create(0);
+  _settled = 0;
+  _expected = connectionCount;
+
+  double start = SubImapBenchmarkNow();
+
+  [self performOnEventLoops:eventLoops sessions:sessionsByLoop block:^(NSArray *sessions) {
+    for (NSUInteger i = 0; i < MIN(sessions.count, SUBIMAP_CONNECTIONS_BENCHMARK_CHAINS); i++) {
+      [sessions[i] open];
+    }
+  }];
+
+  BOOL timedOut = ![self waitForSessions:_expected];
+  double connectSeconds = SubImapBenchmarkNow() - start;
+
+  long rssAfter = SubImapBenchmarkRSS();
+
+  __block long connected = 0;
+
+  [self performOnEventLoops:eventLoops sessions:sessionsByLoop block:^(NSArray *sessions) {
+    long greeted = 0;
+
+    for (SubImapConnectionsBenchmarkSession *session in sessions) {
+      if (session.greeted && !session.failed) greeted++;
+    }
+
+    __sync_add_and_fetch(&connected, greeted);
+  }];
+
+  // A NOOP on every connection at once
+  double noopSeconds = 0;
+
+  if (!timedOut && connected) {
+    _semaphore = dispatch_semaphore_create(0);
+    _settled = 0;
+    _expected = connected;
+
+    start = SubImapBenchmarkNow();
+
+    [self performOnEventLoops:eventLoops sessions:sessionsByLoop block:^(NSArray *sessions) {
+      for (SubImapConnectionsBenchmarkSession *session in sessions) {
+        if (session.greeted && !session.failed) [session sendNoop];
+      }
+    }];
+
+    timedOut = ![self waitForSessions:_expected];
+    noopSeconds = SubImapBenchmarkNow() - start;
+  }
+
+  // Clean up
+  [self performOnEventLoops:eventLoops sessions:sessionsByLoop block:^(NSArray *sessions) {
+    for (SubImapConnectionsBenchmarkSession *session in sessions) {
+      [session close];
+    }
+  }];
+
+  for (SubImapEventLoop *eventLoop in eventLoops) {
+    [eventLoop stop];
+  }
+
+  return @{
+    @"backend":                   [eventLoops[0] backend] == SubImapEventLoopBackendEpoll ? @"epoll" : @"poll",
+    @"threads":                   @(threadCount),
+    @"connections":               @(connectionCount),
+    @"connected":                 @(connected),
+    @"connect_seconds":           @(connectSeconds),
+    @"connections_per_sec":       @(connectSeconds > 0 ? connected / connectSeconds : 0),
+    @"connections_per_thread":    @((double)connected / threadCount),
+    @"bytes_per_idle_connection": @(connected ? (double)(rssAfter - rssBefore) * 1024 / connected : 0),
+    @"noop_seconds":              @(noopSeconds),
+    @"noops_per_sec":             @(noopSeconds > 0 ? connected / noopSeconds : 0),
+    @"peak_rss_kb":               @(SubImapBenchmarkPeakRSS()),
+    @"timed_out":                 @(timedOut),
+  };
+}
+
+@end
\ No newline at end of file
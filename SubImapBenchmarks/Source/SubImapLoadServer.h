@@ -0,0 +1,59 @@
+// SubImapLoadServer.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifdef GNUSTEP
+  #import "SubImapEventLoop.h"
+#else
+  #import <SubImap/SubImap.h>
+#endif
+
+/*
+ * SubImapLoadServer
+ *
+ * A stand-in IMAP server on the loopback interface for load tests, which
+ * holds thousands of mostly idle connections on a single
+ * SubImapEventLoop.
+ *
+ * It sends a greeting, answers every command line with a tagged OK, and
+ * closes the connection after LOGOUT. Literals are not supported.
+ */
+@interface SubImapLoadServer : NSObject
+
+/*
+ * The port the server is listening on, once started.
+ */
+@property (readonly) NSUInteger port;
+
+- (id)initWithEventLoop:(SubImapEventLoop *)eventLoop;
+
+/*
+ * Starts listening on 127.0.0.1. Pass 0 to pick any free port.
+ */
+- (BOOL)startOnPort:(NSUInteger)port;
+
+/*
+ * Stops listening and disconnects every client.
+ */
+- (void)stop;
+
+@end
\ No newline at end of file
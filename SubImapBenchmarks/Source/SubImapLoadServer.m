@@ -0,0 +1,279 @@
+// SubImapLoadServer.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapLoadServer.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef MSG_NOSIGNAL
+  #define SUBIMAP_SEND_FLAGS MSG_NOSIGNAL
+#else
+  #define SUBIMAP_SEND_FLAGS 0
+#endif
+
+static void SubImapLoadServerSetNonBlocking(int descriptor) {
+  fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL) | O_NONBLOCK);
+  fcntl(descriptor, F_SETFD, FD_CLOEXEC);
+}
+
+#pragma mark -
+
+/*
+ * One client connection, answering command lines as they arrive.
+ */
+@interface SubImapLoadServerClient : NSObject <SubImapEventLoopHandler>
+@property (readonly) int descriptor;
+- (id)initWithDescriptor:(int)descriptor eventLoop:(SubImapEventLoop *)eventLoop;
+- (void)close;
+@end
+
+@implementation SubImapLoadServerClient {
+  SubImapEventLoop *_eventLoop;
+  NSMutableData *_input;
+  NSMutableData *_output;
+  BOOL _closeAfterWriting;
+}
+
+- (id)initWithDescriptor:(int)descriptor eventLoop:(SubImapEventLoop *)eventLoop {
+  self = [super init];
+
+  if (self) {
+    _descriptor = descriptor;
+    _eventLoop = eventLoop;
+    _input = [NSMutableData data];
+    _output = [NSMutableData data];
+  }
+
+  return self;
+}
+
+- (void)close {
+  if (_descriptor < 0) {
+    return;
+  }
+
+  [_eventLoop removeDescriptor:_descriptor];
+  close(_descriptor);
+  _descriptor = -1;
+}
+
+- (void)writeString:(NSString *)string {
+  [_output appendData:[string dataUsingEncoding:NSASCIIStringEncoding]];
+  [self flush];
+}
+
+- (void)flush {
+  if (_output.length) {
+    ssize_t bytesWritten = send(_descriptor, [_output bytes], _output.length, SUBIMAP_SEND_FLAGS);
+
+    if (bytesWritten > 0) {
+      [_output replaceBytesInRange:NSMakeRange(0, bytesWritten) withBytes:NULL length:0];
+    }
+
+    else if (bytesWritten < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      [self close];
+      return;
+    }
+  }
+
+  if (!_output.length && _closeAfterWriting) {
+    [self close];
+    return;
+  }
+
+  // Wait for space for the rest
+  NSUInteger events = SubImapEventLoopEventRead;
+  if (_output.length) events |= SubImapEventLoopEventWrite;
+  [_eventLoop setEvents:events forDescriptor:_descriptor];
+}
+
+- (void)eventLoop:(SubImapEventLoop *)eventLoop handleEvents:(NSUInteger)events forDescriptor:(int)descriptor {
+  if (events & SubImapEventLoopEventWrite) {
+    [self flush];
+    if (_descriptor < 0) return;
+  }
+
+  if (!(events & (SubImapEventLoopEventRead | SubImapEventLoopEventError))) {
+    return;
+  }
+
+  uint8_t buffer[4096];
+  ssize_t bytesRead = recv(_descriptor, buffer, sizeof(buffer), 0);
+
+  if (bytesRead == 0 || (bytesRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+    [self close];
+    return;
+  }
+
+  if (bytesRead < 0) {
+    return;
+  }
+
+  [_input appendBytes:buffer length:bytesRead];
+
+  // Answer each complete line
+  for (;;) {
+    const char *bytes = [_input bytes];
+    const char *lf = memchr(bytes, '\n', _input.length);
+    if (!lf) break;
+
+    NSUInteger lineLength = lf - bytes + 1;
+    NSString *line = [[NSString alloc] initWithBytes:bytes length:lineLength encoding:NSASCIIStringEncoding];
+    [_input replaceBytesInRange:NSMakeRange(0, lineLength) withBytes:NULL length:0];
+
+    NSArray *words = [[line stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]] componentsSeparatedByString:@" "];
+    NSString *tag = words[0];
+
+    if (words.count > 1 && [words[1] caseInsensitiveCompare:@"LOGOUT"] == NSOrderedSame) {
+      _closeAfterWriting = YES;
+      [self writeString:[NSString stringWithFormat:@"* BYE Load server logging out\r\n%@ OK LOGOUT completed\r\n", tag]];
+      return;
+    }
+
+    [self writeString:[NSString stringWithFormat:@"%@ OK Completed\r\n", tag]];
+    if (_descriptor < 0) return;
+  }
+}
+
+@end
+
+#pragma mark -
+
+@interface SubImapLoadServer () <SubImapEventLoopHandler>
+@end
+
+@implementation SubImapLoadServer {
+  SubImapEventLoop *_eventLoop;
+  int _listenSocket;
+  NSMutableDictionary *_clients;
+}
+
+- (id)initWithEventLoop:(SubImapEventLoop *)eventLoop {
+  self = [super init];
+
+  if (self) {
+    _eventLoop = eventLoop;
+    _listenSocket = -1;
+    _clients = [NSMutableDictionary dictionary];
+  }
+
+  return self;
+}
+
+#pragma mark Listening
+
+- (BOOL)startOnPort:(NSUInteger)port {
+  if (_listenSocket >= 0) {
+    return NO;
+  }
+
+  int listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+  if (listenSocket < 0) {
+    return NO;
+  }
+
+  int yes = 1;
+  setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons((uint16_t)port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  socklen_t addressLength = sizeof(address);
+
+  // A long backlog, since clients connect in bursts
+  if (bind(listenSocket, (struct sockaddr *)&address, addressLength) != 0 ||
+      listen(listenSocket, 1024) != 0 ||
+      getsockname(listenSocket, (struct sockaddr *)&address, &addressLength) != 0) {
+    close(listenSocket);
+    return NO;
+  }
+
+  SubImapLoadServerSetNonBlocking(listenSocket);
+
+  _listenSocket = listenSocket;
+  _port = ntohs(address.sin_port);
+
+  [_eventLoop performBlock:^{
+    [_eventLoop addDescriptor:listenSocket events:SubImapEventLoopEventRead handler:self];
+  }];
+
+  return YES;
+}
+
+- (void)stop {
+  int listenSocket = _listenSocket;
+  _listenSocket = -1;
+
+  if (listenSocket < 0) {
+    return;
+  }
+
+  [_eventLoop performBlock:^{
+    [_eventLoop removeDescriptor:listenSocket];
+    close(listenSocket);
+
+    for (SubImapLoadServerClient *client in [_clients allValues]) {
+      [client close];
+    }
+
+    [_clients removeAllObjects];
+  }];
+}
+
+#pragma mark SubImapEventLoopHandler
+
+- (void)eventLoop:(SubImapEventLoop *)eventLoop handleEvents:(NSUInteger)events forDescriptor:(int)descriptor {
+  int clientSocket;
+
+  while ((clientSocket = accept(descriptor, NULL, NULL)) >= 0) {
+    SubImapLoadServerSetNonBlocking(clientSocket);
+
+    int yes = 1;
+    setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+#ifdef SO_NOSIGPIPE
+    setsockopt(clientSocket, SOL_SOCKET, SO_NOSIGPIPE, &yes, sizeof(yes));
+#endif
+
+    SubImapLoadServerClient *client = [[SubImapLoadServerClient alloc] initWithDescriptor:clientSocket eventLoop:eventLoop];
+
+    if (![eventLoop addDescriptor:clientSocket events:SubImapEventLoopEventRead handler:client]) {
+      close(clientSocket);
+      continue;
+    }
+
+    // Replaces any closed client that had the same descriptor
+    _clients[@(clientSocket)] = client;
+    [client writeString:@"* OK Load server ready\r\n"];
+  }
+}
+
+@end
\ No newline at end of file
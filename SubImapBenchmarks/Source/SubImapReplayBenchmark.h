@@ -0,0 +1,103 @@
+// SubImapReplayBenchmark.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapReplayServer.h"
+
+#ifdef GNUSTEP
+  #import "SubImapConnection.h"
+#else
+  #import <SubImap/SubImap.h>
+#endif
+
+/*
+ * SubImapReplayBenchmark
+ *
+ * Measures a SubImapConnection end to end against a SubImapReplayServer
+ * replaying a corpus file: commands are written to a loopback socket, and
+ * every response is framed and parsed the same way SubImapClient does.
+ *
+ * With a pipelineDepth of 1, each command is sent once the previous one
+ * completes. Larger depths keep that many commands in flight at a time.
+ */
+@interface SubImapReplayBenchmark : NSObject <SubImapConnectionDelegate>
+
+/*
+ * The corpus name, which is its file name without the extension.
+ */
+@property (readonly) NSString *name;
+
+/*
+ * The server replaying the corpus. Configure its latency, bandwidth and
+ * chunk size before running.
+ */
+@property (readonly) SubImapReplayServer *server;
+
+/*
+ * Number of commands sent per run.
+ *
+ * Defaults to 200.
+ */
+@property NSUInteger commandCount;
+
+/*
+ * Number of commands in flight at a time.
+ *
+ * Defaults to 1.
+ */
+@property NSUInteger pipelineDepth;
+
+/*
+ * Gives up on a run that takes longer than this.
+ *
+ * Defaults to 60 seconds.
+ */
+@property NSTimeInterval timeout;
+
++ (instancetype)benchmarkWithCorpusAtPath:(NSString *)path;
+- (id)initWithCorpusAtPath:(NSString *)path;
+
+/*
+ * Starts the server, connects to it and sends commandCount commands on
+ * the current run loop. Returns nil if the server can not be started.
+ *
+ *   "mode":             (NSString *) "serial" or "pipelined"
+ *   "corpus":           (NSString *) corpus name
+ *   "depth":            (NSNumber *) pipeline depth
+ *   "commands":         (NSNumber *) commands completed
+ *   "responses":        (NSNumber *) responses received
+ *   "bytes":            (NSNumber *) bytes received
+ *   "seconds":          (NSNumber *) time from the first command to the
+ *                                    last completion
+ *   "commands_per_sec": (NSNumber *)
+ *   "ttfb_ms":          (NSNumber *) mean time from writing a command, or
+ *                                    the previous completion if later, to
+ *                                    the first byte of its reply
+ *   "p50_ms", "p90_ms", "p99_ms", "max_ms":
+ *                       (NSNumber *) command latency, from writing a
+ *                                    command to its tagged response
+ *   "errors":           (NSNumber *) responses that failed to parse
+ *   "timed_out":        (NSNumber *) YES if the run did not finish
+ */
+- (NSDictionary *)run;
+
+@end
\ No newline at end of file
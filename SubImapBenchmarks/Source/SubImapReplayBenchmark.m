@@ -0,0 +1,260 @@
+// SubImapReplayBenchmark.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapReplayBenchmark.h"
+#import "SubImapBenchmark.h"
+
+#ifdef GNUSTEP
+  #import "SubImapConnectionData.h"
+  #import "SubImapParser.h"
+#endif
+
+@implementation SubImapReplayBenchmark {
+  SubImapConnection *_connection;
+  SubImapParser *_parser;
+
+  BOOL _receivedGreeting;
+  BOOL _done;
+
+  // Commands sent and completed so far; replies arrive in order, so the
+  // oldest command in flight is always the next to complete
+  NSUInteger _sent;
+  NSUInteger _completed;
+
+  // Per command timestamps
+  double *_sentAt;
+  double *_startedAt;
+  double *_firstByteAt;
+  double *_completedAt;
+
+  NSUInteger _responses;
+  NSUInteger _bytes;
+  NSUInteger _errors;
+}
+
++ (instancetype)benchmarkWithCorpusAtPath:(NSString *)path {
+  return [[self alloc] initWithCorpusAtPath:path];
+}
+
+- (id)initWithCorpusAtPath:(NSString *)path {
+  self = [super init];
+
+  if (self) {
+    _name = [[path lastPathComponent] stringByDeletingPathExtension];
+    _server = [SubImapReplayServer serverWithTranscriptAtPath:path];
+
+    if (!_server) {
+      return nil;
+    }
+
+    self.commandCount = 200;
+    self.pipelineDepth = 1;
+    self.timeout = 60;
+  }
+
+  return self;
+}
+
+- (void)dealloc {
+  [self freeTimestamps];
+}
+
+- (void)freeTimestamps {
+  free(_sentAt);
+  free(_startedAt);
+  free(_firstByteAt);
+  free(_completedAt);
+
+  _sentAt = _startedAt = _firstByteAt = _completedAt = NULL;
+}
+
+#pragma mark -
+
+- (NSDictionary *)run {
+  if (![_server startOnPort:0]) {
+    return nil;
+  }
+
+  // Reset
+  NSUInteger count = MAX(self.commandCount, 1);
+
+  [self freeTimestamps];
+  _sentAt = calloc(count, sizeof(double));
+  _startedAt = calloc(count, sizeof(double));
+  _firstByteAt = calloc(count, sizeof(double));
+  _completedAt = calloc(count, sizeof(double));
+
+  _receivedGreeting = NO;
+  _done = NO;
+  _sent = 0;
+  _completed = 0;
+  _responses = 0;
+  _bytes = 0;
+  _errors = 0;
+
+  _parser = [SubImapParser parser];
+
+  // Connect
+  _connection = [SubImapConnection connectionWithHost:@"127.0.0.1" port:_server.port security:SubImapConnectionSecurityNone];
+  [_connection addDelegate:self];
+  [_connection open];
+
+  double deadline = SubImapBenchmarkNow() + self.timeout;
+
+  while (!_done && SubImapBenchmarkNow() < deadline) @autoreleasepool {
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+  }
+
+  [_connection removeDelegate:self];
+  [_connection close];
+  _connection = nil;
+
+  [_server stop];
+
+  return [self results];
+}
+
+- (void)sendCommands {
+  NSUInteger count = MAX(self.commandCount, 1);
+  NSUInteger depth = MAX(self.pipelineDepth, 1);
+
+  while (_sent < count && _sent - _completed < depth) {
+    NSString *command = [NSString stringWithFormat:@"r%lu NOOP\r\n", (unsigned long)_sent];
+
+    double now = SubImapBenchmarkNow();
+    _sentAt[_sent] = now;
+
+    // Nothing is received for a command before the one ahead of it
+    // completes
+    _startedAt[_sent] = _completed == _sent ? now : 0;
+
+    _sent++;
+    [_connection write:[SubImapConnectionData dataWithString:command]];
+  }
+}
+
+- (NSDictionary *)results {
+  NSUInteger completed = _completed;
+  double seconds = completed ? _completedAt[completed - 1] - _sentAt[0] : 0;
+
+  // Latency percentiles
+  NSMutableArray *latencies = [NSMutableArray arrayWithCapacity:completed];
+  double ttfb = 0;
+
+  for (NSUInteger i = 0; i < completed; i++) {
+    [latencies addObject:@((_completedAt[i] - _sentAt[i]) * 1000)];
+    ttfb += (_firstByteAt[i] - _startedAt[i]) * 1000;
+  }
+
+  [latencies sortUsingSelector:@selector(compare:)];
+
+  NSNumber *(^percentile)(double) = ^NSNumber *(double p) {
+    if (!latencies.count) return @0;
+    return latencies[MIN(latencies.count - 1, (NSUInteger)(p * latencies.count))];
+  };
+
+  return @{
+    @"mode":             MAX(self.pipelineDepth, 1) == 1 ? @"serial" : @"pipelined",
+    @"corpus":           self.name,
+    @"depth":            @(MAX(self.pipelineDepth, 1)),
+    @"commands":         @(completed),
+    @"responses":        @(_responses),
+    @"bytes":            @(_bytes),
+    @"seconds":          @(seconds),
+    @"commands_per_sec": @(seconds > 0 ? completed / seconds : 0),
+    @"ttfb_ms":          @(completed ? ttfb / completed : 0),
+    @"p50_ms":           percentile(0.5),
+    @"p90_ms":           percentile(0.9),
+    @"p99_ms":           percentile(0.99),
+    @"max_ms":           latencies.count ? [latencies lastObject] : @0,
+    @"errors":           @(_errors),
+    @"timed_out":        @(!_done),
+  };
+}
+
+#pragma mark SubImapConnectionDelegate
+
+- (void)connectionDidClose:(SubImapConnection *)connection {
+  _done = YES;
+}
+
+- (void)connection:(SubImapConnection *)connection didEncounterStreamError:(NSError *)error {
+  _done = YES;
+}
+
+- (void)connection:(SubImapConnection *)connection didReceiveData:(NSData *)data {
+  _bytes += [data length];
+
+  if (_completed < _sent && !_firstByteAt[_completed]) {
+    _firstByteAt[_completed] = SubImapBenchmarkNow();
+  }
+}
+
+- (void)connection:(SubImapConnection *)connection didReceiveResponseData:(NSData *)data {
+  double now = SubImapBenchmarkNow();
+  _responses++;
+
+  NSError *error;
+  [_parser parseResponseData:data error:&error];
+  if (error) _errors++;
+
+  // The greeting starts the run
+  if (!_receivedGreeting) {
+    _receivedGreeting = YES;
+    [self sendCommands];
+    return;
+  }
+
+  if (_completed >= _sent) {
+    return;
+  }
+
+  // The reply to the oldest command in flight continues in this read
+  if (!_firstByteAt[_completed]) {
+    _firstByteAt[_completed] = now;
+  }
+
+  // Untagged responses and continuations don't complete a command
+  const char *bytes = [data bytes];
+  if (bytes[0] == '*' || bytes[0] == '+') {
+    return;
+  }
+
+  _completedAt[_completed] = now;
+  _completed++;
+
+  // The next command's reply starts once this one completes
+  if (_completed < _sent && !_startedAt[_completed]) {
+    _startedAt[_completed] = now;
+  }
+
+  if (_completed == MAX(self.commandCount, 1)) {
+    _done = YES;
+  }
+
+  else {
+    [self sendCommands];
+  }
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,91 @@
+// SubImapReplayServer.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/*
+ * SubImapReplayServer
+ *
+ * A scripted IMAP server on the loopback interface, which replays a
+ * recorded transcript so the client can be driven without a real host.
+ *
+ * The transcript is split into a greeting and a list of exchanges: the
+ * untagged responses leading up to each tagged response. Every command
+ * the server receives is answered with the next exchange, in order,
+ * wrapping around at the end, with the recorded tag replaced by the
+ * command's tag. The command itself is ignored, apart from LOGOUT, which
+ * closes the connection.
+ *
+ * Each client is served on its own thread with blocking sockets, so the
+ * server can share a process with a client on the main run loop.
+ */
+@interface SubImapReplayServer : NSObject
+
+/*
+ * The port the server is listening on, once started.
+ */
+@property (readonly) NSUInteger port;
+
+/*
+ * Number of exchanges in the transcript.
+ */
+@property (readonly) NSUInteger exchangeCount;
+
+/*
+ * Delay from a command arriving to the first byte of its reply,
+ * simulating the network round trip. Replies to pipelined commands
+ * overlap: each is due its latency after its own command arrived, not
+ * after the previous reply.
+ *
+ * Defaults to 0.
+ */
+@property NSTimeInterval latency;
+
+/*
+ * Caps the rate replies are written at. 0 for no limit.
+ *
+ * Defaults to 0.
+ */
+@property NSUInteger bytesPerSecond;
+
+/*
+ * Largest number of bytes written to the socket at a time, so responses
+ * reach the client fragmented, the way they do across a real network.
+ * 0 to write each reply at once.
+ *
+ * Defaults to 0.
+ */
+@property NSUInteger chunkSize;
+
++ (instancetype)serverWithTranscriptAtPath:(NSString *)path;
+- (id)initWithTranscript:(NSData *)transcript;
+
+/*
+ * Starts listening on 127.0.0.1. Pass 0 to pick any free port.
+ */
+- (BOOL)startOnPort:(NSUInteger)port;
+
+/*
+ * Stops listening and disconnects every client.
+ */
+- (void)stop;
+
+@end
\ No newline at end of file
@@ -0,0 +1,452 @@
+// SubImapReplayServer.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapReplayServer.h"
+
+#ifdef GNUSTEP
+  #import "SubImapResponseFramer.h"
+#else
+  #import <SubImap/SubImap.h>
+#endif
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef MSG_NOSIGNAL
+  #define SUBIMAP_SEND_FLAGS MSG_NOSIGNAL
+#else
+  #define SUBIMAP_SEND_FLAGS 0
+#endif
+
+@interface SubImapReplayServer ()
+- (BOOL)writeData:(NSData *)data toSocket:(int)clientSocket;
+@end
+
+
+/*
+ * Writes one client's replies on a thread of its own, each once it is
+ * due, so the latency of pipelined commands overlaps as it would on a
+ * network instead of adding up.
+ */
+@interface SubImapReplayWriter : NSObject
+
+- (id)initWithServer:(SubImapReplayServer *)server socket:(int)clientSocket;
+
+/*
+ * Replies are written in order, so due times have to be ascending.
+ */
+- (void)enqueueData:(NSData *)data due:(NSTimeInterval)due;
+
+/*
+ * Returns once every queued reply was written, or writing failed.
+ */
+- (void)finish;
+
+@end
+
+@implementation SubImapReplayWriter {
+  __weak SubImapReplayServer *_server;
+  int _socket;
+
+  // Guards everything below
+  NSCondition *_condition;
+
+  NSMutableArray *_replies;
+  NSMutableArray *_dueTimes;
+  BOOL _finishing;
+  BOOL _finished;
+}
+
+- (id)initWithServer:(SubImapReplayServer *)server socket:(int)clientSocket {
+  self = [super init];
+
+  if (self) {
+    _server = server;
+    _socket = clientSocket;
+    _condition = [[NSCondition alloc] init];
+    _replies = [NSMutableArray array];
+    _dueTimes = [NSMutableArray array];
+
+    [NSThread detachNewThreadSelector:@selector(writeReplies) toTarget:self withObject:nil];
+  }
+
+  return self;
+}
+
+- (void)enqueueData:(NSData *)data due:(NSTimeInterval)due {
+  [_condition lock];
+  [_replies addObject:data];
+  [_dueTimes addObject:@(due)];
+  [_condition signal];
+  [_condition unlock];
+}
+
+- (void)finish {
+  [_condition lock];
+  _finishing = YES;
+  [_condition signal];
+
+  while (!_finished) {
+    [_condition wait];
+  }
+
+  [_condition unlock];
+}
+
+- (void)writeReplies {
+  [_condition lock];
+
+  for (;;) @autoreleasepool {
+    if (!_replies.count) {
+      if (_finishing) break;
+
+      [_condition wait];
+      continue;
+    }
+
+    NSTimeInterval wait = [_dueTimes[0] doubleValue] - [NSDate timeIntervalSinceReferenceDate];
+
+    if (wait > 0) {
+      [_condition waitUntilDate:[NSDate dateWithTimeIntervalSinceNow:wait]];
+      continue;
+    }
+
+    NSData *reply = _replies[0];
+    [_replies removeObjectAtIndex:0];
+    [_dueTimes removeObjectAtIndex:0];
+
+    [_condition unlock];
+    BOOL written = [_server writeData:reply toSocket:_socket];
+    [_condition lock];
+
+    // The client went away, drop the rest
+    if (!written) {
+      [_replies removeAllObjects];
+      [_dueTimes removeAllObjects];
+    }
+  }
+
+  _finished = YES;
+  [_condition broadcast];
+  [_condition unlock];
+}
+
+@end
+
+
+@implementation SubImapReplayServer {
+  NSData *_greeting;
+
+  // Untagged responses before each tagged response, and the tagged
+  // response with its tag removed
+  NSMutableArray *_untagged;
+  NSMutableArray *_completions;
+
+  int _listenSocket;
+  NSMutableSet *_clientSockets;
+}
+
++ (instancetype)serverWithTranscriptAtPath:(NSString *)path {
+  NSData *transcript = [NSData dataWithContentsOfFile:path];
+  return transcript ? [[self alloc] initWithTranscript:transcript] : nil;
+}
+
+- (id)initWithTranscript:(NSData *)transcript {
+  self = [super init];
+
+  if (self) {
+    _untagged = [NSMutableArray array];
+    _completions = [NSMutableArray array];
+    _listenSocket = -1;
+    _clientSockets = [NSMutableSet set];
+
+    self.latency = 0;
+    self.bytesPerSecond = 0;
+    self.chunkSize = 0;
+
+    [self loadTranscript:transcript];
+  }
+
+  return self;
+}
+
+- (void)dealloc {
+  [self stop];
+}
+
+- (NSUInteger)exchangeCount {
+  return _completions.count;
+}
+
+#pragma mark Transcript
+
+- (void)loadTranscript:(NSData *)transcript {
+  NSArray *responses = [[SubImapResponseFramer framer] responsesByAppendingBytes:[transcript bytes] length:[transcript length]];
+  NSMutableData *untagged = [NSMutableData data];
+
+  for (NSData *response in responses) {
+    const char *bytes = [response bytes];
+    NSUInteger length = [response length];
+
+    // Greeting
+    if (!_greeting && !_completions.count && !untagged.length) {
+      if ((length > 5 && strncmp(bytes, "* OK ", 5) == 0) || (length > 10 && strncmp(bytes, "* PREAUTH ", 10) == 0)) {
+        _greeting = response;
+        continue;
+      }
+    }
+
+    // Untagged or continuation response
+    if (bytes[0] == '*' || bytes[0] == '+') {
+      [untagged appendData:response];
+      continue;
+    }
+
+    // Tagged response, keep everything after the tag
+    const char *space = memchr(bytes, ' ', length);
+    if (!space) continue;
+
+    [_untagged addObject:untagged];
+    [_completions addObject:[response subdataWithRange:NSMakeRange(space - bytes, length - (space - bytes))]];
+    untagged = [NSMutableData data];
+  }
+
+  // Untagged responses at the end of the transcript
+  if (untagged.length) {
+    [_untagged addObject:untagged];
+    [_completions addObject:[@" OK Completed\r\n" dataUsingEncoding:NSASCIIStringEncoding]];
+  }
+
+  if (!_greeting) {
+    _greeting = [@"* OK Replay server ready\r\n" dataUsingEncoding:NSASCIIStringEncoding];
+  }
+}
+
+#pragma mark Listening
+
+- (BOOL)startOnPort:(NSUInteger)port {
+  if (_listenSocket >= 0) {
+    return NO;
+  }
+
+  int listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+  if (listenSocket < 0) {
+    return NO;
+  }
+
+  int yes = 1;
+  setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons((uint16_t)port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  socklen_t addressLength = sizeof(address);
+
+  if (bind(listenSocket, (struct sockaddr *)&address, addressLength) != 0 ||
+      listen(listenSocket, 16) != 0 ||
+      getsockname(listenSocket, (struct sockaddr *)&address, &addressLength) != 0) {
+    close(listenSocket);
+    return NO;
+  }
+
+  _listenSocket = listenSocket;
+  _port = ntohs(address.sin_port);
+
+  [NSThread detachNewThreadSelector:@selector(acceptClients:) toTarget:self withObject:@(listenSocket)];
+  return YES;
+}
+
+- (void)stop {
+  if (_listenSocket >= 0) {
+    shutdown(_listenSocket, SHUT_RDWR);
+    close(_listenSocket);
+    _listenSocket = -1;
+  }
+
+  @synchronized (_clientSockets) {
+    for (NSNumber *clientSocket in _clientSockets) {
+      shutdown([clientSocket intValue], SHUT_RDWR);
+    }
+  }
+}
+
+- (void)acceptClients:(NSNumber *)listenSocket {
+  for (;;) {
+    int clientSocket = accept([listenSocket intValue], NULL, NULL);
+
+    // The server was stopped
+    if (clientSocket < 0) {
+      return;
+    }
+
+    int yes = 1;
+    setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+#ifdef SO_NOSIGPIPE
+    setsockopt(clientSocket, SOL_SOCKET, SO_NOSIGPIPE, &yes, sizeof(yes));
+#endif
+
+    @synchronized (_clientSockets) {
+      [_clientSockets addObject:@(clientSocket)];
+    }
+
+    [NSThread detachNewThreadSelector:@selector(serveClient:) toTarget:self withObject:@(clientSocket)];
+  }
+}
+
+#pragma mark Serving
+
+- (void)serveClient:(NSNumber *)clientSocketNumber {
+  int clientSocket = [clientSocketNumber intValue];
+  SubImapReplayWriter *writer = [[SubImapReplayWriter alloc] initWithServer:self socket:clientSocket];
+
+  [writer enqueueData:_greeting due:[NSDate timeIntervalSinceReferenceDate]];
+
+  NSMutableData *input = [NSMutableData data];
+  NSString *tag = nil;
+  NSUInteger literalBytesToRead = 0;
+  NSUInteger exchange = 0;
+  BOOL logout = NO;
+
+  uint8_t buffer[4096];
+  ssize_t bytesRead;
+
+  while (!logout && (bytesRead = recv(clientSocket, buffer, sizeof(buffer), 0)) > 0) @autoreleasepool {
+    [input appendBytes:buffer length:bytesRead];
+
+    // Replies to everything in this read are due a round trip from now
+    NSTimeInterval due = [NSDate timeIntervalSinceReferenceDate] + self.latency;
+
+    for (;;) {
+      // Skip literal data sent with a command
+      if (literalBytesToRead) {
+        NSUInteger skip = MIN(literalBytesToRead, input.length);
+        [input replaceBytesInRange:NSMakeRange(0, skip) withBytes:NULL length:0];
+        literalBytesToRead -= skip;
+
+        if (literalBytesToRead) break;
+      }
+
+      // Find the end of the next line
+      const char *bytes = [input bytes];
+      const char *lf = memchr(bytes, '\n', input.length);
+      if (!lf) break;
+
+      NSUInteger lineLength = lf - bytes + 1;
+      NSString *line = [[NSString alloc] initWithBytes:bytes length:lineLength encoding:NSASCIIStringEncoding];
+      [input replaceBytesInRange:NSMakeRange(0, lineLength) withBytes:NULL length:0];
+
+      line = [line stringByTrimmingCharactersInSet:[NSCharacterSet newlineCharacterSet]];
+
+      // The first line of a command starts with its tag
+      if (!tag) {
+        NSArray *words = [line componentsSeparatedByString:@" "];
+        tag = words[0];
+        logout = words.count > 1 && [words[1] caseInsensitiveCompare:@"LOGOUT"] == NSOrderedSame;
+      }
+
+      // The line ends with a literal, so the command continues after it
+      if ([line hasSuffix:@"}"]) {
+        NSRange brace = [line rangeOfString:@"{" options:NSBackwardsSearch];
+
+        if (brace.location != NSNotFound) {
+          NSString *marker = [line substringFromIndex:brace.location + 1];
+          literalBytesToRead = [marker integerValue];
+
+          // Synchronizing literals wait for a continuation response
+          if (![marker hasSuffix:@"+}"]) {
+            [writer enqueueData:[@"+ Ready for literal data\r\n" dataUsingEncoding:NSASCIIStringEncoding] due:due];
+          }
+
+          continue;
+        }
+      }
+
+      // The command is complete
+      if (logout) {
+        NSString *bye = [NSString stringWithFormat:@"* BYE Replay server logging out\r\n%@ OK LOGOUT completed\r\n", tag];
+        [writer enqueueData:[bye dataUsingEncoding:NSASCIIStringEncoding] due:due];
+        break;
+      }
+
+      [writer enqueueData:[self replyToTag:tag withExchange:exchange] due:due];
+      exchange = (exchange + 1) % MAX(_completions.count, 1);
+      tag = nil;
+    }
+  }
+
+  [writer finish];
+
+  @synchronized (_clientSockets) {
+    [_clientSockets removeObject:clientSocketNumber];
+  }
+
+  close(clientSocket);
+}
+
+- (NSData *)replyToTag:(NSString *)tag withExchange:(NSUInteger)exchange {
+  NSMutableData *reply = [NSMutableData data];
+
+  if (_completions.count) {
+    [reply appendData:_untagged[exchange]];
+    [reply appendData:[tag dataUsingEncoding:NSASCIIStringEncoding]];
+    [reply appendData:_completions[exchange]];
+  }
+
+  else {
+    [reply appendData:[[NSString stringWithFormat:@"%@ OK Completed\r\n", tag] dataUsingEncoding:NSASCIIStringEncoding]];
+  }
+
+  return reply;
+}
+
+- (BOOL)writeData:(NSData *)data toSocket:(int)clientSocket {
+  const uint8_t *bytes = [data bytes];
+  NSUInteger remaining = [data length];
+  NSUInteger chunkSize = self.chunkSize ?: remaining;
+  NSUInteger bytesPerSecond = self.bytesPerSecond;
+
+  while (remaining) {
+    ssize_t bytesWritten = send(clientSocket, bytes, MIN(chunkSize, remaining), SUBIMAP_SEND_FLAGS);
+
+    if (bytesWritten <= 0) {
+      return NO;
+    }
+
+    bytes += bytesWritten;
+    remaining -= bytesWritten;
+
+    if (bytesPerSecond) {
+      usleep((useconds_t)((double)bytesWritten / bytesPerSecond * 1e6));
+    }
+  }
+
+  return YES;
+}
+
+@end
\ No newline at end of file
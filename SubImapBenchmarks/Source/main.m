@@ -0,0 +1,350 @@
+// main.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// SubImapBenchmarks
+//
+// Runs each benchmark stage over each corpus file and prints one JSON
+// object per line, so results can be saved and compared against a
+// baseline.
+//
+// Options:
+//   -corpus <dir>       Directory of *.imap transcripts
+//   -stage <name>       Only run one stage (framing, tokenizer, parser,
+//                       base64, qp)
+//   -only <corpus>      Only run one corpus
+//   -duration <sec>     Minimum time per stage and corpus (default 1)
+//   -chunk <bytes>      Framing and decoding read size (default 1024)
+//   -baseline <file>    Earlier output to compare responses_per_sec with
+//
+// Every stage and corpus runs in its own process, so peak RSS is reported
+// separately for each of them.
+//
+// With -replay YES, each corpus is instead served by a loopback
+// SubImapReplayServer, and commands are sent to it through
+// SubImapConnection, first one at a time and then pipelined:
+//
+//   -commands <n>       Commands sent per run (default 200)
+//   -depth <n>          Commands in flight when pipelined (default 16)
+//   -latency <ms>       Round trip from each command to its reply (default 0)
+//   -bandwidth <bytes>  Server bytes per second, 0 for no limit (default 0)
+//   -fragment <bytes>   Largest server write (default 0, whole replies)
+//
+// With -connections <n>, that many idle connections are held open on
+// SubImapEventLoop threads against a SubImapLoadServer in a child process,
+// measuring connections per thread and memory per idle connection:
+//
+//   -threads <n>        Event loop threads (default 1)
+//   -backend <name>     epoll or poll (default epoll where available)
+//
+// -loadserver YES runs only the SubImapLoadServer, printing its port and
+// serving until standard input is closed.
+
+#import "SubImapBenchmark.h"
+#import "SubImapConnectionsBenchmark.h"
+#import "SubImapLoadServer.h"
+#import "SubImapReplayBenchmark.h"
+
+static NSString *SubImapBenchmarkFormatResult(NSDictionary *result, NSDictionary *baseline) {
+  NSMutableString *line = [NSMutableString stringWithFormat:
+    @"{\"stage\":\"%@\",\"corpus\":\"%@\",\"responses\":%lu,\"bytes\":%.0f,\"seconds\":%.4f,"
+    @"\"responses_per_sec\":%.1f,\"mb_per_sec\":%.3f,\"allocs_per_response\":%.2f,\"peak_rss_kb\":%ld,\"errors\":%lu",
+    result[@"stage"], result[@"corpus"],
+    [result[@"responses"] unsignedLongValue], [result[@"bytes"] doubleValue], [result[@"seconds"] doubleValue],
+    [result[@"responses_per_sec"] doubleValue], [result[@"mb_per_sec"] doubleValue],
+    [result[@"allocs_per_response"] doubleValue], [result[@"peak_rss_kb"] longValue],
+    [result[@"errors"] unsignedLongValue]];
+
+  if (baseline) {
+    double before = [baseline[@"responses_per_sec"] doubleValue];
+    double after = [result[@"responses_per_sec"] doubleValue];
+    [line appendFormat:@",\"baseline_responses_per_sec\":%.1f,\"change_pct\":%.1f", before, before > 0 ? (after - before) / before * 100 : 0];
+  }
+
+  [line appendString:@"}"];
+  return line;
+}
+
+static NSString *SubImapBenchmarkFormatReplayResult(NSDictionary *result) {
+  return [NSString stringWithFormat:
+    @"{\"mode\":\"%@\",\"corpus\":\"%@\",\"depth\":%lu,\"commands\":%lu,\"responses\":%lu,\"bytes\":%lu,\"seconds\":%.4f,"
+    @"\"commands_per_sec\":%.1f,\"ttfb_ms\":%.3f,\"p50_ms\":%.3f,\"p90_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f,\"errors\":%lu,\"timed_out\":%@}",
+    result[@"mode"], result[@"corpus"], [result[@"depth"] unsignedLongValue],
+    [result[@"commands"] unsignedLongValue], [result[@"responses"] unsignedLongValue], [result[@"bytes"] unsignedLongValue],
+    [result[@"seconds"] doubleValue], [result[@"commands_per_sec"] doubleValue], [result[@"ttfb_ms"] doubleValue],
+    [result[@"p50_ms"] doubleValue], [result[@"p90_ms"] doubleValue], [result[@"p99_ms"] doubleValue], [result[@"max_ms"] doubleValue],
+    [result[@"errors"] unsignedLongValue], [result[@"timed_out"] boolValue] ? @"true" : @"false"];
+}
+
+static int SubImapBenchmarkRunReplay(NSString *corpusPath, NSArray *corpora, NSUserDefaults *args) {
+  NSUInteger depth = [args objectForKey:@"depth"] ? [args integerForKey:@"depth"] : 16;
+  int status = 0;
+
+  for (NSString *corpus in corpora) {
+    for (NSNumber *pipelineDepth in @[@1, @(MAX(depth, 2))]) {
+      NSString *path = [[corpusPath stringByAppendingPathComponent:corpus] stringByAppendingPathExtension:@"imap"];
+      SubImapReplayBenchmark *benchmark = [SubImapReplayBenchmark benchmarkWithCorpusAtPath:path];
+
+      if (!benchmark) {
+        fprintf(stderr, "Unable to read corpus '%s'.\n", [path UTF8String]);
+        return 1;
+      }
+
+      benchmark.pipelineDepth = [pipelineDepth unsignedIntegerValue];
+      if ([args objectForKey:@"commands"]) benchmark.commandCount = [args integerForKey:@"commands"];
+
+      benchmark.server.latency = [args doubleForKey:@"latency"] / 1000;
+      benchmark.server.bytesPerSecond = [args integerForKey:@"bandwidth"];
+      benchmark.server.chunkSize = [args integerForKey:@"fragment"];
+
+      NSDictionary *result = [benchmark run];
+
+      if (!result) {
+        fprintf(stderr, "Unable to start the replay server for corpus '%s'.\n", [corpus UTF8String]);
+        return 1;
+      }
+
+      if ([result[@"timed_out"] boolValue]) {
+        status = 1;
+      }
+
+      printf("%s\n", [SubImapBenchmarkFormatReplayResult(result) UTF8String]);
+      fflush(stdout);
+    }
+  }
+
+  return status;
+}
+
+static NSString *SubImapBenchmarkFormatConnectionsResult(NSDictionary *result) {
+  return [NSString stringWithFormat:
+    @"{\"mode\":\"connections\",\"backend\":\"%@\",\"threads\":%lu,\"connections\":%lu,\"connected\":%lu,\"connect_seconds\":%.4f,"
+    @"\"connections_per_sec\":%.1f,\"connections_per_thread\":%.1f,\"bytes_per_idle_connection\":%.0f,"
+    @"\"noop_seconds\":%.4f,\"noops_per_sec\":%.1f,\"peak_rss_kb\":%ld,\"timed_out\":%@}",
+    result[@"backend"], [result[@"threads"] unsignedLongValue], [result[@"connections"] unsignedLongValue],
+    [result[@"connected"] unsignedLongValue], [result[@"connect_seconds"] doubleValue],
+    [result[@"connections_per_sec"] doubleValue], [result[@"connections_per_thread"] doubleValue],
+    [result[@"bytes_per_idle_connection"] doubleValue], [result[@"noop_seconds"] doubleValue],
+    [result[@"noops_per_sec"] doubleValue], [result[@"peak_rss_kb"] longValue],
+    [result[@"timed_out"] boolValue] ? @"true" : @"false"];
+}
+
+static SubImapEventLoopBackend SubImapBenchmarkBackendFromString(NSString *string) {
+  if ([string isEqualToString:@"epoll"]) return SubImapEventLoopBackendEpoll;
+  if ([string isEqualToString:@"poll"]) return SubImapEventLoopBackendPoll;
+  return SubImapEventLoopBackendDefault;
+}
+
+static int SubImapBenchmarkRunLoadServer(NSUserDefaults *args) {
+  SubImapBenchmarkRaiseDescriptorLimit();
+
+  SubImapEventLoop *eventLoop = [[SubImapEventLoop alloc] initWithBackend:SubImapBenchmarkBackendFromString([args stringForKey:@"backend"])];
+  SubImapLoadServer *server = [[SubImapLoadServer alloc] initWithEventLoop:eventLoop];
+
+  if (![eventLoop start] || ![server startOnPort:[args integerForKey:@"port"]]) {
+    fprintf(stderr, "Unable to start the load server.\n");
+    return 1;
+  }
+
+  printf("%lu\n", (unsigned long)server.port);
+  fflush(stdout);
+
+  // Serve until the parent process closes our input
+  [[NSFileHandle fileHandleWithStandardInput] readDataToEndOfFile];
+
+  [server stop];
+  [eventLoop stop];
+
+  return 0;
+}
+
+static int SubImapBenchmarkRunConnections(NSUserDefaults *args) {
+  // The server runs in its own process, so only client memory is measured
+  NSPipe *input = [NSPipe pipe];
+  NSPipe *output = [NSPipe pipe];
+  NSTask *task = [[NSTask alloc] init];
+  task.launchPath = [[NSBundle mainBundle] executablePath];
+  task.arguments = @[@"-loadserver", @"YES"];
+  task.standardInput = input;
+  task.standardOutput = output;
+
+  [task launch];
+
+  // The first line is the server's port
+  NSMutableData *portLine = [NSMutableData data];
+
+  while (!memchr([portLine bytes], '\n', [portLine length])) {
+    NSData *data = [[output fileHandleForReading] availableData];
+    if (![data length]) break;
+    [portLine appendData:data];
+  }
+
+  NSUInteger port = [[[NSString alloc] initWithData:portLine encoding:NSASCIIStringEncoding] integerValue];
+
+  if (!port) {
+    fprintf(stderr, "Unable to start the load server.\n");
+    [task terminate];
+    return 1;
+  }
+
+  SubImapConnectionsBenchmark *benchmark = [[SubImapConnectionsBenchmark alloc] init];
+  benchmark.connectionCount = [args integerForKey:@"connections"];
+  benchmark.backend = SubImapBenchmarkBackendFromString([args stringForKey:@"backend"]);
+  if ([args objectForKey:@"threads"]) benchmark.threadCount = [args integerForKey:@"threads"];
+
+  NSDictionary *result = [benchmark runAgainstPort:port];
+
+  [[input fileHandleForWriting] closeFile];
+  [task waitUntilExit];
+
+  printf("%s\n", [SubImapBenchmarkFormatConnectionsResult(result) UTF8String]);
+  fflush(stdout);
+
+  return [result[@"timed_out"] boolValue] ? 1 : 0;
+}
+
+static NSDictionary *SubImapBenchmarkLoadBaseline(NSString *path) {
+  NSMutableDictionary *baseline = [NSMutableDictionary dictionary];
+  NSString *contents = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:nil];
+
+  for (NSString *line in [contents componentsSeparatedByString:@"\n"]) {
+    NSData *data = [line dataUsingEncoding:NSUTF8StringEncoding];
+    if (![data length]) continue;
+
+    NSDictionary *result = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+    if (![result isKindOfClass:[NSDictionary class]]) continue;
+
+    NSString *key = [NSString stringWithFormat:@"%@/%@", result[@"stage"], result[@"corpus"]];
+    baseline[key] = result;
+  }
+
+  return baseline;
+}
+
+static NSDictionary *SubImapBenchmarkRunInChildProcess(NSString *stage, NSString *corpus, NSArray *options) {
+  NSMutableArray *arguments = [NSMutableArray arrayWithArray:options];
+  [arguments addObjectsFromArray:@[@"-stage", stage, @"-only", corpus]];
+
+  NSPipe *pipe = [NSPipe pipe];
+  NSTask *task = [[NSTask alloc] init];
+  task.launchPath = [[NSBundle mainBundle] executablePath];
+  task.arguments = arguments;
+  task.standardOutput = pipe;
+
+  [task launch];
+  NSData *output = [[pipe fileHandleForReading] readDataToEndOfFile];
+  [task waitUntilExit];
+
+  if ([task terminationStatus] != 0) {
+    return nil;
+  }
+
+  return [NSJSONSerialization JSONObjectWithData:output options:0 error:nil];
+}
+
+int main(int argc, const char *argv[]) {
+  @autoreleasepool {
+    NSUserDefaults *args = [NSUserDefaults standardUserDefaults];
+
+    NSString *corpusPath = [args stringForKey:@"corpus"];
+    if (!corpusPath) {
+      NSString *source = [[NSString stringWithUTF8String:__FILE__] stringByDeletingLastPathComponent];
+      corpusPath = [[source stringByAppendingPathComponent:@"../Resources/Corpus"] stringByStandardizingPath];
+    }
+
+    NSString *stageName = [args stringForKey:@"stage"];
+    NSString *only = [args stringForKey:@"only"];
+
+    if (stageName && [SubImapBenchmark stageFromString:stageName] == SubImapBenchmarkStageUnknown) {
+      fprintf(stderr, "Unknown stage '%s'.\n", [stageName UTF8String]);
+      return 1;
+    }
+
+    // Stand-in server for the connections benchmark
+    if ([args boolForKey:@"loadserver"]) {
+      return SubImapBenchmarkRunLoadServer(args);
+    }
+
+    // Idle connections on event loops
+    if ([args integerForKey:@"connections"] > 0) {
+      return SubImapBenchmarkRunConnections(args);
+    }
+
+    // End to end against the replay server
+    if ([args boolForKey:@"replay"]) {
+      NSArray *corpora = only ? @[only] : [SubImapBenchmark corpusNamesAtPath:corpusPath];
+      return SubImapBenchmarkRunReplay(corpusPath, corpora, args);
+    }
+
+    // Child process: run a single stage over a single corpus
+    if (stageName && only) {
+      NSString *path = [[corpusPath stringByAppendingPathComponent:only] stringByAppendingPathExtension:@"imap"];
+      SubImapBenchmark *benchmark = [SubImapBenchmark benchmarkWithCorpusAtPath:path];
+
+      if (!benchmark) {
+        fprintf(stderr, "Unable to read corpus '%s'.\n", [path UTF8String]);
+        return 1;
+      }
+
+      if ([args objectForKey:@"duration"]) benchmark.minimumDuration = [args doubleForKey:@"duration"];
+      if ([args objectForKey:@"chunk"]) benchmark.chunkSize = [args integerForKey:@"chunk"];
+
+      NSDictionary *result = [benchmark runStage:[SubImapBenchmark stageFromString:stageName]];
+      printf("%s\n", [SubImapBenchmarkFormatResult(result, nil) UTF8String]);
+      return 0;
+    }
+
+    // Parent process: run every stage and corpus in its own process
+    NSMutableArray *options = [NSMutableArray arrayWithObjects:@"-corpus", corpusPath, nil];
+    if ([args objectForKey:@"duration"]) [options addObjectsFromArray:@[@"-duration", [args stringForKey:@"duration"]]];
+    if ([args objectForKey:@"chunk"]) [options addObjectsFromArray:@[@"-chunk", [args stringForKey:@"chunk"]]];
+
+    NSArray *stages = stageName ? @[stageName] : @[@"framing", @"tokenizer", @"parser", @"base64", @"qp"];
+    NSArray *corpora = only ? @[only] : [SubImapBenchmark corpusNamesAtPath:corpusPath];
+    NSDictionary *baseline = [args stringForKey:@"baseline"] ? SubImapBenchmarkLoadBaseline([args stringForKey:@"baseline"]) : nil;
+
+    if (!corpora.count) {
+      fprintf(stderr, "No corpus files found in '%s'.\n", [corpusPath UTF8String]);
+      return 1;
+    }
+
+    int status = 0;
+
+    for (NSString *stage in stages) {
+      for (NSString *corpus in corpora) {
+        NSDictionary *result = SubImapBenchmarkRunInChildProcess(stage, corpus, options);
+
+        if (!result) {
+          fprintf(stderr, "Benchmark '%s' failed for corpus '%s'.\n", [stage UTF8String], [corpus UTF8String]);
+          status = 1;
+          continue;
+        }
+
+        NSDictionary *previous = baseline[[NSString stringWithFormat:@"%@/%@", stage, corpus]];
+        printf("%s\n", [SubImapBenchmarkFormatResult(result, previous) UTF8String]);
+        fflush(stdout);
+      }
+    }
+
+    return status;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+// SubImapClientTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapClientTests.h"
+
+#import <SubImap/SubImap.h>
+
+#import "SubImapTestTransport.h"
+
+// The IDLE command from the README, runnable before login
+@interface SubImapClientTestIdleCommand : SubImapCommand
+@end
+
+@implementation SubImapClientTestIdleCommand
+
+- (NSString *)name {
+  return @"IDLE";
+}
+
+- (BOOL)canExecuteInState:(SubImapClientState)state {
+  return state != SubImapClientStateDisconnected;
+}
+
+- (NSArray *)render {
+  SubImapCommandBuilder *builder = [self builder];
+  [builder appendCRLF];
+
+  return [builder dataList];
+}
+
+@end
+
+@implementation SubImapClientTests
+
+#pragma mark - Helpers
+
+// An open, unauthenticated client whose writes go straight out
+- (SubImapClient *)clientWithTransport:(SubImapTestTransport *)transport {
+  SubImapConnection *connection = [SubImapConnection connectionWithHost:@"127.0.0.1" port:143 security:SubImapConnectionSecurityNone];
+  connection.transport = transport;
+
+  SubImapClient *client = [SubImapClient clientWithConnection:connection];
+
+  [connection open];
+  [transport.delegate transportDidOpen:transport];
+  [transport.delegate transportHasSpaceAvailable:transport];
+
+  return client;
+}
+
+#pragma mark - Tests
+
+- (void)testCancelledAuthenticateIsAborted {
+  SubImapTestTransport *transport = [[SubImapTestTransport alloc] init];
+  SubImapClient *client = [self clientWithTransport:transport];
+
+  SubImapAuthenticateCommand *authenticate = [SubImapAuthenticateCommand commandWithPlainLogin:@"ann" password:@"secret"];
+  SubImapRawCommand *noop = [SubImapRawCommand commandWithString:@"NOOP"];
+  [client enqueueCommand:authenticate];
+  [client enqueueCommand:noop];
+
+  STAssertEqualObjects([transport writtenString], @"#0 AUTHENTICATE PLAIN\r\n", @"Incorrect AUTHENTICATE command.");
+
+  [authenticate cancel];
+  [transport.delegate transportHasSpaceAvailable:transport];
+
+  // Without SASL-IR the server asks for the credentials
+  [transport receiveString:@"+ Ready\r\n"];
+  STAssertEqualObjects([transport writtenString], @"#0 AUTHENTICATE PLAIN\r\n*\r\n", @"Cancelled AUTHENTICATE was not aborted.");
+
+  [transport.delegate transportHasSpaceAvailable:transport];
+  [transport receiveString:@"#0 BAD Authentication aborted\r\n"];
+
+  STAssertTrue([[transport writtenString] hasSuffix:@"#1 NOOP\r\n"], @"Queued command was not sent after the abort.");
+  STAssertTrue(client.state == SubImapClientStateUnauthenticated, @"Aborted AUTHENTICATE changed the state.");
+}
+
+- (void)testIdleCancelledBeforeContinuation {
+  SubImapTestTransport *transport = [[SubImapTestTransport alloc] init];
+  SubImapClient *client = [self clientWithTransport:transport];
+
+  SubImapClientTestIdleCommand *idle = [[SubImapClientTestIdleCommand alloc] init];
+  SubImapRawCommand *noop = [SubImapRawCommand commandWithString:@"NOOP"];
+  [client enqueueCommand:idle];
+  [client enqueueCommand:noop];
+
+  [idle cancel];
+  [transport.delegate transportHasSpaceAvailable:transport];
+  [transport receiveString:@"+ idling\r\n"];
+
+  STAssertTrue([[transport writtenString] hasSuffix:@"#1 NOOP\r\n"], @"Queued command was not sent after the cancelled IDLE.");
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,101 @@
+// SubImapCommandBuilderTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapCommandBuilderTests.h"
+
+#import <SubImap/SubImap.h>
+
+@implementation SubImapCommandBuilderTests
+
+- (NSString *)stringFromData:(SubImapConnectionData *)data {
+  return [[NSString alloc] initWithData:data.data encoding:NSUTF8StringEncoding];
+}
+
+- (void)testIntegers {
+  SubImapCommandBuilder *builder = [SubImapCommandBuilder builder];
+
+  [builder appendInteger:0];
+  [builder appendSP];
+  [builder appendInteger:-42];
+  [builder appendSP];
+  [builder appendUnsignedInteger:4294967296];
+
+  NSArray *dataList = [builder dataList];
+  STAssertTrue(dataList.count == 1, @"Builder split data without a literal.");
+  STAssertEqualObjects([self stringFromData:dataList[0]], @"0 -42 4294967296", @"Builder formatted integers incorrectly.");
+
+  STAssertEqualObjects([self stringFromData:[SubImapConnectionData dataWithInteger:-1234]], @"-1234", @"Integer data formatted incorrectly.");
+}
+
+- (void)testQuotedString {
+  SubImapCommandBuilder *builder = [SubImapCommandBuilder builder];
+  [builder appendQuotedString:@"a \"b\" \\c"];
+
+  NSArray *dataList = [builder dataList];
+  STAssertEqualObjects([self stringFromData:dataList[0]], @"\"a \\\"b\\\" \\\\c\"", @"Builder quoted a string incorrectly.");
+}
+
+- (void)testLiteralSplitsData {
+  NSData *literal = [@"secret" dataUsingEncoding:NSUTF8StringEncoding];
+  SubImapCommandBuilder *builder = [SubImapCommandBuilder builder];
+
+  [builder appendString:@"a1 LOGIN"];
+  [builder appendSP];
+  [builder appendLiteral:literal];
+  [builder appendSP];
+  [builder appendString:@"password"];
+  [builder appendCRLF];
+
+  NSArray *dataList = [builder dataList];
+  STAssertTrue(dataList.count == 3, @"Builder produced %lu objects.", dataList.count);
+  STAssertEqualObjects([self stringFromData:dataList[0]], @"a1 LOGIN ", @"Builder rendered incorrect data.");
+  STAssertTrue([dataList[1] isLiteral], @"Builder did not keep the literal.");
+  STAssertEqualObjects([dataList[1] data], literal, @"Builder changed the literal.");
+  STAssertEqualObjects([self stringFromData:dataList[2]], @" password\r\n", @"Builder rendered incorrect data.");
+
+  // The builder starts over
+  STAssertTrue([builder dataList].count == 0, @"Builder kept data after dataList.");
+}
+
+- (void)testCompressDataList {
+  NSArray *dataList = [SubImapConnectionData compressDataList:@[
+    [SubImapConnectionData dataWithString:@"a1"],
+    [SubImapConnectionData SP],
+    [SubImapConnectionData dataWithString:@"LOGIN"],
+    [SubImapConnectionData SP],
+    [SubImapConnectionData literalDataWithString:@"user" encoding:NSUTF8StringEncoding],
+    [SubImapConnectionData SP],
+    [SubImapConnectionData dataWithString:@"password"],
+    [SubImapConnectionData CRLF],
+  ]];
+
+  STAssertTrue(dataList.count == 3, @"Compressed list has %lu objects.", dataList.count);
+  STAssertEqualObjects([self stringFromData:dataList[0]], @"a1 LOGIN ", @"Compressed data is incorrect.");
+  STAssertEqualObjects([self stringFromData:dataList[2]], @" password\r\n", @"Compressed data is incorrect.");
+
+  // The shared objects are left alone
+  STAssertEqualObjects([self stringFromData:[SubImapConnectionData SP]], @" ", @"Compressing modified SP.");
+  STAssertEqualObjects([self stringFromData:[SubImapConnectionData CRLF]], @"\r\n", @"Compressing modified CRLF.");
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,83 @@
+// SubImapConnectionTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapConnectionTests.h"
+
+#import <SubImap/SubImap.h>
+
+#import "SubImapTestTransport.h"
+
+@implementation SubImapConnectionTests
+
+- (void)testReadingPausesAtHighWaterMark {
+  SubImapTestTransport *transport = [[SubImapTestTransport alloc] init];
+
+  SubImapConnection *connection = [SubImapConnection connectionWithHost:@"127.0.0.1" port:143 security:SubImapConnectionSecurityNone];
+  connection.transport = transport;
+  connection.readHighWaterMark = 1000;
+  connection.readLowWaterMark = 200;
+
+  STAssertTrue([connection open], @"Connection did not open.");
+
+  [connection holdBytes:600];
+  STAssertFalse(transport.readingPaused, @"Reading paused below the high-water mark.");
+
+  [connection holdBytes:600];
+  STAssertTrue(transport.readingPaused, @"Reading not paused above the high-water mark.");
+  STAssertTrue(connection.heldBytes == 1200, @"Incorrect held bytes %lu.", (unsigned long)connection.heldBytes);
+
+  [connection releaseBytes:800];
+  STAssertTrue(transport.readingPaused, @"Reading resumed above the low-water mark.");
+
+  [connection releaseBytes:200];
+  STAssertFalse(transport.readingPaused, @"Reading not resumed at the low-water mark.");
+}
+
+- (void)testStartTLS {
+  SubImapTestTransport *transport = [[SubImapTestTransport alloc] init];
+
+  SubImapConnection *connection = [SubImapConnection connectionWithHost:@"127.0.0.1" port:143 security:SubImapConnectionSecurityStartTLS];
+  connection.transport = transport;
+
+  STAssertTrue([connection open], @"Connection did not open.");
+
+  [transport receiveString:@"* OK IMAP4rev1 ready\r\n"];
+  [transport receiveString:@"tls0 OK Begin TLS negotiation now\r\n"];
+  STAssertTrue(transport.startedTLS, @"TLS not started after the STARTTLS response.");
+}
+
+- (void)testStartTLSFailsWithBytesAfterResponse {
+  SubImapTestTransport *transport = [[SubImapTestTransport alloc] init];
+
+  SubImapConnection *connection = [SubImapConnection connectionWithHost:@"127.0.0.1" port:143 security:SubImapConnectionSecurityStartTLS];
+  connection.transport = transport;
+
+  STAssertTrue([connection open], @"Connection did not open.");
+
+  // Injected in plain text after the response, before the handshake
+  [transport receiveString:@"* OK IMAP4rev1 ready\r\n"];
+  [transport receiveString:@"tls0 OK Begin TLS negotiation now\r\n* CAPABILITY IMAP4rev1\r\n"];
+  STAssertFalse(transport.startedTLS, @"TLS started with bytes after the STARTTLS response.");
+}
+
+@end
\ No newline at end of file
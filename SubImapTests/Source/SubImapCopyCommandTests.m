@@ -0,0 +1,113 @@
+// SubImapCopyCommandTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapCopyCommandTests.h"
+
+#import <SubImap/SubImap.h>
+
+#import "SubImapCommand+TestRendering.h"
+
+@implementation SubImapCopyCommandTests
+
+- (NSIndexSet *)UIDs {
+  NSMutableIndexSet *UIDs = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(1, 10000)];
+  [UIDs addIndex:10005];
+  return UIDs;
+}
+
+- (void)testRenderStore {
+  SubImapStoreCommand *command = [SubImapStoreCommand commandWithUIDs:[self UIDs] flags:@[@"\\Seen", @"$Filed"] operation:SubImapStoreOperationAdd];
+  command.tag = @"a1";
+
+  STAssertEqualObjects([command renderedString], @"a1 UID STORE 1:10000,10005 +FLAGS.SILENT (\\Seen $Filed)\r\n", @"Incorrect STORE command.");
+
+  command = [SubImapStoreCommand commandWithSequenceNumbers:[NSIndexSet indexSetWithIndex:4] flags:@[] operation:SubImapStoreOperationReplace];
+  command.tag = @"a2";
+  command.silent = NO;
+
+  STAssertEqualObjects([command renderedString], @"a2 STORE 4 FLAGS ()\r\n", @"Incorrect non-silent STORE command.");
+}
+
+- (void)testCopyWithCopyUID {
+  SubImapCopyCommand *command = [SubImapCopyCommand commandWithUIDs:[self UIDs] mailbox:@"Archive 2013"];
+  command.tag = @"a1";
+
+  STAssertEqualObjects([command renderedString], @"a1 UID COPY 1:10000,10005 \"Archive 2013\"\r\n", @"Incorrect COPY command.");
+
+  NSDictionary *copyUIDs = @{
+    @"uidvalidity": @38505,
+    @"source": @[@4, @5],
+    @"destination": @[@100, @101],
+  };
+
+  [command handleResponse:[SubImapResponse responseWithStatus:YES type:SubImapResponseTypeOk tag:@"a1" data:@{@"code": @"COPYUID", @"copyuid": copyUIDs}]];
+
+  STAssertNil(command.error, @"Copy failed.");
+  STAssertEqualObjects(command.result[@"uidvalidity"], @38505, @"Incorrect UID validity.");
+  STAssertEqualObjects(command.result[@"uids"], (@{@4: @100, @5: @101}), @"Incorrect UID mapping.");
+}
+
+- (void)testCopyUIDsInServerOrder {
+  NSDictionary *copyUIDs = @{@"uidvalidity": @9, @"source": @[@5, @3], @"destination": @[@10, @11]};
+  NSDictionary *result = [SubImapCopyCommand resultWithCopyUIDs:copyUIDs];
+
+  STAssertEqualObjects(result[@"uids"], (@{@5: @10, @3: @11}), @"UIDs were not paired in the listed order.");
+}
+
+- (void)testMove {
+  SubImapMoveCommand *command = [SubImapMoveCommand commandWithUIDs:[NSIndexSet indexSetWithIndex:7] mailbox:@"Trash"];
+  command.tag = @"a1";
+  command.capabilities = @[@"MOVE", @"UIDPLUS"];
+
+  STAssertEqualObjects([command renderedString], @"a1 UID MOVE 7 Trash\r\n", @"Incorrect MOVE command.");
+  STAssertFalse(command.copiedOnly, @"MOVE was reported as a copy.");
+
+  // COPYUID arrives untagged, before the expunge
+  NSDictionary *copyUIDs = @{@"uidvalidity": @2, @"source": @[@7], @"destination": @[@30]};
+  [command handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeOk data:@{@"code": @"COPYUID", @"copyuid": copyUIDs}]];
+  [command handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeExpunge data:@3]];
+  [command handleResponse:[SubImapResponse responseWithStatus:YES type:SubImapResponseTypeOk tag:@"a1" data:@{}]];
+
+  STAssertEqualObjects(command.result[@"uids"], (@{@7: @30}), @"Untagged COPYUID was not used.");
+}
+
+- (void)testMoveWithoutSupport {
+  SubImapMoveCommand *command = [SubImapMoveCommand commandWithUIDs:[NSIndexSet indexSetWithIndex:7] mailbox:@"Trash"];
+  command.tag = @"a1";
+
+  STAssertEqualObjects([command renderedString], @"a1 UID COPY 7 Trash\r\n", @"MOVE was sent without support.");
+  STAssertTrue(command.copiedOnly, @"Copy was not reported.");
+
+  [command handleResponse:[SubImapResponse responseWithStatus:NO type:SubImapResponseTypeNo tag:@"a1" data:@{@"code": @"TRYCREATE"}]];
+
+  STAssertEquals(command.error.code, (NSInteger)SubImapMoveCommandFailedError, @"Incorrect error code.");
+}
+
+- (void)testRenderUIDExpunge {
+  SubImapExpungeCommand *command = [SubImapExpungeCommand commandWithUIDs:[self UIDs]];
+  command.tag = @"a1";
+
+  STAssertEqualObjects([command renderedString], @"a1 UID EXPUNGE 1:10000,10005\r\n", @"Incorrect UID EXPUNGE command.");
+}
+
+@end
\ No newline at end of file
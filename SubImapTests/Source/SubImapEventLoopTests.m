@@ -0,0 +1,103 @@
+// SubImapEventLoopTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapEventLoopTests.h"
+
+#import <SubImap/SubImap.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+@interface SubImapEventLoopTestHandler : NSObject <SubImapEventLoopHandler>
+@property dispatch_semaphore_t semaphore;
+@property NSUInteger events;
+@property BOOL calledOnEventLoop;
+@end
+
+@implementation SubImapEventLoopTestHandler
+
+- (void)eventLoop:(SubImapEventLoop *)eventLoop handleEvents:(NSUInteger)events forDescriptor:(int)descriptor {
+  char buffer[16];
+  read(descriptor, buffer, sizeof(buffer));
+
+  self.events = events;
+  self.calledOnEventLoop = [eventLoop isCurrentThread];
+  [eventLoop removeDescriptor:descriptor];
+
+  dispatch_semaphore_signal(self.semaphore);
+}
+
+@end
+
+@implementation SubImapEventLoopTests
+
+- (void)testPerformBlockRunsOnEventLoopThread {
+  SubImapEventLoop *eventLoop = [SubImapEventLoop eventLoop];
+  STAssertTrue([eventLoop start], @"Event loop did not start.");
+
+  dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+  __block BOOL calledOnEventLoop = NO;
+
+  [eventLoop performBlock:^{
+    calledOnEventLoop = [eventLoop isCurrentThread];
+    dispatch_semaphore_signal(semaphore);
+  }];
+
+  long timedOut = dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC));
+
+  STAssertTrue(!timedOut, @"Block was not performed.");
+  STAssertTrue(calledOnEventLoop, @"Block was not performed on the event loop thread.");
+
+  [eventLoop stop];
+}
+
+- (void)testReadEventsWithEachBackend {
+  for (NSNumber *backend in @[@(SubImapEventLoopBackendEpoll), @(SubImapEventLoopBackendPoll)]) {
+    SubImapEventLoop *eventLoop = [[SubImapEventLoop alloc] initWithBackend:[backend intValue]];
+    [eventLoop start];
+
+    int descriptors[2];
+    STAssertTrue(socketpair(AF_UNIX, SOCK_STREAM, 0, descriptors) == 0, @"Unable to create sockets.");
+
+    SubImapEventLoopTestHandler *handler = [[SubImapEventLoopTestHandler alloc] init];
+    handler.semaphore = dispatch_semaphore_create(0);
+
+    [eventLoop performBlock:^{
+      [eventLoop addDescriptor:descriptors[0] events:SubImapEventLoopEventRead handler:handler];
+    }];
+
+    write(descriptors[1], "a", 1);
+
+    long timedOut = dispatch_semaphore_wait(handler.semaphore, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC));
+
+    STAssertTrue(!timedOut, @"No read event with backend %d.", eventLoop.backend);
+    STAssertTrue(handler.events & SubImapEventLoopEventRead, @"Incorrect events %lu.", (unsigned long)handler.events);
+    STAssertTrue(handler.calledOnEventLoop, @"Handler was not called on the event loop thread.");
+
+    [eventLoop stop];
+    close(descriptors[0]);
+    close(descriptors[1]);
+  }
+}
+
+@end
\ No newline at end of file
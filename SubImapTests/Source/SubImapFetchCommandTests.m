@@ -0,0 +1,171 @@
+// SubImapFetchCommandTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapFetchCommandTests.h"
+
+#import <SubImap/SubImap.h>
+
+@implementation SubImapFetchCommandTests
+
+#pragma mark - Helpers
+
+- (SubImapResponse *)fetchResponseWithSequenceID:(NSInteger)sequenceID {
+  return [SubImapResponse responseWithType:SubImapResponseTypeFetch data:@{ @"sequenceID": @(sequenceID) }];
+}
+
+- (SubImapResponse *)okResponse {
+  return [SubImapResponse responseWithStatus:YES type:SubImapResponseTypeOk tag:@"#1" data:@{}];
+}
+
+#pragma mark - Tests
+
+- (void)testMessagesAreDeliveredInBatches {
+  SubImapFetchCommand *command = [SubImapFetchCommand commandWithAll];
+  command.batchSize = 2;
+
+  NSMutableArray *batches = [NSMutableArray array];
+  [command addMessagesBlock:^(NSArray *messages) {
+    [batches addObject:messages];
+  }];
+
+  [command handleResponse:[self fetchResponseWithSequenceID:1]];
+  STAssertTrue(batches.count == 0, @"Batch delivered before it was full.");
+
+  [command handleResponse:[self fetchResponseWithSequenceID:2]];
+  STAssertTrue(batches.count == 1, @"Full batch was not delivered.");
+
+  [command handleResponse:[self fetchResponseWithSequenceID:3]];
+  [command handleResponse:[self okResponse]];
+
+  STAssertTrue(batches.count == 2, @"Partial batch was not delivered on completion.");
+  STAssertTrue([batches[1] count] == 1, @"Incorrect partial batch size %lu.", [batches[1] count]);
+  STAssertTrue([command.result count] == 3, @"Retained messages missing from result.");
+}
+
+- (void)testMessagesAreNotRetained {
+  SubImapFetchCommand *command = [SubImapFetchCommand commandWithAll];
+  command.retainsMessages = NO;
+
+  __block NSUInteger delivered = 0;
+  [command addMessagesBlock:^(NSArray *messages) {
+    delivered += messages.count;
+  }];
+
+  [command handleResponse:[self fetchResponseWithSequenceID:1]];
+  [command handleResponse:[self fetchResponseWithSequenceID:2]];
+  [command handleResponse:[self okResponse]];
+
+  STAssertTrue(delivered == 2, @"Incorrect number of delivered messages %lu.", delivered);
+  STAssertTrue([command.result count] == 0, @"Messages were retained.");
+}
+
+- (void)testQueuedMessagesAreHeldOnConnection {
+  SubImapConnection *connection = [SubImapConnection connectionWithHost:@"127.0.0.1"];
+
+  SubImapFetchCommand *command = [SubImapFetchCommand commandWithAll];
+  command.connection = connection;
+  command.batchSize = 2;
+
+  __block NSUInteger heldWhenDelivered = 0;
+  [command addMessagesBlock:^(NSArray *messages) {
+    heldWhenDelivered = connection.heldBytes;
+  }];
+
+  SubImapResponse *response = [self fetchResponseWithSequenceID:1];
+  response.length = 100;
+
+  // Held once for the result and once for the batch
+  [command handleResponse:response];
+  STAssertTrue(connection.heldBytes == 200, @"Incorrect held bytes %lu.", (unsigned long)connection.heldBytes);
+
+  [command handleResponse:response];
+  STAssertTrue(heldWhenDelivered == 400, @"Incorrect held bytes during delivery %lu.", (unsigned long)heldWhenDelivered);
+  STAssertTrue(connection.heldBytes == 200, @"Delivered batch still held, %lu bytes.", (unsigned long)connection.heldBytes);
+
+  [command handleResponse:[self okResponse]];
+  STAssertTrue(connection.heldBytes == 0, @"Bytes still held after completion %lu.", (unsigned long)connection.heldBytes);
+}
+
+- (void)testPreviewFetchFromBodyStructure {
+  NSString *testString = @"* 12 FETCH (UID 40 BODYSTRUCTURE ("
+    @"((\"TEXT\" \"PLAIN\" (\"CHARSET\" \"UTF-8\") NIL NIL \"7BIT\" 2071 40 NIL NIL NIL NIL)"
+    @"(\"TEXT\" \"HTML\" (\"CHARSET\" \"UTF-8\") NIL NIL \"QUOTED-PRINTABLE\" 4619 97 NIL NIL NIL NIL) \"ALTERNATIVE\" (\"BOUNDARY\" \"b1\") NIL NIL NIL)"
+    @"(\"APPLICATION\" \"PDF\" (\"NAME\" \"a.pdf\") NIL NIL \"BASE64\" 881234 NIL (\"ATTACHMENT\" (\"FILENAME\" \"a.pdf\")) NIL NIL)"
+    @" \"MIXED\" (\"BOUNDARY\" \"b0\") NIL (\"EN\") NIL))\r\n";
+  NSData *testData = [testString dataUsingEncoding:NSASCIIStringEncoding];
+
+  NSError *error;
+  SubImapResponse *response = [[SubImapParser parser] parseResponseData:testData error:&error];
+  STAssertNil(error, @"Unable to parse response. %@", error);
+
+  NSDictionary *structure = response.data[@"bodystructure"];
+  NSArray *parts = [SubImapFetchCommand partsInBodyStructure:structure];
+  STAssertTrue(parts.count == 3, @"Incorrect part count %lu.", parts.count);
+  STAssertEqualObjects(parts[1][@"section"], @"1.2", @"Incorrect part number.");
+  STAssertEqualObjects(parts[2][@"disposition"][@"type"], @"ATTACHMENT", @"Disposition was not parsed.");
+  STAssertEqualObjects(structure[@"language"], @[@"EN"], @"Multipart language was not parsed.");
+
+  SubImapFetchCommand *command = [SubImapFetchCommand previewCommandWithUID:40 bodyStructure:structure length:2048];
+  STAssertEqualObjects(command.fields[1], @"BODY.PEEK[1.1]<0.2048>", @"Incorrect preview field.");
+}
+
+- (void)testPartsOfAttachedMessage {
+  NSDictionary *text = @{@"type": @"TEXT", @"subtype": @"PLAIN"};
+  NSDictionary *attached = @{@"type": @"MESSAGE", @"subtype": @"RFC822", @"message": @{@"type": @"MULTIPART", @"parts": @[text, text]}};
+  NSDictionary *structure = @{@"type": @"MULTIPART", @"parts": @[text, attached]};
+
+  NSArray *sections = [[SubImapFetchCommand partsInBodyStructure:structure] valueForKey:@"section"];
+  NSArray *expected = @[@"1", @"2", @"2.1", @"2.2"];
+  STAssertEqualObjects(sections, expected, @"Incorrect part numbers.");
+
+  NSArray *single = [[SubImapFetchCommand partsInBodyStructure:text] valueForKey:@"section"];
+  STAssertEqualObjects(single, @[@"1"], @"A single part body was not part 1.");
+}
+
+- (void)testBinaryFieldsFallBackToBody {
+  SubImapFetchCommand *command = [SubImapFetchCommand commandWithUIDs:@[@7]];
+  command.tag = @"a1";
+  command.fields = @[[SubImapFetchCommand fieldForBinarySizeOfSection:@"2"], [SubImapFetchCommand fieldForBinarySection:@"2" range:NSMakeRange(0, 4096)]];
+
+  NSString *rendered = [[NSString alloc] initWithData:[[command render][0] data] encoding:NSASCIIStringEncoding];
+  STAssertEqualObjects(rendered, @"a1 UID FETCH 7 (BODY.PEEK[2]<0.4096>)\r\n", @"BINARY was sent without support.");
+
+  command.capabilities = @[@"BINARY"];
+
+  rendered = [[NSString alloc] initWithData:[[command render][0] data] encoding:NSASCIIStringEncoding];
+  STAssertEqualObjects(rendered, @"a1 UID FETCH 7 (BINARY.SIZE[2] BINARY.PEEK[2]<0.4096>)\r\n", @"Incorrect BINARY fetch.");
+}
+
+- (void)testUIDSetIsSentAsRanges {
+  NSMutableIndexSet *UIDs = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(1, 500)];
+  [UIDs addIndex:502];
+
+  SubImapFetchCommand *command = [SubImapFetchCommand commandWithUIDSet:UIDs];
+  command.tag = @"a1";
+  command.fields = @[@"UID", @"X-GM-MSGID"];
+
+  NSString *rendered = [[NSString alloc] initWithData:[[command render][0] data] encoding:NSASCIIStringEncoding];
+  STAssertEqualObjects(rendered, @"a1 UID FETCH 1:500,502 (UID X-GM-MSGID)\r\n", @"Incorrect UID set.");
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,67 @@
+// SubImapHeaderParserTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapHeaderParserTests.h"
+
+#import <SubImap/SubImap.h>
+
+@implementation SubImapHeaderParserTests
+
+- (void)testUnfoldedCaseInsensitiveFields {
+  NSString *header = @"Subject: A long\r\n subject\r\nMESSAGE-ID:  <1@example.com> \r\nReferences: <a@example.com>\r\n\t<b@example.com>\r\n\r\nBody: not a field\r\n";
+  NSDictionary *headers = [SubImapHeaderParser headersFromString:header];
+
+  STAssertTrue(headers.count == 3, @"Incorrect field count %lu.", headers.count);
+  STAssertEqualObjects(headers[@"subject"], @"A long subject", @"Folded field was not unfolded.");
+  STAssertEqualObjects(headers[@"message-id"], @"<1@example.com>", @"Field name was not lowercased.");
+  STAssertEqualObjects(headers[@"references"], @"<a@example.com>\t<b@example.com>", @"Incorrect references.");
+}
+
+- (void)testFieldsSplitAcrossChunks {
+  NSData *data = [@"From: a@example.com\r\n (A)\r\nReceived: one\r\nReceived: two\r\n" dataUsingEncoding:NSASCIIStringEncoding];
+  SubImapHeaderParser *parser = [SubImapHeaderParser parser];
+
+  NSMutableArray *received = [NSMutableArray array];
+  parser.fieldBlock = ^(NSString *name, NSString *value, BOOL *stop) {
+    if ([name isEqualToString:@"received"]) [received addObject:value];
+  };
+
+  // One byte at a time, so every CRLF is split
+  for (NSUInteger i = 0; i < data.length; i++) {
+    [parser appendBytes:(const char *)[data bytes] + i length:1];
+  }
+
+  [parser finish];
+
+  STAssertTrue(parser.isComplete, @"Parser did not complete.");
+  STAssertEqualObjects(received, (@[@"one", @"two"]), @"Repeated fields were not all passed to the block.");
+}
+
+- (void)testLatin1Fallback {
+  const char bytes[] = "Subject: caf\xe9\r\n\r\n";
+  NSDictionary *headers = [SubImapHeaderParser headersFromData:[NSData dataWithBytes:bytes length:sizeof(bytes) - 1]];
+
+  STAssertEqualObjects(headers[@"subject"], @"café", @"Invalid UTF-8 was not read as ISO-8859-1.");
+}
+
+@end
\ No newline at end of file
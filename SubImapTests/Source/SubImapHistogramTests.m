@@ -0,0 +1,70 @@
+// SubImapHistogramTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapHistogramTests.h"
+
+#import <SubImap/SubImap.h>
+
+@implementation SubImapHistogramTests
+
+- (void)testPercentilesAreWithinRelativeError {
+  SubImapHistogram *histogram = [SubImapHistogram histogram];
+
+  for (uint64_t value = 1; value <= 100000; value++) {
+    [histogram recordValue:value * 1000];
+  }
+
+  STAssertTrue(histogram.count == 100000, @"Incorrect count %llu.", histogram.count);
+  STAssertTrue(histogram.min == 1000, @"Incorrect min %llu.", histogram.min);
+  STAssertTrue(histogram.max == 100000000, @"Incorrect max %llu.", histogram.max);
+
+  double percentiles[] = { 50, 90, 99, 99.9 };
+
+  for (NSUInteger i = 0; i < sizeof(percentiles) / sizeof(double); i++) {
+    double expected = percentiles[i] * 1000000;
+    double actual = [histogram valueAtPercentile:percentiles[i]];
+
+    STAssertTrue(fabs(actual - expected) / expected < 1.0 / 32, @"p%g is %g, expected %g.", percentiles[i], actual, expected);
+  }
+}
+
+- (void)testResetAndAddHistogram {
+  SubImapHistogram *a = [SubImapHistogram histogram];
+  SubImapHistogram *b = [SubImapHistogram histogram];
+
+  [a recordValue:10];
+  [b recordValue:20];
+  [b recordValue:30];
+
+  [a addHistogram:b];
+  STAssertTrue(a.count == 3, @"Incorrect count after adding %llu.", a.count);
+  STAssertTrue([a valueAtPercentile:100] == 30, @"Incorrect max percentile %llu.", [a valueAtPercentile:100]);
+
+  SubImapHistogram *copy = [a copy];
+  [a reset];
+
+  STAssertTrue(a.count == 0 && a.max == 0 && [a valueAtPercentile:50] == 0, @"Histogram was not reset.");
+  STAssertTrue(copy.count == 3, @"Copy was affected by reset.");
+}
+
+@end
\ No newline at end of file
@@ -13,14 +13,16 @@
 
 - (void)testRenderedLoginString {
   NSString *test = @"abcdefghijklmnopqrstuvwxyz1234567890";
-  NSData *testData = [test dataUsingEncoding:NSUTF8StringEncoding];
   SubImapLoginCommand *command = [SubImapLoginCommand commandWithLogin:test password:@"password"];
+  command.tag = @"a1";
   NSArray *output = [command render];
 
-  STAssertTrue(output.count == 8, @"Login command rendered incorrect connection data.");
+  // Without literals, the whole command is one buffer
+  STAssertTrue(output.count == 1, @"Login command rendered incorrect connection data.");
 
-  SubImapConnectionData *data = [output objectAtIndex:4];
-  STAssertTrue([data.data isEqualToData:testData], @"Login command rendered inccorect connection data.");
+  NSString *line = [NSString stringWithFormat:@"a1 LOGIN %@ password\r\n", test];
+  SubImapConnectionData *data = [output objectAtIndex:0];
+  STAssertTrue([data.data isEqualToData:[line dataUsingEncoding:NSUTF8StringEncoding]], @"Login command rendered inccorect connection data.");
   STAssertTrue(!data.isLiteral, @"Login command rendered inccorect connection data.");
 }
 
@@ -28,11 +30,13 @@
   NSString *test = @"abcdefghijklmnopqrstuvwxyz1234567890~!@#$%^&*()_+-=[]{}\\|\'\";:,./<>?";
   NSData *testData = [test dataUsingEncoding:NSUTF8StringEncoding];
   SubImapLoginCommand *command = [SubImapLoginCommand commandWithLogin:test password:@"password"];
+  command.tag = @"a1";
   NSArray *output = [command render];
 
-  STAssertTrue(output.count == 8, @"Login command rendered incorrect connection data.");
+  // The literal splits the command in three
+  STAssertTrue(output.count == 3, @"Login command rendered incorrect connection data.");
 
-  SubImapConnectionData *data = [output objectAtIndex:4];
+  SubImapConnectionData *data = [output objectAtIndex:1];
   STAssertTrue([data.data isEqualToData:testData], @"Login command rendered inccorect connection data.");
   STAssertTrue(data.isLiteral, @"Login command rendered inccorect connection data.");
 }
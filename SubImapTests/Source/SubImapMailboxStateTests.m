@@ -0,0 +1,118 @@
+// SubImapMailboxStateTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapMailboxStateTests.h"
+
+#import <SubImap/SubImap.h>
+
+@implementation SubImapMailboxStateTests
+
+// A mailbox of count messages, with UIDs 10, 20, 30...
+- (SubImapMailboxState *)stateWithCount:(NSUInteger)count {
+  SubImapMailboxState *state = [SubImapMailboxState stateWithPath:@"INBOX"];
+  [state handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeExists data:@(count)]];
+
+  for (NSUInteger i = 1; i <= count; i++) {
+    [state handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeFetch data:@{
+      @"sequenceID": @(i),
+      @"uid": @(i * 10),
+    }]];
+  }
+
+  return state;
+}
+
+- (void)testUIDMap {
+  SubImapMailboxState *state = [self stateWithCount:5];
+
+  STAssertTrue(state.count == 5, @"Incorrect count %lu.", state.count);
+  STAssertTrue([state UIDForSequenceNumber:3] == 30, @"Incorrect UID.");
+  STAssertTrue([state sequenceNumberForUID:40] == 4, @"Incorrect sequence number.");
+  STAssertTrue([state sequenceNumberForUID:35] == NSNotFound, @"Found a UID that does not exist.");
+  STAssertTrue(state.UIDNext == 51, @"Incorrect UIDNEXT %lu.", state.UIDNext);
+
+  // New messages have unknown UIDs
+  [state handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeExists data:@7]];
+  STAssertEqualObjects([state sequenceNumbersWithUnknownUIDs], [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(6, 2)], @"Incorrect unknown UIDs.");
+  STAssertTrue([state sequenceNumberForUID:50] == 5, @"Unknown UIDs broke the search.");
+}
+
+- (void)testExpunge {
+  SubImapMailboxState *state = [self stateWithCount:10];
+
+  // Messages 3, 4 and 5, the way servers usually send them
+  for (NSUInteger i = 0; i < 3; i++) {
+    [state handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeExpunge data:@3]];
+  }
+
+  // Then 8 and 7
+  [state handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeExpunge data:@5]];
+  [state handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeExpunge data:@4]];
+
+  STAssertTrue(state.count == 5, @"Incorrect count %lu.", state.count);
+
+  NSArray *expected = @[@10, @20, @60, @90, @100];
+
+  for (NSUInteger i = 0; i < expected.count; i++) {
+    STAssertTrue([state UIDForSequenceNumber:i + 1] == [expected[i] unsignedIntegerValue], @"Incorrect UID %lu at %lu.", [state UIDForSequenceNumber:i + 1], i + 1);
+  }
+}
+
+- (void)testVanished {
+  SubImapMailboxState *state = [self stateWithCount:4];
+
+  NSMutableIndexSet *UIDs = [NSMutableIndexSet indexSet];
+  [UIDs addIndex:20];
+  [UIDs addIndex:40];
+
+  [state handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeVanished data:@{
+    @"earlier": @NO,
+    @"uids": UIDs,
+  }]];
+
+  STAssertTrue(state.count == 2, @"Incorrect count %lu.", state.count);
+  STAssertTrue([state sequenceNumberForUID:30] == 2, @"Incorrect sequence number.");
+}
+
+- (void)testFlags {
+  SubImapMailboxState *state = [self stateWithCount:3];
+
+  [state handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeFetch data:@{
+    @"sequenceID": @1,
+    @"flags": @[@"\\Seen", @"$Important"],
+  }]];
+
+  [state handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeFetch data:@{
+    @"sequenceID": @2,
+    @"flags": @[],
+  }]];
+
+  NSArray *flags = [state flagsForSequenceNumber:1];
+  STAssertTrue(flags.count == 2, @"Incorrect flags %@.", flags);
+  STAssertNil([state flagsForSequenceNumber:3], @"Unknown flags were reported.");
+
+  STAssertEqualObjects([state sequenceNumbersWithFlag:@"\\SEEN"], [NSIndexSet indexSetWithIndex:1], @"Flags are not case-insensitive.");
+  STAssertEqualObjects([state sequenceNumbersWithoutFlag:@"\\Seen"], [NSIndexSet indexSetWithIndex:2], @"Incorrect unseen messages.");
+}
+
+@end
\ No newline at end of file
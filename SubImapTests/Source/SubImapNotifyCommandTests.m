@@ -0,0 +1,68 @@
+// SubImapNotifyCommandTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapNotifyCommandTests.h"
+
+#import <SubImap/SubImap.h>
+
+#import "SubImapCommand+TestRendering.h"
+
+@implementation SubImapNotifyCommandTests
+
+- (void)testRenderMailboxes {
+  SubImapNotifyCommand *command = [SubImapNotifyCommand commandWithMailboxes:@[@"INBOX", @"Sent Items"] events:SubImapNotifyEventFlagChange | SubImapNotifyEventMailboxName];
+  command.tag = @"a1";
+  command.selectedFetchAttributes = @[@"UID", @"FLAGS"];
+
+  NSString *expected = @"a1 NOTIFY SET STATUS (SELECTED (MessageNew (UID FLAGS) MessageExpunge FlagChange)) "
+                       @"(MAILBOXES (INBOX \"Sent Items\") (MessageNew MessageExpunge FlagChange MailboxName))\r\n";
+  STAssertEqualObjects([command renderedString], expected, @"Incorrect NOTIFY command.");
+}
+
+- (void)testRenderFilter {
+  SubImapNotifyCommand *command = [SubImapNotifyCommand commandWithFilter:@"personal" events:SubImapNotifyEventMessageNew];
+  command.tag = @"a1";
+  command.selectedEvents = 0;
+  command.sendsStatus = NO;
+
+  STAssertEqualObjects([command renderedString], @"a1 NOTIFY SET (SELECTED NONE) (PERSONAL (MessageNew))\r\n", @"Incorrect NOTIFY command.");
+
+  command = [SubImapNotifyCommand noneCommand];
+  command.tag = @"a2";
+
+  STAssertEqualObjects([command renderedString], @"a2 NOTIFY NONE\r\n", @"Incorrect NOTIFY NONE command.");
+}
+
+- (void)testInitialStatus {
+  SubImapNotifyCommand *command = [SubImapNotifyCommand commandWithMailboxes:@[@"INBOX"] events:SubImapNotifyEventMessageNew];
+  command.tag = @"a1";
+  [command render];
+
+  [command handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeStatus data:@{@"mailbox": @"INBOX", @"unseen": @2}]];
+  [command handleResponse:[SubImapResponse responseWithStatus:YES type:SubImapResponseTypeOk tag:@"a1" data:@{}]];
+
+  STAssertNil(command.error, @"Notify failed.");
+  STAssertEqualObjects(command.result[@"INBOX"][@"unseen"], @2, @"Initial status was not kept.");
+}
+
+@end
\ No newline at end of file
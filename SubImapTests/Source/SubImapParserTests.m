@@ -84,4 +84,253 @@
   STAssertTrue([data[@"message"] isEqualToString:@"Could not parse command"], @"Incorrect message '%@'.", data[@"message"]);
 }
 
+- (void)testVanishedEarlierResponse {
+  NSString *testString = @"* VANISHED (EARLIER) 41,43:45,50\r\n";
+  NSData *testData = [testString dataUsingEncoding:NSASCIIStringEncoding];
+
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizer];
+  SubImapParser *parser = [SubImapParser parserWithTokenizer:tokenizer];
+
+  NSError *error;
+  SubImapResponse *response = [parser parseResponseData:testData error:&error];
+
+  STAssertNil(error, @"Unable to parse response. %@", error);
+  STAssertTrue([response isType:SubImapResponseTypeVanished], @"Incorrect response type.");
+
+  id data = response.data;
+  STAssertTrue([data[@"earlier"] boolValue], @"EARLIER was not parsed.");
+  STAssertTrue([data[@"uids"] count] == 5, @"Incorrect UID count %lu.", [data[@"uids"] count]);
+  STAssertTrue([data[@"uids"] containsIndexesInRange:NSMakeRange(43, 3)], @"UID range was not parsed.");
+}
+
+- (void)testCopyUIDResponseCode {
+  NSString *testString = @"a1 OK [COPYUID 38505 304,319:320 3956:3958] Done\r\n";
+  NSData *testData = [testString dataUsingEncoding:NSASCIIStringEncoding];
+
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizer];
+  SubImapParser *parser = [SubImapParser parserWithTokenizer:tokenizer];
+
+  NSError *error;
+  SubImapResponse *response = [parser parseResponseData:testData error:&error];
+
+  STAssertNil(error, @"Unable to parse response. %@", error);
+  STAssertEqualObjects(response.data[@"code"], @"COPYUID", @"Incorrect code name.");
+  STAssertEqualObjects(response.data[@"message"], @"Done", @"Incorrect message.");
+
+  NSDictionary *UIDs = response.data[@"copyuid"];
+  STAssertEqualObjects(UIDs[@"uidvalidity"], @38505, @"Incorrect UID validity.");
+  STAssertEqualObjects(UIDs[@"source"], (@[@304, @319, @320]), @"Incorrect source UIDs %@.", UIDs[@"source"]);
+  STAssertEqualObjects(UIDs[@"destination"], (@[@3956, @3957, @3958]), @"Incorrect destination UIDs %@.", UIDs[@"destination"]);
+}
+
+- (void)testCopyUIDResponseCodeOrder {
+  NSString *testString = @"a1 OK [COPYUID 9 5,3 11:10] Done\r\n";
+  NSData *testData = [testString dataUsingEncoding:NSASCIIStringEncoding];
+
+  NSError *error;
+  SubImapResponse *response = [[SubImapParser parser] parseResponseData:testData error:&error];
+
+  STAssertNil(error, @"Unable to parse response. %@", error);
+  STAssertEqualObjects(response.data[@"copyuid"][@"source"], (@[@5, @3]), @"Source UIDs were reordered.");
+  STAssertEqualObjects(response.data[@"copyuid"][@"destination"], (@[@11, @10]), @"Descending range was not kept in order.");
+}
+
+- (void)testAppendUIDResponseCode {
+  NSString *testString = @"a2 OK [APPENDUID 38505 3955] APPEND completed\r\n";
+  NSData *testData = [testString dataUsingEncoding:NSASCIIStringEncoding];
+
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizer];
+  SubImapParser *parser = [SubImapParser parserWithTokenizer:tokenizer];
+
+  NSError *error;
+  SubImapResponse *response = [parser parseResponseData:testData error:&error];
+
+  STAssertNil(error, @"Unable to parse response. %@", error);
+  STAssertEqualObjects(response.data[@"code"], @"APPENDUID", @"Incorrect code name.");
+  STAssertEqualObjects(response.data[@"appenduid"][@"uidvalidity"], @38505, @"Incorrect UID validity.");
+  STAssertEqualObjects(response.data[@"appenduid"][@"destination"], @[@3955], @"Incorrect appended UID.");
+  STAssertNil(response.data[@"uidvalidity"], @"UIDVALIDITY was set by APPENDUID.");
+}
+
+- (void)testBadEventResponseCode {
+  NSString *testString = @"a1 NO [BADEVENT (MessageNew MessageExpunge)] Unsupported event\r\n";
+  NSData *testData = [testString dataUsingEncoding:NSASCIIStringEncoding];
+
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizer];
+  SubImapParser *parser = [SubImapParser parserWithTokenizer:tokenizer];
+
+  NSError *error;
+  SubImapResponse *response = [parser parseResponseData:testData error:&error];
+
+  STAssertNil(error, @"Unable to parse response. %@", error);
+  STAssertEqualObjects(response.data[@"code"], @"BADEVENT", @"Incorrect code name.");
+  STAssertEqualObjects(response.data[@"events"], (@[@"MessageNew", @"MessageExpunge"]), @"Incorrect supported events.");
+}
+
+- (void)testRenamedMailboxListResponse {
+  NSString *testString = @"* LIST () \"/\" \"Work/New\" (\"OLDNAME\" (\"Work/Old\"))\r\n";
+  NSData *testData = [testString dataUsingEncoding:NSASCIIStringEncoding];
+
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizer];
+  SubImapParser *parser = [SubImapParser parserWithTokenizer:tokenizer];
+
+  NSError *error;
+  SubImapResponse *response = [parser parseResponseData:testData error:&error];
+
+  STAssertNil(error, @"Unable to parse response. %@", error);
+  STAssertEqualObjects(response.data[@"path"], @"Work/New", @"Incorrect path.");
+  STAssertEqualObjects(response.data[@"oldname"], @"Work/Old", @"Incorrect old name.");
+}
+
+- (void)testEsearchResponse {
+  NSString *testString = @"* ESEARCH (TAG \"#12\") UID MIN 2 COUNT 4 ALL 2,10:12\r\n";
+  NSData *testData = [testString dataUsingEncoding:NSASCIIStringEncoding];
+
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizer];
+  SubImapParser *parser = [SubImapParser parserWithTokenizer:tokenizer];
+
+  NSError *error;
+  SubImapResponse *response = [parser parseResponseData:testData error:&error];
+
+  STAssertNil(error, @"Unable to parse response. %@", error);
+  STAssertTrue([response isType:SubImapResponseTypeEsearch], @"Incorrect response type.");
+
+  id data = response.data;
+  STAssertEqualObjects(data[@"tag"], @"#12", @"Incorrect correlator tag.");
+  STAssertTrue([data[@"uid"] boolValue], @"UID was not parsed.");
+  STAssertEqualObjects(data[@"min"], @2, @"Incorrect MIN.");
+  STAssertEqualObjects(data[@"count"], @4, @"Incorrect COUNT.");
+  STAssertTrue([data[@"all"] count] == 4 && [data[@"all"] containsIndex:11], @"Incorrect ALL %@.", data[@"all"]);
+}
+
+- (void)testSearchResponse {
+  NSString *testString = @"* SEARCH 2 3 4 9\r\n";
+  NSData *testData = [testString dataUsingEncoding:NSASCIIStringEncoding];
+
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizer];
+  SubImapParser *parser = [SubImapParser parserWithTokenizer:tokenizer];
+
+  NSError *error;
+  SubImapResponse *response = [parser parseResponseData:testData error:&error];
+
+  STAssertNil(error, @"Unable to parse response. %@", error);
+
+  NSIndexSet *data = response.data;
+  STAssertTrue([data isKindOfClass:NSIndexSet.class], @"Incorrect data class '%@'.", NSStringFromClass([data class]));
+  STAssertTrue(data.count == 4 && [data containsIndexesInRange:NSMakeRange(2, 3)], @"Incorrect search results %@.", data);
+}
+
+- (void)testThreadResponse {
+  NSString *testString = @"* THREAD (2)(3 6 (4 23)(44 7 96))\r\n";
+  NSData *testData = [testString dataUsingEncoding:NSASCIIStringEncoding];
+
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizer];
+  SubImapParser *parser = [SubImapParser parserWithTokenizer:tokenizer];
+
+  NSError *error;
+  SubImapResponse *response = [parser parseResponseData:testData error:&error];
+
+  STAssertNil(error, @"Unable to parse response. %@", error);
+  STAssertTrue([response isType:SubImapResponseTypeThread], @"Incorrect response type.");
+
+  NSArray *threads = response.data;
+  STAssertTrue(threads.count == 2, @"Incorrect thread count %@.", threads);
+  STAssertEqualObjects(threads[0], (@{@"id": @2, @"children": @[]}), @"Incorrect single message thread.");
+
+  NSDictionary *six = threads[1][@"children"][0];
+  STAssertEqualObjects(six[@"id"], @6, @"Members were not chained.");
+  STAssertTrue([six[@"children"] count] == 2, @"Nested threads were not children of the last member.");
+  STAssertEqualObjects(six[@"children"][1][@"children"][0][@"id"], @7, @"Incorrect nested thread.");
+}
+
+- (void)testExtendedListResponse {
+  NSString *testString = @"* LIST (\\HasChildren) \"/\" Work (\"CHILDINFO\" (\"SUBSCRIBED\"))\r\n";
+  NSData *testData = [testString dataUsingEncoding:NSASCIIStringEncoding];
+
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizer];
+  SubImapParser *parser = [SubImapParser parserWithTokenizer:tokenizer];
+
+  NSError *error;
+  SubImapResponse *response = [parser parseResponseData:testData error:&error];
+
+  STAssertNil(error, @"Unable to parse response. %@", error);
+  STAssertTrue([response isType:SubImapResponseTypeList], @"Incorrect response type.");
+
+  id data = response.data;
+  STAssertEqualObjects(data[@"path"], @"Work", @"Incorrect path.");
+  STAssertEqualObjects(data[@"extended"][@"CHILDINFO"], @[@"SUBSCRIBED"], @"Extended items were not parsed.");
+}
+
+- (void)testStatusResponseWithExtensionAttributes {
+  NSString *testString = @"* STATUS INBOX (MESSAGES 12 UNSEEN 2 HIGHESTMODSEQ 90060115205545359)\r\n";
+  NSData *testData = [testString dataUsingEncoding:NSASCIIStringEncoding];
+
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizer];
+  SubImapParser *parser = [SubImapParser parserWithTokenizer:tokenizer];
+
+  NSError *error;
+  SubImapResponse *response = [parser parseResponseData:testData error:&error];
+
+  STAssertNil(error, @"Unable to parse response. %@", error);
+  STAssertTrue([response isType:SubImapResponseTypeStatus], @"Incorrect response type.");
+
+  id data = response.data;
+  STAssertEqualObjects(data[@"mailbox"], @"INBOX", @"Incorrect mailbox.");
+  STAssertEqualObjects(data[@"unseen"], @2, @"Incorrect unseen count.");
+  STAssertEquals([data[@"highestmodseq"] unsignedLongLongValue], 90060115205545359ULL, @"Incorrect mod-sequence.");
+}
+
+- (void)testPartialBodySectionResponse {
+  NSString *testString = @"* 3 FETCH (BODY[2.1.MIME] {9}\r\nMIME-Ver: BODY[1.HEADER.FIELDS (From To)] \"From: a\" BODY[2]<1024> \"tail\")\r\n";
+  NSData *testData = [testString dataUsingEncoding:NSASCIIStringEncoding];
+
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizer];
+  SubImapParser *parser = [SubImapParser parserWithTokenizer:tokenizer];
+
+  NSError *error;
+  SubImapResponse *response = [parser parseResponseData:testData error:&error];
+
+  STAssertNil(error, @"Unable to parse response. %@", error);
+  STAssertTrue([response isType:SubImapResponseTypeFetch], @"Incorrect response type.");
+
+  NSDictionary *sections = response.data[@"sections"];
+  STAssertTrue(sections.count == 3, @"Incorrect section count %lu.", sections.count);
+  STAssertEqualObjects(sections[@"2.1.MIME"][@"part"], @"2.1", @"Incorrect part number.");
+  STAssertEqualObjects(sections[@"2.1.MIME"][@"text"], @"MIME", @"Incorrect section text.");
+  STAssertEqualObjects(sections[@"1.HEADER.FIELDS (FROM TO)"][@"fields"], (@[@"From", @"To"]), @"Incorrect header fields.");
+  STAssertEqualObjects(sections[@"1.HEADER.FIELDS (FROM TO)"][@"headers"][@"from"], @"a", @"Header section was not parsed.");
+  STAssertEqualObjects(sections[@"2"][@"origin"], @1024, @"Partial origin was not parsed.");
+  STAssertEqualObjects(sections[@"2"][@"data"], @"tail", @"Incorrect section data.");
+}
+
+- (void)testBinarySectionResponse {
+  const char bytes[] = "* 4 FETCH (BINARY.SIZE[2] 3 BINARY[2]<0> ~{3}\r\n\x00\xfe\x01 UID 9)\r\n";
+  NSData *testData = [NSData dataWithBytes:bytes length:sizeof(bytes) - 1];
+
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizer];
+  SubImapParser *parser = [SubImapParser parserWithTokenizer:tokenizer];
+
+  NSError *error;
+  SubImapResponse *response = [parser parseResponseData:testData error:&error];
+
+  STAssertNil(error, @"Unable to parse response. %@", error);
+  STAssertEqualObjects(response.data[@"binary.size"][@"2"], @3, @"Incorrect binary size.");
+  STAssertEqualObjects(response.data[@"binary"][@"2"][@"data"], [NSData dataWithBytes:"\x00\xfe\x01" length:3], @"Incorrect binary data.");
+  STAssertEqualObjects(response.data[@"binary"][@"2"][@"origin"], @0, @"Partial origin was not parsed.");
+  STAssertEqualObjects(response.data[@"uid"], @9, @"Attributes after the literal8 were not parsed.");
+}
+
+- (void)testBinarySectionPlainLiteral {
+  // Latin-1 text, which isn't valid UTF-8, sent as a plain literal
+  const char bytes[] = "* 4 FETCH (BINARY[1] {3}\r\n\xe9\xfe\x01 UID 9)\r\n";
+  NSData *testData = [NSData dataWithBytes:bytes length:sizeof(bytes) - 1];
+
+  NSError *error;
+  SubImapResponse *response = [[SubImapParser parser] parseResponseData:testData error:&error];
+
+  STAssertNil(error, @"Unable to parse response. %@", error);
+  STAssertEqualObjects(response.data[@"binary"][@"1"][@"data"], [NSData dataWithBytes:"\xe9\xfe\x01" length:3], @"Literal bytes were decoded.");
+  STAssertEqualObjects(response.data[@"uid"], @9, @"Attributes after the literal were not parsed.");
+}
+
 @end
\ No newline at end of file
@@ -0,0 +1,116 @@
+// SubImapSearchCommandTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapSearchCommandTests.h"
+
+#import <SubImap/SubImap.h>
+
+#import "SubImapCommand+TestRendering.h"
+
+@implementation SubImapSearchCommandTests
+
+- (void)testRenderCriteria {
+  NSMutableIndexSet *UIDs = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(1, 100)];
+  [UIDs addIndex:200];
+
+  SubImapSearchCommand *command = [SubImapSearchCommand UIDCommandWithCriteria:[SubImapSearchCriteria allOf:@[
+    [SubImapSearchCriteria UIDs:UIDs],
+    [SubImapSearchCriteria unseen],
+    [SubImapSearchCriteria either:[SubImapSearchCriteria from:@"a@example.com"] or:[SubImapSearchCriteria subject:@"two words"]],
+    [SubImapSearchCriteria keyword:@"$Important"],
+  ]]];
+  command.tag = @"a1";
+
+  NSString *expected = @"a1 UID SEARCH (UID 1:100,200 UNSEEN OR FROM a@example.com SUBJECT \"two words\" KEYWORD $Important)\r\n";
+  STAssertEqualObjects([command renderedString], expected, @"Incorrect SEARCH command.");
+}
+
+- (void)testRenderExtendedSearch {
+  SubImapSearchCommand *command = [SubImapSearchCommand commandWithCriteria:[SubImapSearchCriteria text:@"café"]];
+  command.tag = @"a1";
+  command.capabilities = @[@"IMAP4REV1", @"ESEARCH"];
+  command.returnOptions = SubImapSearchReturnCount | SubImapSearchReturnAll;
+
+  NSArray *dataList = [command render];
+  STAssertTrue(dataList.count == 3, @"Non-ASCII text was not sent as a literal.");
+
+  NSString *start = [[NSString alloc] initWithData:[dataList[0] data] encoding:NSASCIIStringEncoding];
+  STAssertEqualObjects(start, @"a1 SEARCH RETURN (COUNT ALL) CHARSET UTF-8 TEXT ", @"Incorrect ESEARCH command.");
+}
+
+- (void)testSearchResult {
+  SubImapSearchCommand *command = [SubImapSearchCommand commandWithCriteria:[SubImapSearchCriteria all]];
+  command.tag = @"a1";
+  [command render];
+
+  NSMutableIndexSet *matches = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(4, 3)];
+  [command handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeSearch data:matches]];
+  [command handleResponse:[SubImapResponse responseWithStatus:YES type:SubImapResponseTypeOk tag:@"a1" data:@{}]];
+
+  STAssertTrue(command.isComplete, @"Command did not complete.");
+  STAssertEqualObjects(command.result[@"count"], @3, @"Incorrect count.");
+  STAssertEqualObjects(command.result[@"min"], @4, @"Incorrect minimum.");
+  STAssertEqualObjects(command.result[@"max"], @6, @"Incorrect maximum.");
+}
+
+- (void)testExtendedSearchResult {
+  SubImapSearchCommand *command = [SubImapSearchCommand commandWithCriteria:[SubImapSearchCriteria all]];
+  command.tag = @"a1";
+  command.capabilities = @[@"ESEARCH"];
+  command.returnOptions = SubImapSearchReturnCount | SubImapSearchReturnAll;
+  [command render];
+
+  // Another command's results are ignored
+  [command handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeEsearch data:@{@"tag": @"a0", @"count": @9}]];
+  [command handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeEsearch data:@{@"tag": @"a1", @"count": @0}]];
+  [command handleResponse:[SubImapResponse responseWithStatus:YES type:SubImapResponseTypeOk tag:@"a1" data:@{}]];
+
+  STAssertEqualObjects(command.result[@"count"], @0, @"Incorrect count.");
+  STAssertTrue([command.result[@"all"] count] == 0, @"Incorrect matches.");
+}
+
+- (void)testRenderGmailCriteria {
+  SubImapSearchCommand *command = [SubImapSearchCommand UIDCommandWithCriteria:[SubImapSearchCriteria allOf:@[
+    [SubImapSearchCriteria gmailRaw:@"has:attachment newer_than:1y"],
+    [SubImapSearchCriteria not:[SubImapSearchCriteria gmailMessageID:@"1278455344230334865"]],
+  ]]];
+  command.tag = @"a1";
+
+  NSString *expected = @"a1 UID SEARCH (X-GM-RAW \"has:attachment newer_than:1y\" NOT X-GM-MSGID 1278455344230334865)\r\n";
+  STAssertEqualObjects([command renderedString], expected, @"Incorrect Gmail SEARCH command.");
+}
+
+- (void)testRenderThread {
+  SubImapThreadCommand *command = [SubImapThreadCommand UIDCommandWithCriteria:[SubImapSearchCriteria all]];
+  command.tag = @"a1";
+
+  STAssertEqualObjects([command renderedString], @"a1 UID THREAD REFERENCES US-ASCII ALL\r\n", @"Incorrect THREAD command.");
+
+  NSArray *threads = @[@{@"id": @2, @"children": @[]}];
+  [command handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeThread data:threads]];
+  [command handleResponse:[SubImapResponse responseWithStatus:YES type:SubImapResponseTypeOk tag:@"a1" data:@{}]];
+
+  STAssertEqualObjects(command.result, threads, @"Incorrect threads.");
+}
+
+@end
\ No newline at end of file
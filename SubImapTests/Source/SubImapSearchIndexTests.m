@@ -0,0 +1,148 @@
+// SubImapSearchIndexTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapSearchIndexTests.h"
+
+#import <SubImap/SubImap.h>
+
+@implementation SubImapSearchIndexTests
+
+- (NSDictionary *)messageWithUID:(NSUInteger)UID subject:(NSString *)subject from:(NSString *)name body:(NSString *)body {
+  NSDictionary *address = @{@"name": name, @"email": [[name lowercaseString] stringByAppendingString:@"@example.com"]};
+
+  return @{
+    @"uid": @(UID),
+    @"rfc.size": @(body.length * 100),
+    @"envelope": @{@"subject": subject, @"from": @[address], @"to": @[], @"cc": @[], @"bcc": @[]},
+    @"bodystructure": @{@"type": @"TEXT", @"subtype": @"PLAIN", @"section": @"1", @"encoding": @"8BIT", @"params": @{@"charset": @"utf-8"}},
+    @"sections": @{@"1": @{@"data": body}},
+  };
+}
+
+- (SubImapSearchIndex *)index {
+  SubImapSearchIndex *index = [SubImapSearchIndex indexWithPath:@"INBOX"];
+  [index addMessages:@[
+    [self messageWithUID:3 subject:@"Invoice for March" from:@"Ann" body:@"Payment is due."],
+    [self messageWithUID:4 subject:@"Lunch?" from:@"Bob" body:@"The café at noon, then the invoice."],
+    [self messageWithUID:9 subject:@"Re: Invoice for March" from:@"Ann" body:@"Paid, thanks"],
+  ]];
+
+  return index;
+}
+
+- (void)testText {
+  SubImapSearchIndex *index = [self index];
+
+  STAssertTrue(index.count == 3, @"Incorrect count.");
+
+  NSMutableIndexSet *expected = [NSMutableIndexSet indexSetWithIndex:3];
+  [expected addIndex:9];
+  STAssertEqualObjects([index UIDsMatchingCriteria:[SubImapSearchCriteria subject:@"invoice"]], expected, @"Incorrect SUBJECT matches.");
+  STAssertEqualObjects([index UIDsMatchingCriteria:[SubImapSearchCriteria from:@"ann@example.com"]], expected, @"Incorrect FROM matches.");
+
+  STAssertEqualObjects([index UIDsMatchingCriteria:[SubImapSearchCriteria body:@"CAFE"]], [NSIndexSet indexSetWithIndex:4], @"Decoded body was not folded.");
+  STAssertEqualObjects([index UIDsMatchingCriteria:[SubImapSearchCriteria body:@"invoice noon"]], [NSIndexSet indexSetWithIndex:4], @"Every word has to match.");
+  STAssertTrue([index UIDsMatchingCriteria:[SubImapSearchCriteria text:@"invoice"]].count == 3, @"TEXT did not search every field.");
+}
+
+- (void)testCombined {
+  SubImapSearchIndex *index = [self index];
+
+  SubImapSearchCriteria *criteria = [SubImapSearchCriteria allOf:@[
+    [SubImapSearchCriteria text:@"invoice"],
+    [SubImapSearchCriteria not:[SubImapSearchCriteria subject:@"re"]],
+    [SubImapSearchCriteria either:[SubImapSearchCriteria from:@"bob"] or:[SubImapSearchCriteria largerThan:1000]],
+  ]];
+
+  NSMutableIndexSet *expected = [NSMutableIndexSet indexSetWithIndex:3];
+  [expected addIndex:4];
+  STAssertEqualObjects([index UIDsMatchingCriteria:criteria], expected, @"Incorrect matches.");
+
+  // Flags need the mailbox state
+  STAssertNil([index UIDsMatchingCriteria:[SubImapSearchCriteria unseen]], @"Evaluated flags without the mailbox state.");
+  STAssertNil([index UIDsMatchingCriteria:[SubImapSearchCriteria gmailRaw:@"in:inbox"]], @"Evaluated an unsupported key.");
+}
+
+- (void)testOutOfOrder {
+  SubImapSearchIndex *index = [self index];
+  [index addMessage:[self messageWithUID:1 subject:@"Invoice draft" from:@"Carol" body:@""]];
+  [index addMessage:[self messageWithUID:200 subject:@"Invoice" from:@"Carol" body:@""]];
+
+  NSMutableIndexSet *expected = [NSMutableIndexSet indexSetWithIndex:1];
+  [expected addIndex:3];
+  [expected addIndex:9];
+  [expected addIndex:200];
+  STAssertEqualObjects([index UIDsMatchingCriteria:[SubImapSearchCriteria subject:@"invoice"]], expected, @"Incorrect matches.");
+}
+
+- (void)testOutOfOrderBatch {
+  SubImapSearchIndex *index = [self index];
+  [index addMessages:@[
+    [self messageWithUID:2 subject:@"Invoice draft" from:@"Carol" body:@""],
+    [self messageWithUID:1 subject:@"Invoice draft" from:@"Carol" body:@""],
+    [self messageWithUID:2 subject:@"Invoice draft" from:@"Carol" body:@""],
+  ]];
+
+  NSMutableIndexSet *expected = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(1, 3)];
+  [expected addIndex:9];
+  STAssertEqualObjects([index UIDsMatchingCriteria:[SubImapSearchCriteria subject:@"invoice"]], expected, @"Incorrect matches.");
+  STAssertEqualObjects([index UIDsMatchingCriteria:[SubImapSearchCriteria subject:@"draft"]], [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(1, 2)], @"Incorrect matches.");
+}
+
+- (void)testMissingDatesAndSizes {
+  SubImapSearchIndex *index = [self index];
+
+  // None of the messages has an internal date
+  STAssertNil([index UIDsMatchingCriteria:[SubImapSearchCriteria since:[NSDate date]]], @"Evaluated dates without them.");
+  STAssertNotNil([index UIDsMatchingCriteria:[SubImapSearchCriteria largerThan:1000]], @"Sizes were not evaluated.");
+
+  [index addMessage:@{@"uid": @20, @"envelope": @{@"subject": @"No size"}}];
+  STAssertNil([index UIDsMatchingCriteria:[SubImapSearchCriteria largerThan:1000]], @"Evaluated sizes with one missing.");
+}
+
+- (void)testHeaderWithoutWords {
+  SubImapSearchIndex *index = [self index];
+
+  // Means every message that has the header, which the index can't tell
+  STAssertNil([index UIDsMatchingCriteria:[SubImapSearchCriteria header:@"X-Spam-Flag" contains:@""]], @"Evaluated HEADER without words.");
+  STAssertNil([index UIDsMatchingCriteria:[SubImapSearchCriteria subject:@"?!"]], @"Evaluated SUBJECT without words.");
+}
+
+- (void)testMailboxState {
+  SubImapSearchIndex *index = [self index];
+
+  SubImapMailboxState *state = [SubImapMailboxState stateWithPath:@"INBOX"];
+  [state handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeExists data:@2]];
+  [state handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeFetch data:@{@"sequenceID": @1, @"uid": @3, @"flags": @[@"\\Seen"]}]];
+  [state handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeFetch data:@{@"sequenceID": @2, @"uid": @9, @"flags": @[]}]];
+
+  // 4 was expunged
+  [index updateWithMailboxState:state];
+
+  STAssertTrue(index.count == 2, @"Expunged message was not removed.");
+  STAssertEqualObjects([index UIDsMatchingCriteria:[SubImapSearchCriteria body:@"noon"]], [NSIndexSet indexSet], @"Expunged message matched.");
+  STAssertEqualObjects([index UIDsMatchingCriteria:[SubImapSearchCriteria unseen]], [NSIndexSet indexSetWithIndex:9], @"Incorrect UNSEEN matches.");
+  STAssertEqualObjects([index UIDsMatchingCriteria:[SubImapSearchCriteria sequenceNumbers:[NSIndexSet indexSetWithIndex:1]]], [NSIndexSet indexSetWithIndex:3], @"Incorrect sequence number matches.");
+}
+
+@end
\ No newline at end of file
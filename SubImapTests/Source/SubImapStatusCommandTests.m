@@ -0,0 +1,102 @@
+// SubImapStatusCommandTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapStatusCommandTests.h"
+
+#import <SubImap/SubImap.h>
+
+#import "SubImapCommand+TestRendering.h"
+
+@implementation SubImapStatusCommandTests
+
+- (SubImapResponse *)listResponseWithPath:(NSString *)path flags:(NSArray *)flags {
+  return [SubImapResponse responseWithType:SubImapResponseTypeList data:@{@"path": path, @"delimiter": @"/", @"flags": flags}];
+}
+
+- (void)testRenderPipelinedStatus {
+  SubImapStatusCommand *command = [SubImapStatusCommand commandWithMailboxes:@[@"INBOX", @"Sent Items"] items:@[@"MESSAGES", @"UNSEEN"]];
+  command.tag = @"a1";
+
+  NSString *expected = @"a1.1 STATUS INBOX (MESSAGES UNSEEN)\r\na1 STATUS \"Sent Items\" (MESSAGES UNSEEN)\r\n";
+  STAssertEqualObjects([command renderedString], expected, @"Incorrect STATUS commands.");
+}
+
+- (void)testPipelinedStatusResult {
+  SubImapStatusCommand *command = [SubImapStatusCommand commandWithMailboxes:@[@"INBOX", @"Gone", @"Sent"] items:@[@"MESSAGES"]];
+  command.tag = @"a1";
+  [command render];
+
+  [command handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeStatus data:@{@"mailbox": @"INBOX", @"messages": @12}]];
+  [command handleResponse:[SubImapResponse responseWithStatus:YES type:SubImapResponseTypeOk tag:@"a1.1" data:@{}]];
+  [command handleResponse:[SubImapResponse responseWithStatus:NO type:SubImapResponseTypeNo tag:@"a1.2" data:@{}]];
+  STAssertFalse(command.isComplete, @"Command completed before every STATUS finished.");
+
+  [command handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeStatus data:@{@"mailbox": @"Sent", @"messages": @3}]];
+  [command handleResponse:[SubImapResponse responseWithStatus:YES type:SubImapResponseTypeOk tag:@"a1" data:@{}]];
+
+  STAssertTrue(command.isComplete, @"Command did not complete.");
+  STAssertNil(command.error, @"A refused mailbox failed the command.");
+  STAssertTrue([command.result count] == 2, @"Incorrect status count.");
+  STAssertEqualObjects(command.result[@"Sent"][@"messages"], @3, @"Incorrect status.");
+}
+
+- (void)testRenderListStatus {
+  SubImapListCommand *command = [SubImapListCommand commandWithAll];
+  command.tag = @"a1";
+  command.statusItems = @[@"MESSAGES", @"UNSEEN"];
+  command.selectionOptions = @[@"SUBSCRIBED"];
+  command.returnOptions = @[@"CHILDREN"];
+
+  STAssertEqualObjects([command renderedString], @"a1 LIST \"\" \"*\"\r\n", @"Options were sent without support.");
+
+  command.capabilities = @[@"LIST-EXTENDED", @"LIST-STATUS"];
+
+  NSString *expected = @"a1 LIST (SUBSCRIBED) \"\" \"*\" RETURN (CHILDREN STATUS (MESSAGES UNSEEN))\r\n";
+  STAssertEqualObjects([command renderedString], expected, @"Incorrect LIST-STATUS command.");
+}
+
+- (void)testListStatusTree {
+  SubImapListCommand *command = [SubImapListCommand commandWithAll];
+  command.tag = @"a1";
+  [command render];
+
+  [command handleResponse:[self listResponseWithPath:@"INBOX" flags:@[]]];
+  [command handleResponse:[SubImapResponse responseWithType:SubImapResponseTypeStatus data:@{@"mailbox": @"INBOX", @"messages": @12}]];
+  [command handleResponse:[self listResponseWithPath:@"Work/2013" flags:@[]]];
+  [command handleResponse:[self listResponseWithPath:@"Work" flags:@[@"\\Noselect"]]];
+  [command handleResponse:[SubImapResponse responseWithStatus:YES type:SubImapResponseTypeOk tag:@"a1" data:@{}]];
+
+  STAssertEqualObjects([command mailboxPathsWithoutStatus], @[@"Work/2013"], @"Incorrect mailboxes without status.");
+
+  [command addStatuses:@{@"Work/2013": @{@"mailbox": @"Work/2013", @"messages": @4}}];
+
+  NSArray *tree = [command mailboxTree];
+  STAssertTrue(tree.count == 2, @"Incorrect root count.");
+  STAssertEqualObjects(tree[0][@"status"][@"messages"], @12, @"LIST-STATUS status was not attached.");
+
+  NSDictionary *child = [tree[1][@"children"] lastObject];
+  STAssertEqualObjects(child[@"name"], @"2013", @"Incorrect child name.");
+  STAssertEqualObjects(child[@"status"][@"messages"], @4, @"STATUS result was not attached.");
+}
+
+@end
\ No newline at end of file
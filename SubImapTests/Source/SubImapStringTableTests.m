@@ -0,0 +1,66 @@
+// SubImapStringTableTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapStringTableTests.h"
+
+#import <SubImap/SubImap.h>
+
+@implementation SubImapStringTableTests
+
+- (void)testSharing {
+  SubImapStringTable *table = [SubImapStringTable tableWithCapacity:16];
+
+  NSString *seen = [table stringWithBytes:"\\Seen" length:5];
+  STAssertEqualObjects(seen, @"\\Seen", @"Incorrect string.");
+  STAssertTrue([table stringWithBytes:"\\Seen" length:5] == seen, @"String was not shared.");
+
+  const char *subject = "A subject longer than thirty-two bytes";
+  NSString *first = [table stringWithBytes:subject length:strlen(subject)];
+  STAssertEqualObjects(first, @(subject), @"Incorrect long string.");
+  STAssertTrue([table stringWithBytes:subject length:strlen(subject)] != first, @"Long string was shared.");
+
+  STAssertNil([table stringWithBytes:"caf\xc3\xa9" length:5], @"Non-ASCII bytes were accepted.");
+}
+
+- (void)testReplacement {
+  SubImapStringTable *table = [SubImapStringTable tableWithCapacity:1];
+
+  NSString *seen = [table stringWithBytes:"\\Seen" length:5];
+  STAssertEqualObjects([table stringWithBytes:"\\Flagged" length:8], @"\\Flagged", @"Incorrect string.");
+
+  // The only slot was taken, but the string is still valid
+  STAssertEqualObjects(seen, @"\\Seen", @"Replaced string was released.");
+  STAssertTrue([table stringWithBytes:"\\Seen" length:5] != seen, @"String was not replaced.");
+}
+
+- (void)testCase {
+  SubImapStringTable *table = [SubImapStringTable tableWithCapacity:16];
+
+  NSString *type = [table uppercaseString:@"text"];
+  STAssertEqualObjects(type, @"TEXT", @"Incorrect uppercase string.");
+  STAssertTrue([table uppercaseString:@"Text"] == type, @"Uppercase string was not shared.");
+  STAssertEqualObjects([table lowercaseString:@"X-GM-MSGID"], @"x-gm-msgid", @"Incorrect lowercase string.");
+  STAssertEqualObjects([table lowercaseString:@"CAFÉ"], @"café", @"Non-ASCII string was not converted.");
+}
+
+@end
\ No newline at end of file
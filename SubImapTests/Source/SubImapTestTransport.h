@@ -0,0 +1,48 @@
+// SubImapTestTransport.h
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <SubImap/SubImap.h>
+
+/*
+ * Records what a connection asks of it, without a server. Reads return
+ * the bytes given to receiveString:, and writes are kept in written.
+ */
+@interface SubImapTestTransport : NSObject <SubImapTransport>
+
+// Bytes to return from the next read
+@property NSData *readData;
+
+@property (readonly) NSMutableData *written;
+@property (readonly) BOOL startedTLS;
+
+/*
+ * Reads the string as if the server had sent it.
+ */
+- (void)receiveString:(NSString *)string;
+
+/*
+ * Everything written so far, as one string.
+ */
+- (NSString *)writtenString;
+
+@end
\ No newline at end of file
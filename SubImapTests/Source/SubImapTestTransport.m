@@ -0,0 +1,77 @@
+// SubImapTestTransport.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapTestTransport.h"
+
+@implementation SubImapTestTransport
+
+@synthesize delegate = _delegate;
+@synthesize readingPaused = _readingPaused;
+
+- (id)init {
+  self = [super init];
+
+  if (self) {
+    _written = [NSMutableData data];
+  }
+
+  return self;
+}
+
+- (BOOL)open { return YES; }
+- (void)close {}
+- (BOOL)isOpen { return YES; }
+- (BOOL)startTLS { _startedTLS = YES; return YES; }
+
+- (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)length {
+  NSUInteger readLength = MIN(length, self.readData.length);
+  if (!readLength) return -1;
+
+  [self.readData getBytes:buffer length:readLength];
+  self.readData = [self.readData subdataWithRange:NSMakeRange(readLength, self.readData.length - readLength)];
+  return readLength;
+}
+
+- (NSInteger)write:(const uint8_t *)buffer maxLength:(NSUInteger)length {
+  [_written appendBytes:buffer length:length];
+  return length;
+}
+
+- (NSInteger)writeBuffers:(NSArray *)buffers {
+  for (NSData *buffer in buffers) {
+    [_written appendData:buffer];
+  }
+
+  return [[buffers valueForKeyPath:@"@sum.length"] integerValue];
+}
+
+- (void)receiveString:(NSString *)string {
+  self.readData = [string dataUsingEncoding:NSUTF8StringEncoding];
+  [self.delegate transportHasBytesAvailable:self];
+}
+
+- (NSString *)writtenString {
+  return [[NSString alloc] initWithData:_written encoding:NSUTF8StringEncoding];
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,134 @@
+// SubImapThreadIndexTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapThreadIndexTests.h"
+
+#import <SubImap/SubImap.h>
+
+@implementation SubImapThreadIndexTests
+
+- (NSDictionary *)messageWithUID:(NSUInteger)UID messageID:(NSString *)messageID references:(NSString *)references {
+  NSMutableDictionary *message = [NSMutableDictionary dictionary];
+  message[@"uid"] = @(UID);
+  message[@"envelope"] = @{@"id": messageID};
+
+  if (references) {
+    message[@"sections"] = @{@"HEADER.FIELDS (REFERENCES)": @{@"headers": @{@"references": references}}};
+  }
+
+  return message;
+}
+
+- (void)testReferences {
+  SubImapThreadIndex *index = [SubImapThreadIndex index];
+  [index addMessages:@[
+    [self messageWithUID:1 messageID:@"<a@x>" references:nil],
+    [self messageWithUID:2 messageID:@"<b@x>" references:@"<a@x>"],
+    [self messageWithUID:3 messageID:@"<c@x>" references:@"<a@x> <b@x>"],
+    [self messageWithUID:4 messageID:@"<d@x>" references:nil],
+  ]];
+
+  STAssertTrue(index.count == 4, @"Incorrect count.");
+  STAssertTrue([index threadIDForUID:3] == [index threadIDForUID:1], @"Reply was not threaded.");
+  STAssertTrue([index threadIDForUID:4] != [index threadIDForUID:1], @"Unrelated message was threaded.");
+  STAssertTrue([index parentUIDOfUID:3] == 2, @"Incorrect parent.");
+  STAssertTrue([index parentUIDOfUID:1] == 0, @"Incorrect root parent.");
+  STAssertTrue([index threads].count == 2, @"Incorrect thread count.");
+}
+
+- (void)testOutOfOrder {
+  SubImapThreadIndex *index = [SubImapThreadIndex index];
+
+  // The reply arrives before the message, which is not in the mailbox yet
+  [index addMessage:[self messageWithUID:7 messageID:@"<c@x>" references:@"<a@x> <b@x>"]];
+  [index addMessage:[self messageWithUID:5 messageID:@"<e@x>" references:@"<a@x>"]];
+
+  STAssertTrue([index threadIDForUID:7] == [index threadIDForUID:5], @"Replies to a missing message were not threaded.");
+  STAssertTrue([index parentUIDOfUID:7] == 0, @"Missing messages were not skipped.");
+
+  [index addMessage:[self messageWithUID:3 messageID:@"<a@x>" references:nil]];
+
+  NSIndexSet *UIDs = [index UIDsInThreadOfUID:3];
+  STAssertTrue(UIDs.count == 3 && [UIDs containsIndex:7] && [UIDs containsIndex:5], @"Incorrect thread %@.", UIDs);
+  STAssertTrue([index parentUIDOfUID:7] == 3, @"Incorrect parent.");
+}
+
+- (void)testGmailThread {
+  SubImapThreadIndex *index = [SubImapThreadIndex index];
+
+  NSMutableDictionary *first = [[self messageWithUID:1 messageID:@"<a@x>" references:nil] mutableCopy];
+  NSMutableDictionary *second = [[self messageWithUID:2 messageID:@"<b@x>" references:nil] mutableCopy];
+  first[@"x-gm-thrid"] = @"1278455344230334865";
+  second[@"x-gm-thrid"] = @"1278455344230334865";
+
+  [index addMessages:@[first, second]];
+
+  STAssertTrue([index threadIDForUID:1] == [index threadIDForUID:2], @"Gmail thread was not used.");
+}
+
+- (void)testCrossingGmailThreads {
+  SubImapThreadIndex *index = [SubImapThreadIndex index];
+
+  NSMutableDictionary *first = [[self messageWithUID:1 messageID:@"<a@x>" references:nil] mutableCopy];
+  NSMutableDictionary *second = [[self messageWithUID:2 messageID:@"<b@x>" references:@"<a@x>"] mutableCopy];
+  NSMutableDictionary *third = [[self messageWithUID:3 messageID:@"<c@x>" references:@"<a@x> <b@x>"] mutableCopy];
+  first[@"x-gm-thrid"] = @"1";
+  second[@"x-gm-thrid"] = @"2";
+  third[@"x-gm-thrid"] = @"1";
+
+  [index addMessages:@[first, second, third]];
+
+  STAssertTrue([index threadIDForUID:1] == [index threadIDForUID:2], @"Reply in another Gmail thread was not joined.");
+  STAssertTrue([index threadIDForUID:1] == [index threadIDForUID:3], @"Reply back in the first Gmail thread was not joined.");
+}
+
+- (void)testServerThreads {
+  SubImapThreadIndex *index = [SubImapThreadIndex index];
+  [index addThreads:@[
+    @{@"id": @2, @"children": @[]},
+    @{@"id": @3, @"children": @[@{@"children": @[@{@"id": @4, @"children": @[]}, @{@"id": @5, @"children": @[]}]}]},
+  ]];
+
+  STAssertTrue(index.count == 4, @"Incorrect count.");
+  STAssertTrue([index threadIDForUID:4] == [index threadIDForUID:5], @"Siblings were not threaded.");
+  STAssertTrue([index parentUIDOfUID:5] == 3, @"Missing message was not skipped.");
+  STAssertTrue([index threadIDForUID:2] != [index threadIDForUID:3], @"Separate threads were joined.");
+}
+
+- (void)testRemove {
+  SubImapThreadIndex *index = [SubImapThreadIndex index];
+  [index addMessages:@[
+    [self messageWithUID:1 messageID:@"<a@x>" references:nil],
+    [self messageWithUID:2 messageID:@"<b@x>" references:@"<a@x>"],
+    [self messageWithUID:3 messageID:@"<c@x>" references:@"<a@x>"],
+  ]];
+
+  [index removeMessagesWithUIDs:[NSIndexSet indexSetWithIndex:1]];
+
+  STAssertTrue(index.count == 2, @"Incorrect count.");
+  STAssertTrue([index threadIDForUID:1] == 0, @"Removed message is still in the index.");
+  STAssertTrue([index threadIDForUID:2] == [index threadIDForUID:3], @"Replies lost their thread.");
+  STAssertEqualObjects([index UIDsInThreadOfUID:2], [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(2, 2)], @"Incorrect thread.");
+}
+
+@end
\ No newline at end of file
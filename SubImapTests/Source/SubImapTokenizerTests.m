@@ -75,4 +75,44 @@
   [self tokenizeString:@"{3}\r\nabc" type:SubImapTokenTypeLiteral];
 }
 
+- (void)testLiteral8IsData {
+  const char bytes[] = "~{4}\r\n\x00\x01\xff\r";
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizerForData:[NSData dataWithBytes:bytes length:sizeof(bytes) - 1]];
+
+  NSError *error;
+  SubImapToken *token = [tokenizer pullTokenOfType:SubImapTokenTypeLiteral error:&error];
+
+  STAssertNil(error, @"Unable to read literal8. %@", error);
+  STAssertEqualObjects(token.value, [NSData dataWithBytes:"\x00\x01\xff\r" length:4], @"Incorrect literal8 bytes.");
+}
+
+- (void)testTruncatedLiteral {
+  [self tokenizeString:@"{3}\r\nabc" type:SubImapTokenTypeLiteral];
+
+  NSData *data = [@"{8}\r\nabc" dataUsingEncoding:NSASCIIStringEncoding];
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizerForData:data];
+  STAssertFalse([tokenizer peekTokenIsType:SubImapTokenTypeLiteral], @"Read past the end of a truncated literal.");
+}
+
+- (void)testSharedStrings {
+  NSData *data = [@"\\Seen \"TEXT\"" dataUsingEncoding:NSASCIIStringEncoding];
+  SubImapTokenizer *tokenizer = [SubImapTokenizer tokenizerForData:data];
+  SubImapTokenizer *otherTokenizer = [SubImapTokenizer tokenizerForData:[NSData dataWithData:data]];
+
+  NSError *error;
+  SubImapToken *flag = [tokenizer pullTokenOfType:SubImapTokenTypeFlag error:&error];
+  SubImapToken *otherFlag = [otherTokenizer pullTokenOfType:SubImapTokenTypeFlag error:&error];
+
+  STAssertEqualObjects(flag.value, @"\\Seen", @"Incorrect flag.");
+  STAssertTrue(flag.value == otherFlag.value, @"Flag strings were not shared.");
+
+  [tokenizer pullTokenOfType:SubImapTokenTypeSpace error:&error];
+  [otherTokenizer pullTokenOfType:SubImapTokenTypeSpace error:&error];
+
+  SubImapToken *string = [tokenizer pullTokenOfType:SubImapTokenTypeQuotedString error:&error];
+  SubImapToken *otherString = [otherTokenizer pullTokenOfType:SubImapTokenTypeQuotedString error:&error];
+
+  STAssertTrue(string.value == otherString.value, @"Quoted strings were not shared.");
+}
+
 @end
\ No newline at end of file
@@ -0,0 +1,114 @@
+// SubImapTransactionalClientTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapTransactionalClientTests.h"
+
+#import <SubImap/SubImap.h>
+
+@implementation SubImapTransactionalClientTests
+
+#pragma mark - Helpers
+
+// Adds a block that records the transaction's name when it starts
+- (void)transaction:(SubImapTransaction *)transaction named:(NSString *)name log:(NSMutableArray *)log {
+  [transaction addBlock:^id(id result) {
+    [log addObject:name];
+    return nil;
+  }];
+}
+
+#pragma mark - Tests
+
+- (void)testTransactionsAreInterleaved {
+  SubImapTransactionalClient *client = [SubImapTransactionalClient clientWithConnection:nil];
+  NSMutableArray *log = [NSMutableArray array];
+
+  // A long running transaction in the inbox, waiting on its command
+  SubImapRawCommand *download = [SubImapRawCommand commandWithString:@"FETCH 1:* BODY[]"];
+  SubImapTransaction *inbox = [SubImapTransaction transactionWithMailbox:@"INBOX"];
+  [self transaction:inbox named:@"inbox" log:log];
+  [inbox addCommand:download];
+
+  SubImapTransaction *status = [SubImapTransaction transaction];
+  status.exclusive = NO;
+  [self transaction:status named:@"status" log:log];
+
+  SubImapTransaction *archive = [SubImapTransaction transactionWithMailbox:@"Archive"];
+  [self transaction:archive named:@"archive" log:log];
+
+  SubImapTransaction *inboxFlags = [SubImapTransaction transactionWithMailbox:@"inbox"];
+  [self transaction:inboxFlags named:@"inbox flags" log:log];
+
+  SubImapTransaction *logout = [SubImapTransaction transaction];
+  [self transaction:logout named:@"logout" log:log];
+
+  for (SubImapTransaction *transaction in @[inbox, status, archive, inboxFlags, logout]) {
+    [client enqueueTransaction:transaction];
+  }
+
+  NSArray *expected = @[@"inbox", @"status"];
+  STAssertEqualObjects(log, expected, @"Independent transaction did not run alongside the inbox.");
+
+  // Finishing the inbox transaction lets the next mailbox run
+  [download complete];
+
+  expected = @[@"inbox", @"status", @"archive", @"inbox flags", @"logout"];
+  STAssertEqualObjects(log, expected, @"Waiting transactions did not run in order.");
+}
+
+- (void)testTransactionsFinishingWhileStarted {
+  SubImapTransactionalClient *client = [SubImapTransactionalClient clientWithConnection:nil];
+  NSMutableArray *log = [NSMutableArray array];
+
+  SubImapRawCommand *download = [SubImapRawCommand commandWithString:@"FETCH 1:* BODY[]"];
+  SubImapTransaction *inbox = [SubImapTransaction transactionWithMailbox:@"INBOX"];
+  [inbox addCommand:download];
+  [client enqueueTransaction:inbox];
+
+  // Waits for the inbox, ahead of transactions that finish as soon as
+  // they are started
+  SubImapTransaction *archive = [SubImapTransaction transactionWithMailbox:@"Archive"];
+  [self transaction:archive named:@"archive" log:log];
+  [client enqueueTransaction:archive];
+
+  for (NSString *name in @[@"first", @"second", @"third"]) {
+    SubImapTransaction *transaction = [SubImapTransaction transaction];
+    transaction.exclusive = NO;
+    [self transaction:transaction named:name log:log];
+    [client enqueueTransaction:transaction];
+  }
+
+  SubImapTransaction *logout = [SubImapTransaction transaction];
+  [self transaction:logout named:@"logout" log:log];
+  [client enqueueTransaction:logout];
+
+  NSArray *expected = @[@"first", @"second", @"third"];
+  STAssertEqualObjects(log, expected, @"Transactions did not each run once.");
+
+  [download complete];
+
+  expected = @[@"first", @"second", @"third", @"archive", @"logout"];
+  STAssertEqualObjects(log, expected, @"Waiting transactions did not run in order.");
+}
+
+@end
\ No newline at end of file
@@ -0,0 +1,72 @@
+// SubImapTransferDecoderTests.m
+// SubMail
+//
+// Copyright (c) 2012 Joseph North (http://sublink.ca/)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SubImapTransferDecoderTests.h"
+
+#import <SubImap/SubImap.h>
+
+@implementation SubImapTransferDecoderTests
+
+- (void)testBase64AcrossChunks {
+  NSString *text = @"The quick brown fox jumps over the lazy dog, twice over.";
+  NSData *plain = [text dataUsingEncoding:NSASCIIStringEncoding];
+  NSData *encoded = [plain base64EncodedDataWithOptions:NSDataBase64Encoding64CharacterLineLength | NSDataBase64EncodingEndLineWithCarriageReturn | NSDataBase64EncodingEndLineWithLineFeed];
+
+  // Every chunk size, so groups, line breaks and padding are all split
+  for (NSUInteger chunkSize = 1; chunkSize <= encoded.length; chunkSize++) {
+    SubImapTransferDecoder *decoder = [SubImapTransferDecoder decoderWithEncoding:@"base64"];
+    NSMutableData *output = [NSMutableData data];
+
+    for (NSUInteger offset = 0; offset < encoded.length; offset += chunkSize) {
+      [decoder decodeBytes:(const char *)[encoded bytes] + offset length:MIN(chunkSize, encoded.length - offset) intoData:output];
+    }
+
+    [decoder finishIntoData:output];
+
+    STAssertEqualObjects(output, plain, @"Incorrect base64 decoding with chunk size %lu.", chunkSize);
+  }
+}
+
+- (void)testQuotedPrintable {
+  NSData *encoded = [@"caf=C3=A9 soft=\r\nbreak  \r\nlast=3d=\n=ZZ end=" dataUsingEncoding:NSASCIIStringEncoding];
+  NSData *decoded = [SubImapTransferDecoder decodeData:encoded encoding:@"QUOTED-PRINTABLE"];
+  NSString *string = [[NSString alloc] initWithData:decoded encoding:NSUTF8StringEncoding];
+
+  STAssertEqualObjects(string, @"café softbreak\r\nlast==ZZ end=", @"Incorrect quoted-printable decoding.");
+}
+
+- (void)testUnknownEncodingPassesThrough {
+  NSData *data = [@"=?not encoded" dataUsingEncoding:NSASCIIStringEncoding];
+
+  STAssertEqualObjects([SubImapTransferDecoder decodeData:data encoding:@"8BIT"], data, @"8BIT data was changed.");
+  STAssertEqualObjects([SubImapTransferDecoder decodeData:data encoding:nil], data, @"Data without an encoding was changed.");
+}
+
+- (void)testEncodedWords {
+  STAssertEqualObjects([SubImapTransferDecoder stringByDecodingEncodedWords:@"=?UTF-8?Q?caf=C3=A9_au_lait?="], @"café au lait", @"Incorrect Q decoding.");
+  STAssertEqualObjects([SubImapTransferDecoder stringByDecodingEncodedWords:@"Re: =?iso-8859-1?B?Y2Fm6Q==?= now"], @"Re: café now", @"Incorrect B decoding.");
+  STAssertEqualObjects([SubImapTransferDecoder stringByDecodingEncodedWords:@"=?UTF-8?Q?a?= \r\n =?UTF-8?Q?b?="], @"ab", @"Whitespace between encoded words was kept.");
+  STAssertEqualObjects([SubImapTransferDecoder stringByDecodingEncodedWords:@"=?UTF-8?X?abc?= =?broken"], @"=?UTF-8?X?abc?= =?broken", @"Malformed words were changed.");
+}
+
+@end
\ No newline at end of file